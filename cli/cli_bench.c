@@ -0,0 +1,894 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <sysexits.h>
+#include <time.h>
+
+#include <hse_util/hse_err.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/atomic.h>
+#include <hse_util/byteorder.h>
+#include <hse_util/data_tree.h>
+#include <hse_util/hash.h>
+#include <hse_util/hdr_hist.h>
+#include <hse_util/minmax.h>
+#include <hse_util/parse_num.h>
+#include <hse_util/perfc.h>
+#include <hse_util/string.h>
+#include <hse_util/time.h>
+#include <hse_util/timing.h>
+#include <hse_util/xrand.h>
+#include <hse_util/yaml.h>
+
+#include <hse/hse.h>
+
+#include "cli_util.h"
+
+/*
+ * DOC: hse bench
+ *
+ * A closed- or open-loop load generator driving a single KVS through the
+ * public API from a configurable number of threads.  Each thread picks an
+ * operation per the workload's mix and a key per its distribution, and
+ * records the latency of each operation in a private HDR histogram.  The
+ * histograms are merged when the run completes.
+ *
+ * Keys are the little-endian encoding of a 64-bit record id padded out to
+ * the key length, so that consecutive ids are spread across the key space
+ * and a prefix of P bytes groups ids that agree in their low 8*P bits.
+ *
+ * In open-loop mode (a target rate was given) each thread issues its
+ * operations on a fixed schedule and latency is measured from the time an
+ * operation was scheduled to start, so that time spent queued behind a
+ * slow operation is charged to the operations it delayed.
+ */
+
+enum bench_op {
+    BENCH_OP_READ,
+    BENCH_OP_UPDATE,
+    BENCH_OP_INSERT,
+    BENCH_OP_SCAN,
+    BENCH_OP_RMW,
+    BENCH_OP_DELETE,
+    BENCH_OP_TXN,
+    BENCH_OP_PDEL,
+    BENCH_OP_MAX,
+};
+
+static const char *const bench_op_names[] = {
+    "read", "update", "insert", "scan", "rmw", "delete", "txn", "pdel",
+};
+
+enum bench_dist {
+    BENCH_DIST_UNIFORM,
+    BENCH_DIST_ZIPFIAN,
+    BENCH_DIST_LATEST,
+};
+
+static const char *const bench_dist_names[] = {
+    "uniform", "zipfian", "latest",
+};
+
+struct bench_workload {
+    const char *    bw_name;
+    const char *    bw_desc;
+    enum bench_dist bw_dist;
+    uint            bw_mix[BENCH_OP_MAX];
+};
+
+static const struct bench_workload bench_workloads[] = {
+    { "load", "insert all records", BENCH_DIST_UNIFORM, { [BENCH_OP_INSERT] = 100 } },
+    { "a", "50% read, 50% update", BENCH_DIST_ZIPFIAN,
+      { [BENCH_OP_READ] = 50, [BENCH_OP_UPDATE] = 50 } },
+    { "b", "95% read, 5% update", BENCH_DIST_ZIPFIAN,
+      { [BENCH_OP_READ] = 95, [BENCH_OP_UPDATE] = 5 } },
+    { "c", "100% read", BENCH_DIST_ZIPFIAN, { [BENCH_OP_READ] = 100 } },
+    { "d", "95% read latest, 5% insert", BENCH_DIST_LATEST,
+      { [BENCH_OP_READ] = 95, [BENCH_OP_INSERT] = 5 } },
+    { "e", "95% scan, 5% insert", BENCH_DIST_ZIPFIAN,
+      { [BENCH_OP_SCAN] = 95, [BENCH_OP_INSERT] = 5 } },
+    { "f", "50% read, 50% read-modify-write", BENCH_DIST_ZIPFIAN,
+      { [BENCH_OP_READ] = 50, [BENCH_OP_RMW] = 50 } },
+    { "scan", "100% scan", BENCH_DIST_UNIFORM, { [BENCH_OP_SCAN] = 100 } },
+    { "txn", "100% txn (2 reads + 2 updates)", BENCH_DIST_ZIPFIAN, { [BENCH_OP_TXN] = 100 } },
+    { "pdel", "90% insert, 10% prefix delete", BENCH_DIST_UNIFORM,
+      { [BENCH_OP_INSERT] = 90, [BENCH_OP_PDEL] = 10 } },
+};
+
+/* Scrambled zipfian generator per Gray et al, "Quickly Generating
+ * Billion-Record Synthetic Databases", as popularized by YCSB.
+ */
+struct bench_zipf {
+    u64    bz_n;
+    double bz_theta;
+    double bz_alpha;
+    double bz_zetan;
+    double bz_eta;
+    double bz_half_pow_theta;
+};
+
+#define BENCH_ZIPF_THETA (0.99)
+
+struct bench_thr;
+
+struct bench {
+    const struct bench_opts *b_opts;
+    struct hse_kvdb *        b_kvdb;
+    struct hse_kvs *         b_kvs;
+    uint                     b_mix[BENCH_OP_MAX]; /* cumulative percent */
+    enum bench_dist          b_dist;
+    struct bench_zipf        b_zipf;
+    bool                     b_load;
+    bool                     b_pdel;
+    size_t                   b_pfx_len;
+    u64                      b_records;
+    u64                      b_interval_ns;
+    u64                      b_deadline_ns;
+    atomic64_t               b_next_id;
+    atomic64_t               b_issued;
+    struct bench_thr *       b_thrv;
+};
+
+struct bench_thr {
+    struct bench *       bt_bench;
+    pthread_t            bt_tid;
+    uint                 bt_idx;
+    struct xrand         bt_xr;
+    struct hse_kvdb_txn *bt_txn;
+    char *               bt_kbuf;
+    char *               bt_vbuf;
+    char *               bt_rbuf;
+    u64                  bt_errv[BENCH_OP_MAX];
+    struct hdr_hist      bt_histv[BENCH_OP_MAX];
+};
+
+static void
+bench_zipf_init(struct bench_zipf *z, u64 n, double theta)
+{
+    double zeta2;
+    u64    i;
+
+    z->bz_n = n;
+    z->bz_theta = theta;
+    z->bz_alpha = 1.0 / (1.0 - theta);
+    z->bz_half_pow_theta = pow(0.5, theta);
+
+    z->bz_zetan = 0;
+    for (i = 1; i <= n; i++)
+        z->bz_zetan += 1.0 / pow((double)i, theta);
+
+    zeta2 = 1.0 + z->bz_half_pow_theta;
+    z->bz_eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / z->bz_zetan);
+}
+
+/* Returns a rank in [0, n), with rank 0 the most popular.
+ */
+static u64
+bench_zipf_next(const struct bench_zipf *z, struct xrand *xr)
+{
+    double u, uz;
+    u64    r;
+
+    u = (xrand64(xr) >> 11) * (1.0 / (1ul << 53));
+    uz = u * z->bz_zetan;
+
+    if (uz < 1.0)
+        return 0;
+    if (uz < 1.0 + z->bz_half_pow_theta)
+        return 1;
+
+    r = z->bz_n * pow(z->bz_eta * u - z->bz_eta + 1.0, z->bz_alpha);
+
+    return r < z->bz_n ? r : z->bz_n - 1;
+}
+
+static u64
+bench_key_id(struct bench_thr *t)
+{
+    struct bench *b = t->bt_bench;
+    u64           n = atomic64_read(&b->b_next_id);
+    u64           r;
+
+    if (n == 0)
+        return 0;
+
+    switch (b->b_dist) {
+    case BENCH_DIST_ZIPFIAN:
+        /* Scramble so that popular records are not clustered. */
+        r = bench_zipf_next(&b->b_zipf, &t->bt_xr);
+        return hse_hash64(&r, sizeof(r)) % n;
+
+    case BENCH_DIST_LATEST:
+        r = bench_zipf_next(&b->b_zipf, &t->bt_xr);
+        return r < n ? n - 1 - r : 0;
+
+    default:
+        return xrand64(&t->bt_xr) % n;
+    }
+}
+
+static void
+bench_key(struct bench_thr *t, u64 id)
+{
+    id = cpu_to_le64(id);
+    memcpy(t->bt_kbuf, &id, sizeof(id));
+}
+
+static size_t
+bench_vlen(struct bench_thr *t)
+{
+    const struct bench_opts *opts = t->bt_bench->b_opts;
+
+    if (opts->vlen_max <= opts->vlen_min)
+        return opts->vlen_min;
+
+    return opts->vlen_min + xrand64(&t->bt_xr) % (opts->vlen_max - opts->vlen_min + 1);
+}
+
+static hse_err_t
+bench_get(struct bench_thr *t, struct hse_kvdb_opspec *os, bool *found)
+{
+    struct bench *b = t->bt_bench;
+    size_t        vlen;
+
+    return hse_kvs_get(
+        b->b_kvs, os, t->bt_kbuf, b->b_opts->klen, found, t->bt_rbuf, b->b_opts->vlen_max, &vlen);
+}
+
+static hse_err_t
+bench_put(struct bench_thr *t, struct hse_kvdb_opspec *os)
+{
+    struct bench *b = t->bt_bench;
+
+    return hse_kvs_put(b->b_kvs, os, t->bt_kbuf, b->b_opts->klen, t->bt_vbuf, bench_vlen(t));
+}
+
+static hse_err_t
+bench_scan(struct bench_thr *t)
+{
+    struct bench *         b = t->bt_bench;
+    struct hse_kvs_cursor *cur;
+    const void *           key, *val;
+    size_t                 klen, vlen;
+    hse_err_t              err;
+    bool                   eof = false;
+    uint                   i;
+
+    err = hse_kvs_cursor_create(b->b_kvs, NULL, NULL, 0, &cur);
+    if (err)
+        return err;
+
+    err = hse_kvs_cursor_seek(cur, NULL, t->bt_kbuf, b->b_opts->klen, NULL, NULL);
+
+    for (i = 0; !err && !eof && i < b->b_opts->scanlen; i++)
+        err = hse_kvs_cursor_read(cur, NULL, &key, &klen, &val, &vlen, &eof);
+
+    hse_kvs_cursor_destroy(cur);
+
+    return err;
+}
+
+static hse_err_t
+bench_txn(struct bench_thr *t)
+{
+    struct bench *         b = t->bt_bench;
+    struct hse_kvdb_opspec os;
+    hse_err_t              err;
+    bool                   found;
+    int                    i;
+
+    HSE_KVDB_OPSPEC_INIT(&os);
+    os.kop_txn = t->bt_txn;
+
+    err = hse_kvdb_txn_begin(b->b_kvdb, t->bt_txn);
+    if (err)
+        return err;
+
+    for (i = 0; !err && i < 2; i++) {
+        bench_key(t, bench_key_id(t));
+        err = bench_get(t, &os, &found);
+    }
+
+    for (i = 0; !err && i < 2; i++) {
+        bench_key(t, bench_key_id(t));
+        err = bench_put(t, &os);
+    }
+
+    if (err) {
+        hse_kvdb_txn_abort(b->b_kvdb, t->bt_txn);
+        return err;
+    }
+
+    return hse_kvdb_txn_commit(b->b_kvdb, t->bt_txn);
+}
+
+static hse_err_t
+bench_op(struct bench_thr *t, enum bench_op op, u64 id)
+{
+    struct bench *b = t->bt_bench;
+    hse_err_t     err;
+    bool          found;
+
+    if (op != BENCH_OP_TXN)
+        bench_key(t, id);
+
+    switch (op) {
+    case BENCH_OP_READ:
+        return bench_get(t, NULL, &found);
+
+    case BENCH_OP_UPDATE:
+    case BENCH_OP_INSERT:
+        return bench_put(t, NULL);
+
+    case BENCH_OP_SCAN:
+        return bench_scan(t);
+
+    case BENCH_OP_RMW:
+        err = bench_get(t, NULL, &found);
+        return err ?: bench_put(t, NULL);
+
+    case BENCH_OP_DELETE:
+        return hse_kvs_delete(b->b_kvs, NULL, t->bt_kbuf, b->b_opts->klen);
+
+    case BENCH_OP_TXN:
+        return bench_txn(t);
+
+    case BENCH_OP_PDEL:
+        return hse_kvs_prefix_delete(b->b_kvs, NULL, t->bt_kbuf, b->b_pfx_len, NULL);
+
+    default:
+        assert(0);
+        return 0;
+    }
+}
+
+static void
+bench_sleep_until(u64 when_ns)
+{
+    struct timespec ts;
+    u64             now = get_time_ns();
+
+    if (when_ns <= now)
+        return;
+
+    when_ns -= now;
+    ts.tv_sec = when_ns / NSEC_PER_SEC;
+    ts.tv_nsec = when_ns % NSEC_PER_SEC;
+    nanosleep(&ts, NULL);
+}
+
+static void *
+bench_main(void *arg)
+{
+    struct bench_thr *       t = arg;
+    struct bench *           b = t->bt_bench;
+    const struct bench_opts *opts = b->b_opts;
+    u64                      next = 0;
+
+    while (1) {
+        enum bench_op op;
+        u64           start, id = 0;
+        uint          pct;
+        hse_err_t     err;
+
+        if (b->b_deadline_ns && get_time_ns() >= b->b_deadline_ns)
+            break;
+
+        if (!b->b_load && opts->ops && atomic64_inc_return(&b->b_issued) > opts->ops)
+            break;
+
+        pct = xrand64(&t->bt_xr) % 100;
+        for (op = 0; op < BENCH_OP_MAX - 1; op++)
+            if (pct < b->b_mix[op])
+                break;
+
+        if (op == BENCH_OP_INSERT) {
+            id = atomic64_inc_return(&b->b_next_id) - 1;
+            if (b->b_load && id >= b->b_records)
+                break;
+        } else {
+            id = bench_key_id(t);
+        }
+
+        if (b->b_interval_ns) {
+            if (!next)
+                next = get_time_ns();
+            bench_sleep_until(next);
+            start = next;
+            next += b->b_interval_ns;
+        } else {
+            start = get_time_ns();
+        }
+
+        err = bench_op(t, op, id);
+        if (err)
+            t->bt_errv[op]++;
+
+        hdr_hist_record(&t->bt_histv[op], get_time_ns() - start);
+    }
+
+    return NULL;
+}
+
+static int
+bench_parse_mix(const char *mix, uint *mixv)
+{
+    char *str, *tok, *next;
+    uint  total = 0;
+    int   rc = 0;
+
+    str = strdup(mix);
+    if (!str)
+        return ENOMEM;
+
+    memset(mixv, 0, sizeof(*mixv) * BENCH_OP_MAX);
+
+    for (next = str; !rc && (tok = strsep(&next, ","));) {
+        char *val = strchr(tok, '=');
+        uint  op, pct;
+
+        if (!val || parse_uint(val + 1, &pct)) {
+            rc = EINVAL;
+            break;
+        }
+
+        *val = '\0';
+
+        for (op = 0; op < BENCH_OP_MAX; op++)
+            if (!strcmp(tok, bench_op_names[op]))
+                break;
+
+        if (op == BENCH_OP_MAX) {
+            rc = EINVAL;
+            break;
+        }
+
+        mixv[op] += pct;
+        total += pct;
+    }
+
+    free(str);
+
+    return rc ?: (total == 100 ? 0 : EINVAL);
+}
+
+/*----------------------------------------------------------------
+ * Engine perfc deltas
+ */
+
+struct bench_perfc {
+    char *bp_name;
+    u64   bp_value;
+};
+
+struct bench_perfcv {
+    struct bench_perfc *bpv_v;
+    uint                bpv_c;
+    uint                bpv_max;
+};
+
+/* Snapshot every cumulative perfc value (counter "value", rate "curr",
+ * and latency/distribution "sum" and "hitcnt") in the data tree.
+ */
+static void
+bench_perfc_snap(struct bench_perfcv *pv)
+{
+    union dt_iterate_parameters dip;
+    struct yaml_context         yc = {};
+    char                        path[DT_PATH_LEN] = "", name[DT_PATH_LEN] = "";
+    char                        full[DT_PATH_LEN * 2 + 16];
+    char *                      buf, *line, *next;
+    size_t                      bufsz = 8 << 20;
+
+    pv->bpv_c = 0;
+
+    buf = malloc(bufsz);
+    if (!buf)
+        return;
+
+    yc.yaml_buf = buf;
+    yc.yaml_buf_sz = bufsz;
+    dip.yc = &yc;
+
+    dt_iterate_cmd(dt_data_tree, DT_OP_EMIT, PERFC_ROOT_PATH, &dip, NULL, NULL, NULL);
+    buf[min_t(size_t, yc.yaml_offset, bufsz - 1)] = '\0';
+
+    for (next = buf; (line = strsep(&next, "\n"));) {
+        char *key, *val;
+        u64   v;
+
+        key = line + strspn(line, " -");
+        val = strstr(key, ": ");
+        if (!val)
+            continue;
+
+        *val = '\0';
+        val += 2;
+
+        if (!strcmp(key, "path")) {
+            strlcpy(path, val, sizeof(path));
+            continue;
+        }
+
+        if (!strcmp(key, "name")) {
+            strlcpy(name, val, sizeof(name));
+            continue;
+        }
+
+        if (strcmp(key, "value") && strcmp(key, "curr") && strcmp(key, "sum") &&
+            strcmp(key, "hitcnt"))
+            continue;
+
+        if (parse_u64(val, &v))
+            continue;
+
+        if (pv->bpv_c == pv->bpv_max) {
+            uint  max = pv->bpv_max ? pv->bpv_max * 2 : 1024;
+            void *p = realloc(pv->bpv_v, max * sizeof(*pv->bpv_v));
+
+            if (!p)
+                break;
+
+            pv->bpv_v = p;
+            pv->bpv_max = max;
+        }
+
+        snprintf(full, sizeof(full), "%s/%s.%s", path, name, key);
+
+        pv->bpv_v[pv->bpv_c].bp_name = strdup(full);
+        if (!pv->bpv_v[pv->bpv_c].bp_name)
+            break;
+
+        pv->bpv_v[pv->bpv_c++].bp_value = v;
+    }
+
+    free(buf);
+}
+
+static void
+bench_perfc_free(struct bench_perfcv *pv)
+{
+    uint i;
+
+    for (i = 0; i < pv->bpv_c; i++)
+        free(pv->bpv_v[i].bp_name);
+    free(pv->bpv_v);
+}
+
+static void
+bench_perfc_report(const struct bench_perfcv *before, const struct bench_perfcv *after)
+{
+    uint i, j = 0, n = 0;
+
+    for (i = 0; i < after->bpv_c; i++) {
+        const struct bench_perfc *a = after->bpv_v + i;
+        const char *              name;
+        u64                       prev = 0;
+        uint                      k;
+
+        /* Counter sets rarely come or go during a run, so the entries
+         * almost always line up.  Fall back to a search if not.
+         */
+        if (j < before->bpv_c && !strcmp(before->bpv_v[j].bp_name, a->bp_name)) {
+            prev = before->bpv_v[j++].bp_value;
+        } else {
+            for (k = 0; k < before->bpv_c; k++) {
+                if (!strcmp(before->bpv_v[k].bp_name, a->bp_name)) {
+                    prev = before->bpv_v[k].bp_value;
+                    j = k + 1;
+                    break;
+                }
+            }
+        }
+
+        if (a->bp_value == prev)
+            continue;
+
+        if (n++ == 0)
+            printf("perfc:\n");
+
+        name = a->bp_name;
+        if (!strncmp(name, PERFC_ROOT_PATH "/", strlen(PERFC_ROOT_PATH) + 1))
+            name += strlen(PERFC_ROOT_PATH) + 1;
+
+        printf("  %s: %ld\n", name, (long)(a->bp_value - prev));
+    }
+}
+
+/*----------------------------------------------------------------
+ * Report
+ */
+
+static void
+bench_report(struct bench *b, u64 elapsed_ns)
+{
+    const struct bench_opts *opts = b->b_opts;
+    static const uint        ppmv[] = { 500000, 900000, 990000, 999000, 999900 };
+    struct hdr_hist *        hh;
+    u64                      total = 0;
+    uint                     op, i;
+
+    hh = malloc(sizeof(*hh));
+    if (!hh)
+        return;
+
+    printf(
+        "%-8s %10s %10s %9s %9s %9s %9s %9s %9s %9s %8s\n",
+        "op", "count", "ops/s", "mean_us", "p50_us", "p90_us", "p99_us",
+        "p99.9_us", "p99.99_us", "max_us", "errors");
+
+    for (op = 0; op < BENCH_OP_MAX; op++) {
+        u64 errs = 0;
+
+        hdr_hist_init(hh);
+        for (i = 0; i < opts->threads; i++) {
+            hdr_hist_merge(hh, &b->b_thrv[i].bt_histv[op]);
+            errs += b->b_thrv[i].bt_errv[op];
+        }
+
+        if (!hh->hh_count)
+            continue;
+
+        total += hh->hh_count;
+
+        printf(
+            "%-8s %10lu %10lu %9.1f",
+            bench_op_names[op],
+            (ulong)hh->hh_count,
+            (ulong)(hh->hh_count * NSEC_PER_SEC / elapsed_ns),
+            hh->hh_sum / 1000.0 / hh->hh_count);
+
+        for (i = 0; i < NELEM(ppmv); i++)
+            printf(" %9.1f", hdr_hist_pctile(hh, ppmv[i]) / 1000.0);
+
+        printf(" %9.1f %8lu\n", hh->hh_max / 1000.0, (ulong)errs);
+    }
+
+    printf(
+        "%-8s %10lu %10lu  (%u threads, %.2f s, %s)\n",
+        "total",
+        (ulong)total,
+        (ulong)(total * NSEC_PER_SEC / elapsed_ns),
+        opts->threads,
+        elapsed_ns / 1e9,
+        b->b_interval_ns ? "open loop" : "closed loop");
+
+    free(hh);
+}
+
+/*----------------------------------------------------------------
+ * Setup and teardown
+ */
+
+static int
+bench_setup(struct bench *b, const struct bench_opts *opts)
+{
+    const struct bench_workload *wl = NULL;
+    uint                         mixv[BENCH_OP_MAX];
+    uint                         i, sum;
+
+    for (i = 0; i < NELEM(bench_workloads); i++) {
+        if (!strcmp(opts->workload, bench_workloads[i].bw_name)) {
+            wl = bench_workloads + i;
+            break;
+        }
+    }
+
+    if (!wl) {
+        fprintf(stderr, "bench: invalid workload '%s', expected one of:\n", opts->workload);
+        for (i = 0; i < NELEM(bench_workloads); i++)
+            fprintf(stderr, "  %-6s %s\n", bench_workloads[i].bw_name, bench_workloads[i].bw_desc);
+        return EX_USAGE;
+    }
+
+    memcpy(mixv, wl->bw_mix, sizeof(mixv));
+    b->b_dist = wl->bw_dist;
+    b->b_load = !strcmp(wl->bw_name, "load");
+
+    if (opts->mix) {
+        if (bench_parse_mix(opts->mix, mixv)) {
+            fprintf(
+                stderr,
+                "bench: invalid mix '%s', expected <op>=<pct>,... summing to 100"
+                " with <op> one of read, update, insert, scan, rmw, delete, txn, pdel\n",
+                opts->mix);
+            return EX_USAGE;
+        }
+        b->b_load = false;
+    }
+
+    if (opts->dist) {
+        for (i = 0; i < NELEM(bench_dist_names); i++)
+            if (!strcmp(opts->dist, bench_dist_names[i]))
+                break;
+
+        if (i == NELEM(bench_dist_names)) {
+            fprintf(stderr, "bench: invalid distribution '%s'\n", opts->dist);
+            return EX_USAGE;
+        }
+        b->b_dist = i;
+    }
+
+    if (opts->klen < sizeof(u64) || opts->klen > HSE_KVS_KLEN_MAX) {
+        fprintf(stderr, "bench: key length must be in [%zu..%u]\n", sizeof(u64), HSE_KVS_KLEN_MAX);
+        return EX_USAGE;
+    }
+
+    if (opts->vlen_min > opts->vlen_max || opts->vlen_max > HSE_KVS_VLEN_MAX) {
+        fprintf(stderr, "bench: invalid value length range\n");
+        return EX_USAGE;
+    }
+
+    if (!opts->threads || !opts->records) {
+        fprintf(stderr, "bench: threads and records must be non-zero\n");
+        return EX_USAGE;
+    }
+
+    for (i = sum = 0; i < BENCH_OP_MAX; i++) {
+        sum += mixv[i];
+        b->b_mix[i] = sum;
+    }
+
+    b->b_pdel = mixv[BENCH_OP_PDEL] > 0;
+    b->b_opts = opts;
+    b->b_records = opts->records;
+
+    /* A load inserts ids [0, records), everything else runs against
+     * the records a prior load inserted.
+     */
+    atomic64_set(&b->b_next_id, b->b_load ? 0 : opts->records);
+    atomic64_set(&b->b_issued, 0);
+
+    if (opts->rate)
+        b->b_interval_ns = max_t(u64, 1, NSEC_PER_SEC * opts->threads / opts->rate);
+
+    if (b->b_dist != BENCH_DIST_UNIFORM)
+        bench_zipf_init(&b->b_zipf, opts->records, BENCH_ZIPF_THETA);
+
+    return 0;
+}
+
+static merr_t
+bench_thr_init(struct bench *b, struct bench_thr *t, uint idx)
+{
+    const struct bench_opts *opts = b->b_opts;
+    uint                     i;
+
+    t->bt_bench = b;
+    t->bt_idx = idx;
+    xrand_init(&t->bt_xr, opts->seed + idx);
+
+    for (i = 0; i < BENCH_OP_MAX; i++)
+        hdr_hist_init(&t->bt_histv[i]);
+
+    t->bt_kbuf = malloc(opts->klen);
+    t->bt_vbuf = malloc(opts->vlen_max + 1);
+    t->bt_rbuf = malloc(opts->vlen_max + 1);
+    if (!t->bt_kbuf || !t->bt_vbuf || !t->bt_rbuf)
+        return merr(ENOMEM);
+
+    memset(t->bt_kbuf, 'k', opts->klen);
+    for (i = 0; i <= opts->vlen_max; i++)
+        t->bt_vbuf[i] = xrand64(&t->bt_xr);
+
+    t->bt_txn = hse_kvdb_txn_alloc(b->b_kvdb);
+    if (!t->bt_txn)
+        return merr(ENOMEM);
+
+    return 0;
+}
+
+static void
+bench_thr_fini(struct bench *b, struct bench_thr *t)
+{
+    if (t->bt_txn)
+        hse_kvdb_txn_free(b->b_kvdb, t->bt_txn);
+    free(t->bt_kbuf);
+    free(t->bt_vbuf);
+    free(t->bt_rbuf);
+}
+
+int
+kvs_bench(const char *kvdb, const char *kvs, struct hse_params *params, const struct bench_opts *opts)
+{
+    struct bench_perfcv before = {}, after = {};
+    struct merr_info    info;
+    struct bench        b = {};
+    merr_t              err;
+    u64                 start, elapsed;
+    uint                i, started = 0;
+    int                 rc;
+
+    rc = bench_setup(&b, opts);
+    if (rc) {
+        hse_params_destroy(params);
+        return rc;
+    }
+
+    err = hse_kvdb_open(kvdb, params, &b.b_kvdb);
+    if (err) {
+        fprintf(stderr, "kvdb open %s failed: %s\n", kvdb, merr_info(err, &info));
+        hse_params_destroy(params);
+        return -1;
+    }
+
+    err = hse_kvdb_kvs_open(b.b_kvdb, kvs, params, &b.b_kvs);
+    if (err) {
+        fprintf(stderr, "kvs open %s/%s failed: %s\n", kvdb, kvs, merr_info(err, &info));
+        goto out;
+    }
+
+    if (b.b_pdel) {
+        /* Only interested in the KVS prefix length here. */
+        hse_kvs_prefix_delete(b.b_kvs, NULL, NULL, 0, &b.b_pfx_len);
+        if (!b.b_pfx_len || b.b_pfx_len > opts->klen) {
+            fprintf(stderr, "bench: pdel needs a KVS with pfx_len in [1..%u]\n", opts->klen);
+            err = merr(EINVAL);
+            goto out;
+        }
+    }
+
+    b.b_thrv = calloc(opts->threads, sizeof(*b.b_thrv));
+    if (!b.b_thrv) {
+        err = merr(ENOMEM);
+        goto out;
+    }
+
+    for (i = 0; i < opts->threads; i++) {
+        err = bench_thr_init(&b, &b.b_thrv[i], i);
+        if (err) {
+            fprintf(stderr, "bench: thread init failed: %s\n", merr_info(err, &info));
+            goto out;
+        }
+    }
+
+    bench_perfc_snap(&before);
+
+    start = get_time_ns();
+    if (opts->duration)
+        b.b_deadline_ns = start + opts->duration * NSEC_PER_SEC;
+
+    for (i = 0; i < opts->threads; i++) {
+        rc = pthread_create(&b.b_thrv[i].bt_tid, NULL, bench_main, &b.b_thrv[i]);
+        if (rc) {
+            fprintf(stderr, "bench: pthread_create failed: %s\n", strerror(rc));
+            err = merr(rc);
+            break;
+        }
+        started++;
+    }
+
+    for (i = 0; i < started; i++)
+        pthread_join(b.b_thrv[i].bt_tid, NULL);
+
+    elapsed = max_t(u64, 1, get_time_ns() - start);
+
+    if (!err) {
+        bench_report(&b, elapsed);
+
+        bench_perfc_snap(&after);
+        bench_perfc_report(&before, &after);
+    }
+
+out:
+    if (b.b_thrv) {
+        for (i = 0; i < opts->threads; i++)
+            bench_thr_fini(&b, &b.b_thrv[i]);
+        free(b.b_thrv);
+    }
+
+    bench_perfc_free(&before);
+    bench_perfc_free(&after);
+
+    if (b.b_kvs)
+        hse_kvdb_kvs_close(b.b_kvs);
+    hse_kvdb_close(b.b_kvdb);
+    hse_params_destroy(params);
+
+    return err ? -1 : 0;
+}
@@ -25,4 +25,43 @@ kvdb_compact_request(
     struct hse_params *params,
     const char *       request_type,
     unsigned           timeout_sec);
+
+/**
+ * struct bench_opts - hse bench options
+ * @workload: name of a canned workload (e.g., "load", "a" through "f")
+ * @mix:      custom op mix ("read=90,update=10"), overrides the workload's
+ * @dist:     key distribution (uniform, zipfian or latest), NULL for default
+ * @threads:  number of worker threads
+ * @records:  number of records loaded or assumed loaded
+ * @ops:      total operations to issue (0 for no limit)
+ * @duration: run time limit in seconds (0 for no limit)
+ * @rate:     target ops/sec across all threads (0 for closed loop)
+ * @seed:     random seed
+ * @klen:     key length
+ * @vlen_min: minimum value length
+ * @vlen_max: maximum value length
+ * @scanlen:  number of records read per scan
+ */
+struct bench_opts {
+    const char *workload;
+    const char *mix;
+    const char *dist;
+    unsigned    threads;
+    uint64_t    records;
+    uint64_t    ops;
+    uint64_t    duration;
+    uint64_t    rate;
+    uint64_t    seed;
+    unsigned    klen;
+    unsigned    vlen_min;
+    unsigned    vlen_max;
+    unsigned    scanlen;
+};
+
+int
+kvs_bench(
+    const char *             kvdb,
+    const char *             kvs,
+    struct hse_params *      params,
+    const struct bench_opts *opts);
 #endif
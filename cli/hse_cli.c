@@ -104,10 +104,10 @@ struct name_desc {
 
 struct cmd_spec {
     const char *           usagev[4];
-    const struct name_desc optionv[8];
+    const struct name_desc optionv[16];
     const struct name_desc configv[8];
-    const struct option    longoptv[8];
-    const char *           extra_help[8];
+    const struct option    longoptv[16];
+    const char *           extra_help[16];
 };
 
 typedef int(cli_cmd_func_t)(struct cli_cmd *self, struct cli *cli);
@@ -171,12 +171,15 @@ struct cli_cmd        cli_hse_kvs_commands[] = {
  *    hse version
  *    hse kvdb
  *    hse kvs
+ *    hse bench
  */
 static cli_cmd_func_t cli_hse_kvdb;
 static cli_cmd_func_t cli_hse_kvs;
+static cli_cmd_func_t cli_hse_bench;
 struct cli_cmd        cli_hse_commands[] = {
     { "kvdb", "KVDB commands", cli_hse_kvdb, cli_hse_kvdb_commands },
     { "kvs", "KVS commands", cli_hse_kvs, cli_hse_kvs_commands },
+    { "bench", "Benchmark a KVS", cli_hse_bench, 0 },
     { 0 },
 };
 
@@ -1379,6 +1382,236 @@ cli_hse_kvs_destroy(struct cli_cmd *self, struct cli *cli)
     return rc;
 }
 
+static int
+cli_hse_bench_impl(
+    struct cli *             cli,
+    const char *             cfile,
+    const char *             kvdb,
+    const char *             kvs,
+    const struct bench_opts *opts)
+{
+    struct hse_params *hp = 0;
+
+    if (cli_hse_init(cli))
+        return -1;
+
+    hp = parse_cmdline_hse_params(cli, cfile, "kvdb.excl=1", 0);
+    if (!hp)
+        return EX_USAGE;
+
+    return kvs_bench(kvdb, kvs, hp, opts);
+}
+
+static int
+cli_hse_bench_parse_u64(struct cli_cmd *self, const char *arg, uint64_t *result)
+{
+    if (parse_u64(arg, result)) {
+        fprintf(
+            stderr,
+            STR("%s: unable to parse"
+                " '%s' as an unsigned 64-bit"
+                " scalar value\n"),
+            self->cmd_path,
+            arg);
+        return EX_USAGE;
+    }
+
+    return 0;
+}
+
+static int
+cli_hse_bench_parse_u32(struct cli_cmd *self, const char *arg, uint32_t *result)
+{
+    if (parse_u32(arg, result)) {
+        fprintf(
+            stderr,
+            STR("%s: unable to parse"
+                " '%s' as an unsigned 32-bit"
+                " scalar value\n"),
+            self->cmd_path,
+            arg);
+        return EX_USAGE;
+    }
+
+    return 0;
+}
+
+static int
+cli_hse_bench(struct cli_cmd *self, struct cli *cli)
+{
+    const struct cmd_spec spec = {
+        .usagev =
+            {
+                "[options] <kvdb>/<kvs> [<config_param>=<value>]...",
+                NULL,
+            },
+        .optionv =
+            {
+                OPTION_HELP,
+                OPTION_CFILE,
+                { "[-w|--workload NAME]", "Run workload NAME (load, a-f, scan, txn, pdel), default: a" },
+                { "[-m|--mix MIX]", "Run a custom op mix, e.g. read=90,update=10" },
+                { "[-D|--dist DIST]", "Key distribution: uniform, zipfian or latest" },
+                { "[-t|--threads N]", "Use N worker threads, default: 4" },
+                { "[-n|--records N]", "Number of records to load or run against, default: 1000000" },
+                { "[-o|--ops N]", "Stop after N operations" },
+                { "[-d|--duration SECS]", "Stop after SECS seconds" },
+                { "[-r|--rate OPS]", "Issue OPS ops/sec (open loop), default: as fast as possible" },
+                { "[-k|--klen LEN]", "Key length, default: 16" },
+                { "[-l|--vlen MIN[:MAX]]", "Value length or range, default: 100" },
+                { "[-s|--scanlen N]", "Records read per scan, default: 100" },
+                { "[-S|--seed N]", "Random seed" },
+                { NULL },
+            },
+        .longoptv =
+            {
+                { "help", no_argument, 0, 'h' },
+                { "config", required_argument, 0, 'c' },
+                { "workload", required_argument, 0, 'w' },
+                { "mix", required_argument, 0, 'm' },
+                { "dist", required_argument, 0, 'D' },
+                { "threads", required_argument, 0, 't' },
+                { "records", required_argument, 0, 'n' },
+                { "ops", required_argument, 0, 'o' },
+                { "duration", required_argument, 0, 'd' },
+                { "rate", required_argument, 0, 'r' },
+                { "klen", required_argument, 0, 'k' },
+                { "vlen", required_argument, 0, 'l' },
+                { "scanlen", required_argument, 0, 's' },
+                { "seed", required_argument, 0, 'S' },
+                { NULL },
+            },
+        .configv =
+            {
+                { NULL },
+            },
+        .extra_help = {
+            "Workloads a through f follow YCSB: a is 50% read/50% update, b is",
+            "95% read/5% update, c is read only, d reads the latest inserts, e is",
+            "95% scan/5% insert and f is 50% read/50% read-modify-write.  Run the",
+            "load workload first to populate the KVS with the same --records,",
+            "--klen and --vlen.  With no --ops or --duration, a run issues as",
+            "many operations as there are records.",
+            "",
+            "Latency percentiles are reported per op in microseconds, followed by",
+            "the change in each engine performance counter during the run.",
+            NULL,
+        },
+    };
+
+    struct bench_opts opts = {
+        .workload = "a",
+        .threads = 4,
+        .records = 1000 * 1000,
+        .klen = 16,
+        .vlen_min = 100,
+        .vlen_max = 100,
+        .scanlen = 100,
+    };
+
+    const char *cfile = 0;
+    const char *kvdb_arg = 0;
+    char *      kvdb = 0;
+    char *      kvs = 0;
+    char *      sep;
+    bool        help = false;
+    int         c, rc = 0;
+
+    if (cli_hook(cli, self, &spec))
+        return 0;
+
+    opts.seed = getpid();
+
+    while (!rc && -1 != (c = cli_getopt(cli))) {
+        switch (c) {
+            case 'h':
+                help = true;
+                break;
+            case 'c':
+                cfile = optarg;
+                break;
+            case 'w':
+                opts.workload = optarg;
+                break;
+            case 'm':
+                opts.mix = optarg;
+                break;
+            case 'D':
+                opts.dist = optarg;
+                break;
+            case 't':
+                rc = cli_hse_bench_parse_u32(self, optarg, &opts.threads);
+                break;
+            case 'n':
+                rc = cli_hse_bench_parse_u64(self, optarg, &opts.records);
+                break;
+            case 'o':
+                rc = cli_hse_bench_parse_u64(self, optarg, &opts.ops);
+                break;
+            case 'd':
+                rc = cli_hse_bench_parse_u64(self, optarg, &opts.duration);
+                break;
+            case 'r':
+                rc = cli_hse_bench_parse_u64(self, optarg, &opts.rate);
+                break;
+            case 'k':
+                rc = cli_hse_bench_parse_u32(self, optarg, &opts.klen);
+                break;
+            case 'l':
+                sep = strchr(optarg, ':');
+                if (sep)
+                    *sep++ = '\0';
+                rc = cli_hse_bench_parse_u32(self, optarg, &opts.vlen_min);
+                opts.vlen_max = opts.vlen_min;
+                if (!rc && sep)
+                    rc = cli_hse_bench_parse_u32(self, sep, &opts.vlen_max);
+                break;
+            case 's':
+                rc = cli_hse_bench_parse_u32(self, optarg, &opts.scanlen);
+                break;
+            case 'S':
+                rc = cli_hse_bench_parse_u64(self, optarg, &opts.seed);
+                break;
+            default:
+                return EX_USAGE;
+        }
+    }
+
+    if (rc)
+        return rc;
+
+    kvdb_arg = cli_next_arg(cli);
+
+    if (!kvdb_arg || help) {
+        cmd_print_help(self, help_style_usage, help ? stdout : stderr);
+        return help ? 0 : EX_USAGE;
+    }
+
+    if (!opts.ops && !opts.duration && strcmp(opts.workload, "load"))
+        opts.ops = opts.records;
+
+    /* clone to modify */
+    kvdb = strdup(kvdb_arg);
+    if (!kvdb) {
+        fprintf(stderr, "%s: out of memory\n", self->cmd_path);
+        return -1;
+    }
+
+    kvs = strchr(kvdb, '/');
+    if (!kvs) {
+        fprintf(stderr, "%s: invalid usage for <kvdb>/<kvs>: '%s'\n", self->cmd_path, kvdb);
+        free(kvdb);
+        return -1;
+    }
+
+    *kvs++ = '\0';
+
+    rc = cli_hse_bench_impl(cli, cfile, kvdb, kvs, &opts);
+
+    free(kvdb);
+    return rc;
+}
+
 static int
 cli_hse_kvs(struct cli_cmd *self, struct cli *cli)
 {
@@ -124,6 +124,7 @@ struct hse_kvdb_opspec {
 #define HSE_KVDB_KOP_FLAG_BIND_TXN 0x02    /**< cursor bound to transaction */
 #define HSE_KVDB_KOP_FLAG_STATIC_VIEW 0x04 /**< bound cursor's view is static */
 #define HSE_KVDB_KOP_FLAG_PRIORITY 0x08    /**< op won't be throttled @see, hse_kvs_put */
+#define HSE_KVDB_KOP_FLAG_KEYS_ONLY 0x10   /**< cursor returns keys and value lengths only */
 
 /**@}*/
 
@@ -693,6 +694,10 @@ hse_kvdb_txn_get_state(struct hse_kvdb *kvdb, struct hse_kvdb_txn *txn);
  * the mutations of the transaction, if any. Note that this will make any other
  * mutations that occurred during the lifespan of the transaction visible as well.
  *
+ * If the HSE_KVDB_KOP_FLAG_KEYS_ONLY flag is set then the cursor returns each key with
+ * the length of its value but not the value itself, and value data is never read from
+ * media.  Like its direction, a cursor's keys-only mode is determined when it is created.
+ *
  * @param kvs:      KVS to iterate over, handle from hse_kvdb_kvs_open()
  * @param opspec:   Optional flags, optional txn
  * @param filt:     Optional: iteration limited to keys matching this prefix filter
@@ -798,7 +803,7 @@ hse_kvs_cursor_seek_range(
  * @param opspec:  Ignored; may be zero
  * @param key:     [out] Next key in sequence
  * @param key_len: [out] Length of key
- * @param val:     [out] Next value in sequence
+ * @param val:     [out] Next value in sequence (NULL for a keys-only cursor)
  * @param val_len: [out] Length of value
  * @param eof:     [out] If true, no more key/value pairs in sequence
  * @return The function's error status
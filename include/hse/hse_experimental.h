@@ -100,6 +100,84 @@ hse_kvs_prefix_probe_exp(
     size_t                      valbuf_sz,
     size_t *                    val_len);
 
+/**
+ * struct hse_kvs_cursor_rec - a key/value pair returned by hse_kvs_cursor_read_batch_exp()
+ * @kcr_key:     Key data (within the caller's buffer)
+ * @kcr_key_len: Length of key
+ * @kcr_val:     Value data (within the caller's buffer, NULL for a keys-only cursor)
+ * @kcr_val_len: Length of value
+ */
+struct hse_kvs_cursor_rec {
+    const void *kcr_key;
+    size_t      kcr_key_len;
+    const void *kcr_val;
+    size_t      kcr_val_len;
+};
+
+/**
+ * Read a batch of key/value pairs from the cursor
+ *
+ * Copy up to "rec_max" key/value pairs into "buf", advancing the cursor past each pair
+ * copied, and describe them in "recv".  The batch ends early if the next pair does not
+ * fit in the remaining space in "buf", in which case the cursor is positioned at that
+ * pair.  If not even the first pair fits then ENOSPC is returned.  This function is
+ * thread safe across disparate cursors.
+ *
+ * @param cursor:  Cursor handle from hse_kvs_cursor_create()
+ * @param opspec:  Ignored; may be zero
+ * @param buf:     Buffer into which keys and values are copied
+ * @param buf_sz:  Size of @buf
+ * @param recv:    [out] Vector of key/value pairs read
+ * @param rec_max: Max number of elements in @recv
+ * @param rec_cnt: [out] Number of key/value pairs read
+ * @param eof:     [out] If true, no more key/value pairs in sequence
+ * @return The function's error status
+ */
+hse_err_t
+hse_kvs_cursor_read_batch_exp(
+    struct hse_kvs_cursor *    cursor,
+    struct hse_kvdb_opspec *   opspec,
+    void *                     buf,
+    size_t                     buf_sz,
+    struct hse_kvs_cursor_rec *recv,
+    size_t                     rec_max,
+    size_t *                   rec_cnt,
+    bool *                     eof);
+
+/**
+ * struct hse_kvs_cursor_pred - a scan predicate for hse_kvs_cursor_pred_set_exp()
+ * @kcp_key_sfx:     Required key suffix (NULL if none)
+ * @kcp_key_sfx_len: Length of @kcp_key_sfx
+ * @kcp_val_max:     Max value length (0 if unlimited)
+ * @kcp_val_pat:     Required value bytes (NULL if none)
+ * @kcp_val_pat_len: Length of @kcp_val_pat
+ * @kcp_val_pat_off: Offset within the value at which @kcp_val_pat must appear
+ */
+struct hse_kvs_cursor_pred {
+    const void *kcp_key_sfx;
+    size_t      kcp_key_sfx_len;
+    size_t      kcp_val_max;
+    const void *kcp_val_pat;
+    size_t      kcp_val_pat_len;
+    size_t      kcp_val_pat_off;
+};
+
+/**
+ * Set or clear a cursor's scan predicate
+ *
+ * Key/value pairs that do not satisfy the predicate are skipped by subsequent cursor
+ * reads.  The key suffix and value length tests are applied before values are read
+ * from media, so rejected values are never fetched.  The buffers referenced by "pred"
+ * must remain valid until the predicate is cleared or the cursor is destroyed.  This
+ * function is thread safe across disparate cursors.
+ *
+ * @param cursor: Cursor handle from hse_kvs_cursor_create()
+ * @param pred:   Predicate to apply, or NULL to clear the current predicate
+ * @return The function's error status
+ */
+hse_err_t
+hse_kvs_cursor_pred_set_exp(struct hse_kvs_cursor *cursor, const struct hse_kvs_cursor_pred *pred);
+
 /**
  * Retrieve the last error message
  *
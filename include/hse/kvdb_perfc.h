@@ -101,6 +101,8 @@ enum kvdb_perfc_sidx_sp3 {
     PERFC_BA_SP3_LSIZE_TARG,
     PERFC_BA_SP3_RSIZE_CURR,
     PERFC_BA_SP3_RSIZE_TARG,
+    PERFC_BA_SP3_IORATE,
+    PERFC_BA_SP3_IOLAT,
     PERFC_EN_SP3
 };
 
@@ -154,7 +156,7 @@ enum kvdb_perfc_compact {
     PERFC_DI_CNCOMP_VBCNT,
     PERFC_DI_CNCOMP_VBUTIL,
     PERFC_DI_CNCOMP_VBDEAD,
-    PERFC_LT_CNCOMP_TOTAL,
+    PERFC_HG_CNCOMP_TOTAL,
     PERFC_DI_CNCOMP_VGET,
     PERFC_EN_CNCOMP
 };
@@ -230,6 +232,7 @@ enum kvdb_perfc_sidx_cursorcache {
     PERFC_BA_CC_TOMB_SKIPLEN,
     PERFC_BA_CC_TOMB_SPAN_ADD,
     PERFC_BA_CC_TOMB_SPAN_TIME,
+    PERFC_BA_CC_PRED_SKIP,
     PERFC_EN_CC
 };
 
@@ -252,8 +255,8 @@ enum kvdb_perfc_sidx_cursordist {
 
 /* "PKVSL" stands for Public KVS interface Latencies" */
 enum kvdb_perfc_sidx_pkvsl {
-    PERFC_LT_PKVSL_KVS_PUT,
-    PERFC_LT_PKVSL_KVS_GET,
+    PERFC_HG_PKVSL_KVS_PUT,
+    PERFC_HG_PKVSL_KVS_GET,
     PERFC_LT_PKVSL_KVS_DEL,
 
     PERFC_LT_PKVSL_KVS_PFX_PROBE,
@@ -261,9 +264,10 @@ enum kvdb_perfc_sidx_pkvsl {
 
     PERFC_LT_PKVSL_KVS_CURSOR_CREATE,
     PERFC_LT_PKVSL_KVS_CURSOR_UPDATE,
-    PERFC_LT_PKVSL_KVS_CURSOR_SEEK,
-    PERFC_LT_PKVSL_KVS_CURSOR_READFWD,
-    PERFC_LT_PKVSL_KVS_CURSOR_READREV,
+    PERFC_HG_PKVSL_KVS_CURSOR_SEEK,
+    PERFC_HG_PKVSL_KVS_CURSOR_READFWD,
+    PERFC_HG_PKVSL_KVS_CURSOR_READREV,
+    PERFC_HG_PKVSL_KVS_CURSOR_READBATCH,
     PERFC_LT_PKVSL_KVS_CURSOR_DESTROY,
 
     PERFC_EN_PKVSL,
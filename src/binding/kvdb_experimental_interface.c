@@ -9,6 +9,7 @@
 #include <hse/hse_experimental.h>
 
 #include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/kvs.h>
 #include <hse_ikvdb/hse_params_internal.h>
 #include <hse_ikvdb/kvdb_perfc.h>
 
@@ -114,6 +115,7 @@ hse_kvs_prefix_probe_exp(
     struct kvs_buf      kbuf, vbuf;
     enum key_lookup_res res;
     merr_t              err = 0;
+    u64                 tstart;
     u64 sum             __maybe_unused;
 
     if (!handle || !pfx || !pfx_len || !found || !val_len)
@@ -140,9 +142,22 @@ hse_kvs_prefix_probe_exp(
     kvs_buf_init(&kbuf, keybuf, keybuf_sz);
     kvs_buf_init(&vbuf, valbuf, valbuf_sz);
 
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_pfx_probe(handle, os, &kt, &res, &kbuf, &vbuf);
-    if (ev(err))
+    if (ev(err)) {
+        if (tstart)
+            ikvdb_kvs_optrace(
+                handle,
+                KVDB_OPTRACE_PFX_PROBE,
+                os ? os->kop_txn : NULL,
+                pfx,
+                pfx_len,
+                0,
+                tstart,
+                err);
         return err;
+    }
 
     sum = 0;
 
@@ -168,11 +183,168 @@ hse_kvs_prefix_probe_exp(
             break;
     }
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle,
+            KVDB_OPTRACE_PFX_PROBE,
+            os ? os->kop_txn : NULL,
+            pfx,
+            pfx_len,
+            sum ? vbuf.b_len : 0,
+            tstart,
+            0);
+
     PERFC_INCADD_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_PFXPROBE, PERFC_BA_KVDBOP_KVS_GETB, sum, 128);
 
     return 0UL;
 }
 
+uint64_t
+hse_kvs_cursor_read_batch_exp(
+    struct hse_kvs_cursor *    cursor,
+    struct hse_kvdb_opspec *   os,
+    void *                     buf,
+    size_t                     buf_sz,
+    struct hse_kvs_cursor_rec *recv,
+    size_t                     rec_max,
+    size_t *                   rec_cnt,
+    bool *                     eof)
+{
+    struct kvs_kvtuple kvtv[64];
+    size_t             used = 0;
+    size_t             n = 0;
+    merr_t             err = 0;
+    u64                tstart;
+
+    if (ev(!cursor || !buf || !recv || !rec_cnt || !eof))
+        return merr(EINVAL);
+
+    if (os && unlikely(((os->kop_opaque >> 16) != 0xb0de) || ((os->kop_opaque & 0x0000ffff) != 1)))
+        return merr(EINVAL);
+
+    *eof = false;
+
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
+    /* Tuples are staged in kvtv[] and then converted to records, so
+     * each pass through the cursor layers returns up to NELEM(kvtv)
+     * pairs.
+     */
+    while (n < rec_max && !*eof) {
+        uint kvtmax = min_t(size_t, NELEM(kvtv), rec_max - n);
+        uint kvtc, i;
+
+        err = ikvdb_kvs_cursor_read_batch(
+            cursor, os, (char *)buf + used, buf_sz - used, kvtv, kvtmax, &kvtc, eof);
+        if (err)
+            break;
+
+        for (i = 0; i < kvtc; ++i, ++n) {
+            struct hse_kvs_cursor_rec *rec = recv + n;
+
+            rec->kcr_key = kvtv[i].kvt_key.kt_data;
+            rec->kcr_key_len = kvtv[i].kvt_key.kt_len;
+            rec->kcr_val = kvtv[i].kvt_value.vt_data;
+            rec->kcr_val_len = kvs_vtuple_vlen(&kvtv[i].kvt_value);
+
+            used += rec->kcr_key_len + (rec->kcr_val ? rec->kcr_val_len : 0);
+        }
+
+        /* Either the buffer is full or the cursor is at eof. */
+        if (kvtc < kvtmax)
+            break;
+    }
+
+    *rec_cnt = n;
+
+    /* A batch is traced as one op whose value length is the number of
+     * bytes it returned.
+     */
+    if (tstart)
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_READ_BATCH,
+            cursor,
+            NULL,
+            0,
+            used,
+            tstart,
+            n > 0 ? 0 : err);
+
+    /* A full buffer merely ends the batch, and other errors are sticky
+     * in the cursor and will be reported by the next call, so return
+     * the pairs read thus far.
+     */
+    if (n > 0) {
+        perfc_add2(
+            &kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_READ, n, PERFC_BA_KVDBOP_KVS_GETB, used);
+        return 0UL;
+    }
+
+    return merr_errno(err) == ENOSPC ? err : ev(err);
+}
+
+uint64_t
+hse_kvs_cursor_pred_set_exp(struct hse_kvs_cursor *cursor, const struct hse_kvs_cursor_pred *pred)
+{
+    struct kc_pred kp = {};
+    u64            tstart;
+
+    if (ev(!cursor))
+        return merr(EINVAL);
+
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
+    if (!pred) {
+        ikvdb_kvs_cursor_pred_set(cursor, NULL);
+        if (tstart)
+            ikvdb_kvs_optrace(
+                (struct hse_kvs *)cursor->kc_kvs,
+                KVDB_OPTRACE_CUR_PRED_SET,
+                cursor,
+                NULL,
+                0,
+                0,
+                tstart,
+                0);
+        return 0UL;
+    }
+
+    if (ev((pred->kcp_key_sfx_len && !pred->kcp_key_sfx) ||
+           (pred->kcp_val_pat_len && !pred->kcp_val_pat)))
+        return merr(EINVAL);
+
+    if (ev(pred->kcp_key_sfx_len > HSE_KVS_KLEN_MAX || pred->kcp_val_max > HSE_KVS_VLEN_MAX ||
+           pred->kcp_val_pat_len > HSE_KVS_VLEN_MAX ||
+           pred->kcp_val_pat_len + pred->kcp_val_pat_off > HSE_KVS_VLEN_MAX))
+        return merr(EINVAL);
+
+    kp.kcp_ksfx = pred->kcp_key_sfx;
+    kp.kcp_ksfxlen = pred->kcp_key_sfx_len;
+    kp.kcp_vlenmax = pred->kcp_val_max;
+    kp.kcp_vpat = pred->kcp_val_pat;
+    kp.kcp_vpatlen = pred->kcp_val_pat_len;
+    kp.kcp_vpatoff = pred->kcp_val_pat_off;
+
+    ikvdb_kvs_cursor_pred_set(cursor, &kp);
+
+    /* Only the key suffix and value length limit are traced, a replay
+     * cannot reproduce a value pattern.
+     */
+    if (tstart)
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_PRED_SET,
+            cursor,
+            kp.kcp_ksfx,
+            kp.kcp_ksfxlen,
+            kp.kcp_vlenmax,
+            tstart,
+            0);
+
+    return 0UL;
+}
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "hse_experimental_ut_impl.i"
 #endif /* HSE_UNIT_TEST_MODE */
@@ -13,6 +13,7 @@
 
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/kvdb_ctxn.h>
+#include <hse_ikvdb/kvs.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/kvdb_perfc.h>
 #include <hse_ikvdb/wp.h>
@@ -407,6 +408,7 @@ hse_kvs_put(
     struct kvs_ktuple kt;
     struct kvs_vtuple vt;
     merr_t            err;
+    u64               tstart;
 
     if (unlikely(!handle || !key || (val_len > 0 && !val)))
         return merr_to_hse_err(merr(EINVAL));
@@ -426,9 +428,15 @@ hse_kvs_put(
     kvs_ktuple_init_nohash(&kt, key, key_len);
     kvs_vtuple_init(&vt, (void *)val, val_len);
 
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_put(handle, os, &kt, &vt);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle, KVDB_OPTRACE_PUT, os ? os->kop_txn : NULL, key, key_len, val_len, tstart, err);
+
     if (!err)
         PERFC_INCADD_RU(
             &kvdb_pc, PERFC_RA_KVDBOP_KVS_PUT, PERFC_BA_KVDBOP_KVS_PUTB, key_len + val_len, 128);
@@ -451,6 +459,7 @@ hse_kvs_get(
     struct kvs_buf      vbuf;
     enum key_lookup_res res;
     merr_t              err;
+    u64                 tstart;
 
     if (unlikely(!handle || !key || !found || !val_len))
         return merr_to_hse_err(merr(EINVAL));
@@ -478,7 +487,21 @@ hse_kvs_get(
     kvs_ktuple_init_nohash(&kt, key, key_len);
     kvs_buf_init(&vbuf, valbuf, valbuf_sz);
 
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_get(handle, os, &kt, &res, &vbuf);
+
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle,
+            KVDB_OPTRACE_GET,
+            os ? os->kop_txn : NULL,
+            key,
+            key_len,
+            (!err && res == FOUND_VAL) ? vbuf.b_len : 0,
+            tstart,
+            err);
+
     if (ev(err))
         return merr_to_hse_err(err);
 
@@ -505,6 +528,7 @@ hse_kvs_delete(struct hse_kvs *handle, struct hse_kvdb_opspec *os, const void *k
 {
     merr_t            err = 0;
     struct kvs_ktuple kt;
+    u64               tstart;
 
     if (unlikely(!handle || !key))
         return merr_to_hse_err(merr(EINVAL));
@@ -519,9 +543,16 @@ hse_kvs_delete(struct hse_kvs *handle, struct hse_kvdb_opspec *os, const void *k
         return merr_to_hse_err(merr(ENOENT));
 
     kvs_ktuple_init_nohash(&kt, key, key_len);
+
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_del(handle, os, &kt);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle, KVDB_OPTRACE_DEL, os ? os->kop_txn : NULL, key, key_len, 0, tstart, err);
+
     if (!err)
         PERFC_INCADD_RU(
             &kvdb_pc, PERFC_RA_KVDBOP_KVS_DEL, PERFC_BA_KVDBOP_KVS_DELB, key_len, 128);
@@ -539,6 +570,7 @@ hse_kvs_prefix_delete(
 {
     merr_t            err;
     struct kvs_ktuple kt;
+    u64               tstart;
 
     if (unlikely(!handle))
         return merr_to_hse_err(merr(EINVAL));
@@ -551,9 +583,15 @@ hse_kvs_prefix_delete(
 
     kvs_ktuple_init(&kt, prefix_key, key_len);
 
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_prefix_delete(handle, os, &kt, kvs_pfx_len);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle, KVDB_OPTRACE_PDEL, os ? os->kop_txn : NULL, prefix_key, key_len, 0, tstart, err);
+
     if (!err)
         PERFC_INCADD_RU(
             &kvdb_pc, PERFC_RA_KVDBOP_KVS_PFX_DEL, PERFC_BA_KVDBOP_KVS_PFX_DELB, key_len, 128);
@@ -621,11 +659,13 @@ hse_err_t
 hse_kvdb_txn_begin(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 {
     merr_t err;
-    u64    tstart;
+    u64    tstart, optrace_start;
 
     if (unlikely(!handle || !txn))
         return merr_to_hse_err(merr(EINVAL));
 
+    optrace_start = ikvdb_optrace_start((struct ikvdb *)handle);
+
     tstart = kvdb_lat_startu(PERFC_LT_PKVDBL_KVDB_TXN_BEGIN);
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVDB_TXN_BEGIN, 128);
 
@@ -634,6 +674,9 @@ hse_kvdb_txn_begin(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 
     kvdb_lat_record(PERFC_LT_PKVDBL_KVDB_TXN_BEGIN, tstart);
 
+    if (optrace_start)
+        ikvdb_optrace((struct ikvdb *)handle, KVDB_OPTRACE_TXN_BEGIN, txn, optrace_start, err);
+
     return merr_to_hse_err(err);
 }
 
@@ -641,7 +684,9 @@ hse_err_t
 hse_kvdb_txn_commit(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 {
     merr_t err;
-    u64    tstart;
+    u64    tstart, optrace_start;
+
+    optrace_start = ikvdb_optrace_start((struct ikvdb *)handle);
 
     tstart = kvdb_lat_startu(PERFC_LT_PKVDBL_KVDB_TXN_COMMIT);
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVDB_TXN_COMMIT, 128);
@@ -651,6 +696,9 @@ hse_kvdb_txn_commit(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 
     kvdb_lat_record(PERFC_LT_PKVDBL_KVDB_TXN_COMMIT, tstart);
 
+    if (optrace_start)
+        ikvdb_optrace((struct ikvdb *)handle, KVDB_OPTRACE_TXN_COMMIT, txn, optrace_start, err);
+
     return merr_to_hse_err(err);
 }
 
@@ -658,7 +706,9 @@ hse_err_t
 hse_kvdb_txn_abort(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 {
     merr_t err;
-    u64    tstart;
+    u64    tstart, optrace_start;
+
+    optrace_start = ikvdb_optrace_start((struct ikvdb *)handle);
 
     tstart = kvdb_lat_startu(PERFC_LT_PKVDBL_KVDB_TXN_ABORT);
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVDB_TXN_ABORT, 128);
@@ -668,6 +718,9 @@ hse_kvdb_txn_abort(struct hse_kvdb *handle, struct hse_kvdb_txn *txn)
 
     kvdb_lat_record(PERFC_LT_PKVDBL_KVDB_TXN_ABORT, tstart);
 
+    if (optrace_start)
+        ikvdb_optrace((struct ikvdb *)handle, KVDB_OPTRACE_TXN_ABORT, txn, optrace_start, err);
+
     return merr_to_hse_err(err);
 }
 
@@ -712,6 +765,7 @@ hse_kvs_cursor_create(
     struct hse_kvs_cursor **cursor)
 {
     merr_t err;
+    u64    tstart;
 
     if (unlikely(!handle || !cursor || (pfx_len && !prefix)))
         return merr_to_hse_err(merr(EINVAL));
@@ -721,9 +775,15 @@ hse_kvs_cursor_create(
 
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_CREATE, 128);
 
+    tstart = ikvdb_kvs_optrace_start(handle);
+
     err = ikvdb_kvs_cursor_create(handle, os, prefix, pfx_len, cursor);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            handle, KVDB_OPTRACE_CUR_CREATE, err ? NULL : *cursor, prefix, pfx_len, 0, tstart, err);
+
     return merr_to_hse_err(err);
 }
 
@@ -731,6 +791,7 @@ hse_err_t
 hse_kvs_cursor_update(struct hse_kvs_cursor *cursor, struct hse_kvdb_opspec *os)
 {
     merr_t err;
+    u64    tstart;
 
     if (unlikely(!cursor))
         return merr_to_hse_err(merr(EINVAL));
@@ -740,9 +801,22 @@ hse_kvs_cursor_update(struct hse_kvs_cursor *cursor, struct hse_kvdb_opspec *os)
 
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_UPDATE, 128);
 
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
     err = ikvdb_kvs_cursor_update(cursor, os);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_UPDATE,
+            cursor,
+            NULL,
+            0,
+            0,
+            tstart,
+            err);
+
     return merr_to_hse_err(err);
 }
 
@@ -757,6 +831,7 @@ hse_kvs_cursor_seek(
 {
     struct kvs_ktuple kt;
     merr_t            err;
+    u64               tstart;
 
     if (unlikely(!cursor))
         return merr_to_hse_err(merr(EINVAL));
@@ -766,10 +841,23 @@ hse_kvs_cursor_seek(
 
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_SEEK, 128);
 
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
     kt.kt_len = 0;
     err = ikvdb_kvs_cursor_seek(cursor, os, key, len, 0, 0, found ? &kt : 0);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_SEEK,
+            cursor,
+            key,
+            len,
+            0,
+            tstart,
+            err);
+
     if (found && flen && !err) {
         *found = kt.kt_data;
         *flen = kt.kt_len;
@@ -791,6 +879,7 @@ hse_kvs_cursor_seek_range(
 {
     struct kvs_ktuple kt;
     merr_t            err;
+    u64               tstart;
 
     if (unlikely(!cursor))
         return merr_to_hse_err(merr(EINVAL));
@@ -800,10 +889,23 @@ hse_kvs_cursor_seek_range(
 
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_SEEK, 128);
 
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
     kt.kt_len = 0;
     err = ikvdb_kvs_cursor_seek(cursor, os, key, key_len, limit, limit_len, found ? &kt : 0);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_SEEK,
+            cursor,
+            key,
+            key_len,
+            0,
+            tstart,
+            err);
+
     if (found && flen && !err) {
         *found = kt.kt_data;
         *flen = kt.kt_len;
@@ -823,6 +925,7 @@ hse_kvs_cursor_read(
     bool *                  eof)
 {
     merr_t err;
+    u64    tstart;
 
     if (unlikely(!cursor || !key || !klen || !val || !vlen || !eof))
         return merr_to_hse_err(merr(EINVAL));
@@ -830,9 +933,25 @@ hse_kvs_cursor_read(
     if (os && unlikely(((os->kop_opaque >> 16) != 0xb0de) || ((os->kop_opaque & 0x0000ffff) != 1)))
         return merr_to_hse_err(merr(EINVAL));
 
+    tstart = ikvdb_kvs_optrace_start((struct hse_kvs *)cursor->kc_kvs);
+
     err = ikvdb_kvs_cursor_read(cursor, os, key, klen, val, vlen, eof);
     ev(err);
 
+    if (tstart) {
+        bool hit = !err && !*eof;
+
+        ikvdb_kvs_optrace(
+            (struct hse_kvs *)cursor->kc_kvs,
+            KVDB_OPTRACE_CUR_READ,
+            cursor,
+            hit ? *key : NULL,
+            hit ? *klen : 0,
+            hit ? *vlen : 0,
+            tstart,
+            err);
+    }
+
     if (!err && !*eof) {
         PERFC_INCADD_RU(
             &kvdb_pc,
@@ -848,16 +967,25 @@ hse_kvs_cursor_read(
 hse_err_t
 hse_kvs_cursor_destroy(struct hse_kvs_cursor *cursor)
 {
-    merr_t err;
+    struct hse_kvs *kvs;
+    merr_t          err;
+    u64             tstart;
 
     if (unlikely(!cursor))
         return merr_to_hse_err(merr(EINVAL));
 
     PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_DESTROY, 128);
 
+    /* The cursor is gone once destroyed, so only its address is traced. */
+    kvs = (struct hse_kvs *)cursor->kc_kvs;
+    tstart = ikvdb_kvs_optrace_start(kvs);
+
     err = ikvdb_kvs_cursor_destroy(cursor);
     ev(err);
 
+    if (tstart)
+        ikvdb_kvs_optrace(kvs, KVDB_OPTRACE_CUR_DESTROY, cursor, NULL, 0, 0, tstart, err);
+
     return merr_to_hse_err(err);
 }
 
@@ -105,6 +105,8 @@ struct perfc_name csched_sp3_perfc[] = {
     NE(PERFC_BA_SP3_LSIZE_TARG, 3, "target leaf size ", "t_lsize"),
     NE(PERFC_BA_SP3_RSIZE_CURR, 3, "currrent non-leaf size ", "c_rsize"),
     NE(PERFC_BA_SP3_RSIZE_TARG, 3, "target non-leaf size ", "t_rsize"),
+    NE(PERFC_BA_SP3_IORATE, 2, "compaction I/O budget (MiB/s)", "c_iorate"),
+    NE(PERFC_BA_SP3_IOLAT, 3, "mean cN get latency (ns)", "c_iolat"),
 };
 NE_CHECK(csched_sp3_perfc, PERFC_EN_SP3, "csched_sp3_perfc table/enum mismatch");
 
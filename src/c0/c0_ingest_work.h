@@ -17,6 +17,18 @@
 #include <hse_ikvdb/c0_kvset_iterator.h>
 #include <hse_ikvdb/sched_sts.h>
 
+/**
+ * struct c0_ingest_part - ingest into one kvs partitioned by its root's children
+ * @cip_fanout:  number of partitions (see cn_ingest_fanout())
+ * @cip_bldrv:   kvset builder for each partition
+ * @cip_mblocks: mblocks built for each partition
+ */
+struct c0_ingest_part {
+    uint                  cip_fanout;
+    struct kvset_builder *cip_bldrv[CN_FANOUT_MAX];
+    struct kvset_mblocks  cip_mblocks[CN_FANOUT_MAX];
+};
+
 /**
  * struct c0_ingest_work - description of ingest work to be performed
  * @c0iw_c0:            struct c0 in whose context the ingest is occuring
@@ -27,6 +39,7 @@
  * @c0iw_coalscedbldrs:
  * @c0iw_bldrs:
  * @c0iw_mblocks:
+ * @c0iw_partv:         per-kvs partitioned ingest state (NULL if not partitioned)
  * @c0iw_c0kvms:        struct c0_kvmultiset being ingested
  * @c0iw_c0:
  * @c0iw_iterc:
@@ -46,6 +59,7 @@ struct c0_ingest_work {
     struct c0_kvmultiset       *c0iw_coalscedkvms[HSE_C0_KVSET_ITER_MAX];
     struct kvset_builder       *c0iw_bldrs[HSE_KVS_COUNT_MAX];
     struct kvset_mblocks        c0iw_mblocks[HSE_KVS_COUNT_MAX];
+    struct c0_ingest_part      *c0iw_partv[HSE_KVS_COUNT_MAX];
     struct c0_kvmultiset       *c0iw_c0kvms;
     u32                         c0iw_iterc;
     u32                         c0iw_coalescec;
@@ -13,6 +13,8 @@
 #include <hse_util/table.h>
 #include <hse_util/cds_list.h>
 #include <hse_util/bonsai_tree.h>
+#include <hse_util/sdt.h>
+#include <hse_util/flightrec.h>
 
 #include <hse/hse.h>
 
@@ -362,6 +364,98 @@ c0sk_builder_add(
     return err;
 }
 
+/**
+ * c0sk_builder_create() - create the kvset builder(s) for one kvs
+ * @ingest:     ingest work
+ * @cn:         cn of the kvs
+ * @skidx:      index of the kvs
+ * @bldrp:      (output) kvset builder
+ *
+ * If cn permits a partitioned ingest then one builder is created for
+ * each partition and *@bldrp is set to the first of them, the builder
+ * for each key must then be selected by c0sk_builder_route().
+ */
+static merr_t
+c0sk_builder_create(
+    struct c0_ingest_work *ingest,
+    struct cn *            cn,
+    u16                    skidx,
+    struct kvset_builder **bldrp)
+{
+    struct c0_ingest_part *part;
+    uint                   fanout, i;
+    merr_t                 err;
+
+    fanout = cn_ingest_fanout(cn);
+    if (fanout < 2) {
+        err = kvset_builder_create(
+            bldrp, cn, cn_get_ingest_perfc(cn), get_time_ns(), KVSET_BUILDER_FLAGS_INGEST);
+        if (ev(err))
+            return err;
+
+        kvset_builder_set_agegroup(*bldrp, HSE_MPOLICY_AGE_ROOT);
+
+        return 0;
+    }
+
+    part = calloc(1, sizeof(*part));
+    if (ev(!part))
+        return merr(ENOMEM);
+
+    for (i = 0; i < fanout; ++i) {
+        err = kvset_builder_create(
+            &part->cip_bldrv[i],
+            cn,
+            cn_get_ingest_perfc(cn),
+            get_time_ns(),
+            KVSET_BUILDER_FLAGS_INGEST);
+        if (ev(err)) {
+            while (i-- > 0)
+                kvset_builder_destroy(part->cip_bldrv[i]);
+            free(part);
+            return err;
+        }
+
+        /* The kvsets bypass the root node, and in the common case of
+         * a two level tree land directly in the leaves.
+         */
+        kvset_builder_set_agegroup(part->cip_bldrv[i], HSE_MPOLICY_AGE_LEAF);
+    }
+
+    part->cip_fanout = fanout;
+    ingest->c0iw_partv[skidx] = part;
+    *bldrp = part->cip_bldrv[0];
+
+    return 0;
+}
+
+/**
+ * c0sk_builder_route() - select the kvset builder for a key
+ * @ingest:     ingest work
+ * @cn:         cn of the kvs
+ * @skidx:      index of the kvs
+ * @bkv:        key
+ * @bldr:       kvset builder returned by c0sk_builder_create()
+ */
+static struct kvset_builder *
+c0sk_builder_route(
+    struct c0_ingest_work *ingest,
+    struct cn *            cn,
+    u16                    skidx,
+    struct bonsai_kv *     bkv,
+    struct kvset_builder * bldr)
+{
+    struct c0_ingest_part *part = ingest->c0iw_partv[skidx];
+    struct key_obj         ko;
+
+    if (!part)
+        return bldr;
+
+    key2kobj(&ko, bkv->bkv_key, key_imm_klen(&bkv->bkv_key_imm));
+
+    return part->cip_bldrv[cn_ingest_route(cn, &ko)];
+}
+
 static void
 c0sk_ingest_rec_perfc(struct perfc_set *perfc, u32 sidx, u64 cycles)
 {
@@ -404,7 +498,7 @@ c0sk_ingest_worker(struct work_struct *work)
     struct c0_kvmultiset * kvms;
     struct c0sk_impl *     c0sk;
     u32                    iterc;
-    int                    i;
+    int                    i, j;
     int *                  mbc;
     struct kvset_mblocks **mbv;
     u32 *                  cmtv;
@@ -438,6 +532,8 @@ c0sk_ingest_worker(struct work_struct *work)
 
     c0kvms_priv_wait(kvms);
 
+    HSE_SDT(c0sk_ingest_start, kvms, c0kvms_gen_read(kvms), c0kvms_used_get(kvms));
+
     if (ev(iterc == 0))
         goto exit_err;
 
@@ -469,6 +565,7 @@ c0sk_ingest_worker(struct work_struct *work)
     skidx_prev = -1;
     unsorted = 0;
     bldr = NULL;
+    cn = NULL;
     seqno = 0;
 
     ingestid = c0kvms_rsvd_sn_get(kvms);
@@ -502,7 +599,12 @@ c0sk_ingest_worker(struct work_struct *work)
         if (val_head && (bn_kv_cmp(bkv, bkv_prev) || skidx != skidx_prev)) {
             *val_tailp = NULL;
 
-            err = c0sk_builder_add(bldr, kvms, bkv_prev, val_head, unsorted);
+            err = c0sk_builder_add(
+                c0sk_builder_route(ingest, cn, skidx_prev, bkv_prev, bldr),
+                kvms,
+                bkv_prev,
+                val_head,
+                unsorted);
             if (ev(err))
                 goto health_err;
 
@@ -574,28 +676,26 @@ c0sk_ingest_worker(struct work_struct *work)
             skidx_prev = skidx;
             bldr = bldrs[skidx];
             if (!bldr) {
-                cn = c0sk->c0sk_cnv[skidx];
-                assert(cn);
-                err = kvset_builder_create(
-                    &bldr,
-                    cn,
-                    cn_get_ingest_perfc(c0sk->c0sk_cnv[skidx]),
-                    get_time_ns(),
-                    KVSET_BUILDER_FLAGS_INGEST);
+                assert(c0sk->c0sk_cnv[skidx]);
+                err = c0sk_builder_create(ingest, c0sk->c0sk_cnv[skidx], skidx, &bldr);
                 if (ev(err))
                     goto health_err;
 
-                kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_ROOT);
-
                 bldrs[skidx] = bldr;
             }
+            cn = c0sk->c0sk_cnv[skidx];
         }
     }
 
     if (val_head) {
         *val_tailp = NULL;
 
-        err = c0sk_builder_add(bldr, kvms, bkv_prev, val_head, unsorted);
+        err = c0sk_builder_add(
+            c0sk_builder_route(ingest, cn, skidx_prev, bkv_prev, bldr),
+            kvms,
+            bkv_prev,
+            val_head,
+            unsorted);
         if (ev(err))
             goto health_err;
 
@@ -606,9 +706,23 @@ c0sk_ingest_worker(struct work_struct *work)
         ingest->t4 = get_time_ns();
 
     for (i = 0; i < HSE_KVS_COUNT_MAX; ++i) {
+        struct c0_ingest_part *part = ingest->c0iw_partv[i];
+
         if (bldrs[i] == 0)
             continue;
 
+        if (part) {
+            for (j = 0; j < part->cip_fanout; ++j) {
+                err = kvset_builder_get_mblocks(part->cip_bldrv[j], &part->cip_mblocks[j]);
+                if (ev(err))
+                    goto health_err;
+            }
+
+            mbc[i] = part->cip_fanout;
+            mbv[i] = part->cip_mblocks;
+            continue;
+        }
+
         mbc[i] = 1;
         mbv[i] = &mblocks[i];
         err = kvset_builder_get_mblocks(bldrs[i], &mblocks[i]);
@@ -667,9 +781,23 @@ exit_err:
         hse_elog(HSE_ERR "c0 ingest failed on %p: @@e", err, kvms);
 
     for (i = 0; i < HSE_KVS_COUNT_MAX; ++i) {
+        struct c0_ingest_part *part = ingest->c0iw_partv[i];
+
         if (bldrs[i] == 0)
             continue;
 
+        if (part) {
+            for (j = 0; j < part->cip_fanout; ++j) {
+                kvset_mblocks_destroy(&part->cip_mblocks[j]);
+                kvset_builder_destroy(part->cip_bldrv[j]);
+            }
+
+            free(part);
+            ingest->c0iw_partv[i] = NULL;
+            bldrs[i] = NULL;
+            continue;
+        }
+
         kvset_mblocks_destroy(&mblocks[i]);
         kvset_builder_destroy(bldrs[i]);
 
@@ -683,6 +811,9 @@ exit_err:
         ingest->gencur = c0kvms_gen_current(kvms);
     }
 
+    HSE_SDT(c0sk_ingest_done, kvms, c0kvms_gen_read(kvms), merr_errno(err));
+    flightrec_add(FLIGHTREC_C0_INGEST_DONE, c0kvms_gen_read(kvms), merr_errno(err));
+
     c0sk_kvmultiset_ingest_completion(c0sk, kvms);
 }
 
@@ -1176,6 +1307,8 @@ genchk:
     c0kvms_usage(old, &usage);
     c0kvms_used_set(old, usage.u_alloc - usage.u_free);
 
+    flightrec_add(FLIGHTREC_C0_INGEST_QUEUE, c0kvms_gen_read(old), usage.u_alloc - usage.u_free);
+
     if (ev(new)) {
         /* do nothing */
     } else {
@@ -1495,8 +1628,11 @@ c0sk_putdel(
     const struct kvs_vtuple *vt,
     uintptr_t                seqnoref)
 {
+    u64    vlen = vt ? kvs_vtuple_vlen(vt) : 0;
     merr_t err;
 
+    HSE_SDT(c0sk_putdel_start, op, kt->kt_len, vlen);
+
     while (1) {
         struct c0_kvmultiset *dst;
         struct c0_kvset *     kvs;
@@ -1542,6 +1678,8 @@ c0sk_putdel(
         c0kvms_putref(dst);
     }
 
+    HSE_SDT(c0sk_putdel_done, op, kt->kt_len, vlen, merr_errno(err));
+
     return err;
 }
 
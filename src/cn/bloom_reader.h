@@ -22,6 +22,7 @@ struct kvs_mblk_desc;
  * @bd_n_pages:     size of data region in pages
  * @bd_n_hashes:
  * @bd_n_bits:      size of bloom filter in bits
+ * @bd_pfx_len:     length of key prefixes also in the filter (0: none)
  *
  * When a kblock is opened for reading, the @bloom_hdr_omf struct is read from
  * media and the relevant information is stored in a @bloom_desc struct.
@@ -41,6 +42,7 @@ struct bloom_desc {
     u32 bd_first_page;
     u32 bd_n_pages;
     u32 bd_bktsz;
+    u32 bd_pfx_len;
 };
 
 #define BLOOM_LOOKUP_NONE (0)
@@ -172,6 +172,18 @@ cn_get_maint_wq(struct cn *cn)
     return cn->cn_maint_wq;
 }
 
+struct workqueue_struct *
+cn_get_cursor_wq(struct cn *cn)
+{
+    return cn->cn_cursor_wq;
+}
+
+struct workqueue_struct *
+cn_get_subc_wq(struct cn *cn)
+{
+    return cn->cn_subc_wq;
+}
+
 struct csched *
 cn_get_sched(struct cn *cn)
 {
@@ -276,6 +288,12 @@ cn_get_ingest_perfc(const struct cn *cn)
     return cn ? &((struct cn *)cn)->cn_pc_ingest : 0;
 }
 
+struct perfc_set *
+cn_get_lookup_perfc(const struct cn *cn)
+{
+    return cn ? &((struct cn *)cn)->cn_pc_get : 0;
+}
+
 u32
 cn_cp2cflags(struct kvs_cparams *cp)
 {
@@ -569,35 +587,46 @@ cn_mb_est_alen(size_t full_captgt, size_t mb_alloc_unit, size_t wlen, uint flags
  * @cn:
  * @childv:
  * @childc:
+ * @spread: add the kvsets to the root node's children rather than the root
  * @txid:
  * @context:
  * @vcommitted: vblocks already committed.
  *      Can be NULL. If NULL, none of the vblocks are already committed.
- * @le_out:
+ * @kvsetv: (out) one kvset per element of @childv (NULL if empty)
+ *
+ * If @childc is greater than one then @childv holds an ingest partitioned
+ * by the root node's children.  If the kvsets can no longer be added to
+ * the children (@spread is false) they are instead added to the root,
+ * each with its own dgen, which is no different than a series of small
+ * ingests of disjoint keys.
  */
 static merr_t
 cn_ingest_prep(
     struct cn *           cn,
     struct kvset_mblocks *childv,
     unsigned int          childc,
+    bool                  spread,
     u64                   txid,
     u64 *                 context,
     u32 *                 vcommitted,
-    struct kvset **       kvsetp)
+    struct kvset **       kvsetv)
 {
-    struct kvset_meta km = {};
-    struct kvset *    kvset;
-    u64               dgen, tag_throwaway = 0;
-    u32               commitc = 0;
-    merr_t            err = 0;
+    u64    tagv[CN_FANOUT_MAX];
+    u64    dgen;
+    u32    commitc = 0;
+    uint   i;
+    merr_t err = 0;
 
-    /* Currently support only one child (this would need
-     * to change if we re-enable c0_spill).
-     */
-    if (!childv || childc != 1)
+    if (!childv || childc < 1 || childc > CN_FANOUT_MAX)
         return merr(ev(EINVAL));
 
-    dgen = atomic64_read(&cn->cn_ingest_dgen) + 1;
+    if (childc > 1) {
+        err = cn_spill_khashmap_sync(cn->cn_tree);
+        if (ev(err))
+            goto done;
+    }
+
+    dgen = atomic64_read(&cn->cn_ingest_dgen);
 
     /* Note: cn_mblocks_commit() creates "C" records in CNDB */
     err = cn_mblocks_commit(
@@ -611,60 +640,85 @@ cn_ingest_prep(
         vcommitted,
         &commitc,
         context,
-        &tag_throwaway);
+        tagv);
     if (ev(err))
         goto done;
 
-    /* Lend childv[0] kblk and vblk lists to kvset_create().
-     * Yes, the struct copy is a bit gross, but it works and
-     * avoids unnecessary allocations of temporary lists.
-     */
-    km.km_kblk_list = childv[0].kblks;
-    km.km_vblk_list = childv[0].vblks;
-    km.km_dgen = dgen;
-    km.km_node_level = 0;
-    km.km_node_offset = 0;
-
-    km.km_vused = childv[0].bl_vused;
-    km.km_compc = 0;
-    km.km_capped = cn_is_capped(cn);
-    km.km_restored = false;
-    km.km_scatter = km.km_vused ? 1 : 0;
-
-    /* It is conceivable that there are no kblocks on ingest.  All it takes
-     * is the creation of builder in the c0 ingest code without any keys
-     * ever making it to that builder.  We've already told CNDB how many
-     * C-records to expect, so we had to get this far to create the
-     * correct number of C and CMeta records.  But if there are in fact
-     * no kblocks, there's nothing more to do.  CNDB recognizes this
-     * and realizes that this is not a real kvset.
-     */
-    if (childv[0].kblks.n_blks == 0) {
-        assert(childv[0].vblks.n_blks == 0);
-        goto done;
-    }
+    for (i = 0; i < childc; i++) {
+        struct kvset_meta km = {};
+
+        /* It is conceivable that there are no kblocks on ingest.  All it
+         * takes is the creation of builder in the c0 ingest code without
+         * any keys ever making it to that builder (which is common for
+         * a partitioned ingest).  We've already told CNDB how many
+         * C-records to expect, so we had to get this far to create the
+         * correct number of C and CMeta records.  But if there are in
+         * fact no kblocks, there's nothing more to do.  CNDB recognizes
+         * this and realizes that this is not a real kvset.
+         */
+        if (childv[i].kblks.n_blks == 0) {
+            assert(childv[i].vblks.n_blks == 0);
+            continue;
+        }
 
-    /* DO NOT LOG META WHEN childv[0].kblks.n_blks == 0 */
-    err = cndb_txn_meta(cn->cn_cndb, txid, cn->cn_cnid, *context, &km);
-    if (ev(err))
-        goto done;
+        /* Lend childv[i] kblk and vblk lists to kvset_create().
+         * Yes, the struct copy is a bit gross, but it works and
+         * avoids unnecessary allocations of temporary lists.
+         */
+        km.km_kblk_list = childv[i].kblks;
+        km.km_vblk_list = childv[i].vblks;
 
-    err = kvset_create(cn->cn_tree, *context, &km, &kvset);
-    if (ev(err))
-        goto done;
+        if (spread) {
+            km.km_dgen = dgen + 1;
+            km.km_node_level = 1;
+            km.km_node_offset = i;
+        } else {
+            km.km_dgen = ++dgen;
+            km.km_node_level = 0;
+            km.km_node_offset = 0;
+        }
 
-    *kvsetp = kvset;
+        km.km_vused = childv[i].bl_vused;
+        km.km_compc = 0;
+        km.km_capped = cn_is_capped(cn);
+        km.km_restored = false;
+        km.km_scatter = km.km_vused ? 1 : 0;
+
+        /* DO NOT LOG META WHEN childv[i].kblks.n_blks == 0 */
+        err = cndb_txn_meta(cn->cn_cndb, txid, cn->cn_cnid, tagv[i], &km);
+        if (ev(err))
+            goto done;
+
+        err = kvset_create(cn->cn_tree, tagv[i], &km, &kvsetv[i]);
+        if (ev(err))
+            goto done;
+    }
 
 done:
     if (err) {
         /* Delete committed mblocks, abort those not yet committed. */
         cn_mblocks_destroy(cn->cn_dataset, childc, childv, 0, commitc);
-        *kvsetp = NULL;
+
+        for (i = 0; i < childc; i++) {
+            if (kvsetv[i])
+                kvset_put_ref(kvsetv[i]);
+            kvsetv[i] = NULL;
+        }
     }
 
     return err;
 }
 
+/**
+ * struct cn_ingest_out - kvsets created by an ingest into one cn
+ * @io_spread: true if @io_kvsetv go to the root node's children
+ * @io_kvsetv: kvsets, one per element of the cn's ingest mblocks vector
+ */
+struct cn_ingest_out {
+    bool          io_spread;
+    struct kvset *io_kvsetv[CN_FANOUT_MAX];
+};
+
 merr_t
 cn_ingestv(
     struct cn **           cn,
@@ -676,13 +730,13 @@ cn_ingestv(
     bool *                 ingested_out,
     u64 *                  seqno_max_out)
 {
-    struct kvset **    kvsetv = NULL;
-    struct cndb *      cndb = NULL;
-    struct kvset_stats kst = {};
+    struct cn_ingest_out *outv = NULL;
+    struct cndb *         cndb = NULL;
+    struct kvset_stats    kst = {};
 
     merr_t err = 0;
     u64    txid = 0;
-    uint   i, first, last, count, check;
+    uint   i, j, first, last, count, check, nc;
     u64    context = 0; /* must be initialized to zero */
     u64    seqno_max = 0, seqno_min = U64_MAX;
     uint   ext_vblk_count = 0;
@@ -693,14 +747,21 @@ cn_ingestv(
      * Remember the first and last index so we don't have
      * to iterate the entire list each time.
      */
-    first = last = count = 0;
+    first = last = count = nc = 0;
     for (i = 0; i < ingestc; i++) {
 
         if (!cn[i] || !mbc[i] || !mbv[i])
             continue;
 
-        seqno_max = max_t(u64, seqno_max, mbv[i]->bl_seqno_max);
-        seqno_min = min_t(u64, seqno_min, mbv[i]->bl_seqno_min);
+        if (ev(mbc[i] > CN_FANOUT_MAX)) {
+            err = merr(EINVAL);
+            goto done;
+        }
+
+        for (j = 0; j < mbc[i]; j++) {
+            seqno_max = max_t(u64, seqno_max, mbv[i][j].bl_seqno_max);
+            seqno_min = min_t(u64, seqno_min, mbv[i][j].bl_seqno_min);
+        }
 
         if (ev(seqno_min > seqno_max)) {
             err = merr(EINVAL);
@@ -713,6 +774,7 @@ cn_ingestv(
             first = i;
         last = i;
         count++;
+        nc += mbc[i];
         perfc_inc(&cn[i]->cn_pc_ingest, PERFC_BA_CNCOMP_START);
     }
 
@@ -734,19 +796,20 @@ cn_ingestv(
         goto done;
     }
 
-    kvsetv = calloc(ingestc, sizeof(*kvsetv));
-    if (ev(!kvsetv)) {
+    outv = calloc(last - first + 1, sizeof(*outv));
+    if (ev(!outv)) {
         err = merr(EINVAL);
         goto done;
     }
 
-    err = cndb_txn_start(cndb, &txid, ingestid, count, 0, seqno_max);
+    err = cndb_txn_start(cndb, &txid, ingestid, nc, 0, seqno_max);
     if (ev(err))
         goto done;
 
     check = 0;
     for (i = first; i <= last; i++) {
-        u32 *vcp;
+        struct cn_ingest_out *out = &outv[i - first];
+        u32 *                 vcp;
 
         if (!cn[i] || !mbc[i] || !mbv[i])
             continue;
@@ -754,11 +817,18 @@ cn_ingestv(
         if (cn[i]->rp && !log_ingest)
             log_ingest = cn[i]->rp->cn_compaction_debug & 2;
 
-        vcp = (ingestid == CNDB_INVAL_INGESTID) ? NULL : &vcommitted[i];
+        /* Ingests are serialized and only they add kvsets to the root,
+         * so the root cannot gain kvsets before cn_tree_ingest_update_children().
+         */
+        if (mbc[i] > 1)
+            out->io_spread = (cn_tree_ingest_fanout(cn[i]->cn_tree) == mbc[i]);
+
+        vcp = (ingestid == CNDB_INVAL_INGESTID || mbc[i] > 1) ? NULL : &vcommitted[i];
         if (vcp)
             ext_vblk_count += *vcp;
 
-        err = cn_ingest_prep(cn[i], mbv[i], mbc[i], txid, &context, vcp, &kvsetv[i]);
+        err = cn_ingest_prep(
+            cn[i], mbv[i], mbc[i], out->io_spread, txid, &context, vcp, out->io_kvsetv);
         if (ev(err))
             goto done;
         check++;
@@ -774,21 +844,35 @@ cn_ingestv(
 
     check = 0;
     for (i = first; i <= last; i++) {
+        struct cn_ingest_out *out = &outv[i - first];
 
         if (!cn[i] || !mbc[i] || !mbv[i])
             continue;
 
-        if (log_ingest) {
-            kvset_stats_add(kvset_statsp(kvsetv[i]), &kst);
-            dgen = kvsetv[i]->ks_dgen;
+        for (j = 0; j < mbc[i]; j++) {
+            if (log_ingest && out->io_kvsetv[j]) {
+                kvset_stats_add(kvset_statsp(out->io_kvsetv[j]), &kst);
+                dgen = out->io_kvsetv[j]->ks_dgen;
+            }
+        }
+
+        if (out->io_spread) {
+            cn_tree_ingest_update_children(cn[i]->cn_tree, out->io_kvsetv, mbc[i]);
+            check++;
+            continue;
         }
 
-        cn_tree_ingest_update(
-            cn[i]->cn_tree,
-            kvsetv[i],
-            mbv[i]->bl_last_ptomb,
-            mbv[i]->bl_last_ptlen,
-            mbv[i]->bl_last_ptseq);
+        for (j = 0; j < mbc[i]; j++) {
+            if (!out->io_kvsetv[j])
+                continue;
+
+            cn_tree_ingest_update(
+                cn[i]->cn_tree,
+                out->io_kvsetv[j],
+                mbv[i][j].bl_last_ptomb,
+                mbv[i][j].bl_last_ptlen,
+                mbv[i][j].bl_last_ptseq);
+        }
         check++;
     }
     assert(check == count);
@@ -821,17 +905,30 @@ done:
 
     /* NOTE: we always free the callers kvset mblocks */
     for (i = first; i <= last; i++) {
-        kvset_mblocks_destroy(mbv[i]);
+        for (j = 0; mbv[i] && j < mbc[i]; j++)
+            kvset_mblocks_destroy(&mbv[i][j]);
 
         if (cn[i])
             perfc_inc(&cn[i]->cn_pc_ingest, PERFC_BA_CNCOMP_FINISH);
     }
 
-    free(kvsetv);
+    free(outv);
 
     return err;
 }
 
+uint
+cn_ingest_fanout(struct cn *cn)
+{
+    return cn_tree_ingest_fanout(cn->cn_tree);
+}
+
+uint
+cn_ingest_route(struct cn *cn, const struct key_obj *kobj)
+{
+    return cn_tree_ingest_route(cn->cn_tree, kobj);
+}
+
 static void
 cn_maintenance_task(struct work_struct *context)
 {
@@ -1318,6 +1415,18 @@ cn_open(
         *vszsuf,
         vcnt);
 
+    /* Cursor merge helpers are needed whenever cursors are,
+     * independent of maintenance mode.  A single group would
+     * merge no faster than the cursor itself.
+     */
+    if (rp->cn_cursor_par > 1) {
+        cn->cn_cursor_wq = alloc_workqueue("cn_cursor", 0, rp->cn_cursor_par);
+        if (ev(!cn->cn_cursor_wq)) {
+            err = merr(ENOMEM);
+            goto err_exit;
+        }
+    }
+
     if (!maint)
         goto done;
 
@@ -1340,6 +1449,17 @@ cn_open(
         goto err_exit;
     }
 
+    /* Subcompaction workers run the key-range pieces of large spills
+     * and kv-compactions (see cn_spill()).
+     */
+    if (rp->cn_compact_subc > 1 && !cn_is_capped(cn)) {
+        cn->cn_subc_wq = alloc_workqueue("cn_subc", 0, rp->cn_compact_subc);
+        if (ev(!cn->cn_subc_wq)) {
+            err = merr(ENOMEM);
+            goto err_exit;
+        }
+    }
+
     if (cn->csched && !cn_is_capped(cn))
         csched_tree_add(cn->csched, cn->cn_tree);
 
@@ -1365,6 +1485,10 @@ done:
     return 0;
 
 err_exit:
+    if (cn->cn_subc_wq)
+        destroy_workqueue(cn->cn_subc_wq);
+    if (cn->cn_cursor_wq)
+        destroy_workqueue(cn->cn_cursor_wq);
     destroy_workqueue(cn->cn_maint_wq);
     destroy_workqueue(cn->cn_io_wq);
     cn_tree_destroy(cn->cn_tree);
@@ -1382,6 +1506,8 @@ cn_close(struct cn *cn)
     u64   report_ns = 5 * NSEC_PER_SEC;
     void *maint_wq = cn->cn_maint_wq;
     void *io_wq = cn->cn_io_wq;
+    void *cursor_wq = cn->cn_cursor_wq;
+    void *subc_wq = cn->cn_subc_wq;
     u64   next_report;
     useconds_t dlymax, dly;
     bool  cancel;
@@ -1430,8 +1556,14 @@ cn_close(struct cn *cn)
      */
     flush_workqueue(maint_wq);
     flush_workqueue(io_wq);
+    if (cursor_wq)
+        flush_workqueue(cursor_wq);
+    if (subc_wq)
+        flush_workqueue(subc_wq);
     cn->cn_maint_wq = NULL;
     cn->cn_io_wq = NULL;
+    cn->cn_cursor_wq = NULL;
+    cn->cn_subc_wq = NULL;
 
     cndb_cn_close(cn->cn_cndb, cn->cn_cnid);
     cndb_putref(cn->cn_cndb);
@@ -1441,6 +1573,10 @@ cn_close(struct cn *cn)
 
     destroy_workqueue(maint_wq);
     destroy_workqueue(io_wq);
+    if (cursor_wq)
+        destroy_workqueue(cursor_wq);
+    if (subc_wq)
+        destroy_workqueue(subc_wq);
     cn_perfc_free(cn);
 
     free_aligned(cn);
@@ -1549,6 +1685,8 @@ cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
+    const struct kc_pred * pred,
     const void *           prefix,
     u32                    pfx_len,
     struct cursor_summary *summary,
@@ -1592,6 +1730,8 @@ cn_cursor_create(
 
     cur->summary = summary;
     cur->reverse = reverse;
+    cur->keys_only = keys_only;
+    cur->pred = (pred && kc_pred_active(pred)) ? pred : NULL;
 
     /*
      * attempt to create the cursor several times:
@@ -1632,11 +1772,19 @@ cn_cursor_update(void *cursor, u64 seqno, bool *updated)
     if (ev(cur->merr))
         return cur->merr;
 
-    cur->seqno = seqno;
-
     /* common case: nothing changed, nothing to do */
-    if (cur->dgen == dgen)
+    if (cur->dgen == dgen) {
+        /* A parallel merge resolves values ahead of the reader,
+         * so a new view seqno requires the caller to seek.
+         */
+        if (cur->pm && cur->seqno != seqno && updated)
+            *updated = true;
+
+        cur->seqno = seqno;
         return 0;
+    }
+
+    cur->seqno = seqno;
 
     do {
         err = cn_tree_cursor_update(cur, cur->cn->cn_tree);
@@ -1673,6 +1821,22 @@ cn_cursor_read(void *cursor, struct kvs_kvtuple *kvt, bool *eof)
     return cn_tree_cursor_read(cursor, kvt, eof);
 }
 
+void
+cn_cursor_pred(void *cursor, const struct kc_pred *pred)
+{
+    struct pscan *cur = cursor;
+
+    cur->pred = (pred && kc_pred_active(pred)) ? pred : NULL;
+}
+
+void
+cn_cursor_keys_only(void *cursor, bool keys_only)
+{
+    struct pscan *cur = cursor;
+
+    cur->keys_only = keys_only;
+}
+
 void
 cn_cursor_destroy(void *cursor)
 {
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_CN_HEAT_H
+#define HSE_KVS_CN_HEAT_H
+
+#include <hse_util/platform.h>
+#include <hse_util/atomic.h>
+#include <hse_util/timing.h>
+
+#include <hse_ikvdb/kvset_view.h>
+
+/* Read activity counters (enum kvset_heat_ctr) of a kvset or cn tree
+ * node.  Each counter is spread over CN_HEAT_SLOTS cache lines selected
+ * by CPU so that concurrent readers seldom share a line.
+ */
+#define CN_HEAT_SLOTS (8)
+
+struct cn_heat_slot {
+    atomic64_t chs_ctrv[KVSET_HEAT_MAX];
+} __aligned(SMP_CACHE_BYTES);
+
+struct cn_heat {
+    struct cn_heat_slot ch_slotv[CN_HEAT_SLOTS];
+};
+
+static __always_inline void
+cn_heat_add(struct cn_heat *heat, enum kvset_heat_ctr ctr, u64 n)
+{
+    struct cn_heat_slot *slot = heat->ch_slotv + (raw_smp_processor_id() % CN_HEAT_SLOTS);
+
+    atomic64_add(n, &slot->chs_ctrv[ctr]);
+}
+
+/**
+ * cn_heat_folds() - whether a kvset's counter is passed on to its node
+ *
+ * A node counts its own gets and cursors, each of which may search
+ * several of its kvsets.  The remaining counters are per kblock probe
+ * and are summed over the node's kvsets, retired kvsets included.
+ * The gets and cursors of retired kvsets are kept apart from the
+ * node's own (see cn_node_rheat()).
+ */
+static inline bool
+cn_heat_folds(enum kvset_heat_ctr ctr)
+{
+    return ctr != KVSET_HEAT_GETS && ctr != KVSET_HEAT_CURSORS;
+}
+
+/**
+ * cn_heat_sum() - add the counters of @heat to @kh
+ */
+static inline void
+cn_heat_sum(struct cn_heat *heat, struct kvset_heat *kh)
+{
+    uint i, j;
+
+    for (i = 0; i < CN_HEAT_SLOTS; i++)
+        for (j = 0; j < KVSET_HEAT_MAX; j++)
+            kh->kh_ctrv[j] += atomic64_read(&heat->ch_slotv[i].chs_ctrv[j]);
+}
+
+#endif
@@ -62,6 +62,12 @@ struct cn {
     atomic_t                 cn_maint_cancel;
     bool                     cn_maintenance_stop;
 
+    /* for parallel cursor merge helpers */
+    struct workqueue_struct *cn_cursor_wq;
+
+    /* for key-range subcompactions */
+    struct workqueue_struct *cn_subc_wq;
+
     struct kvs_rparams *  rp;
     struct kvs_cparams *  cp;
     struct ikvdb *        ikvdb;
@@ -238,6 +238,42 @@ cn_merge_stats_diff(
     cn_merge_stats_ops_diff(&s->ms_kblk_read_wait, &a->ms_kblk_read_wait, &b->ms_kblk_read_wait);
 }
 
+static inline void
+cn_merge_stats_ops_add(struct cn_merge_stats_ops *s, const struct cn_merge_stats_ops *a)
+{
+    count_ops(s, a->op_cnt, a->op_size, a->op_time);
+}
+
+/* Accumulate @a into @s, except for @ms_srcs which describes the whole merge.
+ */
+static inline void
+cn_merge_stats_add(struct cn_merge_stats *s, const struct cn_merge_stats *a)
+{
+    s->ms_keys_in  += a->ms_keys_in;
+    s->ms_keys_out += a->ms_keys_out;
+
+    s->ms_key_bytes_in  += a->ms_key_bytes_in;
+    s->ms_key_bytes_out += a->ms_key_bytes_out;
+    s->ms_val_bytes_out += a->ms_val_bytes_out;
+
+    s->ms_vblk_wasted_reads += a->ms_vblk_wasted_reads;
+
+    cn_merge_stats_ops_add(&s->ms_kblk_alloc, &a->ms_kblk_alloc);
+    cn_merge_stats_ops_add(&s->ms_kblk_write, &a->ms_kblk_write);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_alloc, &a->ms_vblk_alloc);
+    cn_merge_stats_ops_add(&s->ms_vblk_write, &a->ms_vblk_write);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_read1,      &a->ms_vblk_read1);
+    cn_merge_stats_ops_add(&s->ms_vblk_read1_wait, &a->ms_vblk_read1_wait);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_read2,      &a->ms_vblk_read2);
+    cn_merge_stats_ops_add(&s->ms_vblk_read2_wait, &a->ms_vblk_read2_wait);
+
+    cn_merge_stats_ops_add(&s->ms_kblk_read,      &a->ms_kblk_read);
+    cn_merge_stats_ops_add(&s->ms_kblk_read_wait, &a->ms_kblk_read_wait);
+}
+
 /**
  * struct cn_samp_stats - metrics used to track space amp
  * @r_alen: allocated length of root node
@@ -37,7 +37,7 @@ struct perfc_name cn_perfc_get[] = {
 };
 
 struct perfc_name cn_perfc_compact[] = {
-    NE(PERFC_LT_CNCOMP_TOTAL, 2, "comp latency", "l_comp"),
+    NE(PERFC_HG_CNCOMP_TOTAL, 2, "comp latency", "l_comp"),
 
     NE(PERFC_BA_CNCOMP_START, 3, "started", "started"),
     NE(PERFC_BA_CNCOMP_FINISH, 3, "finished", "finished"),
@@ -33,6 +33,8 @@
 #include <hse_util/log2.h>
 #include <hse_util/workqueue.h>
 #include <hse_util/compression_lz4.h>
+#include <hse_util/sdt.h>
+#include <hse_util/flightrec.h>
 
 #include <mpool/mpool.h>
 
@@ -48,6 +50,7 @@
 #include <hse_ikvdb/cursor.h>
 #include <hse_ikvdb/sched_sts.h>
 #include <hse_ikvdb/csched.h>
+#include <hse_ikvdb/kvdb_slowop.h>
 #include <hse_ikvdb/kvs_rparams.h>
 
 #include "cn_tree.h"
@@ -66,6 +69,7 @@
 #include "kv_iterator.h"
 #include "wbt_reader.h"
 #include "pscan.h"
+#include "pmerge.h"
 #include "spill.h"
 #include "kcompact.h"
 #include "kblock_builder.h"
@@ -407,6 +411,8 @@ cn_tree_create(
         return merr(ENOMEM);
     }
 
+    cn_wamp_init(&tree->ct_wamp, get_time_ns());
+
     /* no internal nodes, one leaf node (root) */
     tree->ct_i_nodec = 0;
     tree->ct_l_nodec = 1;
@@ -722,6 +728,70 @@ cn_node_stats_get(const struct cn_tree_node *tn, struct cn_node_stats *s_out)
     *s_out = tn->tn_ns;
 }
 
+void
+cn_node_heat_get(struct cn_tree_node *tn, struct kvset_heat *heat)
+{
+    struct kvset_list_entry *le;
+    struct kvset_heat        kh;
+    uint                     i;
+
+    memset(heat, 0, sizeof(*heat));
+    cn_heat_sum(&tn->tn_heat, heat);
+
+    list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+        kvset_get_heat(le->le_kvset, &kh);
+
+        for (i = 0; i < KVSET_HEAT_MAX; i++)
+            if (cn_heat_folds(i))
+                heat->kh_ctrv[i] += kh.kh_ctrv[i];
+    }
+}
+
+u64
+cn_node_rheat(struct cn_tree_node *tn)
+{
+    struct kvset_list_entry *le;
+    struct kvset_heat        kh;
+    u64                      probes, reads;
+    void *                   lock;
+
+    rmlock_rlock(&tn->tn_tree->ct_lock, &lock);
+    probes = tn->tn_heat_probes;
+
+    list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+        kvset_get_heat(le->le_kvset, &kh);
+        probes += kh.kh_ctrv[KVSET_HEAT_GETS] + kh.kh_ctrv[KVSET_HEAT_CURSORS];
+    }
+    rmlock_runlock(lock);
+
+    /* A read counts in the node before it probes any kvset. */
+    memset(&kh, 0, sizeof(kh));
+    cn_heat_sum(&tn->tn_heat, &kh);
+    reads = kh.kh_ctrv[KVSET_HEAT_GETS] + kh.kh_ctrv[KVSET_HEAT_CURSORS];
+
+    return probes > reads ? probes - reads : 0;
+}
+
+/**
+ * cn_node_heat_retire() - keep the counters of a kvset leaving @tn
+ *
+ * Caller must hold the tree write lock.
+ */
+static void
+cn_node_heat_retire(struct cn_tree_node *tn, struct kvset *kvset)
+{
+    struct kvset_heat kh;
+    uint              i;
+
+    kvset_get_heat(kvset, &kh);
+
+    for (i = 0; i < KVSET_HEAT_MAX; i++)
+        if (cn_heat_folds(i) && kh.kh_ctrv[i])
+            cn_heat_add(&tn->tn_heat, i, kh.kh_ctrv[i]);
+
+    tn->tn_heat_probes += kh.kh_ctrv[KVSET_HEAT_GETS] + kh.kh_ctrv[KVSET_HEAT_CURSORS];
+}
+
 /* Helper for cn_tree_samp_* functions.  Do not use directly. */
 static void
 tn_samp_clear(struct cn_tree_node *tn)
@@ -1089,6 +1159,7 @@ cn_tree_view_create(struct cn *cn, struct table **view_out)
 
         s->kvset = 0;
         s->node_loc = node->tn_loc;
+        cn_node_heat_get(node, &s->node_heat);
 
         list_for_each_entry (le, &node->tn_kvset_list, le_link) {
             struct kvset *kvset = le->le_kvset;
@@ -1272,12 +1343,15 @@ cn_tree_lookup(
     uint                     pc_nkvset;
     u64                      pc_start;
     u64                      spill_hash = 0;
+    u64                      ttl_dgen;
     u16                      pc_lvl, pc_lvl_start, pc_depth;
     bool                     pfx_hashing, first;
     void *                   wbti;
 
     __builtin_prefetch(tree);
 
+    HSE_SDT(cn_lookup_start, tree, kt->kt_len);
+
     err = 0;
     *res = NOT_FOUND;
 
@@ -1314,6 +1388,7 @@ cn_tree_lookup(
 
     pfx_hashing = kt->kt_len > tree->ct_pfx_len && node->tn_pfx_spill;
     first = true;
+    ttl_dgen = cn_tree_ttl_dgen(tree);
 
     rmlock_rlock(&tree->ct_lock, &lock);
     while (node) {
@@ -1326,6 +1401,16 @@ cn_tree_lookup(
             struct kvset *kvset;
 
             kvset = le->le_kvset;
+
+            /* This and all remaining kvsets have expired (kvs_ttl). */
+            if (kvset_get_dgen(kvset) <= ttl_dgen) {
+                rmlock_runlock(lock);
+                goto done;
+            }
+
+            if (!yield)
+                cn_heat_add(&node->tn_heat, KVSET_HEAT_GETS, 1);
+
             yield = true;
             ++pc_nkvset;
 
@@ -1396,6 +1481,13 @@ cn_tree_lookup(
     rmlock_runlock(lock);
 
 done:
+    HSE_SDT(cn_lookup_done, tree, kt->kt_len, pc_nkvset, pc_depth, *res, merr_errno(err));
+
+    if (kvdb_slowop_tls.ss_active) {
+        kvdb_slowop_tls.ss_kvsets += pc_nkvset;
+        kvdb_slowop_tls.ss_depth = max_t(u32, kvdb_slowop_tls.ss_depth, pc_depth);
+    }
+
     if (pc && !wbti) {
         /* latencies first - close in time */
         perfc_lat_record(pc, PERFC_LT_CNGET_GET, pc_start);
@@ -1432,10 +1524,120 @@ cn_tree_initial_dgen(const struct cn_tree *tree)
     return tree->ct_dgen_init;
 }
 
+static void cn_tree_ttl_ingest(struct cn_tree *tree, u64 dgen);
+
 void
 cn_tree_set_initial_dgen(struct cn_tree *tree, u64 dgen)
 {
     tree->ct_dgen_init = dgen;
+
+    /* Ingest times are not persisted, so kvs_ttl applies to the kvsets
+     * found at open as if they had been ingested now.
+     */
+    cn_tree_ttl_ingest(tree, dgen);
+}
+
+/*----------------------------------------------------------------
+ * SECTION: Time-to-live (kvs_ttl)
+ *
+ * Data expires kvs_ttl seconds after it is ingested into cn.  Ingests
+ * are recorded in time windows of kvs_ttl / CN_TTL_WINDOWS_PER_TTL
+ * (see struct cn_ttl_window).  When the last ingest of the oldest
+ * window is kvs_ttl old, every kvset with a dgen at or below the
+ * window's dgen has expired.  Gets and cursors ignore such kvsets, and
+ * csched deletes them from the tail of leaf nodes by metadata alone.
+ *
+ * Expiry is per kvset rather than per key, so data lives between
+ * kvs_ttl and kvs_ttl plus the time it spends in c0 and in kvsets that
+ * were merged with newer data.  Leaf compactions do not merge kvsets
+ * from different windows to bound the latter.
+ */
+
+static void
+cn_tree_ttl_ingest(struct cn_tree *tree, u64 dgen)
+{
+    struct cn_ttl_window *tw;
+    u64                   now, win;
+    uint                  n;
+
+    if (!tree->rp || !tree->rp->kvs_ttl || cn_is_capped(tree->cn))
+        return;
+
+    now = get_time_ns();
+    win = tree->rp->kvs_ttl * NSEC_PER_SEC / CN_TTL_WINDOWS_PER_TTL;
+    n = tree->ct_ttl_windowc;
+
+    /* Extend the current window, or the last one if all are in use
+     * (which only delays expiry).
+     */
+    if (n > 0) {
+        tw = tree->ct_ttl_windowv + n - 1;
+
+        if (n == CN_TTL_WINDOWS || now < tw->tw_start + win) {
+            tw->tw_dgen = max(tw->tw_dgen, dgen);
+            tw->tw_last = now;
+            return;
+        }
+    }
+
+    tw = tree->ct_ttl_windowv + n;
+    tw->tw_dgen = dgen;
+    tw->tw_start = tw->tw_last = now;
+    tree->ct_ttl_windowc++;
+}
+
+bool
+cn_tree_ttl_update(struct cn_tree *tree)
+{
+    struct cn_ttl_window *twv = tree->ct_ttl_windowv;
+    void *                lock;
+    u64                   ttl, now, dgen;
+    bool                  expired;
+    uint                  n;
+
+    if (!tree->rp->kvs_ttl)
+        return false;
+
+    ttl = tree->rp->kvs_ttl * NSEC_PER_SEC;
+    now = get_time_ns();
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    expired = tree->ct_ttl_windowc > 0 && twv[0].tw_last + ttl <= now;
+    rmlock_runlock(lock);
+
+    if (!expired)
+        return false;
+
+    dgen = 0;
+
+    rmlock_wlock(&tree->ct_lock);
+    for (n = 0; n < tree->ct_ttl_windowc && twv[n].tw_last + ttl <= now; n++)
+        dgen = twv[n].tw_dgen;
+
+    tree->ct_ttl_windowc -= n;
+    memmove(twv, twv + n, tree->ct_ttl_windowc * sizeof(*twv));
+
+    if (dgen > cn_tree_ttl_dgen(tree))
+        atomic64_set(&tree->ct_ttl_dgen, dgen);
+    rmlock_wunlock(&tree->ct_lock);
+
+    return dgen > 0;
+}
+
+u64
+cn_tree_ttl_window(struct cn_tree *tree, u64 dgen)
+{
+    uint i;
+
+    if (dgen <= cn_tree_ttl_dgen(tree))
+        return 0;
+
+    for (i = 0; i < tree->ct_ttl_windowc; i++) {
+        if (dgen <= tree->ct_ttl_windowv[i].tw_dgen)
+            return tree->ct_ttl_windowv[i].tw_start;
+    }
+
+    return U64_MAX;
 }
 
 u32
@@ -1502,6 +1704,16 @@ cn_comp_release(struct cn_compaction_work *w)
     if (w->cw_have_token)
         cn_node_comp_token_put(w->cw_node);
 
+    HSE_SDT(
+        cn_comp_done,
+        w,
+        w->cw_tree->cnid,
+        w->cw_action,
+        merr_errno(w->cw_err),
+        w->cw_stats.ms_keys_out,
+        w->cw_stats.ms_key_bytes_out,
+        w->cw_stats.ms_val_bytes_out);
+
     perfc_inc(w->cw_pc, PERFC_BA_CNCOMP_FINISH);
 
     if (ev(w->cw_bonus))
@@ -1676,6 +1888,8 @@ cn_tree_capped_compact(struct cn_tree *tree)
      */
     rmlock_wlock(&tree->ct_lock);
     list_trim(&retired, head, &mark->le_link);
+    list_for_each_entry (le, &retired, le_link)
+        cn_node_heat_retire(node, le->le_kvset);
     cn_tree_samp_update_compact(tree, node);
     rmlock_wunlock(&tree->ct_lock);
 
@@ -1687,6 +1901,82 @@ cn_tree_capped_compact(struct cn_tree *tree)
     }
 }
 
+/**
+ * cn_tree_subc_plan() - choose the key ranges of subcompactions
+ * @w:         compaction work
+ * @keyv_out:  boundary keys between subcompactions (output)
+ *
+ * Large spills and kv-compactions are split into key ranges that are merged
+ * in parallel (see cn_spill()).  The ranges are taken from evenly spaced
+ * kblocks of the input kvset with the most kblocks.  Inputs that contain
+ * prefix tombstones are not split, since a ptomb must be merged together
+ * with all the keys it covers.
+ *
+ * Return: number of subcompactions, or 0 if @w should not be split
+ */
+static uint
+cn_tree_subc_plan(struct cn_compaction_work *w, struct key_obj **keyv_out)
+{
+    struct kvs_rparams *     rp = w->cw_rp;
+    struct kvset_list_entry *le;
+    struct kvset *           ks = NULL;
+    struct key_obj *         keyv;
+    uint                     subc, kblkc = 0;
+    uint                     i;
+
+    *keyv_out = NULL;
+
+    if (!rp || rp->cn_compact_subc < 2 || !cn_get_subc_wq(w->cw_tree->cn))
+        return 0;
+
+    if (w->cw_action != CN_ACTION_COMPACT_KV && w->cw_action != CN_ACTION_SPILL)
+        return 0;
+
+    if (w->cw_est.cwe_read_sz < (s64)(rp->cn_compact_subc_min << 20))
+        return 0;
+
+    for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt; i++, le = list_prev_entry(le, le_link)) {
+        uint n;
+
+        if (kvset_pt_start(le->le_kvset) >= 0)
+            return 0;
+
+        n = kvset_get_num_kblocks(le->le_kvset);
+        if (n > kblkc) {
+            kblkc = n;
+            ks = le->le_kvset;
+        }
+    }
+
+    subc = min_t(uint, rp->cn_compact_subc, kblkc);
+    if (subc < 2)
+        return 0;
+
+    keyv = calloc(subc - 1, sizeof(*keyv));
+    if (ev(!keyv))
+        return 0;
+
+    /* The smallest keys of distinct kblocks of one kvset are strictly
+     * ascending, hence so are the boundaries.
+     */
+    for (i = 1; i < subc; i++) {
+        const void *key;
+        uint        klen;
+
+        kvset_get_nth_kblock_min_key(ks, (i * kblkc) / subc, &key, &klen);
+        if (!key) {
+            free(keyv);
+            return 0;
+        }
+
+        key2kobj(&keyv[i - 1], key, klen);
+    }
+
+    *keyv_out = keyv;
+
+    return subc;
+}
+
 merr_t
 cn_tree_prepare_compaction(struct cn_compaction_work *w)
 {
@@ -1702,6 +1992,11 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
     struct kvset_vblk_map    vbm = {};
     bool                     oldest;
     struct workqueue_struct *vra_wq;
+    struct workqueue_struct *io_workq = w->cw_io_workq;
+    struct kv_iterator **    subins = 0;
+    struct key_obj *         subkeyv = 0;
+    uint                     subc = 0, j;
+    uint                     iter_flags = w->cw_iter_flags;
 
     fanout = 1 << w->cw_tree->ct_fanout_bits;
     n_outs = fanout;
@@ -1721,6 +2016,21 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
 
     vra_wq = cn_get_maint_wq(node->tn_tree->cn);
 
+    /* Subcompactions seek their iterators to the start of their key
+     * ranges, which requires iterating via mcache maps.
+     */
+    subc = cn_tree_subc_plan(w, &subkeyv);
+    if (subc > 1) {
+        iter_flags |= kvset_iter_flag_mcache;
+        io_workq = NULL;
+
+        subins = calloc((subc - 1) * w->cw_kvset_cnt, sizeof(*subins));
+        if (ev(!subins)) {
+            err = merr(ENOMEM);
+            goto err_exit;
+        }
+    }
+
     /*
      * Create one iterator for each input kvset.  The list 'ins' must be
      * ordered such that 'ins[i]' is newer then 'ins[i+1]'.  We walk the
@@ -1745,13 +2055,38 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
          */
         kvset_get_ref(le->le_kvset);
 
-        err = kvset_iter_create(
-            le->le_kvset, w->cw_io_workq, vra_wq, w->cw_pc, w->cw_iter_flags, iter);
+        err = kvset_iter_create(le->le_kvset, io_workq, vra_wq, w->cw_pc, iter_flags, iter);
         if (ev(err)) {
             kvset_put_ref(le->le_kvset);
             goto err_exit;
         }
         kvset_iter_set_stats(*iter, &w->cw_stats);
+
+        /* k-compaction reads only kblocks */
+        if (w->cw_action == CN_ACTION_COMPACT_K)
+            w->cw_input_wlen += kvset_statsp(le->le_kvset)->kst_kwlen;
+        else
+            w->cw_input_wlen += kvset_wlen(kvset_statsp(le->le_kvset));
+
+        for (j = 1; j < subc; j++) {
+            const struct key_obj *skey = &subkeyv[j - 1];
+            bool                  eof;
+
+            iter = &subins[(j - 1) * w->cw_kvset_cnt + w->cw_kvset_cnt - 1 - i];
+
+            kvset_get_ref(le->le_kvset);
+
+            err = kvset_iter_create(le->le_kvset, NULL, vra_wq, w->cw_pc, iter_flags, iter);
+            if (ev(err)) {
+                kvset_put_ref(le->le_kvset);
+                goto err_exit;
+            }
+            kvset_iter_set_stats(*iter, &w->cw_stats);
+
+            err = kvset_iter_seek(*iter, skey->ko_sfx, skey->ko_sfx_len, &eof);
+            if (ev(err))
+                goto err_exit;
+        }
     }
 
     /* k-compaction keeps all the vblocks from the source kvsets
@@ -1793,6 +2128,10 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
     w->cw_vbmap = vbm;
     w->cw_drop_tombv = drop_tombs;
     w->cw_hash_shift = 0;
+    w->cw_subc = subc;
+    w->cw_subkeyv = subkeyv;
+    w->cw_subinputv = subins;
+    w->cw_sub_ekey = NULL;
 
     if (n_outs > 1) {
         uint bits = w->cw_tree->ct_fanout_bits;
@@ -1813,6 +2152,13 @@ err_exit:
         free(ins);
         free(vbm.vbm_blkv);
     }
+    if (subins) {
+        for (i = 0; i < (subc - 1) * w->cw_kvset_cnt; i++)
+            if (subins[i])
+                subins[i]->kvi_ops->kvi_release(subins[i]);
+        free(subins);
+    }
+    free(subkeyv);
     free(drop_tombs);
     free(outs);
 
@@ -1895,11 +2241,20 @@ kvstart_put_ref(void *arg)
 merr_t
 cn_tree_cursor_active_kvsets(struct pscan *cur, u32 *active, u32 *total)
 {
-    *active = bin_heap2_width(cur->bh);
+    *active = cur->pm ? pmerge_active(cur->pm) : bin_heap2_width(cur->bh);
     *total = cur->iterc;
     return 0;
 }
 
+/* A keys-only cursor need not fetch values unless its predicate must
+ * test value data.
+ */
+static inline bool
+cur_novals(const struct pscan *cur)
+{
+    return cur->keys_only && !(cur->pred && cur->pred->kcp_vpatlen);
+}
+
 merr_t
 cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
 {
@@ -1915,6 +2270,7 @@ cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
     struct element_source ** esrc;
     uint                     iterc;
     uint                     shift;
+    u64                      ttl_dgen;
     enum kvset_iter_flags    flags;
 
     merr_t err = 0;
@@ -1968,13 +2324,16 @@ cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
 
 #define dgen_at(_idx) (tdgenv[1 + _idx])
 
+    ttl_dgen = cn_tree_ttl_dgen(tree);
+
     rmlock_rlock(&tree->ct_lock, &lock);
     cur->dgen = tdgenv[0] = cn_get_ingest_dgen(cur->cn);
     while (node) {
 
         /* recover least dgen of parent when entering a node */
-        u32 level = node->tn_loc.node_level;
-        u64 dgen = dgen_at(level - 1);
+        u32  level = node->tn_loc.node_level;
+        u64  dgen = dgen_at(level - 1);
+        uint iterc_node = iterc;
 
         list_for_each_entry (le, &node->tn_kvset_list, le_link) {
             struct kvset *   kvset = le->le_kvset;
@@ -1992,6 +2351,10 @@ cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
 
             assert(x <= cur->dgen);
 
+            /* This and all older kvsets in the node have expired. */
+            if (x <= ttl_dgen)
+                break;
+
             /* determine if this kvset participates.
              * If prefixed tree, check if kvset has ptombs.
              */
@@ -2034,6 +2397,9 @@ cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
             goto errout;
         }
 
+        if (iterc > iterc_node)
+            cn_heat_add(&node->tn_heat, KVSET_HEAT_CURSORS, 1);
+
         if (level > 0)
             rmlock_yield(&tree->ct_lock, &lock);
 
@@ -2135,13 +2501,43 @@ cn_tree_cursor_create(struct pscan *cur, struct cn_tree *tree)
         assert(cur->iterv[i]);
     }
 
-    err = bin_heap2_create(cur->iterc, cur->reverse ? cn_kv_cmp_rev : cn_kv_cmp, &cur->bh);
-    if (ev(err))
-        goto errout;
+    /* Merge large kvset stacks on helper threads if so configured.
+     * The cursor's heap then merges one element source per group.
+     */
+    if (cur->iterc >= tree->rp->cn_cursor_parmin && tree->rp->cn_cursor_par > 1 &&
+        cn_get_cursor_wq(cur->cn) && !cn_is_capped(cur->cn)) {
+        struct element_source **esrcv;
+        uint                    esrcc;
+
+        err = pmerge_create(
+            cur->iterv,
+            cur->iterc,
+            tree->rp->cn_cursor_par,
+            cur->reverse ? cn_kv_cmp_rev : cn_kv_cmp,
+            cn_get_cursor_wq(cur->cn),
+            &cur->pm);
+        if (ev(err))
+            goto errout;
 
-    err = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
-    if (ev(err))
-        goto errout;
+        pmerge_reset(cur->pm, cur->seqno, cur_novals(cur));
+        esrcc = pmerge_esrcv(cur->pm, &esrcv);
+
+        err = bin_heap2_create(esrcc, cur->reverse ? cn_kv_cmp_rev : cn_kv_cmp, &cur->bh);
+        if (ev(err))
+            goto errout;
+
+        err = bin_heap2_prepare(cur->bh, esrcc, esrcv);
+        if (ev(err))
+            goto errout;
+    } else {
+        err = bin_heap2_create(cur->iterc, cur->reverse ? cn_kv_cmp_rev : cn_kv_cmp, &cur->bh);
+        if (ev(err))
+            goto errout;
+
+        err = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
+        if (ev(err))
+            goto errout;
+    }
 
     cursor_summary_add_dgen(cur->summary, cur->dgen);
     cur->summary->n_kvset = cur->iterc;
@@ -2394,6 +2790,9 @@ cn_tree_cursor_update(struct pscan *cur, struct cn_tree *tree)
     if (ev(cn_is_capped(cur->cn) && !cur->reverse))
         return cn_tree_capped_cursor_update(cur, tree);
 
+    pmerge_destroy(cur->pm);
+    cur->pm = NULL;
+
     kvset_iterv_release(cur->iterc, cur->iterv, cn_get_maint_wq(cur->cn));
     bin_heap2_destroy(cur->bh);
 
@@ -2413,6 +2812,10 @@ cn_tree_cursor_update(struct pscan *cur, struct cn_tree *tree)
 void
 cn_tree_cursor_destroy(struct pscan *cur)
 {
+    /* Helpers must be stopped before their iterators are released. */
+    pmerge_destroy(cur->pm);
+    cur->pm = NULL;
+
     kvset_iterv_release(cur->iterc, cur->iterv, cn_get_maint_wq(cur->cn));
     bin_heap2_destroy(cur->bh);
     cur->bh = 0;
@@ -2481,6 +2884,37 @@ cur_item_cmp(struct pscan *cur, struct cn_kv_item *item)
     return rc;
 }
 
+/* Returns true if the key and value length satisfy the cursor predicate.
+ * The key suffix may straddle the key object's prefix and suffix parts.
+ */
+static bool
+cur_pred_kv(const struct kc_pred *pred, const struct key_obj *kobj, uint vlen)
+{
+    const void *ksfx = pred->kcp_ksfx;
+    uint        n = pred->kcp_ksfxlen;
+
+    if (!kc_pred_vlen(pred, vlen))
+        return false;
+
+    if (!n)
+        return true;
+
+    if (key_obj_len(kobj) < n)
+        return false;
+
+    if (n > kobj->ko_sfx_len) {
+        uint pn = n - kobj->ko_sfx_len;
+
+        if (memcmp(kobj->ko_pfx + kobj->ko_pfx_len - pn, ksfx, pn))
+            return false;
+
+        ksfx += pn;
+        n -= pn;
+    }
+
+    return !memcmp(kobj->ko_sfx + kobj->ko_sfx_len - n, ksfx, n);
+}
+
 /*
  * cn_tree_cursor_read - returns the next value in the cursor
  * @cur: the cursor returned from cn_cursor_create
@@ -2503,6 +2937,10 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
     int                 rc;
     struct kv_iterator *kv_iter = 0;
     struct key_obj      filter_ko = { 0 };
+    enum kmd_vtype      vtype;
+    uint                vbidx;
+    uint                vboff;
+    bool                novals = cur_novals(cur);
 
     if (ev(cur->merr))
         return cur->merr;
@@ -2518,6 +2956,12 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
     do {
 
         if (!bin_heap2_peek(cur->bh, (void **)&popme)) {
+            if (cur->pm) {
+                cur->merr = pmerge_err(cur->pm);
+                if (ev(cur->merr))
+                    return cur->merr;
+            }
+
             *eof = (cur->eof = 1);
             return 0;
         }
@@ -2528,6 +2972,15 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
         item = *popme;
         is_tomb = item.vctx.is_ptomb;
 
+        if (cur->pm) {
+            struct pmerge_item *pi = (void *)popme;
+
+            seq = pi->pi_seq;
+            vdata = pi->pi_vdata;
+            vlen = pi->pi_vlen;
+            complen = pi->pi_complen;
+        }
+
         bin_heap2_pop(cur->bh, (void **)&popme);
 
         rc = cur_item_cmp(cur, &item);
@@ -2546,30 +2999,65 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
             }
         }
 
-        kv_iter = kvset_cursor_es_h2r(item.src);
         end = false;
 
-        do {
-            enum kmd_vtype vtype;
-            u32            vbidx;
-            u32            vboff;
+        /* A parallel merge helper has already resolved the visible
+         * value, and skipped keys with no visible value.
+         */
+        if (!cur->pm) {
+            kv_iter = kvset_cursor_es_h2r(item.src);
+
+            /* Skip values newer than our view without fetching
+             * them, then test the predicate on the visible value's
+             * length before reading it from its vblock.
+             */
+            do {
+                if (!kvset_iter_next_vref(
+                        kv_iter, &item.vctx, &seq, &vtype, &vbidx,
+                        &vboff, &vdata, &vlen, &complen)) {
+                    end = true;
+                    break;
+                }
+            } while (seq > cur->seqno);
+            if (end)
+                continue;
 
-            if (!kvset_iter_next_vref(
-                    kv_iter, &item.vctx, &seq, &vtype, &vbidx,
-                    &vboff, &vdata, &vlen, &complen)) {
+            if (cur->pred && vtype != vtype_tomb && vtype != vtype_ptomb &&
+                !cur_pred_kv(cur->pred, &item.kobj, vlen)) {
+                drop_dups(cur, &item);
                 end = true;
-                break;
+                continue;
             }
 
-            cur->merr =
-                kvset_iter_next_val(kv_iter, &item.vctx, vtype, vbidx,
-                    vboff, &vdata, &vlen, &complen);
-            if (ev(cur->merr))
-                return cur->merr;
+            if (novals && (vtype == vtype_val || vtype == vtype_cval)) {
+                vdata = NULL;
+            } else {
+                cur->merr = kvset_iter_next_val(kv_iter, &item.vctx, vtype,
+                    vbidx, vboff, &vdata, &vlen, &complen);
+                if (ev(cur->merr))
+                    return cur->merr;
+            }
+        }
 
-        } while (seq > cur->seqno);
-        if (end)
-            continue;
+        /* Values returned by a parallel merge helper have already been
+         * fetched, so test the whole predicate here.  Compressed values
+         * (and values not fetched) are left to the kvs cursor to test.
+         */
+        if (cur->pred && !HSE_CORE_IS_TOMB(vdata)) {
+            const struct kc_pred *pred = cur->pred;
+            bool                  match = true;
+
+            if (cur->pm)
+                match = cur_pred_kv(pred, &item.kobj, vlen);
+            if (match && pred->kcp_vpatlen && vdata && !complen)
+                match = kc_pred_val(pred, vdata, vlen);
+
+            if (!match) {
+                drop_dups(cur, &item);
+                end = true;
+                continue;
+            }
+        }
 
         if (HSE_CORE_IS_PTOMB(vdata) &&
             (!cur->pt_set || key_obj_cmp(&cur->pt_kobj, &item.kobj) != 0)) {
@@ -2616,7 +3104,9 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
 
     kvs_vtuple_init(&kvt->kvt_value, cur->buf + kvt->kvt_key.kt_len, vlen);
 
-    if (complen) {
+    if (novals) {
+        kvt->kvt_value.vt_data = NULL;
+    } else if (complen) {
         extern struct compress_ops compress_lz4_ops;
         uint len_check;
 
@@ -2636,7 +3126,7 @@ cn_tree_cursor_read(struct pscan *cur, struct kvs_kvtuple *kvt, bool *eof)
 
     cur->stats.ms_keys_out++;
     cur->stats.ms_key_bytes_out += kvt->kvt_key.kt_len;
-    cur->stats.ms_val_bytes_out += vlen;
+    cur->stats.ms_val_bytes_out += novals ? 0 : vlen;
 
     drop_dups(cur, &item);
 
@@ -2679,7 +3169,12 @@ cn_tree_cursor_seek(
     if (cur->eof)
         cur->eof = 0;
 
-    /* [HSE_REVISIT]: this is parallelizable */
+    /* The merge helpers must be idle before repositioning their
+     * iterators.  They are restarted once the iterators are in place.
+     */
+    if (cur->pm)
+        pmerge_quiesce(cur->pm);
+
     first = -1; /* first kvset that is not at EOF */
     for (i = cur->iterc - 1; i >= 0; --i) {
         bool eof = false;
@@ -2722,7 +3217,20 @@ cn_tree_cursor_seek(
      * If we have a problem here, the cursor becomes invalid,
      * and cannot be reused.  Only recovery is to destroy it.
      */
-    cur->merr = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
+    if (cur->pm) {
+        struct element_source **esrcv;
+        uint                    esrcc;
+
+        pmerge_reset(cur->pm, cur->seqno, cur_novals(cur));
+        esrcc = pmerge_esrcv(cur->pm, &esrcv);
+
+        cur->merr = bin_heap2_prepare(cur->bh, esrcc, esrcv);
+        if (!cur->merr)
+            cur->merr = pmerge_err(cur->pm);
+    } else {
+        cur->merr = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
+    }
+
     perfc_set(pc, PERFC_BA_CNCAPPED_ACTIVE, (10000 * bin_heap2_width(cur->bh)) / cur->iterc);
 
     /*
@@ -2798,6 +3306,7 @@ cn_comp_update_kvcompact(struct cn_compaction_work *work, struct kvset *new_kvse
         le = work->cw_mark;
         for (i = 0; i < work->cw_kvset_cnt; i++) {
             tmp = list_prev_entry(le, le_link);
+            cn_node_heat_retire(work->cw_node, le->le_kvset);
             list_del(&le->le_link);
             list_add(&le->le_link, &retired_kvsets);
             le = tmp;
@@ -2934,6 +3443,7 @@ cn_comp_update_spill(struct cn_compaction_work *work, struct spill_child *childv
             assert(!list_empty(&pnode->tn_kvset_list));
             le = list_last_entry(&pnode->tn_kvset_list, struct kvset_list_entry, le_link);
             assert(kx > 0 || work->cw_dgen_lo == kvset_get_dgen(le->le_kvset));
+            cn_node_heat_retire(pnode, le->le_kvset);
             list_del(&le->le_link);
             list_add(&le->le_link, &retired_kvsets);
         }
@@ -3029,6 +3539,45 @@ done:
     return err;
 }
 
+/**
+ * cn_comp_wamp() - account for the bytes a committed job read and wrote
+ */
+static void
+cn_comp_wamp(struct cn_compaction_work *w)
+{
+    struct cn_merge_stats *ms = &w->cw_stats;
+    enum cn_wamp_op        op;
+    uint                   level = w->cw_node->tn_loc.node_level;
+
+    /* Expired kvsets are deleted, not read or rewritten. */
+    if (w->cw_expire)
+        return;
+
+    switch (w->cw_action) {
+        case CN_ACTION_COMPACT_K:
+            op = CN_WAMP_KCOMPACT;
+            break;
+        case CN_ACTION_COMPACT_KV:
+            op = CN_WAMP_KVCOMPACT;
+            break;
+        case CN_ACTION_SPILL:
+            op = CN_WAMP_SPILL;
+            break;
+        default:
+            return;
+    }
+
+    cn_wamp_add(
+        &w->cw_tree->ct_wamp,
+        get_time_ns(),
+        op,
+        level,
+        w->cw_input_wlen,
+        op == CN_WAMP_SPILL ? level + 1 : level,
+        ms->ms_kblk_write.op_size + ms->ms_vblk_write.op_size,
+        &w->cw_samp_post);
+}
+
 /**
  * cn_comp_commit() - commit compaction operation to cndb log
  * See section comment for more info.
@@ -3150,6 +3699,11 @@ done:
 
     /* always free kvset ptrs */
     free(kvsets);
+
+    if (!w->cw_err)
+        cn_comp_wamp(w);
+
+    flightrec_add(FLIGHTREC_CN_COMP_COMMIT, w->cw_tree->cnid, merr_errno(w->cw_err));
 }
 
 /**
@@ -3284,6 +3838,24 @@ cn_comp_compact(struct cn_compaction_work *w)
     if (ev(err))
         goto err_exit;
 
+    if (w->cw_expire) {
+        /* Expired kvsets are deleted without reading them.  Commit a
+         * k-compaction with no output kvset (see cn_comp_commit()).
+         */
+        w->cw_outv = calloc(1, sizeof(*w->cw_outv));
+        if (ev(!w->cw_outv)) {
+            err = merr(ENOMEM);
+            kvdb_health_event(hp, KVDB_HEALTH_FLAG_NOMEM, err);
+            goto err_exit;
+        }
+
+        w->cw_outc = 1;
+        w->cw_keep_vblks = false;
+        w->cw_t2_prep = w->cw_t3_build = get_time_ns();
+        skip_commit = true;
+        goto txn_start;
+    }
+
     /* cn_tree_prepare_compaction() will initiate I/O
      * if ASYNCIO is enabled.
      */
@@ -3326,6 +3898,11 @@ cn_comp_compact(struct cn_compaction_work *w)
         if (w->cw_inputv[i])
             w->cw_inputv[i]->kvi_ops->kvi_release(w->cw_inputv[i]);
     free(w->cw_inputv);
+    for (i = 0; w->cw_subc > 1 && i < (w->cw_subc - 1) * w->cw_kvset_cnt; i++)
+        if (w->cw_subinputv[i])
+            w->cw_subinputv[i]->kvi_ops->kvi_release(w->cw_subinputv[i]);
+    free(w->cw_subinputv);
+    free(w->cw_subkeyv);
     free(w->cw_drop_tombv);
     if (ev(err)) {
         if (!w->cw_canceled)
@@ -3341,6 +3918,7 @@ cn_comp_compact(struct cn_compaction_work *w)
         w->cw_keep_vblks = false;
     }
 
+txn_start:
     if (!skip_commit) {
         w->cw_tagv = calloc(w->cw_outc, sizeof(*w->cw_tagv));
         if (!w->cw_tagv) {
@@ -3417,6 +3995,17 @@ cn_comp(struct cn_compaction_work *w)
     u64               tstart;
     struct perfc_set *pc = w->cw_pc;
 
+    HSE_SDT(
+        cn_comp_start,
+        w,
+        w->cw_tree->cnid,
+        w->cw_action,
+        w->cw_node->tn_loc.node_level,
+        w->cw_node->tn_loc.node_offset,
+        w->cw_kvset_cnt);
+
+    flightrec_add(FLIGHTREC_CN_COMP_START, w->cw_tree->cnid, w->cw_action);
+
     tstart = perfc_lat_start(pc);
     cn_comp_compact(w);
 
@@ -3435,7 +4024,7 @@ cn_comp(struct cn_compaction_work *w)
         /* Non-root spill (only one at a time per node). */
         cn_comp_finish(w);
     }
-    perfc_lat_record(pc, PERFC_LT_CNCOMP_TOTAL, tstart);
+    perfc_lat_record(pc, PERFC_HG_CNCOMP_TOTAL, tstart);
 }
 
 /**
@@ -3490,6 +4079,7 @@ cn_tree_ingest_update(struct cn_tree *tree, struct kvset *kvset, void *ptomb, ui
     rmlock_wlock(&tree->ct_lock);
     kvset_list_add(kvset, &tree->ct_root->tn_kvset_list);
     cn_inc_ingest_dgen(tree->cn);
+    cn_tree_ttl_ingest(tree, kvset_get_dgen(kvset));
 
     /* Record ptomb as the max ptomb seen by this cn */
     if (cn_get_flags(tree->cn) & CN_CFLAG_CAPPED) {
@@ -3510,10 +4100,135 @@ cn_tree_ingest_update(struct cn_tree *tree, struct kvset *kvset, void *ptomb, ui
 
     rmlock_wunlock(&tree->ct_lock);
 
+    cn_wamp_add(
+        &tree->ct_wamp,
+        get_time_ns(),
+        CN_WAMP_INGEST,
+        0,
+        0,
+        0,
+        kvset_wlen(kvset_statsp(kvset)),
+        &post);
+
     csched_notify_ingest(
         cn_get_sched(tree->cn), tree, post.r_alen - pre.r_alen, post.r_wlen - pre.r_wlen);
 }
 
+/*----------------------------------------------------------------
+ * SECTION: Partitioned ingest
+ *
+ * A root spill rewrites every ingested kvset into the root's children.
+ * When the root node is empty, c0 can instead partition its ingest by
+ * the root's spill routing and hand cn one kvset per child, which cn
+ * then adds directly to the children.  This is only valid while the
+ * root is empty, as every kvset in a child must be older than every
+ * kvset in its parent.  The root only gains kvsets via ingest, which
+ * is serialized, and it loses them only when a root spill commits,
+ * so an empty root also guarantees no root spill is in progress.
+ */
+
+uint
+cn_tree_ingest_fanout(struct cn_tree *tree)
+{
+    struct cn_tree_node *root = tree->ct_root;
+    uint                 fanout = 1;
+    void *               lock;
+
+    if (!tree->rp || !tree->rp->cn_ingest_partition || cn_is_capped(tree->cn))
+        return 1;
+
+    /* Prefix trees that spill from the root by full key hash must
+     * replicate ptombs into every child, which only spill can do.
+     */
+    if (tree->ct_pfx_len && !root->tn_pfx_spill)
+        return 1;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    if (root->tn_childc == tree->ct_cp->cp_fanout && list_empty(&root->tn_kvset_list))
+        fanout = tree->ct_cp->cp_fanout;
+    rmlock_runlock(lock);
+
+    return fanout;
+}
+
+uint
+cn_tree_ingest_route(struct cn_tree *tree, const struct key_obj *kobj)
+{
+    struct cn_khashmap *khashmap = tree->ct_khashmap;
+    size_t              hashlen;
+    u64                 hash;
+    uint                child;
+
+    /* Route exactly as kv_spill() would from the root (i.e., hash
+     * shift zero), see cn_spill_khashmap_sync() for khashmap updates.
+     */
+    hashlen = tree->ct_root->tn_pfx_spill ? tree->ct_pfx_len : 0;
+    hashlen = hashlen ?: key_obj_len(kobj) - tree->ct_sfx_len;
+
+    hash = pfx_obj_hash64(kobj, hashlen);
+
+    if (khashmap) {
+        u8 * mapv = khashmap->khm_mapv;
+        uint idx = hash % CN_TSTATE_KHM_SZ;
+
+        if (unlikely(mapv[idx] == 0)) {
+            spin_lock(&khashmap->khm_lock);
+            while (mapv[idx] == 0)
+                mapv[idx] = (khashmap->khm_gen += 3);
+            spin_unlock(&khashmap->khm_lock);
+        }
+        child = mapv[idx];
+    } else {
+        child = hash;
+    }
+
+    return child & tree->ct_fanout_mask;
+}
+
+void
+cn_tree_ingest_update_children(struct cn_tree *tree, struct kvset **kvsetv, uint kvsetc)
+{
+    struct cn_tree_node *root = tree->ct_root;
+    struct cn_samp_stats pre, post, diff;
+    u64                  dgen = 0;
+    u64                  wlen = 0;
+    uint                 i;
+
+    assert(kvsetc == tree->ct_cp->cp_fanout);
+
+    rmlock_wlock(&tree->ct_lock);
+    assert(list_empty(&root->tn_kvset_list));
+
+    cn_tree_samp(tree, &pre);
+
+    for (i = 0; i < kvsetc; i++) {
+        struct cn_tree_node *tn = root->tn_childv[i];
+
+        if (!kvsetv[i])
+            continue;
+
+        assert(tn);
+        kvset_list_add(kvsetv[i], &tn->tn_kvset_list);
+        cn_tree_samp_update_ingest(tree, tn);
+        dgen = kvset_get_dgen(kvsetv[i]);
+        wlen += kvset_wlen(kvset_statsp(kvsetv[i]));
+    }
+
+    cn_inc_ingest_dgen(tree->cn);
+    if (dgen)
+        cn_tree_ttl_ingest(tree, dgen);
+
+    cn_tree_samp(tree, &post);
+
+    rmlock_wunlock(&tree->ct_lock);
+
+    cn_wamp_add(&tree->ct_wamp, get_time_ns(), CN_WAMP_INGEST, 1, 0, 1, wlen, &post);
+
+    cn_samp_diff(&diff, &post, &pre);
+
+    csched_notify_ingest_children(cn_get_sched(tree->cn), tree, &diff);
+}
+
 void
 cn_tree_perfc_shape_report(
     struct cn_tree *  tree,
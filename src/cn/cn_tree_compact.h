@@ -21,6 +21,7 @@
 
 struct cn_tree;
 struct cn_tree_node;
+struct key_obj;
 struct kv_iterator;
 struct kvset_list_entry;
 struct kvset_mblocks;
@@ -49,6 +50,10 @@ enum cn_comp_rule {
     CN_CR_LSHORT_IDLE,    /* short leaf, idle */
     CN_CR_LSHORT_IDLE_VG, /* short leaf, idle, vblk groups */
     CN_CR_LSCATTER,       /* leaf vblk scatter */
+    CN_CR_LREAD,          /* leaf read heat */
+    CN_CR_LTIER,          /* leaf size-tiered merge */
+    CN_CR_LTIER_SAMP,     /* leaf size-tiered merge, reducing space amp */
+    CN_CR_LTTL,           /* leaf expired kvsets (kvs_ttl) */
     CN_CR_END,
 };
 
@@ -107,6 +112,14 @@ cn_comp_rule2str(enum cn_comp_rule rule)
             return "idle_vg";
         case CN_CR_LSCATTER:
             return "scatter";
+        case CN_CR_LREAD:
+            return "read";
+        case CN_CR_LTIER:
+            return "tier";
+        case CN_CR_LTIER_SAMP:
+            return "tier_samp";
+        case CN_CR_LTTL:
+            return "ttl";
     }
 
     return "unknown_rule";
@@ -145,6 +158,7 @@ struct cn_work_est {
  *                       tree is being updated with this work
  * @cw_dgen_hi:      the dgen of the newest kvset to be compacted
  * @cw_dgen_lo:      the dgen of the oldest kvset to be compacted
+ * @cw_expire:       delete the input kvsets without a merge (they have expired)
  * @cw_active_count: for tracking the number of active "root" or "other" threads
  * @cw_horizon:      sequence number horizon to use while compacting
  * @cw_debug:        enables debug stats
@@ -155,6 +169,12 @@ struct cn_work_est {
  *                       kvsets during k-compaction
  * @cw_hash_shift:   used to determine output child when spilling
  * @cw_drop_tombv:   if true, then tombstones can be dropped in the merge loop
+ * @cw_subc:         number of key-range subcompactions (0 if not split)
+ * @cw_subkeyv:      boundary keys between subcompactions (@cw_subc - 1)
+ * @cw_subinputv:    input iterators of subcompactions 1 .. @cw_subc - 1,
+ *                   @cw_kvset_cnt per subcompaction
+ * @cw_sub_ekey:     if set, exclusive end of the key range to merge
+ * @cw_input_wlen:   bytes of the input kvsets the merge reads
  * @cw_work_txid:    the cndb transaction id
  * @cw_commitc:      keeps track of how many output mblocks have been committed
  * @cw_keep_vblks:   indicates whether or not vblocks should be deleted or
@@ -205,6 +225,7 @@ struct cn_compaction_work {
     u64                      cw_dgen_hi;
     u64                      cw_dgen_lo;
     atomic_t *               cw_bonus;
+    bool                     cw_expire;
 
     /* For scheduler */
     struct sts_job        cw_job;
@@ -228,6 +249,11 @@ struct cn_compaction_work {
     struct kvset_vblk_map cw_vbmap;
     u32                   cw_hash_shift;
     bool *                cw_drop_tombv;
+    uint                  cw_subc;
+    struct key_obj *      cw_subkeyv;
+    struct kv_iterator ** cw_subinputv;
+    const struct key_obj *cw_sub_ekey;
+    u64                   cw_input_wlen;
 
     /* initialized in cn_compaction_worker() */
     u64                   cw_work_txid;
@@ -254,10 +280,62 @@ cn_tree_ingest_update(
     uint            ptlen,
     u64             ptseq);
 
+/**
+ * cn_tree_ingest_fanout() - number of kvsets into which to partition an ingest
+ * @tree: cn tree
+ *
+ * Return: the root node's fanout if the kvs enables partitioned ingest
+ * and the root node has all its children and no kvsets, otherwise 1
+ */
+uint
+cn_tree_ingest_fanout(struct cn_tree *tree);
+
+/**
+ * cn_tree_ingest_route() - root node child to which a key would spill
+ * @tree: cn tree
+ * @kobj: key
+ */
+uint
+cn_tree_ingest_route(struct cn_tree *tree, const struct key_obj *kobj);
+
+/**
+ * cn_tree_ingest_update_children() - add one ingested kvset to each root child
+ * @tree:   cn tree
+ * @kvsetv: kvset for each child (NULL if the partition was empty)
+ * @kvsetc: number of elements in @kvsetv (i.e., the root node's fanout)
+ *
+ * The caller must have verified with cn_tree_ingest_fanout() that the
+ * root node has no kvsets.
+ */
+void
+cn_tree_ingest_update_children(struct cn_tree *tree, struct kvset **kvsetv, uint kvsetc);
+
 /* MTF_MOCK */
 void
 cn_tree_capped_compact(struct cn_tree *tree);
 
+/**
+ * cn_tree_ttl_update() - advance the kvs_ttl expiry of a tree
+ * @tree: cn tree
+ *
+ * Return: true if more kvsets have expired since the last call
+ */
+bool
+cn_tree_ttl_update(struct cn_tree *tree);
+
+/**
+ * cn_tree_ttl_window() - kvs_ttl time window of a kvset
+ * @tree: cn tree
+ * @dgen: kvset dgen
+ *
+ * The caller must hold the tree lock.  Kvsets in different windows
+ * should not be merged, so that each expires as a whole.
+ *
+ * Return: start time of the window, 0 if the kvset has expired
+ */
+u64
+cn_tree_ttl_window(struct cn_tree *tree, u64 dgen);
+
 /* MTF_MOCK */
 bool
 cn_node_comp_token_get(struct cn_tree_node *tn);
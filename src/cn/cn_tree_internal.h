@@ -19,6 +19,8 @@
 #include "cn_tree.h"
 #include "cn_tree_iter.h"
 #include "cn_metrics.h"
+#include "cn_heat.h"
+#include "cn_wamp.h"
 #include "omf.h"
 
 #include "csched_sp3.h"
@@ -75,6 +77,26 @@ struct cn_khashmap {
     u8         khm_mapv[CN_TSTATE_KHM_SZ];
 };
 
+/* kvs_ttl is tracked in time windows of kvs_ttl / CN_TTL_WINDOWS_PER_TTL */
+#define CN_TTL_WINDOWS_PER_TTL (8)
+#define CN_TTL_WINDOWS         (2 * CN_TTL_WINDOWS_PER_TTL)
+
+/**
+ * struct cn_ttl_window - kvsets ingested in a kvs_ttl time window
+ * @tw_dgen:  dgen of the newest kvset ingested in the window
+ * @tw_start: time of the first ingest in the window (ns)
+ * @tw_last:  time of the last ingest in the window (ns)
+ *
+ * Ingest dgens increase with time and compaction preserves the dgen
+ * order of kvsets along every search path, so all data in kvsets with
+ * a dgen at or below @tw_dgen expires once @tw_last is kvs_ttl old.
+ */
+struct cn_ttl_window {
+    u64 tw_dgen;
+    u64 tw_start;
+    u64 tw_last;
+};
+
 /**
  * struct cn_tree - the cn tree (tree of nodes holding kvsets)
  * @ct_root:        root node of tree
@@ -99,7 +121,11 @@ struct cn_khashmap {
  * @ct_last_ptseq:
  * @ct_last_ptlen:  length of @ct_last_ptomb
  * @ct_last_ptomb:  if cn is a capped, this holds the last (largest) ptomb in cn
+ * @ct_ttl_dgen:    kvsets with a dgen at or below this have expired (kvs_ttl)
+ * @ct_ttl_windowc: number of entries in @ct_ttl_windowv
+ * @ct_ttl_windowv: ingest time windows not yet expired, oldest first
  * @ct_kle_cache:   kvset list entry cache
+ * @ct_wamp:        bytes read and written by ingests and compactions
  * @ct_lock:        read-mostly lock to protect kvset list
  *
  * Note: The first fields are frequently accessed in the order listed
@@ -140,6 +166,10 @@ struct cn_tree {
     u64                      ct_capped_dgen;
     struct kvset_list_entry *ct_capped_le;
 
+    atomic64_t           ct_ttl_dgen;
+    uint                 ct_ttl_windowc;
+    struct cn_ttl_window ct_ttl_windowv[CN_TTL_WINDOWS];
+
     __aligned(SMP_CACHE_BYTES) struct kvdb_health *ct_kvdb_health;
 
     u64 ct_last_ptseq;
@@ -148,6 +178,8 @@ struct cn_tree {
 
     __aligned(SMP_CACHE_BYTES) struct cn_kle_cache ct_kle_cache;
 
+    __aligned(SMP_CACHE_BYTES) struct cn_wamp ct_wamp;
+
     struct rmlock ct_lock;
 };
 
@@ -162,6 +194,10 @@ struct cn_tree {
  * @tn_stats_add_cntr:
  * @tn_stats_rem_cntr:
  * @tn_ns:           metrics about node to guide node compaction decisions
+ * @tn_heat:         gets and cursors that searched the node, and the probe
+ *                   counters of retired kvsets (see cn_heat_folds())
+ * @tn_heat_probes:  gets and cursors counted by kvsets retired from the
+ *                   node, protected by the tree lock
  * @tn_loc:          location of node within tree
  * @tn_kvset_cnt:    number of kvsets  in node
  * @tn_pfx_spill:    true if spills/scans from this node use the prefix hash
@@ -187,6 +223,9 @@ struct cn_tree_node {
     u64                  tn_size_max;
     u64                  tn_update_incr_dgen;
 
+    __aligned(SMP_CACHE_BYTES) struct cn_heat tn_heat;
+    u64                                       tn_heat_probes;
+
     __aligned(SMP_CACHE_BYTES) struct cn_node_loc tn_loc;
     bool                 tn_terminal_node_warning;
     bool                 tn_pfx_spill;
@@ -196,6 +235,18 @@ struct cn_tree_node {
     struct cn_tree_node *tn_childv[];
 };
 
+/**
+ * cn_tree_ttl_dgen() - dgen at or below which kvsets have expired
+ * @tree: cn tree
+ *
+ * Return: 0 if no kvsets have expired or kvs_ttl is not set
+ */
+static inline u64
+cn_tree_ttl_dgen(struct cn_tree *tree)
+{
+    return atomic64_read(&tree->ct_ttl_dgen);
+}
+
 /* cn_tree_node to sp3_node */
 #define tn2spn(_tn) (&(_tn)->tn_sched.sp3n)
 #define spn2tn(_spn) container_of(_spn, struct cn_tree_node, tn_sched.sp3n)
@@ -227,6 +278,31 @@ rmlock_runlock(void *cookie);
 void
 cn_node_stats_get(const struct cn_tree_node *tn, struct cn_node_stats *stats);
 
+/**
+ * cn_node_heat_get() - get the read activity counters of a node
+ * @tn:   node
+ * @heat: (output) counters, see enum kvset_heat_ctr
+ *
+ * Caller must hold the tree lock.
+ */
+void
+cn_node_heat_get(struct cn_tree_node *tn, struct kvset_heat *heat);
+
+/**
+ * cn_node_rheat() - kvsets probed in a node beyond the first per read
+ * @tn: node
+ *
+ * Every get and cursor that searches a node counts once in the node and
+ * once in each kvset it probes, so the difference between the two is
+ * the number of probes that compacting the node would eliminate.
+ *
+ * Return: cumulative count, which only decreases if read transiently
+ * between a node's count and its kvsets' counts being updated
+ */
+/* MTF_MOCK */
+u64
+cn_node_rheat(struct cn_tree_node *tn);
+
 /* MTF_MOCK */
 bool
 cn_node_isleaf(const struct cn_tree_node *node);
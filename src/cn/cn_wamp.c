@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/time.h>
+#include <hse_util/timing.h>
+
+#include <hse_ikvdb/cn.h>
+
+#include "cn_wamp.h"
+#include "cn_tree_internal.h"
+
+#define CN_WAMP_INTERVAL_NS ((u64)CN_WAMP_INTERVAL_SECS * NSEC_PER_SEC)
+
+static const char *const cn_wamp_op_namev[] = {
+    [CN_WAMP_INGEST] = "ingest",
+    [CN_WAMP_SPILL] = "spill",
+    [CN_WAMP_KCOMPACT] = "kcompact",
+    [CN_WAMP_KVCOMPACT] = "kvcompact",
+};
+
+const char *
+cn_wamp_op_name(enum cn_wamp_op op)
+{
+    if (op >= NELEM(cn_wamp_op_namev))
+        return "unknown";
+
+    return cn_wamp_op_namev[op];
+}
+
+void
+cn_wamp_init(struct cn_wamp *wa, u64 now)
+{
+    int i;
+
+    memset(wa, 0, sizeof(*wa));
+    spin_lock_init(&wa->wa_lock);
+    wa->wa_since = now;
+
+    /* Mark every interval as unused. */
+    for (i = 0; i < CN_WAMP_INTERVALS; i++)
+        wa->wa_intv[i].ws_idx = U64_MAX;
+}
+
+static void
+cn_wamp_sample_add(
+    struct cn_wamp_sample *     ws,
+    enum cn_wamp_op             op,
+    uint                        rlvl,
+    u64                         rbytes,
+    uint                        wlvl,
+    u64                         wbytes,
+    const struct cn_samp_stats *samp)
+{
+    ws->ws_opv[op].wc_jobs++;
+    ws->ws_opv[op].wc_rbytes += rbytes;
+    ws->ws_opv[op].wc_wbytes += wbytes;
+
+    ws->ws_lvlv[rlvl].wc_rbytes += rbytes;
+    ws->ws_lvlv[wlvl].wc_jobs++;
+    ws->ws_lvlv[wlvl].wc_wbytes += wbytes;
+
+    if (samp) {
+        ws->ws_alen = samp->i_alen + samp->l_alen;
+        ws->ws_good = samp->l_good;
+    }
+}
+
+void
+cn_wamp_add(
+    struct cn_wamp *            wa,
+    u64                         now,
+    enum cn_wamp_op             op,
+    uint                        rlvl,
+    u64                         rbytes,
+    uint                        wlvl,
+    u64                         wbytes,
+    const struct cn_samp_stats *samp)
+{
+    struct cn_wamp_sample *ws;
+    u64                    idx;
+
+    assert(op < CN_WAMP_OP_MAX);
+
+    rlvl = min_t(uint, rlvl, CN_WAMP_LEVELS - 1);
+    wlvl = min_t(uint, wlvl, CN_WAMP_LEVELS - 1);
+
+    idx = now / CN_WAMP_INTERVAL_NS;
+
+    spin_lock(&wa->wa_lock);
+    ws = wa->wa_intv + (idx % CN_WAMP_INTERVALS);
+
+    if (ws->ws_idx != idx) {
+        memset(ws, 0, sizeof(*ws));
+        ws->ws_idx = idx;
+        ws->ws_alen = wa->wa_total.ws_alen;
+        ws->ws_good = wa->wa_total.ws_good;
+    }
+
+    cn_wamp_sample_add(ws, op, rlvl, rbytes, wlvl, wbytes, samp);
+    cn_wamp_sample_add(&wa->wa_total, op, rlvl, rbytes, wlvl, wbytes, samp);
+    wa->wa_total.ws_idx = idx;
+    spin_unlock(&wa->wa_lock);
+}
+
+void
+cn_wamp_read(struct cn_wamp *wa, u64 now, struct cn_wamp_view *view)
+{
+    u64 idx, cur;
+
+    cur = now / CN_WAMP_INTERVAL_NS;
+    idx = cur >= CN_WAMP_INTERVALS ? cur - CN_WAMP_INTERVALS + 1 : 0;
+
+    view->wv_now = now;
+    view->wv_intc = 0;
+
+    spin_lock(&wa->wa_lock);
+    view->wv_since = wa->wa_since;
+    view->wv_total = wa->wa_total;
+
+    for (; idx <= cur; idx++) {
+        struct cn_wamp_sample *ws = wa->wa_intv + (idx % CN_WAMP_INTERVALS);
+
+        if (ws->ws_idx == idx)
+            view->wv_intv[view->wv_intc++] = *ws;
+    }
+    spin_unlock(&wa->wa_lock);
+}
+
+void
+cn_wamp_get(struct cn *cn, struct cn_wamp_view *view)
+{
+    struct cn_tree *tree = cn_get_tree(cn);
+
+    cn_wamp_read(&tree->ct_wamp, get_time_ns(), view);
+}
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_CN_WAMP_H
+#define HSE_KVS_CN_WAMP_H
+
+#include <hse_util/spinlock.h>
+
+#include <hse_ikvdb/cn_wamp.h>
+
+struct cn_samp_stats;
+
+/**
+ * struct cn_wamp - a cn tree's write-amp accounting
+ * @wa_lock:  protects all fields
+ * @wa_since: get_time_ns() when accounting started
+ * @wa_total: totals since @wa_since
+ * @wa_intv:  ring of intervals indexed by ws_idx % CN_WAMP_INTERVALS
+ *
+ * Jobs are accounted when they commit, which is far too seldom for
+ * the lock to be contended.
+ */
+struct cn_wamp {
+    spinlock_t            wa_lock;
+    u64                   wa_since;
+    struct cn_wamp_sample wa_total;
+    struct cn_wamp_sample wa_intv[CN_WAMP_INTERVALS];
+};
+
+void
+cn_wamp_init(struct cn_wamp *wa, u64 now);
+
+/**
+ * cn_wamp_add() - account for a completed job
+ * @wa:     accounting
+ * @now:    get_time_ns()
+ * @op:     operation
+ * @rlvl:   level the job read from
+ * @rbytes: bytes read
+ * @wlvl:   level the job wrote to
+ * @wbytes: bytes written
+ * @samp:   tree samp stats after the job, may be NULL
+ */
+void
+cn_wamp_add(
+    struct cn_wamp *            wa,
+    u64                         now,
+    enum cn_wamp_op             op,
+    uint                        rlvl,
+    u64                         rbytes,
+    uint                        wlvl,
+    u64                         wbytes,
+    const struct cn_samp_stats *samp);
+
+/**
+ * cn_wamp_read() - take a snapshot of @wa
+ * @wa:   accounting
+ * @now:  get_time_ns()
+ * @view: (output) snapshot
+ */
+void
+cn_wamp_read(struct cn_wamp *wa, u64 now, struct cn_wamp_view *view);
+
+#endif
@@ -10,6 +10,7 @@
 #include <hse_util/string.h>
 #include <hse_util/log2.h>
 #include <hse_util/atomic.h>
+#include <hse_util/flightrec.h>
 
 #define MTF_MOCK_IMPL_cndb
 #define MTF_MOCK_IMPL_cndb_internal
@@ -3120,6 +3121,8 @@ cndb_txn_start(struct cndb *cndb, u64 *txid, u64 ingestid, int nc, int nd, u64 s
     omf_set_tx_seqno(&tx, cndb->cndb_seqno);
     omf_set_tx_ingestid(&tx, ingestid);
 
+    flightrec_add(FLIGHTREC_CNDB_TXN_START, *txid, ingestid);
+
     err = ev(cndb_journal(cndb, &tx, sizeof(tx)), HSE_ERR);
     return err;
 }
@@ -3294,6 +3297,8 @@ cndb_txn_ack_c(struct cndb *cndb, u64 txid)
     if (t != NFAULT_TRIG_NONE)
         return 0;
 
+    flightrec_add(FLIGHTREC_CNDB_TXN_ACK_C, txid, 0);
+
     return cndb_txn_ack(cndb, txid, 0, 0);
 }
 
@@ -3317,6 +3322,8 @@ cndb_txn_nak(struct cndb *cndb, u64 txid)
     cndb_set_hdr(&nak.hdr, CNDB_TYPE_NAK, sizeof(nak));
     omf_set_nak_txid(&nak, txid);
 
+    flightrec_add(FLIGHTREC_CNDB_TXN_NAK, txid, 0);
+
     err = cndb_journal(cndb, &nak, sizeof(nak));
 
     return ev(err, HSE_ERR);
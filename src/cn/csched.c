@@ -45,6 +45,7 @@ csched_create(
             err = sp_noop_create(rp, mp, health, &cs);
             break;
         case csched_policy_sp3:
+        case csched_policy_tiered:
             err = sp3_create(ds, rp, mp, health, &cs);
             break;
     }
@@ -73,6 +74,18 @@ csched_notify_ingest(struct csched *handle, struct cn_tree *tree, size_t alen, s
         cs->cs_notify_ingest(cs, tree, alen, wlen);
 }
 
+void
+csched_notify_ingest_children(
+    struct csched *             handle,
+    struct cn_tree *            tree,
+    const struct cn_samp_stats *diff)
+{
+    struct csched_ops *cs = (void *)handle;
+
+    if (cs && cs->cs_notify_ingest_children)
+        cs->cs_notify_ingest_children(cs, tree, diff);
+}
+
 void
 csched_tree_add(struct csched *handle, struct cn_tree *tree)
 {
@@ -118,6 +131,15 @@ csched_compact_status_get(struct csched *handle, struct hse_kvdb_compact_status
         cs->cs_compact_status_get(cs, status);
 }
 
+void
+csched_io_charge(struct csched *handle, enum csched_io_class ioc, size_t len)
+{
+    struct csched_ops *cs = (void *)handle;
+
+    if (cs && cs->cs_io_charge)
+        cs->cs_io_charge(cs, ioc, len);
+}
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "csched_ut_impl.i"
 #endif /* HSE_UNIT_TEST_MODE */
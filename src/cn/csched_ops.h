@@ -8,11 +8,13 @@
 
 #include <hse_util/inttypes.h>
 
+#include <hse_ikvdb/csched.h>
 #include <hse_ikvdb/sched_sts.h>
 
 struct csched_ops;
 struct cn_tree;
 struct throttle_sensor;
+struct cn_samp_stats;
 struct hse_kvdb_compact_status;
 
 struct csched_ops {
@@ -23,12 +25,19 @@ struct csched_ops {
 
     void (*cs_notify_ingest)(struct csched_ops *, struct cn_tree *, size_t, size_t);
 
+    void (*cs_notify_ingest_children)(
+        struct csched_ops *,
+        struct cn_tree *,
+        const struct cn_samp_stats *);
+
     void (*cs_throttle_sensor)(struct csched_ops *, struct throttle_sensor *);
 
     void (*cs_compact_request)(struct csched_ops *, int);
 
     void (*cs_compact_status_get)(struct csched_ops *, struct hse_kvdb_compact_status *);
 
+    void (*cs_io_charge)(struct csched_ops *, enum csched_io_class, size_t);
+
     void (*cs_destroy)(struct csched_ops *);
 };
 
@@ -8,6 +8,7 @@
 #include <hse_util/platform.h>
 #include <hse_util/slab.h>
 #include <hse_util/string.h>
+#include <hse_util/token_bucket.h>
 
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/ikvdb.h>
@@ -16,6 +17,8 @@
 #include <hse_ikvdb/sched_sts.h>
 #include <hse_ikvdb/throttle.h>
 #include <hse_ikvdb/kvdb_rparams.h>
+#include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/csched_rp.h>
 
 #include "csched_ops.h"
 #include "csched_sp3.h"
@@ -138,6 +141,29 @@ struct mpool;
  *      size because long nodes decrease query performance, and large nodes
  *      are hard to compact and spill.  This extra logic is not strictly
  *      required to manage space amp.
+ *
+ *    - If csched_rheat_min is set, nodes are also compacted in order of
+ *      read heat, i.e., the rate of kvset probes beyond the first that
+ *      gets and cursors make in each node.  This lets a short node that
+ *      takes many reads be compacted ahead of a longer but cold node.
+ *
+ * Size-tiered trees:
+ *    Trees of KVSes with the cn_compact_tiered rparam set, or all trees if
+ *    csched_policy is csched_policy_tiered, favor write amp over space amp.
+ *    Their root and internal nodes spill as described above, but their
+ *    leaves are not compacted to meet the space amp target, nor for
+ *    length or vblock scatter.  Instead, runs of similarly sized kvsets
+ *    are merged by k-compaction (see sp3_node_tier_len()), and the oldest
+ *    kvsets are kv-compacted only when no run qualifies and the leaf's
+ *    space amp exceeds a bound.  Leaves still spill when they get too big.
+ *
+ * Trees with kvs_ttl set:
+ *    Kvsets expire kvs_ttl seconds after they are ingested (see
+ *    cn_tree_ttl_update()).  Leaves with expired kvsets at the tail are
+ *    kept on the RBT_L_TTL red-black tree, and those kvsets are deleted
+ *    without being read.  Other leaf compactions only merge kvsets that
+ *    were ingested in the same time window, so that merging does not
+ *    extend the life of older data.
  */
 
 /* Red-Black Trees */
@@ -146,6 +172,9 @@ struct mpool;
 #define RBT_L_GARB  2 /* leaf nodes sorted by garbage */
 #define RBT_LI_LEN  3 /* internal and leaf nodes, sorted by #kvsets */
 #define RBT_L_SCAT  4 /* leaf nodes sorted by vblock scatter */
+#define RBT_LI_HEAT 5 /* internal and leaf nodes sorted by read heat */
+#define RBT_L_TIER  6 /* size-tiered leaf nodes sorted by merge width */
+#define RBT_L_TTL   7 /* leaf nodes sorted by expired kvsets */
 
 #define CSCHED_SAMP_MAX_MIN  100
 #define CSCHED_SAMP_MAX_MAX  999
@@ -157,7 +186,7 @@ struct mpool;
 #define CSCHED_LEAF_PCT_MAX  99
 
 static const char *const rbt_name[] = {
-    "ri_size", "l_size", "l_garb", "li_len", "l_scat",
+    "ri_size", "l_size", "l_garb", "li_len", "l_scat", "li_heat", "l_tier", "l_ttl",
 };
 
 struct sp3_qinfo {
@@ -187,6 +216,7 @@ qfull(struct sp3_qinfo *qi)
  * @new_tlist:        list of new trees
  * @new_tlist_lock:   lock for list of new trees
  * @samp_reduce:      if true, compact while samp > LWM
+ * @tiered:           if true, all trees use size-tiered leaf compaction
  */
 struct sp3 {
     /* Accessed only by monitor thread */
@@ -213,6 +243,7 @@ struct sp3 {
 
     int  activity;
     bool idle;
+    bool tiered;
 
     struct cn_compaction_work *wp;
 
@@ -273,6 +304,17 @@ struct sp3 {
     u64 ucomp_prev_report_ns __aligned(SMP_CACHE_BYTES);
     bool                     ucomp_active;
     bool                     ucomp_canceled;
+
+    /* Compaction I/O budget, charged by ingest and job threads,
+     * tuned by the monitor (see sp3_op_io_charge()).
+     */
+    struct tbkt io_tb;
+    struct tbkt io_leaf_tb;
+    u64         io_rate_max;
+    u64         io_rate;
+    uint        io_leaf_pct;
+    u64         io_lat_sum;
+    u64         io_lat_hits;
 };
 
 /* external to internal handle */
@@ -815,6 +857,24 @@ sp3_refresh_thresholds(struct sp3 *sp)
     v = sp->rp->csched_vb_scatter_pct;
     thresh.lscatter_pct = clamp_t(u64, v, 0, 100);
 
+    /* size-tiered leaf node settings */
+    v = sp->rp->csched_tier_params;
+    if (v != U64_MAX) {
+        if (v) {
+            thresh.tier_width_max = (v >> 0) & 0xff;
+            thresh.tier_width_min = (v >> 8) & 0xff;
+            thresh.tier_ratio_pct = (v >> 16) & 0xff;
+            thresh.tier_samp_pct = (v >> 24) & 0xff;
+        } else {
+            thresh.tier_width_max = 12;
+            thresh.tier_width_min = 4;
+            thresh.tier_ratio_pct = 20;
+            thresh.tier_samp_pct = 200;
+        }
+        thresh.tier_width_min = max(thresh.tier_width_min, SP3_TIER_WIDTH_MIN);
+        thresh.tier_width_max = max(thresh.tier_width_max, thresh.tier_width_min);
+    }
+
     if (!memcmp(&thresh, &sp->thresh, sizeof(thresh)))
         return;
 
@@ -829,7 +889,8 @@ sp3_refresh_thresholds(struct sp3 *sp)
                    " kvcompc: %u,"
                    " idlec: %u,"
                    " idlem: %u,"
-                   " lscatter_pct: %u%%",
+                   " lscatter_pct: %u%%,"
+                   " tier: min/max/ratio/samp %u/%u/%u%%/%u%%",
         thresh.rspill_kvsets_min,
         thresh.rspill_kvsets_max,
 
@@ -847,7 +908,12 @@ sp3_refresh_thresholds(struct sp3 *sp)
         thresh.llen_idlec,
         thresh.llen_idlem,
 
-        thresh.lscatter_pct);
+        thresh.lscatter_pct,
+
+        thresh.tier_width_min,
+        thresh.tier_width_max,
+        thresh.tier_ratio_pct,
+        thresh.tier_samp_pct);
 }
 
 static void
@@ -876,6 +942,130 @@ sp3_refresh_settings(struct sp3 *sp)
     sp3_refresh_worker_counts(sp);
 }
 
+/*****************************************************************
+ *
+ * SP3 compaction I/O budget
+ *
+ * Compaction reads and writes, as well as ingest writes, draw from a
+ * KVDB-wide token bucket refilled at csched_io_rate.  Ingest is never
+ * delayed, but its I/O is charged so that compaction backs off while
+ * ingest is busy.  Internal and leaf node work also draws from a second
+ * bucket limited to csched_io_leaf_pct of the budget, which leaves
+ * headroom for root node work (the work that unblocks ingest).
+ *
+ * If csched_io_lat_tgt is set, the budget is tuned once per second
+ * against the mean cN get latency of all managed trees: it is reduced
+ * by a quarter while the target is exceeded, and raised by 1/16th of
+ * csched_io_rate while latency is comfortably below the target.  The
+ * latency is sampled from the cN get perf counters, so tuning has no
+ * effect unless they are enabled.
+ */
+
+#define SP3_IO_RATE_MIN (4ul << 20)
+
+static void
+sp3_io_rate_set(struct sp3 *sp, u64 rate)
+{
+    u64 leaf = rate * sp->io_leaf_pct / 100;
+
+    /* Allow a quarter second worth of burst. */
+    tbkt_adjust(&sp->io_tb, rate / 4, rate);
+    tbkt_adjust(&sp->io_leaf_tb, leaf / 4, leaf);
+
+    sp->io_rate = rate;
+
+    perfc_set(&sp->sched_pc, PERFC_BA_SP3_IORATE, rate >> 20);
+}
+
+static void
+sp3_io_refresh(struct sp3 *sp)
+{
+    u64  rate_max = sp->rp->csched_io_rate << 20;
+    uint leaf_pct = sp->rp->csched_io_leaf_pct;
+
+    u64  rate_prev = sp->io_rate_max;
+
+    if (rate_max == rate_prev && leaf_pct == sp->io_leaf_pct)
+        return;
+
+    sp->io_leaf_pct = leaf_pct;
+    sp->io_rate_max = rate_max;
+
+    sp3_io_rate_set(sp, rate_max);
+
+    if (!rate_max && !rate_prev)
+        return;
+
+    hse_slog(
+        HSE_NOTICE,
+        HSE_SLOG_START("cn_io_budget"),
+        HSE_SLOG_FIELD("rate_mb", "%lu", (ulong)(rate_max >> 20)),
+        HSE_SLOG_FIELD("leaf_pct", "%u", leaf_pct),
+        HSE_SLOG_FIELD("lat_tgt_us", "%lu", (ulong)sp->rp->csched_io_lat_tgt),
+        HSE_SLOG_END);
+}
+
+static void
+sp3_io_tune(struct sp3 *sp)
+{
+    struct cn_tree *tree;
+
+    u64 sum = 0, hits = 0;
+    u64 lat, tgt, rate;
+
+    tgt = sp->rp->csched_io_lat_tgt * 1000;
+    if (!sp->io_rate_max || !tgt)
+        return;
+
+    list_for_each_entry (tree, &sp->mon_tlist, ct_sched.sp3t.spt_tlink) {
+        u64 tsum, thits;
+
+        perfc_dis_read(cn_get_lookup_perfc(tree->cn), PERFC_LT_CNGET_GET, &tsum, &thits);
+        sum += tsum;
+        hits += thits;
+    }
+
+    /* The counters are cumulative, but they go backward when a tree
+     * is removed or the counters are cleared.  Skip such intervals.
+     */
+    if (sum < sp->io_lat_sum || hits < sp->io_lat_hits) {
+        sp->io_lat_sum = sum;
+        sp->io_lat_hits = hits;
+        return;
+    }
+
+    lat = 0;
+    if (hits > sp->io_lat_hits)
+        lat = (sum - sp->io_lat_sum) / (hits - sp->io_lat_hits);
+
+    sp->io_lat_sum = sum;
+    sp->io_lat_hits = hits;
+
+    perfc_set(&sp->sched_pc, PERFC_BA_SP3_IOLAT, lat);
+
+    rate = sp->io_rate;
+    if (lat > tgt)
+        rate -= rate / 4;
+    else if (lat < tgt - tgt / 4)
+        rate += sp->io_rate_max / 16;
+
+    rate = clamp_t(u64, rate, min_t(u64, SP3_IO_RATE_MIN, sp->io_rate_max), sp->io_rate_max);
+    if (rate == sp->io_rate)
+        return;
+
+    sp3_io_rate_set(sp, rate);
+
+    if (debug_qos(sp)) {
+        hse_slog(
+            HSE_NOTICE,
+            HSE_SLOG_START("cn_io_tune"),
+            HSE_SLOG_FIELD("lat_ns", "%lu", (ulong)lat),
+            HSE_SLOG_FIELD("tgt_ns", "%lu", (ulong)tgt),
+            HSE_SLOG_FIELD("rate_mb", "%lu", (ulong)(rate >> 20)),
+            HSE_SLOG_END);
+    }
+}
+
 /*****************************************************************
  *
  * SP3 user-initiated compaction (ucomp)
@@ -1045,6 +1235,12 @@ sp3_unlink_all_nodes(struct sp3 *sp, struct cn_tree *tree)
         sp3_node_unlink(sp, tn2spn(tn));
 }
 
+static bool
+sp3_tree_is_tiered(struct sp3 *sp, struct cn_tree *tree)
+{
+    return sp->tiered || tree->rp->cn_compact_tiered;
+}
+
 static void
 sp3_dirty_node(struct sp3 *sp, struct cn_tree_node *tn)
 {
@@ -1054,17 +1250,48 @@ sp3_dirty_node(struct sp3 *sp, struct cn_tree_node *tn)
     uint             garbage;
 
     uint scatter = 0;
+    uint tier = 0;
+    uint ttl = 0;
 
     sp3_node_unlink(sp, spn);
 
+    spn->spn_tiered = sp3_tree_is_tiered(sp, tn->tn_tree);
+
     if (tn->tn_parent != NULL) {
         /* RBT_LI_LEN: internal and leaf nodes sorted by #kvsets*/
         sp3_node_insert(sp, spn, RBT_LI_LEN, n_kvsets);
+
+        /* RBT_LI_HEAT: internal and leaf nodes sorted by read heat */
+        if (spn->spn_rheat > 0 && n_kvsets > 1)
+            sp3_node_insert(sp, spn, RBT_LI_HEAT, spn->spn_rheat);
     }
 
     garbage = samp_pct_garbage(&tn->tn_samp, 100);
 
-    if (cn_node_isleaf(tn)) {
+    if (cn_node_isleaf(tn) && tn->tn_tree->rp->kvs_ttl) {
+        struct kvset_list_entry *mark;
+
+        /* RBT_L_TTL: leaf nodes sorted by number of expired kvsets */
+        ttl = sp3_node_ttl_len(spn, &mark);
+        if (ttl > 0)
+            sp3_node_insert(sp, spn, RBT_L_TTL, ttl);
+    }
+
+    if (cn_node_isleaf(tn) && spn->spn_tiered) {
+        struct kvset_list_entry *mark;
+        bool                     full;
+
+        /* RBT_L_PCAP: leaf nodes sorted by pct capacity */
+        sp3_node_insert(sp, spn, RBT_L_PCAP, tn->tn_ns.ns_pcap);
+
+        /* RBT_L_TIER: size-tiered leaf nodes with a merge pending,
+         * sorted by the number of kvsets to merge.
+         */
+        tier = sp3_node_tier_len(spn, &sp->thresh, &mark, &full);
+        if (tier > 0)
+            sp3_node_insert(sp, spn, RBT_L_TIER, tier);
+
+    } else if (cn_node_isleaf(tn)) {
 
         /* RBT_L_GARB: leaf nodes sorted by pct garbage.
          * Range: 0 <= rbe_weight <= 100.  If rbe_weight == 3, then
@@ -1101,6 +1328,9 @@ sp3_dirty_node(struct sp3 *sp, struct cn_tree_node *tn)
             HSE_SLOG_FIELD("alen", "%lu", (ulong)alen),
             HSE_SLOG_FIELD("garbage", "%lu", (ulong)garbage),
             HSE_SLOG_FIELD("scatter", "%u", scatter),
+            HSE_SLOG_FIELD("rheat", "%lu", (ulong)spn->spn_rheat),
+            HSE_SLOG_FIELD("tier", "%u", tier),
+            HSE_SLOG_FIELD("ttl", "%u", ttl),
             HSE_SLOG_END);
     }
 }
@@ -1199,6 +1429,43 @@ sp3_process_ingest(struct sp3 *sp)
             sp3_dirty_node(sp, tree->ct_root);
             ingested = true;
         }
+
+        /* A partitioned ingest bypassed the root, see
+         * cn_tree_ingest_update_children().
+         */
+        v = atomic_read(&spt->spt_ingest_children);
+        if (v) {
+            struct cn_tree_node *tn;
+            struct sp3_node *    spn;
+            uint                 i;
+
+            atomic_sub(v, &spt->spt_ingest_children);
+
+            alen = atomic64_read(&spt->spt_ingest_ialen);
+            atomic64_sub(alen, &spt->spt_ingest_ialen);
+            sp->samp.i_alen += alen;
+
+            alen = atomic64_read(&spt->spt_ingest_lalen);
+            atomic64_sub(alen, &spt->spt_ingest_lalen);
+            sp->samp.l_alen += alen;
+
+            alen = atomic64_read(&spt->spt_ingest_lgood);
+            atomic64_sub(alen, &spt->spt_ingest_lgood);
+            sp->samp.l_good += alen;
+
+            for (i = 0; i < tree->ct_cp->cp_fanout; i++) {
+                tn = tree->ct_root->tn_childv[i];
+                if (!tn)
+                    continue;
+
+                spn = tn2spn(tn);
+                if (!spn->spn_initialized)
+                    sp3_node_init(sp, spn);
+                sp3_dirty_node(sp, tn);
+            }
+
+            ingested = true;
+        }
     }
 
     if (ingested)
@@ -1438,6 +1705,18 @@ sp3_comp_thread_name(
         case CN_CR_LSCATTER:
             r = "sc";
             break;
+        case CN_CR_LREAD:
+            r = "rd";
+            break;
+        case CN_CR_LTIER:
+            r = "ti";
+            break;
+        case CN_CR_LTIER_SAMP:
+            r = "ts";
+            break;
+        case CN_CR_LTTL:
+            r = "tl";
+            break;
     }
 
     if (loc->node_level == 0)
@@ -1787,6 +2066,74 @@ sp3_tree_shape_check(struct sp3 *sp)
     }
 }
 
+/**
+ * sp3_rheat_update() - refresh the read heat of all non-root nodes
+ *
+ * Called once per second.  A node's read heat is an exponentially
+ * weighted moving average of the number of extra kvsets probed in
+ * the node per second (see cn_node_rheat()).
+ */
+static void
+sp3_rheat_update(struct sp3 *sp)
+{
+    struct rb_node *rbn;
+    uint            tx;
+
+    if (!sp->rp->csched_rheat_min)
+        return;
+
+    /* All non-root nodes are on the RBT_LI_LEN red/black tree.
+     */
+    tx = RBT_LI_LEN;
+    for (rbn = rb_first(sp->rbt + tx); rbn; rbn = rb_next(rbn)) {
+
+        struct sp3_rbe *     rbe = rb_entry(rbn, struct sp3_rbe, rbe_node);
+        struct sp3_node *    spn = (void *)(rbe - tx);
+        struct cn_tree_node *tn = spn2tn(spn);
+        u64                  probes, delta, heat;
+
+        probes = cn_node_rheat(tn);
+        delta = probes > spn->spn_rheat_prev ? probes - spn->spn_rheat_prev : 0;
+        heat = (3 * spn->spn_rheat + delta) / 4;
+
+        spn->spn_rheat_prev = max(probes, spn->spn_rheat_prev);
+        if (heat == spn->spn_rheat)
+            continue;
+
+        spn->spn_rheat = heat;
+
+        sp3_rb_erase(sp->rbt + RBT_LI_HEAT, spn->spn_rbe + RBT_LI_HEAT);
+        if (heat > 0 && cn_ns_kvsets(&tn->tn_ns) > 1)
+            sp3_node_insert(sp, spn, RBT_LI_HEAT, heat);
+    }
+}
+
+/**
+ * sp3_ttl_update() - expire kvsets in trees with kvs_ttl set
+ *
+ * Called once per second.  When a tree's expiry cutoff advances, its
+ * leaves are re-evaluated so that they land on the RBT_L_TTL tree.
+ */
+static void
+sp3_ttl_update(struct sp3 *sp)
+{
+    struct cn_tree *tree;
+
+    list_for_each_entry (tree, &sp->mon_tlist, ct_sched.sp3t.spt_tlink) {
+        struct cn_tree_node *tn;
+        struct tree_iter     iter;
+
+        if (!cn_tree_ttl_update(tree))
+            continue;
+
+        tree_iter_init(tree, &iter, TRAVERSE_TOPDOWN);
+        while (NULL != (tn = tree_iter_next(tree, &iter))) {
+            if (cn_node_isleaf(tn))
+                sp3_dirty_node(sp, tn);
+        }
+    }
+}
+
 static bool
 sp3_check_rb_tree(struct sp3 *sp, uint tx, u64 threshold, enum sp3_work_type wtype)
 {
@@ -1913,6 +2260,9 @@ sp3_schedule(struct sp3 *sp)
         jtype_leaf_garbage,
         jtype_leaf_size,
         jtype_leaf_scatter,
+        jtype_read_heat,
+        jtype_leaf_tier,
+        jtype_leaf_ttl,
         jtype_MAX,
     };
 
@@ -2028,6 +2378,42 @@ sp3_schedule(struct sp3 *sp)
                     break;
                 job = sp3_check_rb_tree(sp, RBT_L_SCAT, SP3_LSCAT_THRESH_MIN, wtype_leaf_scatter);
                 break;
+
+            case jtype_read_heat:
+                /* Service RBT_LI_HEAT red-black tree.
+                 * Implements:
+                 *   - Internal and leaf node read-amp rule
+                 */
+                if (!sp->rp->csched_rheat_min)
+                    break;
+                qi = sp->qinfo + SP3_QNUM_INTERN;
+                if (qfull(qi) && shared_full)
+                    break;
+                job = sp3_check_rb_tree(sp, RBT_LI_HEAT, sp->rp->csched_rheat_min, wtype_read_heat);
+                break;
+
+            case jtype_leaf_tier:
+                /* Service RBT_L_TIER red-black tree.
+                 * Implements:
+                 *   - Size-tiered leaf node merge rule
+                 *   - Size-tiered leaf node space amp rule
+                 */
+                qi = sp->qinfo + SP3_QNUM_LEAF;
+                if (qfull(qi))
+                    break;
+                job = sp3_check_rb_tree(sp, RBT_L_TIER, 1, wtype_leaf_tier);
+                break;
+
+            case jtype_leaf_ttl:
+                /* Service RBT_L_TTL red-black tree.
+                 * Implements:
+                 *   - Leaf node expiry rule (kvs_ttl)
+                 */
+                qi = sp->qinfo + SP3_QNUM_LEAF;
+                if (qfull(qi))
+                    break;
+                job = sp3_check_rb_tree(sp, RBT_L_TTL, 1, wtype_leaf_ttl);
+                break;
         }
     }
 }
@@ -2116,6 +2502,9 @@ sp3_monitor(struct work_struct *work)
     struct periodic_check chk_qos;
     struct periodic_check chk_refresh;
     struct periodic_check chk_shape;
+    struct periodic_check chk_io;
+    struct periodic_check chk_rheat;
+    struct periodic_check chk_ttl;
 
     u64 now, last_activity;
 
@@ -2125,12 +2514,19 @@ sp3_monitor(struct work_struct *work)
     chk_qos.interval = NSEC_PER_SEC / 5;
     chk_refresh.interval = 10 * NSEC_PER_SEC;
     chk_shape.interval = 15 * NSEC_PER_SEC;
+    chk_io.interval = NSEC_PER_SEC;
+    chk_rheat.interval = NSEC_PER_SEC;
+    chk_ttl.interval = NSEC_PER_SEC;
 
     chk_qos.next = now + chk_qos.interval;
     chk_refresh.next = now + chk_refresh.interval;
     chk_shape.next = now + chk_shape.interval;
+    chk_io.next = now + chk_io.interval;
+    chk_rheat.next = now + chk_rheat.interval;
+    chk_ttl.next = now + chk_ttl.interval;
 
     sp3_refresh_settings(sp);
+    sp3_io_refresh(sp);
 
     while (!atomic_read(&sp->destruct)) {
         merr_t err;
@@ -2165,9 +2561,25 @@ sp3_monitor(struct work_struct *work)
 
         if (now > chk_refresh.next) {
             sp3_refresh_settings(sp);
+            sp3_io_refresh(sp);
             chk_refresh.next = now + chk_refresh.interval;
         }
 
+        if (now > chk_io.next) {
+            sp3_io_tune(sp);
+            chk_io.next = now + chk_io.interval;
+        }
+
+        if (now > chk_rheat.next) {
+            sp3_rheat_update(sp);
+            chk_rheat.next = now + chk_rheat.interval;
+        }
+
+        if (now > chk_ttl.next) {
+            sp3_ttl_update(sp);
+            chk_ttl.next = now + chk_ttl.interval;
+        }
+
         if (now > chk_qos.next) {
             sp3_qos_check(sp);
             chk_qos.next = now + chk_qos.interval;
@@ -2250,6 +2662,51 @@ sp3_op_notify_ingest(struct csched_ops *handle, struct cn_tree *tree, size_t ale
     sp3_monitor_wake(sp);
 }
 
+/**
+ * sp3_op_notify_ingest_children() - External API: notify partitioned ingest
+ */
+static void
+sp3_op_notify_ingest_children(
+    struct csched_ops *         handle,
+    struct cn_tree *            tree,
+    const struct cn_samp_stats *diff)
+{
+    struct sp3 *     sp = h2sp(handle);
+    struct sp3_tree *spt = tree2spt(tree);
+
+    atomic64_add(diff->i_alen, &spt->spt_ingest_ialen);
+    atomic64_add(diff->l_alen, &spt->spt_ingest_lalen);
+    atomic64_add(diff->l_good, &spt->spt_ingest_lgood);
+    atomic_inc(&spt->spt_ingest_children);
+
+    sp3_monitor_wake(sp);
+}
+
+/**
+ * sp3_op_io_charge() - External API: charge cN media I/O
+ */
+static void
+sp3_op_io_charge(struct csched_ops *handle, enum csched_io_class ioc, size_t len)
+{
+    struct sp3 *sp = h2sp(handle);
+    u64         delay;
+
+    if (!sp->io_rate_max)
+        return;
+
+    delay = tbkt_request(&sp->io_tb, len);
+
+    /* Ingest only consumes budget, it never waits for it.
+     */
+    if (ioc == CSCHED_IO_INGEST)
+        return;
+
+    if (ioc == CSCHED_IO_LEAF)
+        delay = max_t(u64, delay, tbkt_request(&sp->io_leaf_tb, len));
+
+    tbkt_delay(delay);
+}
+
 static void
 sp3_tree_init(struct sp3_tree *spt)
 {
@@ -2382,10 +2839,13 @@ sp3_create(
         HSE_SLOG_FIELD("shared", "%lu", (rp->csched_qthreads >> (8 * SP3_NUM_QUEUES)) & 0xff),
         HSE_SLOG_END);
 
-    /* Allocate cache aligned space for struct csched + sp->name */
+    /* Allocate aligned space for struct csched + sp->name.  Note that
+     * struct sp3 embeds token buckets, which need more than cache line
+     * alignment.
+     */
     name_sz = strlen(mp) + 1;
     alloc_sz = sizeof(*sp) + name_sz;
-    sp = alloc_aligned(alloc_sz, SMP_CACHE_BYTES);
+    sp = alloc_aligned(alloc_sz, __alignof__(*sp));
     if (ev(!sp))
         return merr(ENOMEM);
 
@@ -2397,6 +2857,10 @@ sp3_create(
 
     sp->rp = rp;
     sp->health = health;
+    sp->tiered = csched_rp_policy(rp) == csched_policy_tiered;
+
+    if (sp->tiered)
+        hse_log(HSE_NOTICE "%s: size-tiered leaf compaction enabled for all trees", sp->name);
 
     mutex_init(&sp->new_tlist_lock);
     mutex_init(&sp->work_list_lock);
@@ -2412,6 +2876,9 @@ sp3_create(
 
     atomic_set(&sp->destruct, 0);
 
+    tbkt_init(&sp->io_tb, 0, 0);
+    tbkt_init(&sp->io_leaf_tb, 0, 0);
+
     err = sts_create(sp->rp, sp->name, SP3_NUM_QUEUES, &sp->sts);
     if (ev(err))
         goto err_exit;
@@ -2422,6 +2889,11 @@ sp3_create(
         goto err_exit;
     }
 
+    /* Apply the I/O budget before any tree is added, the monitor
+     * only picks up later changes.
+     */
+    sp3_io_refresh(sp);
+
     INIT_WORK(&sp->wstruct, sp3_monitor);
     queue_work(sp->wqueue, &sp->wstruct);
 
@@ -2429,9 +2901,11 @@ sp3_create(
 
     sp->ops.cs_destroy = sp3_op_destroy;
     sp->ops.cs_notify_ingest = sp3_op_notify_ingest;
+    sp->ops.cs_notify_ingest_children = sp3_op_notify_ingest_children;
     sp->ops.cs_throttle_sensor = sp3_op_throttle_sensor;
     sp->ops.cs_compact_request = sp3_op_compact_request;
     sp->ops.cs_compact_status_get = sp3_op_compact_status_get;
+    sp->ops.cs_io_charge = sp3_op_io_charge;
     sp->ops.cs_tree_add = sp3_op_tree_add;
     sp->ops.cs_tree_remove = sp3_op_tree_remove;
 
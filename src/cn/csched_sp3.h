@@ -10,7 +10,7 @@
 
 /* MTF_MOCK_DECL(csched_sp3) */
 
-#define RBT_MAX 5
+#define RBT_MAX 8
 #define CN_THROTTLE_MAX (THROTTLE_SENSOR_SCALE_MED + 50)
 
 struct kvdb_rparams;
@@ -35,7 +35,10 @@ struct sp3_node {
     struct sp3_rbe spn_rbe[RBT_MAX];
     u32            spn_ttl;
     u64            spn_timeout;
+    u64            spn_rheat;
+    u64            spn_rheat_prev;
     bool           spn_initialized;
+    bool           spn_tiered;
 };
 
 struct sp3_tree {
@@ -45,6 +48,10 @@ struct sp3_tree {
     atomic_t         spt_ingest_count;
     atomic64_t       spt_ingest_alen;
     atomic64_t       spt_ingest_wlen;
+    atomic_t         spt_ingest_children;
+    atomic64_t       spt_ingest_ialen;
+    atomic64_t       spt_ingest_lalen;
+    atomic64_t       spt_ingest_lgood;
 };
 
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
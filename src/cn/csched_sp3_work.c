@@ -636,6 +636,242 @@ sp3_work_leaf_scatter(
     return 0;
 }
 
+/*
+ * Leaf nodes with high read heat: k-compact the newest kvsets, as these
+ * are probed by every get that reaches the node.
+ */
+uint
+sp3_node_rheat_len(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark)
+{
+    struct cn_tree_node *    tn;
+    struct kvset_list_entry *le;
+
+    uint cnt_max = thresh->llen_runlen_max;
+    uint cnt = 0;
+
+    tn = spn2tn(spn);
+
+    if (cn_ns_kvsets(&tn->tn_ns) < 2)
+        return 0;
+
+    list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+        *mark = le;
+        if (++cnt >= cnt_max)
+            break;
+    }
+
+    return cnt;
+}
+
+static uint
+sp3_work_leaf_rheat(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    enum cn_action *          action,
+    enum cn_comp_rule *       rule)
+{
+    uint n_kvsets;
+
+    n_kvsets = sp3_node_rheat_len(spn, thresh, mark);
+    if (!n_kvsets)
+        return 0;
+
+    *action = CN_ACTION_COMPACT_K;
+    *rule = CN_CR_LREAD;
+
+    return n_kvsets;
+}
+
+/*
+ * Size-tiered leaf nodes merge runs of similarly sized kvsets rather
+ * than compacting to a space amp target.  Starting from the newest
+ * kvset, a run grows toward older kvsets as long as each kvset is no
+ * more than tier_ratio_pct percent larger than the sum of the newer
+ * kvsets in the run.  The newest run of at least tier_width_min
+ * kvsets (at most tier_width_max) is merged with a k-compaction, so
+ * values are not rewritten.
+ *
+ * If no run qualifies and the leaf's space amp (alen over the estimated
+ * live data) exceeds tier_samp_pct percent, the oldest kvsets are instead
+ * kv-compacted to reclaim the garbage they hold.
+ */
+uint
+sp3_node_tier_len(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    bool *                    full)
+{
+    struct cn_tree_node *    tn;
+    struct cn_samp_stats *   samp;
+    struct list_head *       head;
+    struct kvset_list_entry *start, *le;
+    uint                     kvsets;
+
+    uint width_min = thresh->tier_width_min;
+    uint width_max = thresh->tier_width_max;
+
+    tn = spn2tn(spn);
+    head = &tn->tn_kvset_list;
+    *full = false;
+
+    kvsets = 0;
+    list_for_each_entry (le, head, le_link)
+        ++kvsets;
+
+    if (kvsets < SP3_TIER_WIDTH_MIN)
+        return 0;
+
+    list_for_each_entry (start, head, le_link) {
+        struct kvset_list_entry *last = NULL;
+        u64                      sum = 0;
+        uint                     n = 0;
+
+        for (le = start; &le->le_link != head; le = list_next_entry(le, le_link)) {
+            u64 alen = kvset_alen(kvset_statsp(le->le_kvset));
+
+            if (n > 0 && alen * 100 > sum * (100 + thresh->tier_ratio_pct))
+                break;
+
+            sum += alen;
+            last = le;
+            if (++n >= width_max)
+                break;
+        }
+
+        if (n >= width_min) {
+            *mark = last;
+            return n;
+        }
+    }
+
+    samp = &tn->tn_samp;
+    if (samp->l_alen > 0 && samp->l_alen * 100 > (s64)thresh->tier_samp_pct * samp->l_good) {
+        *mark = list_last_entry(head, typeof(*le), le_link);
+        *full = true;
+        return min_t(uint, kvsets, width_max);
+    }
+
+    return 0;
+}
+
+static uint
+sp3_work_leaf_tier(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    enum cn_action *          action,
+    enum cn_comp_rule *       rule)
+{
+    uint n_kvsets;
+    bool full;
+
+    n_kvsets = sp3_node_tier_len(spn, thresh, mark, &full);
+    if (!n_kvsets)
+        return 0;
+
+    if (full) {
+        *action = CN_ACTION_COMPACT_KV;
+        *rule = CN_CR_LTIER_SAMP;
+    } else {
+        *action = CN_ACTION_COMPACT_K;
+        *rule = CN_CR_LTIER;
+    }
+
+    return n_kvsets;
+}
+
+uint
+sp3_node_ttl_len(struct sp3_node *spn, struct kvset_list_entry **mark)
+{
+    struct cn_tree_node *    tn;
+    struct kvset_list_entry *le;
+    u64                      ttl_dgen;
+    uint                     n_kvsets;
+
+    tn = spn2tn(spn);
+    ttl_dgen = cn_tree_ttl_dgen(tn->tn_tree);
+    if (!ttl_dgen)
+        return 0;
+
+    n_kvsets = 0;
+    list_for_each_entry_reverse (le, &tn->tn_kvset_list, le_link) {
+        if (kvset_get_dgen(le->le_kvset) > ttl_dgen)
+            break;
+        if (!n_kvsets)
+            *mark = le;
+        ++n_kvsets;
+    }
+
+    return n_kvsets;
+}
+
+/*
+ * Leaf nodes with expired kvsets at the tail: delete them without
+ * reading them (see cn_comp_compact()).
+ */
+static uint
+sp3_work_leaf_ttl(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    enum cn_action *          action,
+    enum cn_comp_rule *       rule)
+{
+    uint n_kvsets;
+
+    n_kvsets = sp3_node_ttl_len(spn, mark);
+    if (!n_kvsets)
+        return 0;
+
+    *action = CN_ACTION_COMPACT_K;
+    *rule = CN_CR_LTTL;
+
+    return min_t(uint, n_kvsets, thresh->lcomp_kvsets_max);
+}
+
+/*
+ * Leaf compactions in trees with kvs_ttl set only merge kvsets that were
+ * ingested in the same time window, so that a merged kvset expires no
+ * later than the data it holds.  If the oldest kvset selected has already
+ * expired, delete the expired kvsets instead.  Called with the tree lock
+ * held.
+ *
+ * Return: number of kvsets to compact, starting at *@mark
+ */
+static uint
+sp3_work_ttl_trim(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    uint                      n_kvsets,
+    enum cn_action *          action,
+    enum cn_comp_rule *       rule)
+{
+    struct cn_tree_node *    tn = spn2tn(spn);
+    struct kvset_list_entry *le;
+    u64                      window;
+    uint                     n;
+
+    window = cn_tree_ttl_window(tn->tn_tree, kvset_get_dgen((*mark)->le_kvset));
+    if (!window)
+        return sp3_work_leaf_ttl(spn, thresh, mark, action, rule);
+
+    le = *mark;
+    for (n = 1; n < n_kvsets; n++) {
+        le = list_prev_entry(le, le_link);
+        if (cn_tree_ttl_window(tn->tn_tree, kvset_get_dgen(le->le_kvset)) != window)
+            break;
+    }
+
+    /* A single kvset is only worth compacting if it was chosen alone. */
+    return (n < n_kvsets && n < 2) ? 0 : n;
+}
+
 /**
  * sp3_work() - determine if a given node needs maintenance
  * @tn: the cn tree node to check
@@ -711,7 +947,11 @@ sp3_work(
                 break;
 
             case wtype_node_len:
-                n_kvsets = sp3_work_leaf_len(spn, thresh, &mark, &action, &rule, &bonus);
+                /* Size-tiered leaves bound their length with tiered merges. */
+                if (spn->spn_tiered)
+                    n_kvsets = sp3_work_leaf_tier(spn, thresh, &mark, &action, &rule);
+                else
+                    n_kvsets = sp3_work_leaf_len(spn, thresh, &mark, &action, &rule, &bonus);
                 *qnum_out = SP3_QNUM_LEAF;
                 break;
 
@@ -720,10 +960,29 @@ sp3_work(
                 *qnum_out = SP3_QNUM_LEAFBIG;
                 break;
 
+            case wtype_read_heat:
+                n_kvsets = sp3_work_leaf_rheat(spn, thresh, &mark, &action, &rule);
+                *qnum_out = SP3_QNUM_LEAF;
+                break;
+
+            case wtype_leaf_tier:
+                n_kvsets = sp3_work_leaf_tier(spn, thresh, &mark, &action, &rule);
+                *qnum_out = SP3_QNUM_LEAF;
+                break;
+
+            case wtype_leaf_ttl:
+                n_kvsets = sp3_work_leaf_ttl(spn, thresh, &mark, &action, &rule);
+                *qnum_out = SP3_QNUM_LEAF;
+                break;
+
             default:
                 ev(1, HSE_WARNING);
                 break;
         }
+
+        if (n_kvsets > 0 && tn->tn_tree->rp->kvs_ttl && action != CN_ACTION_SPILL &&
+            rule != CN_CR_LTTL)
+            n_kvsets = sp3_work_ttl_trim(spn, thresh, &mark, n_kvsets, &action, &rule);
     } else {
         uint cmin;
         uint cmax;
@@ -731,6 +990,7 @@ sp3_work(
         switch (wtype) {
             case wtype_rspill:
             case wtype_node_len:
+            case wtype_read_heat:
                 cmin = thresh->rspill_kvsets_min;
                 cmax = thresh->rspill_kvsets_max;
                 break;
@@ -812,6 +1072,7 @@ sp3_work(
     w->cw_action = action;
     w->cw_comp_rule = rule;
     w->cw_bonus = bonus;
+    w->cw_expire = rule == CN_CR_LTTL;
     w->cw_debug = debug;
 
     w->cw_have_token = use_token;
@@ -839,6 +1100,8 @@ sp3_work(
     return 0;
 
 locked_nowork:
+    if (bonus)
+        atomic_dec(bonus);
     if (use_token)
         cn_node_comp_token_put(tn);
     rmlock_runlock(lock);
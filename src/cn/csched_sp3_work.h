@@ -15,6 +15,7 @@
 
 struct cn_tree_node;
 struct cn_compaction_work;
+struct kvset_list_entry;
 
 enum sp3_work_type {
     wtype_rspill,       /* root node: spill */
@@ -23,8 +24,11 @@ enum sp3_work_type {
     wtype_leaf_size,    /* leaf nodes: size */
     wtype_node_len,     /* all nodes: numbrer of kvsets */
     wtype_leaf_scatter, /* leaf nodes: scatter */
+    wtype_read_heat,    /* all nodes: read heat */
+    wtype_leaf_tier,    /* leaf nodes: size-tiered merge */
+    wtype_leaf_ttl,     /* leaf nodes: expired kvsets */
 };
-#define wtype_MAX (wtype_leaf_scatter + 1)
+#define wtype_MAX (wtype_leaf_ttl + 1)
 
 struct sp3_thresholds {
     u8 rspill_kvsets_min;
@@ -41,6 +45,10 @@ struct sp3_thresholds {
     u8 llen_kvcompc;
     u8 llen_idlec;
     u8 llen_idlem;
+    u8 tier_width_min;
+    u8 tier_width_max;
+    u8 tier_ratio_pct;
+    u8 tier_samp_pct;
 };
 
 /* rspill and ispill require at least 1 kvset,
@@ -51,6 +59,7 @@ struct sp3_thresholds {
 #define SP3_LCOMP_KVSETS_MIN ((u8)2)
 #define SP3_LLEN_RUNLEN_MIN ((u8)2)
 #define SP3_LSCAT_THRESH_MIN ((u8)2)
+#define SP3_TIER_WIDTH_MIN ((u8)2)
 
 /* MTF_MOCK */
 merr_t
@@ -62,6 +71,49 @@ sp3_work(
     uint *                      qnum_out,
     struct cn_compaction_work **wp);
 
+/**
+ * sp3_node_tier_len() - find the kvsets a size-tiered leaf should merge
+ * @spn:    leaf node
+ * @thresh: thresholds (tier_*)
+ * @mark:   (output) oldest kvset to merge
+ * @full:   (output) true if merging to reduce space amp
+ *
+ * Return: number of kvsets to merge, starting at @mark and moving
+ * toward newer kvsets, or 0 if the node needs no tiered merge.
+ */
+uint
+sp3_node_tier_len(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark,
+    bool *                    full);
+
+/**
+ * sp3_node_rheat_len() - find the kvsets a read-hot leaf should merge
+ * @spn:    leaf node
+ * @thresh: thresholds (llen_runlen_max)
+ * @mark:   (output) oldest kvset to merge
+ *
+ * Return: number of kvsets to merge, starting at @mark and moving
+ * toward newer kvsets, or 0 if the node has fewer than two kvsets.
+ */
+uint
+sp3_node_rheat_len(
+    struct sp3_node *         spn,
+    struct sp3_thresholds *   thresh,
+    struct kvset_list_entry **mark);
+
+/**
+ * sp3_node_ttl_len() - count the expired kvsets at the tail of a leaf
+ * @spn:  leaf node
+ * @mark: (output) oldest kvset
+ *
+ * Return: number of kvsets that have expired (kvs_ttl), starting at
+ * @mark and moving toward newer kvsets.
+ */
+uint
+sp3_node_ttl_len(struct sp3_node *spn, struct kvset_list_entry **mark);
+
 /* work queues */
 #define SP3_QNUM_UNUSED 0
 #define SP3_QNUM_INTERN 1
@@ -96,6 +96,9 @@ struct hash_set {
  * @bloom_elt_cap: Number of keys Bloom filter can hold at current size
  * @hash_set:  Hash set to store key hashes. Used to build
  *             Bloom filter at end of kblock construction.
+ * @blm_pfx_len:  Length of key prefixes added to the Bloom filter (0: none)
+ * @blm_pfx_hash: Hash of the most recently added key prefix
+ * @num_pfxs:  Number of distinct key prefixes in the Bloom filter.
  * @num_keys:  Number of keys in kblock.
  * @num_tombstones:  Number of keys in kblock that have tombstone values.
  * @total_key_bytes: Sum of all key lengths.
@@ -145,6 +148,10 @@ struct curr_kblock {
     struct hash_set        hash_set;
     struct bf_bithash_desc desc;
 
+    uint blm_pfx_len;
+    u64  blm_pfx_hash;
+    u32  num_pfxs;
+
     void *kblk_hdr;
     void *bloom;
     uint  bloom_len;
@@ -279,6 +286,8 @@ mblk_blow_chunks(
             continue;
         }
 
+        csched_io_charge(cn_get_sched(self->cn), kvset_builder_io_class(self->flags), wlen);
+
         if (alen >= need) {
             /* Segment 'a' has enough data for a write.
              * Trim front and back end of this segment, issue
@@ -375,7 +384,7 @@ hash_set_init(struct hash_set *hs)
 }
 
 static merr_t
-hash_set_add(struct hash_set *hs, const struct key_obj *kobj)
+hash_set_add(struct hash_set *hs, u64 hash)
 {
     if (!hs->curr_part) {
         hs->curr_part = malloc(sizeof(*hs->curr_part));
@@ -387,7 +396,7 @@ hash_set_add(struct hash_set *hs, const struct key_obj *kobj)
 
     assert(hs->curr_part->n_hashes < HSP_HASH_MAX_KEYS);
 
-    hs->curr_part->hashvec[hs->curr_part->n_hashes++] = key_obj_hash64(kobj);
+    hs->curr_part->hashvec[hs->curr_part->n_hashes++] = hash;
 
     /* If full, then use next part.  If next is null, allocate new
      * part next time one is added.
@@ -466,6 +475,12 @@ kblock_init(
     kblk->pc = pc;
     kblk->desc = bf_compute_bithash_est(rp->cn_bloom_prob);
 
+    /* Prefix scans and probes can skip kblocks whose bloom filter
+     * lacks the hash of the scan prefix's first pfx_len bytes.
+     */
+    if (rp->cn_bloom_pfx)
+        kblk->blm_pfx_len = cp->cp_pfx_len;
+
     err = wbb_create(&kblk->wbtree, kblk->wbt_pgc + free_pgc(kblk), &kblk->wbt_pgc);
     if (ev(err))
         return err;
@@ -482,6 +497,7 @@ kblock_reset(struct curr_kblock *kblk)
     kblk->total_val_bytes = 0;
     kblk->num_keys = 0;
     kblk->num_tombstones = 0;
+    kblk->num_pfxs = 0;
 
     kblk->blm_pgc = 0;
     kblk->blm_elt_cap = 0;
@@ -535,16 +551,10 @@ kblock_add_entry(
 
     if (kblk->rp->cn_bloom_create) {
         size_t tree_sfx_len = kblk->cp->cp_sfx_len;
+        u64    hash, pfx_hash = 0;
+        bool   new_pfx = false;
 
-        /* Ensure we have enough pages reserved for bloom filters. */
-        if (kblk->num_keys + 1 > kblk->blm_elt_cap) {
-            if (!free_pgc(kblk))
-                return 0;
-            kblk->blm_pgc++;
-            kblk->blm_elt_cap = bf_element_estimate(kblk->desc, kblk->blm_pgc * PAGE_SIZE);
-        }
-
-        /* Add key's hash to hash_set. Hash only on the soft prefix. */
+        /* Hash only on the soft prefix. */
         if (tree_sfx_len) {
             struct key_obj ko = *kobj;
             size_t         min_sfx_len;
@@ -552,13 +562,41 @@ kblock_add_entry(
             min_sfx_len = min_t(size_t, tree_sfx_len, ko.ko_sfx_len);
             ko.ko_sfx_len -= min_sfx_len;
             ko.ko_pfx_len -= tree_sfx_len - min_sfx_len;
-            err = hash_set_add(&kblk->hash_set, (const void *)&ko);
+            hash = key_obj_hash64(&ko);
         } else {
-            err = hash_set_add(&kblk->hash_set, kobj);
+            hash = key_obj_hash64(kobj);
+        }
+
+        /* Keys arrive in sorted order, so each distinct prefix need
+         * only be added once.  Keys shorter than the prefix cannot
+         * match a prefix scan and need not be added at all.
+         */
+        if (kblk->blm_pfx_len && key_obj_len(kobj) >= kblk->blm_pfx_len) {
+            pfx_hash = pfx_obj_hash64(kobj, kblk->blm_pfx_len);
+            new_pfx = pfx_hash != hash && (!kblk->num_pfxs || pfx_hash != kblk->blm_pfx_hash);
+        }
+
+        /* Ensure we have enough pages reserved for bloom filters. */
+        if (kblk->num_keys + kblk->num_pfxs + 1 + new_pfx > kblk->blm_elt_cap) {
+            if (!free_pgc(kblk))
+                return 0;
+            kblk->blm_pgc++;
+            kblk->blm_elt_cap = bf_element_estimate(kblk->desc, kblk->blm_pgc * PAGE_SIZE);
         }
 
+        /* Add key's hash to hash_set. */
+        err = hash_set_add(&kblk->hash_set, hash);
         if (ev(err))
             return err;
+
+        if (new_pfx) {
+            err = hash_set_add(&kblk->hash_set, pfx_hash);
+            if (ev(err))
+                return err;
+
+            kblk->blm_pfx_hash = pfx_hash;
+            kblk->num_pfxs++;
+        }
     }
 
     /* update wbtree */
@@ -611,7 +649,8 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
         }
 
         memset(kblk->bloom, 0, kblk->bloom_len);
-        bf_filter_init(&bloom, kblk->desc, kblk->num_keys, kblk->bloom, kblk->bloom_len);
+        bf_filter_init(
+            &bloom, kblk->desc, kblk->num_keys + kblk->num_pfxs, kblk->bloom, kblk->bloom_len);
         list_for_each_entry (part, &kblk->hash_set.part_list, part_link) {
             bf_filter_insert_by_hashv(&bloom, part->hashvec, part->n_hashes);
         }
@@ -626,6 +665,8 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
     omf_set_bh_bktshift(blm_hdr, bloom.bf_bktshift);
     omf_set_bh_rotl(blm_hdr, bloom.bf_rotl);
     omf_set_bh_n_hashes(blm_hdr, bloom.bf_n_hashes);
+    if (bloom.bf_bitmapsz)
+        omf_set_bh_pfx_len(blm_hdr, kblk->blm_pfx_len);
 
     return 0;
 }
@@ -1248,6 +1289,19 @@ kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats)
     bld->mstats = stats;
 }
 
+bool
+kbb_is_empty(struct kblock_builder *bld)
+{
+    return kblock_is_empty(&bld->curr) && bld->finished_kblks.n_blks == 0 &&
+           wbb_entries(bld->ptree) == 0;
+}
+
+void
+kbb_hlog_union(struct kblock_builder *bld, struct kblock_builder *src)
+{
+    hlog_union(bld->hlog, hlog_data(src->hlog));
+}
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "kblock_builder_ut_impl.i"
 #endif /* HSE_UNIT_TEST_MODE */
@@ -134,6 +134,7 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks, u64 seqno_min, u6
 size_t
 kbb_estimate_alen(struct cn *cn, size_t wlen, enum mp_media_classp mclass);
 
+/* MTF_MOCK */
 void
 kbb_set_agegroup(struct kblock_builder *bld, enum hse_mclass_policy_age age);
 
@@ -143,6 +144,26 @@ kbb_get_agegroup(struct kblock_builder *bld);
 void
 kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats);
 
+/**
+ * kbb_is_empty() - check if any keys or ptombs have been added
+ * @bld: builder handle
+ */
+/* MTF_MOCK */
+bool
+kbb_is_empty(struct kblock_builder *bld);
+
+/**
+ * kbb_hlog_union() - merge the key cardinality estimate of @src into @bld
+ * @bld: builder handle
+ * @src: builder whose keys will be counted in the hlog of @bld
+ *
+ * Used when the kblocks of several builders are concatenated into one
+ * kvset, in which case only the hlog of the last kblock is consulted.
+ */
+/* MTF_MOCK */
+void
+kbb_hlog_union(struct kblock_builder *bld, struct kblock_builder *src);
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "kblock_builder_ut.h"
 #endif /* HSE_UNIT_TEST_MODE */
@@ -232,6 +232,7 @@ kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
     desc->bd_bktshift = omf_bh_bktshift(blm_omf);
     desc->bd_n_hashes = omf_bh_n_hashes(blm_omf);
     desc->bd_rotl = omf_bh_rotl(blm_omf);
+    desc->bd_pfx_len = omf_bh_pfx_len(blm_omf);
     desc->bd_bktmask = (1u << desc->bd_bktshift) - 1;
 
     return 0;
@@ -360,17 +360,19 @@ cn_kcompact(struct cn_compaction_work *w)
 {
     merr_t               err;
     struct cn_tree_node *pnode;
+    uint                 flags;
+
+    pnode = w->cw_node;
+
+    flags = KVSET_BUILDER_FLAGS_SPARE;
+    if (pnode && cn_node_isroot(pnode))
+        flags |= KVSET_BUILDER_FLAGS_ROOT;
 
     err = kvset_builder_create(
-        &w->cw_child[0],
-        cn_tree_get_cn(w->cw_tree),
-        w->cw_pc,
-        w->cw_dgen_hi,
-        KVSET_BUILDER_FLAGS_SPARE);
+        &w->cw_child[0], cn_tree_get_cn(w->cw_tree), w->cw_pc, w->cw_dgen_hi, flags);
     if (ev(err))
         goto done;
 
-    pnode = w->cw_node;
     if (pnode) {
         if (cn_node_isroot(pnode))
             kvset_builder_set_agegroup(w->cw_child[0], HSE_MPOLICY_AGE_ROOT);
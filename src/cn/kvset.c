@@ -19,6 +19,7 @@
 #include <hse_util/mman.h>
 #include <hse_util/compression_lz4.h>
 #include <hse_util/vlb.h>
+#include <hse_util/sdt.h>
 
 #include <hse/hse_limits.h>
 #include <hse/kvdb_perfc.h>
@@ -26,7 +27,9 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/cn_kvdb.h>
 #include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/kvdb_slowop.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/csched.h>
 
 #include "kvs_mblk_desc.h"
 
@@ -1137,6 +1140,67 @@ kvset_pt_start(struct kvset *ks)
     return last;
 }
 
+static bool
+kblk_bloom_hit(struct kvset_kblk *kblk, struct kvs_ktuple *kt)
+{
+    merr_t err;
+    bool   hit = true;
+
+    if (kblk->kb_blm_pages) {
+        hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
+    } else if (kblk->kb_blm_desc.bd_n_pages) {
+        err = bloom_reader_mcache_lookup(&kblk->kb_blm_desc, &kblk->kb_kblk_desc, kt, &hit);
+        if (ev(err))
+            hit = true;
+    }
+
+    return hit;
+}
+
+/**
+ * kblk_pfx_absent() - check kblock prefix blooms for a prefix
+ * @ks:      kvset
+ * @pfx:     prefix
+ * @pfx_len: prefix length
+ * @i:       first (last if reverse) kblock whose key range admits @pfx
+ * @reverse:
+ *
+ * Walks the run of kblocks whose key ranges admit @pfx.  If every one
+ * of them has a bloom built with key prefixes no longer than @pfx_len
+ * and none of those blooms holds the hash of the matching leading
+ * bytes of @pfx then the kvset cannot contain a key with this prefix.
+ *
+ * Return: true if no key in the kvset can have prefix @pfx
+ */
+static bool
+kblk_pfx_absent(struct kvset *ks, const void *pfx, uint pfx_len, int i, bool reverse)
+{
+    struct kvs_ktuple kt;
+
+    kt.kt_len = 0;
+
+    while (i >= 0 && i < ks->ks_st.kst_kblks) {
+        struct kvset_kblk *kblk = ks->ks_kblks + i;
+        uint               blm_pfx_len = kblk->kb_blm_desc.bd_pfx_len;
+
+        if (kblk_plausible(kblk, NULL, pfx, -pfx_len, 0))
+            break;
+
+        if (!blm_pfx_len || blm_pfx_len > pfx_len || !kblk->kb_blm_desc.bd_n_pages)
+            return false;
+
+        if (kt.kt_len != blm_pfx_len)
+            kvs_ktuple_init(&kt, pfx, blm_pfx_len);
+
+        if (kblk_bloom_hit(kblk, &kt))
+            return false;
+
+        i += reverse ? -1 : 1;
+    }
+
+    return true;
+}
+
 /**
  * kvset_kblk_start() - determine if a kvset might contain a key. This does not
  * include ptombs. For ptombs, see kvset_pt_start().
@@ -1144,6 +1208,10 @@ kvset_pt_start(struct kvset *ks)
  * len > 0 => seek;   seek to key
  * len < 0 => create; seek to prefix
  *
+ * For prefixes, kblocks whose blooms were built with key prefixes (see
+ * the cn_bloom_pfx rparam) are consulted and the kvset is reported as a
+ * miss if none of them can contain the prefix.
+ *
  * Return value:
  * i >= 0 : of the first kblock that could possibly contain a match for key.
  * %KVSET_MISS_KEY_TOO_LARGE: key is larger than all key in the kvset.
@@ -1178,8 +1246,11 @@ kvset_kblk_start(struct kvset *ks, const void *key, int len, bool reverse)
     if (reverse) {
         for (i = ks->ks_st.kst_kblks - 1; i >= 0; --i) {
             rc = kblk_plausible(ks->ks_kblks + i, &kdisc, key, len, 0);
-            if (rc == 0)
+            if (rc == 0) {
+                if (len < 0 && kblk_pfx_absent(ks, key, -len, i, true))
+                    return KVSET_MISS_KEY_TOO_SMALL;
                 return i;
+            }
             if (rc > 0)
                 return len > 0 ? i : KVSET_MISS_KEY_TOO_LARGE;
         }
@@ -1190,8 +1261,11 @@ kvset_kblk_start(struct kvset *ks, const void *key, int len, bool reverse)
     } else {
         for (i = 0; i < ks->ks_st.kst_kblks; ++i) {
             rc = kblk_plausible(ks->ks_kblks + i, &kdisc, key, len, 0);
-            if (rc == 0)
+            if (rc == 0) {
+                if (len < 0 && kblk_pfx_absent(ks, key, -len, i, false))
+                    return KVSET_MISS_KEY_TOO_LARGE;
                 return i;
+            }
             /*
              * blks are ordered: cannot be in ks if pfx (len < 0)
              * but this is the correct answer for seek (len > 0)
@@ -1216,20 +1290,33 @@ kblk_get_value_ref(
     struct kvs_vtuple_ref *vref)
 {
     struct kvset_kblk *kblk = ks->ks_kblks + kblk_idx;
-    bool               hit;
     merr_t             err;
+    u64                pages;
+    bool               hit;
 
-    if (kblk->kb_blm_pages) {
-        hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
-        if (!hit)
-            return 0;
-    } else if (kblk->kb_blm_desc.bd_n_pages) {
-        err = bloom_reader_mcache_lookup(&kblk->kb_blm_desc, &kblk->kb_kblk_desc, kt, &hit);
-        if (!ev(err) && !hit)
-            return 0;
+    hit = kblk_bloom_hit(kblk, kt);
+
+    HSE_SDT(kvset_bloom, ks, kblk_idx, hit);
+
+    if (!hit) {
+        kvset_heat_add(ks, KVSET_HEAT_BLOOM_NEG, 1);
+        if (kvdb_slowop_tls.ss_active)
+            kvdb_slowop_tls.ss_bloom_neg++;
+        return 0;
     }
 
-    return wbtr_read_vref(&kblk->kb_kblk_desc, &kblk->kb_wbt_desc, kt, lcp, seq, result, vref);
+    pages = wbtr_pages_tls;
+
+    err = wbtr_read_vref(&kblk->kb_kblk_desc, &kblk->kb_wbt_desc, kt, lcp, seq, result, vref);
+
+    kvset_heat_add(ks, KVSET_HEAT_WBT_PAGES, wbtr_pages_tls - pages);
+
+    /* A bloom hit on a key the kblock does not have is a false positive.
+     */
+    if (!err && *result == NOT_FOUND && (kblk->kb_blm_pages || kblk->kb_blm_desc.bd_n_pages))
+        kvset_heat_add(ks, KVSET_HEAT_BLOOM_FP, 1);
+
+    return err;
 }
 
 static merr_t
@@ -1351,6 +1438,8 @@ done:
         }
     }
 
+    HSE_SDT(kvset_lookup, ks, kt->kt_len, *result);
+
     return 0;
 }
 
@@ -1503,6 +1592,7 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     void               *src, *dst;
     uint                omlen, copylen;
     bool direct;
+    u64                 tstart;
 
     assert(vref->vr_type == vtype_ival
         || vref->vr_type == vtype_zval
@@ -1531,6 +1621,12 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     direct = copylen >= ks->ks_vmax
         || (copylen >= ks->ks_vmin && ks->ks_node_level >= ks->ks_vminlvl);
 
+    tstart = kvdb_slowop_stage_start();
+    if (tstart) {
+        kvdb_slowop_tls.ss_vreads++;
+        kvdb_slowop_tls.ss_vbytes += omlen;
+    }
+
     if (vref->vb.vr_complen) {
         uint outlen;
 
@@ -1546,6 +1642,8 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
                 return err;
         }
 
+        kvdb_slowop_stage_end(KVDB_SLOWOP_DECOMP, tstart);
+
         if (ev(copylen == vref->vb.vr_len && outlen != copylen)) {
             /* oops: full size buffer, but not able to decompress all data */
             assert(0);
@@ -1566,6 +1664,9 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     }
 
   done:
+    if (!vref->vb.vr_complen)
+        kvdb_slowop_stage_end(KVDB_SLOWOP_VREAD, tstart);
+
     vbuf->b_len = vref->vb.vr_len;
     return 0;
 }
@@ -1607,6 +1708,7 @@ kvset_pfx_lookup(
     const void *curr_sfx;
 
     key2kobj(&kt_obj, kt->kt_data, kt->kt_len);
+    kvset_heat_add(ks, KVSET_HEAT_GETS, 1);
 
     err = kvset_ptomb_lookup(ks, kt, seq, res, &vref);
     if (ev(err))
@@ -1644,8 +1746,10 @@ next_kblk:
             hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
         }
 
-        if (!hit)
+        if (!hit) {
+            kvset_heat_add(ks, KVSET_HEAT_BLOOM_NEG, 1);
             goto done;
+        }
     }
 
     wbti_reset(wbti, &kblk->kb_kblk_desc, &kblk->kb_wbt_desc, kt, 0, 0);
@@ -1778,6 +1882,8 @@ kvset_lookup(
     struct kvs_vtuple_ref vref;
     merr_t                err;
 
+    kvset_heat_add(ks, KVSET_HEAT_GETS, 1);
+
     err = kvset_lookup_vref(ks, kt, kdisc, seq, res, &vref);
     if (ev(err))
         return err;
@@ -1898,6 +2004,30 @@ kvset_set_scatter_pct(struct kvset *ks, uint spct)
     ks->ks_scatter_pct = spct;
 }
 
+void
+kvset_get_heat(struct kvset *ks, struct kvset_heat *heat)
+{
+    memset(heat, 0, sizeof(*heat));
+    cn_heat_sum(&ks->ks_heat, heat);
+}
+
+static const char *const kvset_heat_namev[] = {
+    [KVSET_HEAT_GETS] = "gets",
+    [KVSET_HEAT_BLOOM_NEG] = "bloom_neg",
+    [KVSET_HEAT_BLOOM_FP] = "bloom_fp",
+    [KVSET_HEAT_WBT_PAGES] = "wbt_pages",
+    [KVSET_HEAT_CURSORS] = "cursors",
+};
+
+const char *
+kvset_heat_name(enum kvset_heat_ctr ctr)
+{
+    if (ctr >= NELEM(kvset_heat_namev))
+        return "unknown";
+
+    return kvset_heat_namev[ctr];
+}
+
 u32
 kvset_get_num_kblocks(struct kvset *ks)
 {
@@ -1981,6 +2111,32 @@ kvset_get_max_key(struct kvset *ks, void **key, uint *klen)
     *klen = kb->kb_klen_max;
 }
 
+/**
+ * kvset_get_nth_kblock_min_key() - Get the smallest key in the nth kblock
+ * @ks:    struct kvset handle.
+ * @index: kblock index
+ * @key:   (output) smallest key. Null if the kblock contains only ptombs.
+ * @klen:  (output) length of @key. Zero if the kblock contains only ptombs.
+ */
+void
+kvset_get_nth_kblock_min_key(struct kvset *ks, u32 index, const void **key, uint *klen)
+{
+    struct kvset_kblk *kb;
+
+    *key = 0;
+    *klen = 0;
+
+    if (index >= ks->ks_st.kst_kblks)
+        return;
+
+    kb = &ks->ks_kblks[index];
+    if (kb->kb_wbt_desc.wbd_n_pages == 0)
+        return;
+
+    *key = kb->kb_koff_min;
+    *klen = kb->kb_klen_min;
+}
+
 void
 kvset_get_metrics(struct kvset *ks, struct kvset_metrics *m)
 {
@@ -2041,10 +2197,12 @@ struct kr_buf {
 
 struct kblk_reader {
 
-    struct work_struct work;
-    struct mpool *     ds;
-    struct async_mbio  mbio;
-    struct perfc_set * pc;
+    struct work_struct   work;
+    struct mpool *       ds;
+    struct async_mbio    mbio;
+    struct perfc_set *   pc;
+    struct csched *      csched;
+    enum csched_io_class ioc;
 
     /* io buffers */
     struct kr_buf kr_buf[2];
@@ -2052,8 +2210,9 @@ struct kblk_reader {
     bool          asyncio;
 
     /* reader state */
-    bool kr_requested;
-    bool kr_eof;
+    bool   kr_requested;
+    bool   kr_eof;
+    size_t kr_uncharged;
 
     /* io results */
     struct {
@@ -2086,10 +2245,12 @@ struct vr_buf {
  * must maintain its own vbidx to handle vblock transitions within a vgroup.
  */
 struct vblk_reader {
-    struct work_struct work;
-    struct async_mbio  mbio;
-    struct mpool *     ds;
-    struct perfc_set * pc;
+    struct work_struct   work;
+    struct async_mbio    mbio;
+    struct mpool *       ds;
+    struct perfc_set *   pc;
+    struct csched *      csched;
+    enum csched_io_class ioc;
     /* index, offset, and length of async mblock read */
     uint vr_io_vbidx;
     uint vr_io_offset;
@@ -2146,6 +2307,9 @@ struct kvset_iterator {
     struct workqueue_struct *vra_wq;
     bool                     reverse;
     bool                     asyncio;
+    bool                     ra_adapt;
+    u32                      kblk_done;
+    struct vbr_ra_adapt      vra_adapt;
     struct iter_meta         wbti_meta;
     struct iter_meta         pti_meta;
 
@@ -2160,6 +2324,8 @@ struct kvset_iterator {
     struct kblk_reader       kreader;  /* kb work buffer */
     struct vblk_reader *     vreaders; /* vb work buffer */
     struct workqueue_struct *workq;
+    struct csched *          csched; /* charged for mblock reads */
+    enum csched_io_class     ioc;
 
     struct kblk_reader ptreader; /* kb work buffer for ptombs */
 
@@ -2314,6 +2480,7 @@ kvset_iter_kblock_read(struct work_struct *rock)
     }
 
     rlen += iov.iov_len;
+    kr->kr_uncharged = iov.iov_len;
     err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
     if (ev(err))
         goto done;
@@ -2345,10 +2512,22 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
 {
     bool success       __maybe_unused;
     struct kvset_kblk *kblk;
+    uint               nodec;
 
     assert(!kr->mbio.pending);
     assert(iter->workq);
 
+    /* Reads are charged to the compaction I/O budget here, in the
+     * compaction thread, because charging may sleep and must not
+     * park a cn_io worker that also serves other jobs.  The length
+     * of a read's kmd is known only once its leaf nodes are in, so
+     * it is charged with the next read.
+     */
+    if (kr->kr_uncharged) {
+        csched_io_charge(kr->csched, kr->ioc, kr->kr_uncharged);
+        kr->kr_uncharged = 0;
+    }
+
     if (kr->kr_nodex == kr->kr_nodec) {
         struct wbt_desc *wbt;
 
@@ -2378,6 +2557,10 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
         kr->kr_next_kblk_idx++;
     }
 
+    nodec = kr->kr_nodec - kr->kr_nodex;
+    nodec = min_t(uint, nodec, kr->kr_buf[kr->kr_bufx].node_buf_sz / PAGE_SIZE);
+    csched_io_charge(kr->csched, kr->ioc, nodec * PAGE_SIZE);
+
     mbio_arm(&kr->mbio);
     INIT_WORK(&kr->work, kvset_iter_kblock_read);
     if (iter->asyncio) {
@@ -2444,6 +2627,9 @@ vr_start_read(
     if (vr->vr_io_len > vr->vr_buf_sz)
         vr->vr_io_len = vr->vr_buf_sz;
 
+    /* Charge in the caller's thread, see kblk_start_read(). */
+    csched_io_charge(vr->csched, vr->ioc, vr->vr_io_len);
+
     vr->mbio.pending = 1;
 
     INIT_WORK(&vr->work, vr_read_work);
@@ -2521,6 +2707,8 @@ kvset_iter_enable_mblock_read_cmn(struct kvset_iterator *iter, struct kblk_reade
     kr->kr_kblk_cnt = iter->ks->ks_st.kst_kblks;
     kr->ds = iter->ks->ks_ds;
     kr->pc = iter->pc;
+    kr->csched = iter->csched;
+    kr->ioc = iter->ioc;
 
     mbio_init(&kr->mbio);
 
@@ -2628,6 +2816,8 @@ kvset_iter_enable_mblock_read(struct kvset_iterator *iter)
 
             vr->ds = iter->ks->ks_ds;
             vr->pc = iter->pc;
+            vr->csched = iter->csched;
+            vr->ioc = iter->ioc;
         }
     }
 
@@ -2705,12 +2895,22 @@ kvset_iter_create(
     iter->vra_len = min_t(u32, iter->vra_len, 1024 * 1024);
     iter->vra_wq = vra_wq;
 
+    /* Cursors size their readahead windows to the observed access
+     * pattern unless static windows were requested.
+     */
+    if (!fullscan && !mblock_read && iter->vra_len > 0 && ks->ks_rp->cn_cursor_vra_max > 0) {
+        iter->ra_adapt = true;
+        vbr_ra_adapt_init(&iter->vra_adapt, iter->vra_len, ks->ks_rp->cn_cursor_vra_max);
+    }
+
     iter->workq = io_workq;
     iter->last = SRC_NONE;
     iter->pc = pc;
 
     if (mblock_read) {
         iter->asyncio = io_workq ? true : false;
+        iter->csched = cn_get_sched(cn_tree_get_cn(ks->ks_tree));
+        iter->ioc = ks->ks_node_level > 0 ? CSCHED_IO_LEAF : CSCHED_IO_ROOT;
 
         err = kvset_iter_enable_mblock_read(iter);
         if (ev(err))
@@ -2724,6 +2924,10 @@ kvset_iter_create(
             kvset_iter_mblock_read_start(iter);
     }
 
+    /* Only compaction scans the whole kvset, all others are cursors. */
+    if (!fullscan)
+        kvset_heat_add(ks, KVSET_HEAT_CURSORS, 1);
+
     *handle = &iter->handle;
     return 0;
 
@@ -2974,6 +3178,7 @@ kvset_iter_seek(struct kv_iterator *handle, const void *key, s32 len, bool *eof)
     wbti = iter->wbti;
     pti = iter->pti;
     iter->wbti = iter->pti = NULL;
+    iter->kblk_done = 0;
     err = 0;
 
     iter->pti_meta.eof = true;
@@ -3150,8 +3355,10 @@ next_kblock:
 
         /* Can use 'cn_cursor_kblk_madv' to control use of madvise
          * with mcache map since this code is only used with cursors.
+         * An adaptive cursor preloads once it has read through a
+         * whole kblock since its last seek.
          */
-        preload_wbt_nodes = ks->ks_rp->cn_cursor_kra ? 1 : 0;
+        preload_wbt_nodes = ks->ks_rp->cn_cursor_kra || (iter->ra_adapt && iter->kblk_done > 0);
         err = wbti_create(
             &iter->wbti, &kb->kb_kblk_desc, &kb->kb_wbt_desc, 0, iter->reverse, preload_wbt_nodes);
         if (ev(err))
@@ -3163,6 +3370,7 @@ next_kblock:
         wbti_destroy(iter->wbti);
         iter->wbti = 0;
         iter->curr_kblk += inc;
+        iter->kblk_done++;
 
         goto next_kblock;
     }
@@ -3588,17 +3796,22 @@ kvset_iter_get_valptr_mcache(struct kvset_iterator *iter, uint vbidx, uint vboff
 {
     struct kvset *      ks = iter->ks;
     struct vblock_desc *vbd;
+    u32                 ra_len = iter->vra_len;
 
     vbd = lvx2vbd(ks, vbidx);
     assert(vbd);
 
-    if (iter->vra_len > 0) {
+    if (iter->ra_adapt)
+        ra_len = vbr_ra_adapt(
+            &iter->vra_adapt, vbidx, vboff, vlen, iter->reverse, ks->ks_rp->cn_cursor_ra_qdepth);
+
+    if (ra_len > 0) {
         vbr_readahead(
             vbd,
             vboff,
             vlen,
             iter->vra_flags,
-            iter->vra_len,
+            ra_len,
             NELEM(iter->ra_histv),
             iter->ra_histv,
             iter->vra_wq);
@@ -248,6 +248,10 @@ kvset_list_add_tail(struct kvset *kvset, struct list_head *head);
 void
 kvset_get_max_key(struct kvset *km, void **key, uint *klen);
 
+/* MTF_MOCK */
+void
+kvset_get_nth_kblock_min_key(struct kvset *km, u32 index, const void **key, uint *klen);
+
 /* MTF_MOCK */
 u64
 kvset_ctime(const struct kvset *kvset);
@@ -53,6 +53,9 @@ kvset_builder_create(
         goto err_exit2;
 
     bld->cn = cn;
+    bld->pc = pc;
+    bld->flags = flags;
+    bld->agegroup = HSE_MPOLICY_AGE_LEAF; /* kblock builder default */
     bld->key_stats.seqno_prev = U64_MAX;
     bld->key_stats.seqno_prev_ptomb = U64_MAX;
 
@@ -114,6 +117,9 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
         return merr(EINVAL);
 
     if (self->key_stats.nptombs > 0) {
+        if (ev(self->parent))
+            return merr(EINVAL);
+
         err = kbb_add_ptomb(self->kbb, kobj, self->sec.kmd, self->sec.kmd_used, &self->key_stats);
         if (ev(err))
             return err;
@@ -207,7 +213,11 @@ kvset_builder_add_val(
 
         /* vblock builder needs on-media length */
         omlen = complen ? complen : vlen;
-        err = vbb_add_entry(self->vbb, vdata, omlen, &vbid, &vbidx, &vboff);
+
+        if (self->parent)
+            err = vbb_add_entry_shared(self->vbb, vdata, omlen, &vbid, &vbidx, &vboff);
+        else
+            err = vbb_add_entry(self->vbb, vdata, omlen, &vbid, &vbidx, &vboff);
         if (ev(err))
             return err;
 
@@ -317,7 +327,8 @@ kvset_builder_destroy(struct kvset_builder *bld)
     blk_list_free(&bld->vblk_list);
 
     kbb_destroy(bld->kbb);
-    vbb_destroy(bld->vbb);
+    if (!bld->parent)
+        vbb_destroy(bld->vbb);
 
     free(bld->main.kmd);
     free(bld->sec.kmd);
@@ -340,10 +351,15 @@ kvset_builder_finish(struct kvset_builder *imp)
 
     assert(imp->kbb);
     assert(imp->vbb);
+    assert(!imp->parent);
 
-    err = kbb_finish(imp->kbb, &imp->kblk_list, imp->seqno_min, imp->seqno_max);
-    if (ev(err))
-        return err;
+    /* A joined builder already holds the kblocks of its sub-builders.
+     */
+    if (!imp->joined) {
+        err = kbb_finish(imp->kbb, &imp->kblk_list, imp->seqno_min, imp->seqno_max);
+        if (ev(err))
+            return err;
+    }
 
     if (imp->kblk_list.n_blks == 0) {
         /* There are no kblocks. This happens when each input key has
@@ -370,6 +386,9 @@ kvset_builder_get_mblocks(struct kvset_builder *self, struct kvset_mblocks *mblk
     merr_t           err;
     struct blk_list *list;
 
+    if (ev(self->join_err))
+        return self->join_err;
+
     err = kvset_builder_finish(self);
     if (ev(err))
         return err;
@@ -406,15 +425,124 @@ void
 kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_age age)
 {
     assert(age < HSE_MPOLICY_AGE_CNT);
+    self->agegroup = age;
     kbb_set_agegroup(self->kbb, age);
-    vbb_set_agegroup(self->vbb, age);
+    if (!self->parent)
+        vbb_set_agegroup(self->vbb, age);
 }
 
 void
 kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats *stats)
 {
     kbb_set_merge_stats(self->kbb, stats);
-    vbb_set_merge_stats(self->vbb, stats);
+    if (!self->parent)
+        vbb_set_merge_stats(self->vbb, stats);
+}
+
+merr_t
+kvset_builder_create_sub(struct kvset_builder *self, struct kvset_builder **sub_out)
+{
+    struct kvset_builder *sub;
+    merr_t                err;
+
+    if (ev(self->parent || self->joined || self->join_err))
+        return merr(EINVAL);
+
+    sub = malloc(sizeof(*sub));
+    if (ev(!sub))
+        return merr(ENOMEM);
+
+    memset(sub, 0, sizeof(*sub));
+
+    sub->seqno_min = U64_MAX;
+
+    err = kbb_create(&sub->kbb, self->cn, self->pc, self->flags);
+    if (ev(err)) {
+        free(sub);
+        return err;
+    }
+
+    kbb_set_agegroup(sub->kbb, self->agegroup);
+
+    sub->cn = self->cn;
+    sub->vbb = self->vbb;
+    sub->parent = self;
+    sub->pc = self->pc;
+    sub->flags = self->flags;
+    sub->agegroup = self->agegroup;
+    sub->key_stats.seqno_prev = U64_MAX;
+    sub->key_stats.seqno_prev_ptomb = U64_MAX;
+
+    *sub_out = sub;
+    return 0;
+}
+
+merr_t
+kvset_builder_join(struct kvset_builder *self, struct kvset_builder **subv, uint subc)
+{
+    struct kvset_builder *last = NULL;
+    u64                   seqno_min = self->seqno_min;
+    u64                   seqno_max = self->seqno_max;
+    merr_t                err;
+    uint                  i, j;
+
+    if (ev(self->parent || self->joined || self->join_err || !kbb_is_empty(self->kbb)))
+        return merr(EINVAL);
+
+    for (i = 0; i < subc; i++) {
+        assert(subv[i]->parent == self);
+
+        seqno_min = min_t(u64, seqno_min, subv[i]->seqno_min);
+        seqno_max = max_t(u64, seqno_max, subv[i]->seqno_max);
+
+        if (!kbb_is_empty(subv[i]->kbb))
+            last = subv[i];
+    }
+
+    /* The kvset's hlog is read from its last kblock, so the last
+     * non-empty sub-builder must account for all the keys.
+     */
+    for (i = 0; last && i < subc; i++) {
+        if (subv[i] != last)
+            kbb_hlog_union(last->kbb, subv[i]->kbb);
+    }
+
+    for (i = 0; i < subc; i++) {
+        struct kvset_builder *sub = subv[i];
+        u32                   n_blks = self->kblk_list.n_blks;
+
+        err = kbb_finish(sub->kbb, &sub->kblk_list, seqno_min, seqno_max);
+        if (ev(err))
+            goto errout;
+
+        for (j = 0; j < sub->kblk_list.n_blks; j++) {
+            err = blk_list_append(&self->kblk_list, sub->kblk_list.blks[j].bk_blkid);
+            if (ev(err)) {
+                self->kblk_list.n_blks = n_blks;
+                goto errout;
+            }
+        }
+
+        /* The kblocks now belong to the joined builder. */
+        blk_list_free(&sub->kblk_list);
+
+        self->vused += sub->vused;
+    }
+
+    self->seqno_min = seqno_min;
+    self->seqno_max = seqno_max;
+    self->joined = true;
+
+    return 0;
+
+errout:
+    /* The kblocks joined so far belong to this builder and are aborted
+     * when it is destroyed, but they hold only some of the keys.  Make
+     * sure no kvset is ever made of them.
+     */
+    self->join_err = err;
+
+    return err;
 }
 
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
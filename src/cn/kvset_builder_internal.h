@@ -36,11 +36,22 @@ struct kmd_info {
  *                   only if cn is a capped.
  * @last_ptlen:      length of @last_ptomb
  * @vblk_baseidx:    base index used for coalescing multiple vblock builders
+ * @parent:          builder whose vblock builder this builder shares
+ * @pc:              perf counters (for sub-builder kblock builders)
+ * @flags:           builder flags (for sub-builder kblock builders)
+ * @agegroup:        media class age group
+ * @joined:          kblocks were taken from sub-builders
+ * @join_err:        error from a failed join, the builder is unusable
  *
  * This struct contains the output kvset when merging multiple input kvsets
  * into one output kvset.  It is used for ingest, compaction and spill.  When
  * used for spill, there is one of these structs for each child (i.e., one for
  * each output kvset).
+ *
+ * A sub-builder (see kvset_builder_create_sub()) has its own kblock builder
+ * but appends values to its parent's vblock builder (see
+ * vbb_add_entry_shared()), so that the kblocks of several sub-builders can
+ * later be joined into the parent's kvset.
  */
 struct kvset_builder {
     struct cn *cn;
@@ -70,5 +81,12 @@ struct kvset_builder {
     u32 last_ptlen;
     u64 last_ptseq;
     u32 vblk_baseidx;
+
+    struct kvset_builder      *parent;
+    struct perfc_set          *pc;
+    uint                       flags;
+    enum hse_mclass_policy_age agegroup;
+    bool                       joined;
+    merr_t                     join_err;
 };
 #endif
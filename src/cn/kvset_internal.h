@@ -28,6 +28,7 @@
 #include "wbt_internal.h"
 #include "cn_metrics.h"
 #include "cn_tree.h"
+#include "cn_heat.h"
 
 struct kvset_kblk {
     struct kvs_mblk_desc kb_kblk_desc; /* kblock descriptor */
@@ -111,7 +112,15 @@ struct kvset {
     u64      ks_ctime;
     u64      ks_tag;
 
+    struct cn_heat ks_heat; /* read activity, see kvset_get_heat() */
+
     __aligned(SMP_CACHE_BYTES) struct kvset_kblk ks_kblks[];
 };
 
+static __always_inline void
+kvset_heat_add(struct kvset *ks, enum kvset_heat_ctr ctr, u64 n)
+{
+    cn_heat_add(&ks->ks_heat, ctr, n);
+}
+
 #endif /* HSE_KVS_CN_KVSET_INTERNAL_H */
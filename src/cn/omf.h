@@ -125,6 +125,7 @@ OMF_SETGET(struct kblock_hdr_omf, kbh_max_seqno, 64)
  * @bh_n_hashes:        number of hashes per bucket
  * @bh_bitmapsz:        size of bitmap in bytes
  * @bh_modulus:         modulus used to convert first hash to bucket
+ * @bh_pfx_len:         length of key prefixes also in the filter (0: none)
  */
 struct bloom_hdr_omf {
     __le32 bh_magic;
@@ -132,7 +133,7 @@ struct bloom_hdr_omf {
     __le32 bh_bitmapsz;
     __le32 bh_modulus;
     __le32 bh_bktshift;
-    __le16 bh_rsvd1;
+    __le16 bh_pfx_len;
     u8     bh_rotl;
     u8     bh_n_hashes;
     __le32 bh_rsvd2;
@@ -145,6 +146,7 @@ OMF_SETGET(struct bloom_hdr_omf, bh_version, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_bitmapsz, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_modulus, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_bktshift, 32)
+OMF_SETGET(struct bloom_hdr_omf, bh_pfx_len, 16)
 OMF_SETGET(struct bloom_hdr_omf, bh_rotl, 8)
 OMF_SETGET(struct bloom_hdr_omf, bh_n_hashes, 8)
 
@@ -0,0 +1,476 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/alloc.h>
+#include <hse_util/atomic.h>
+#include <hse_util/condvar.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/key_util.h>
+#include <hse_util/mutex.h>
+#include <hse_util/workqueue.h>
+
+#include <hse_ikvdb/tuple.h>
+
+#include "kvset.h"
+#include "kv_iterator.h"
+#include "pmerge.h"
+
+/* Number of resolved items buffered per group.  Must be a power of two.
+ * The helper is rescheduled once the ring drains to half full.
+ */
+#define PMERGE_RING_SZ    (256)
+#define PMERGE_RING_MASK  (PMERGE_RING_SZ - 1)
+#define PMERGE_RING_LOWAT (PMERGE_RING_SZ / 2)
+
+/**
+ * struct pmerge_group - merge state for a contiguous range of kvsets
+ * @pg_es:      element source presented to the cursor's bin heap
+ * @pg_pm:      ptr to parent parallel merge context
+ * @pg_bh:      bin heap that merges this group's kvset iterators
+ * @pg_esrcv:   this group's kvset iterator element sources
+ * @pg_iterc:   number of elements in @pg_esrcv
+ * @pg_prepare: producer must (re)prepare @pg_bh before popping from it
+ * @pg_held:    consumer holds the ring slot at @pg_head
+ * @pg_work:    helper work struct
+ * @pg_ringv:   ring of resolved items
+ * @pg_busy:    producer is queued or running (helper or consumer inline)
+ * @pg_eof:     producer has exhausted @pg_bh
+ * @pg_tail:    next ring slot to fill (written only by the producer)
+ * @pg_head:    next ring slot to read (written only by the consumer)
+ *
+ * Exactly one producer at a time may access @pg_bh and the kvset
+ * iterators, which is enforced by @pg_busy.
+ */
+struct pmerge_group {
+    struct element_source   pg_es;
+    struct pmerge *         pg_pm;
+    struct bin_heap2 *      pg_bh;
+    struct element_source **pg_esrcv;
+    uint                    pg_iterc;
+    bool                    pg_prepare;
+    bool                    pg_held;
+    struct work_struct      pg_work;
+    struct pmerge_item *    pg_ringv;
+
+    __aligned(SMP_CACHE_BYTES) atomic_t pg_busy;
+    atomic_t                            pg_eof;
+    atomic64_t                          pg_tail;
+
+    __aligned(SMP_CACHE_BYTES) atomic64_t pg_head;
+};
+
+/**
+ * struct pmerge - parallel merge context
+ * @pm_wq:      workqueue on which to run the helpers
+ * @pm_seqno:   view seqno used to resolve visible values
+ * @pm_novals:  do not fetch values from vblocks
+ * @pm_groupc:  number of groups in @pm_groupv
+ * @pm_esrcv:   group element sources (one per group)
+ * @pm_iesrcv:  kvset iterator element sources (sliced among the groups)
+ * @pm_groupv:  vector of merge groups
+ * @pm_lock:    held by helpers to clear pg_busy
+ * @pm_cv:      signaled when a helper clears pg_busy
+ * @pm_stop:    helpers must stop producing
+ * @pm_err:     first error encountered by any producer
+ */
+struct pmerge {
+    struct workqueue_struct *pm_wq;
+    u64                      pm_seqno;
+    bool                     pm_novals;
+    uint                     pm_groupc;
+    struct element_source ** pm_esrcv;
+    struct element_source ** pm_iesrcv;
+    struct pmerge_group *    pm_groupv;
+    struct mutex             pm_lock;
+    struct cv                pm_cv;
+
+    __aligned(SMP_CACHE_BYTES) atomic_t pm_stop;
+    atomic64_t                          pm_err;
+};
+
+static void
+pmerge_seterr(struct pmerge *pm, merr_t err)
+{
+    atomic64_cmpxchg(&pm->pm_err, 0, err);
+}
+
+/* Resolve the value of item visible at the merge's view seqno, mirroring
+ * the version walk in cn_tree_cursor_read().  Sets *visible to false if
+ * no version of the key is visible.  Only the visible value is fetched,
+ * and not even that if the merge was reset without values.
+ */
+static merr_t
+pmerge_resolve(struct pmerge *pm, struct pmerge_item *pi, bool *visible)
+{
+    struct kv_iterator *kv_iter = kvset_cursor_es_h2r(pi->pi_kv.src);
+    enum kmd_vtype      vtype;
+    u32                 vbidx;
+    u32                 vboff;
+    merr_t              err;
+
+    *visible = false;
+
+    do {
+        if (!kvset_iter_next_vref(
+                kv_iter, &pi->pi_kv.vctx, &pi->pi_seq, &vtype, &vbidx, &vboff,
+                &pi->pi_vdata, &pi->pi_vlen, &pi->pi_complen))
+            return 0;
+    } while (pi->pi_seq > pm->pm_seqno);
+
+    *visible = true;
+
+    if (pm->pm_novals && (vtype == vtype_val || vtype == vtype_cval)) {
+        pi->pi_vdata = NULL;
+        return 0;
+    }
+
+    err = kvset_iter_next_val(
+        kv_iter, &pi->pi_kv.vctx, vtype, vbidx, vboff, &pi->pi_vdata, &pi->pi_vlen,
+        &pi->pi_complen);
+
+    return ev(err);
+}
+
+/* Fill the group's ring until it is full, the group's kvsets are
+ * exhausted, or the merge is stopped.  Caller must own pg_busy.
+ */
+static void
+pmerge_fill(struct pmerge_group *pg)
+{
+    struct pmerge *pm = pg->pg_pm;
+    u64            tail = atomic64_read(&pg->pg_tail);
+    merr_t         err;
+
+    if (pg->pg_prepare) {
+        pg->pg_prepare = false;
+
+        err = bin_heap2_prepare(pg->pg_bh, pg->pg_iterc, pg->pg_esrcv);
+        if (ev(err)) {
+            pmerge_seterr(pm, err);
+            atomic_set_rel(&pg->pg_eof, 1);
+            return;
+        }
+    }
+
+    while (!atomic_read(&pm->pm_stop)) {
+        struct pmerge_item *pi;
+        struct cn_kv_item * item;
+        bool                visible;
+
+        if (tail - atomic64_read_acq(&pg->pg_head) >= PMERGE_RING_SZ)
+            break;
+
+        if (!bin_heap2_peek(pg->pg_bh, (void **)&item)) {
+            atomic_set_rel(&pg->pg_eof, 1);
+            break;
+        }
+
+        /* Copy out the item before bin_heap2_pop() overwrites it.
+         */
+        pi = pg->pg_ringv + (tail & PMERGE_RING_MASK);
+        pi->pi_kv = *item;
+
+        bin_heap2_pop(pg->pg_bh, (void **)&item);
+
+        err = pmerge_resolve(pm, pi, &visible);
+        if (ev(err)) {
+            pmerge_seterr(pm, err);
+            atomic_set_rel(&pg->pg_eof, 1);
+            break;
+        }
+
+        if (!visible)
+            continue;
+
+        /* Older versions of a visible key within this group can never
+         * be returned, so drop them here rather than in the cursor.
+         * As in drop_dups(), a ptomb must not hide its own key, nor
+         * may we drop a ptomb that hides older keys.
+         */
+        if (!pi->pi_kv.vctx.is_ptomb) {
+            while (bin_heap2_peek(pg->pg_bh, (void **)&item)) {
+                if (item->vctx.is_ptomb || key_obj_cmp(&item->kobj, &pi->pi_kv.kobj))
+                    break;
+
+                bin_heap2_pop(pg->pg_bh, (void **)&item);
+            }
+        }
+
+        atomic64_inc_rel(&pg->pg_tail);
+        ++tail;
+    }
+}
+
+static void
+pmerge_worker(struct work_struct *work)
+{
+    struct pmerge_group *pg = container_of(work, struct pmerge_group, pg_work);
+    struct pmerge *      pm = pg->pg_pm;
+
+    pmerge_fill(pg);
+
+    /* pm may be freed once pg_busy is cleared and pm_lock is dropped. */
+    mutex_lock(&pm->pm_lock);
+    atomic_set_rel(&pg->pg_busy, 0);
+    cv_broadcast(&pm->pm_cv);
+    mutex_unlock(&pm->pm_lock);
+}
+
+/* Sleep until the group's helper is idle.  The helper may still be
+ * waiting for a thread on the workqueue, hence we must not spin.
+ */
+static void
+pmerge_wait(struct pmerge_group *pg)
+{
+    struct pmerge *pm = pg->pg_pm;
+
+    if (!atomic_read_acq(&pg->pg_busy))
+        return;
+
+    mutex_lock(&pm->pm_lock);
+    while (atomic_read_acq(&pg->pg_busy))
+        cv_wait(&pm->pm_cv, &pm->pm_lock);
+    mutex_unlock(&pm->pm_lock);
+}
+
+static void
+pmerge_kick(struct pmerge_group *pg)
+{
+    if (atomic_read(&pg->pg_busy) || atomic_cmpxchg(&pg->pg_busy, 0, 1) != 0)
+        return;
+
+    queue_work(pg->pg_pm->pm_wq, &pg->pg_work);
+}
+
+static bool
+pmerge_get_next(struct element_source *es, void **element)
+{
+    struct pmerge_group *pg = container_of(es, struct pmerge_group, pg_es);
+    struct pmerge *      pm = pg->pg_pm;
+    u64                  head;
+
+    /* Release the slot returned by the previous call.
+     */
+    if (pg->pg_held) {
+        atomic64_inc_rel(&pg->pg_head);
+        pg->pg_held = false;
+    }
+
+    head = atomic64_read(&pg->pg_head);
+
+    while (1) {
+        bool eof = atomic_read_acq(&pg->pg_eof);
+        u64  tail = atomic64_read_acq(&pg->pg_tail);
+
+        if (head < tail) {
+            if (!eof && tail - head <= PMERGE_RING_LOWAT)
+                pmerge_kick(pg);
+
+            *element = pg->pg_ringv + (head & PMERGE_RING_MASK);
+            pg->pg_held = true;
+            return true;
+        }
+
+        if (eof || atomic64_read(&pm->pm_err))
+            return false;
+
+        /* The ring is empty.  If the helper isn't running produce
+         * the next batch inline, otherwise wait for it to catch up.
+         */
+        if (atomic_cmpxchg(&pg->pg_busy, 0, 1) == 0) {
+            pmerge_fill(pg);
+            atomic_set_rel(&pg->pg_busy, 0);
+            continue;
+        }
+
+        pmerge_wait(pg);
+    }
+}
+
+static bool
+pmerge_unget(struct element_source *es)
+{
+    return false;
+}
+
+merr_t
+pmerge_create(
+    struct kv_iterator **    iterv,
+    uint                     iterc,
+    uint                     groupc,
+    bin_heap2_compare_fn *   cmp,
+    struct workqueue_struct *wq,
+    struct pmerge **         pm_out)
+{
+    struct pmerge *pm;
+    size_t         sz;
+    merr_t         err;
+    uint           i, j;
+
+    if (ev(!wq || !iterc || !groupc))
+        return merr(EINVAL);
+
+    groupc = min_t(uint, groupc, iterc);
+
+    pm = alloc_aligned(sizeof(*pm), SMP_CACHE_BYTES);
+    if (ev(!pm))
+        return merr(ENOMEM);
+
+    memset(pm, 0, sizeof(*pm));
+    pm->pm_wq = wq;
+    pm->pm_groupc = groupc;
+    mutex_init(&pm->pm_lock);
+    cv_init(&pm->pm_cv, "pmerge");
+    atomic_set(&pm->pm_stop, 1);
+    atomic64_set(&pm->pm_err, 0);
+
+    pm->pm_esrcv = calloc(groupc + iterc, sizeof(*pm->pm_esrcv));
+    sz = sizeof(*pm->pm_groupv) * groupc;
+    pm->pm_groupv = alloc_aligned(sz, SMP_CACHE_BYTES);
+    if (ev(!pm->pm_esrcv || !pm->pm_groupv)) {
+        err = merr(ENOMEM);
+        goto errout;
+    }
+
+    memset(pm->pm_groupv, 0, sz);
+    pm->pm_iesrcv = pm->pm_esrcv + groupc;
+
+    for (i = 0; i < iterc; ++i)
+        pm->pm_iesrcv[i] = &iterv[i]->kvi_es;
+
+    /* Groups are contiguous and ordered newest to oldest so that
+     * the cursor's bin heap breaks ties between groups exactly
+     * as it would between the kvsets themselves.
+     */
+    for (i = j = 0; i < groupc; ++i) {
+        struct pmerge_group *pg = pm->pm_groupv + i;
+        uint                 end = ((i + 1) * iterc) / groupc;
+
+        pg->pg_pm = pm;
+        pg->pg_esrcv = pm->pm_iesrcv + j;
+        pg->pg_iterc = end - j;
+        pg->pg_es = es_make(pmerge_get_next, pmerge_unget, NULL);
+        atomic_set(&pg->pg_busy, 0);
+        atomic_set(&pg->pg_eof, 1);
+        atomic64_set(&pg->pg_tail, 0);
+        atomic64_set(&pg->pg_head, 0);
+        INIT_WORK(&pg->pg_work, pmerge_worker);
+
+        pm->pm_esrcv[i] = &pg->pg_es;
+        j = end;
+
+        pg->pg_ringv = malloc(sizeof(*pg->pg_ringv) * PMERGE_RING_SZ);
+        if (ev(!pg->pg_ringv)) {
+            err = merr(ENOMEM);
+            goto errout;
+        }
+
+        err = bin_heap2_create(pg->pg_iterc, cmp, &pg->pg_bh);
+        if (ev(err))
+            goto errout;
+    }
+
+    *pm_out = pm;
+
+    return 0;
+
+errout:
+    pmerge_destroy(pm);
+
+    return err;
+}
+
+void
+pmerge_destroy(struct pmerge *pm)
+{
+    uint i;
+
+    if (!pm)
+        return;
+
+    if (pm->pm_groupv) {
+        pmerge_quiesce(pm);
+
+        for (i = 0; i < pm->pm_groupc; ++i) {
+            bin_heap2_destroy(pm->pm_groupv[i].pg_bh);
+            free(pm->pm_groupv[i].pg_ringv);
+        }
+    }
+
+    cv_destroy(&pm->pm_cv);
+    mutex_destroy(&pm->pm_lock);
+
+    free_aligned(pm->pm_groupv);
+    free(pm->pm_esrcv);
+    free_aligned(pm);
+}
+
+void
+pmerge_quiesce(struct pmerge *pm)
+{
+    uint i;
+
+    atomic_set(&pm->pm_stop, 1);
+
+    for (i = 0; i < pm->pm_groupc; ++i)
+        pmerge_wait(pm->pm_groupv + i);
+}
+
+void
+pmerge_reset(struct pmerge *pm, u64 seqno, bool novals)
+{
+    uint i;
+
+    assert(atomic_read(&pm->pm_stop));
+
+    pm->pm_seqno = seqno;
+    pm->pm_novals = novals;
+
+    for (i = 0; i < pm->pm_groupc; ++i) {
+        struct pmerge_group *pg = pm->pm_groupv + i;
+
+        assert(!atomic_read(&pg->pg_busy));
+
+        pg->pg_prepare = true;
+        pg->pg_held = false;
+        atomic64_set(&pg->pg_head, 0);
+        atomic64_set(&pg->pg_tail, 0);
+        atomic_set(&pg->pg_eof, 0);
+    }
+
+    atomic_set_rel(&pm->pm_stop, 0);
+
+    /* Start all the helpers so that the groups are primed in parallel
+     * by the time the cursor prepares its bin heap.
+     */
+    for (i = 0; i < pm->pm_groupc; ++i)
+        pmerge_kick(pm->pm_groupv + i);
+}
+
+uint
+pmerge_esrcv(struct pmerge *pm, struct element_source ***esrcv)
+{
+    *esrcv = pm->pm_esrcv;
+
+    return pm->pm_groupc;
+}
+
+uint
+pmerge_active(struct pmerge *pm)
+{
+    uint i, active = 0;
+
+    for (i = 0; i < pm->pm_groupc; ++i)
+        active += bin_heap2_width(pm->pm_groupv[i].pg_bh);
+
+    return active;
+}
+
+merr_t
+pmerge_err(struct pmerge *pm)
+{
+    return atomic64_read(&pm->pm_err);
+}
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVDB_CN_PMERGE_H
+#define HSE_KVDB_CN_PMERGE_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/bin_heap.h>
+
+#include "kv_iterator.h"
+
+#pragma GCC visibility push(hidden)
+
+/*
+ * A parallel merge splits a cursor's kvset iterators into a small number
+ * of contiguous groups (newest first) and merges each group on a helper
+ * thread.  Each helper resolves the visible value of every key it pops
+ * and drops the older duplicates within its group, leaving the results
+ * in a bounded single-producer/single-consumer ring.  The cursor then
+ * merges the group rings with its own bin heap, exactly as it would
+ * merge the kvset iterators themselves.
+ */
+
+struct pmerge;
+struct workqueue_struct;
+
+/**
+ * struct pmerge_item - a merged item with its visible value resolved
+ * @pi_kv:      key and value context (must be first, see cn_kv_cmp())
+ * @pi_seq:     seqno of the visible value
+ * @pi_vdata:   value data or tombstone
+ * @pi_vlen:    uncompressed value length
+ * @pi_complen: compressed value length (0 if not compressed)
+ */
+struct pmerge_item {
+    struct cn_kv_item pi_kv;
+    u64               pi_seq;
+    const void *      pi_vdata;
+    uint              pi_vlen;
+    uint              pi_complen;
+};
+
+/**
+ * pmerge_create() - create a parallel merge over a vector of kvset iterators
+ * @iterv:  kvset iterators, newest first (caller retains ownership)
+ * @iterc:  number of iterators in @iterv
+ * @groupc: desired number of merge groups
+ * @cmp:    key comparator (cn_kv_cmp or cn_kv_cmp_rev)
+ * @wq:     workqueue on which to run the merge helpers
+ * @pm_out: parallel merge context (output)
+ *
+ * The caller must position the iterators and call pmerge_reset() before
+ * reading from the element sources returned by pmerge_esrcv().
+ */
+merr_t
+pmerge_create(
+    struct kv_iterator **    iterv,
+    uint                     iterc,
+    uint                     groupc,
+    bin_heap2_compare_fn *   cmp,
+    struct workqueue_struct *wq,
+    struct pmerge **         pm_out);
+
+/**
+ * pmerge_destroy() - stop all merge helpers and free the context
+ * @pm: parallel merge context (may be NULL)
+ */
+void
+pmerge_destroy(struct pmerge *pm);
+
+/**
+ * pmerge_quiesce() - stop all merge helpers and wait for them to go idle
+ * @pm: parallel merge context
+ *
+ * Must be called before the iterators are repositioned.
+ */
+void
+pmerge_quiesce(struct pmerge *pm);
+
+/**
+ * pmerge_reset() - discard all merged items and restart the helpers
+ * @pm:     parallel merge context
+ * @seqno:  view seqno used to resolve visible values
+ * @novals: if true, do not fetch values stored in vblocks
+ *
+ * Items whose values are not fetched have a NULL @pi_vdata.
+ */
+void
+pmerge_reset(struct pmerge *pm, u64 seqno, bool novals);
+
+/**
+ * pmerge_esrcv() - retrieve the per-group element sources
+ * @pm:    parallel merge context
+ * @esrcv: element source vector (output)
+ *
+ * Return: number of groups (i.e., elements in @esrcv)
+ */
+uint
+pmerge_esrcv(struct pmerge *pm, struct element_source ***esrcv);
+
+/**
+ * pmerge_active() - number of kvset iterators not yet exhausted
+ * @pm: parallel merge context
+ */
+uint
+pmerge_active(struct pmerge *pm);
+
+/**
+ * pmerge_err() - retrieve the first error encountered by any merge helper
+ * @pm: parallel merge context
+ */
+merr_t
+pmerge_err(struct pmerge *pm);
+
+#pragma GCC visibility pop
+
+#endif
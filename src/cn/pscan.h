@@ -13,6 +13,7 @@
 #include "cn_metrics.h"
 
 struct cursor_summary;
+struct pmerge;
 
 /**
  * struct pscan - allocated prefix scan context, including output buffer
@@ -41,6 +42,7 @@ struct cursor_summary;
  * @pt_set:     if the ptomb in pt_kobj, if there is one, is relevant.
  * @pt_kobj:    ptomb key obj (key in kblk OR pt_buf[] right after cur update)
  * @pt_seq:     ptomb's seqno
+ * @pm:         parallel merge context (NULL if merging serially)
  */
 struct pscan {
     struct bin_heap2 *      bh;
@@ -65,6 +67,7 @@ struct pscan {
     u32 reverse : 1;
     u32 eof : 1;
     u32 pt_set : 1;
+    u32 keys_only : 1;
 
     struct key_obj pt_kobj;
     u64            pt_seq;
@@ -72,6 +75,8 @@ struct pscan {
 
     struct cn_merge_stats stats;
     struct kc_filter *    filter;
+    const struct kc_pred *pred;
+    struct pmerge *       pm;
     void *                base;
 
     __aligned(SMP_CACHE_BYTES) char buf[];
@@ -6,6 +6,9 @@
 #include <hse_util/platform.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/slab.h>
+#include <hse_util/condvar.h>
+#include <hse_util/mutex.h>
+#include <hse_util/workqueue.h>
 
 #include <hse_ikvdb/kvs_cparams.h>
 #include <hse_ikvdb/kvs_rparams.h>
@@ -13,6 +16,7 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/kvdb_perfc.h>
+#include <hse_ikvdb/cn.h>
 
 /* [HSE_REVISIT] - Why is this at the top of this file? */
 
@@ -60,8 +64,15 @@ merge_item_compare(const void *a_blob, const void *b_blob)
     return 0;
 }
 
+/* Keys at or beyond @ekey (if given) belong to the next subcompaction.
+ */
 static merr_t
-replenish(struct bin_heap *bh, struct kv_iterator **iterv, uint src, struct cn_merge_stats *stats)
+replenish(
+    struct bin_heap *      bh,
+    struct kv_iterator **  iterv,
+    uint                   src,
+    const struct key_obj * ekey,
+    struct cn_merge_stats *stats)
 {
     struct kv_iterator *iter = iterv[src];
     merr_t              err;
@@ -76,6 +87,9 @@ replenish(struct bin_heap *bh, struct kv_iterator **iterv, uint src, struct cn_m
     if (unlikely(iter->kvi_eof))
         return 0;
 
+    if (ekey && key_obj_cmp(&item.kobj, ekey) >= 0)
+        return 0;
+
     item.src = src;
 
     err = bin_heap_insert(bh, &item);
@@ -93,6 +107,7 @@ merge_init(
     struct bin_heap **     bh_out,
     struct kv_iterator **  iterv,
     u32                    iterc,
+    const struct key_obj * ekey,
     struct cn_merge_stats *stats)
 {
     u32    i;
@@ -105,7 +120,7 @@ merge_init(
     stats->ms_srcs = iterc;
 
     for (i = 0; i < iterc; i++) {
-        err = replenish(*bh_out, iterv, i, stats);
+        err = replenish(*bh_out, iterv, i, ekey, stats);
         if (ev(err))
             goto err_exit2;
     }
@@ -124,6 +139,7 @@ get_next_item(
     struct bin_heap *      bh,
     struct kv_iterator **  iterv,
     struct merge_item *    item,
+    const struct key_obj * ekey,
     struct cn_merge_stats *stats,
     merr_t *               err_out)
 {
@@ -131,7 +147,7 @@ get_next_item(
 
     got_item = bin_heap_get_delete(bh, item);
     if (got_item)
-        *err_out = replenish(bh, iterv, item->src, stats);
+        *err_out = replenish(bh, iterv, item->src, ekey, stats);
     else
         *err_out = 0;
     return got_item;
@@ -230,11 +246,11 @@ kv_spill(struct cn_compaction_work *w)
     if (w->cw_prog_interval && w->cw_progress)
         tprog = jiffies;
 
-    err = merge_init(&bh, w->cw_inputv, w->cw_kvset_cnt, &w->cw_stats);
+    err = merge_init(&bh, w->cw_inputv, w->cw_kvset_cnt, w->cw_sub_ekey, &w->cw_stats);
     if (ev(err))
         return err;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(bh, w->cw_inputv, &curr, w->cw_sub_ekey, &w->cw_stats, &err);
     if (!more || ev(err))
         goto done;
 
@@ -519,7 +535,7 @@ get_values:
     dbg_nvals_this_key = 0;
     dbg_prev_src = curr.src;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(bh, w->cw_inputv, &curr, w->cw_sub_ekey, &w->cw_stats, &err);
     if (ev(err))
         goto done;
 
@@ -568,31 +584,245 @@ done:
     bin_heap_destroy(bh);
     free_aligned(buf);
 
-    /* We must ensure the latest version of the key hash map is persisted
-     * if it changed while we were using it (regardless of who changed it,
-     * and especially if we changed it, regardless of error).
+    if (seqno_errcnt)
+        hse_log(HSE_WARNING "%s: seqno errcnt %u", __func__, seqno_errcnt);
+
+    if (tprog)
+        w->cw_progress(w);
+
+    return err;
+}
+
+/* We must ensure the latest version of the key hash map is persisted
+ * if it changed while we were using it (regardless of who changed it,
+ * and especially if we changed it, regardless of error).
+ */
+merr_t
+cn_spill_khashmap_sync(struct cn_tree *tree)
+{
+    struct cn_khashmap *khashmap;
+    bool                update;
+
+    khashmap = cn_tree_get_khashmap(tree);
+    if (!khashmap)
+        return 0;
+
+    spin_lock(&khashmap->khm_lock);
+    update = (khashmap->khm_gen > khashmap->khm_gen_committed);
+    spin_unlock(&khashmap->khm_lock);
+
+    if (update) {
+        struct cn_tstate *ts = tree->ct_tstate;
+
+        return ts->ts_update(ts, kv_spill_prepare, kv_spill_commit, kv_spill_abort, tree);
+    }
+
+    return 0;
+}
+
+/**
+ * struct spill_subc_ctl - state shared by the key ranges of a subcompaction
+ * @sc_lock:    protects @sc_running and each key range's @ss_prog
+ * @sc_cv:      signaled as each key range finishes
+ * @sc_running: number of key ranges still merging
+ */
+struct spill_subc_ctl {
+    struct mutex sc_lock;
+    struct cv    sc_cv;
+    uint         sc_running;
+};
+
+/**
+ * struct spill_subc - one key range of a subcompaction
+ * @ss_wstruct: for running on the cn subcompaction workqueue
+ * @ss_w:       merge parameters, inputs and sub-builders of this key range
+ * @ss_ctl:     shared subcompaction state
+ * @ss_err:     merge status
+ * @ss_prog:    copy of @ss_w.cw_stats last published by the worker
+ *
+ * @ss_w.cw_stats is private to the worker until it finishes, the
+ * waiting thread reports progress from @ss_prog.
+ */
+struct spill_subc {
+    struct work_struct        ss_wstruct;
+    struct cn_compaction_work ss_w;
+    struct spill_subc_ctl *   ss_ctl;
+    merr_t                    ss_err;
+    struct cn_merge_stats     ss_prog;
+};
+
+static void
+kv_spill_subc_progress(struct cn_compaction_work *sw)
+{
+    struct spill_subc *ss = container_of(sw, struct spill_subc, ss_w);
+
+    mutex_lock(&ss->ss_ctl->sc_lock);
+    ss->ss_prog = sw->cw_stats;
+    mutex_unlock(&ss->ss_ctl->sc_lock);
+}
+
+static void
+kv_spill_subc_cb(struct work_struct *work)
+{
+    struct spill_subc *    ss = container_of(work, struct spill_subc, ss_wstruct);
+    struct spill_subc_ctl *ctl = ss->ss_ctl;
+
+    ss->ss_err = kv_spill(&ss->ss_w);
+
+    mutex_lock(&ctl->sc_lock);
+    --ctl->sc_running;
+    cv_signal(&ctl->sc_cv);
+    mutex_unlock(&ctl->sc_lock);
+}
+
+/*
+ * While the key ranges are merging (@vstatsv is NULL), sum what they last
+ * published with sc_lock held.  The vblock stats are updated under the
+ * output builders' locks and are only added once all key ranges finished.
+ */
+static void
+kv_spill_subc_stats(
+    struct cn_compaction_work *  w,
+    const struct cn_merge_stats *base,
+    struct spill_subc *          subv,
+    const struct cn_merge_stats *vstatsv)
+{
+    uint i;
+
+    w->cw_stats = *base;
+
+    for (i = 0; i < w->cw_subc; i++)
+        cn_merge_stats_add(&w->cw_stats, vstatsv ? &subv[i].ss_w.cw_stats : &subv[i].ss_prog);
+
+    for (i = 0; vstatsv && i < w->cw_outc; i++)
+        cn_merge_stats_add(&w->cw_stats, &vstatsv[i]);
+
+    w->cw_stats.ms_srcs = w->cw_kvset_cnt;
+}
+
+/**
+ * kv_spill_subc() - merge the key ranges of a subcompaction in parallel
+ *
+ * Each key range is merged by kv_spill() on the cn subcompaction workqueue
+ * into a set of sub-builders, one per output.  Sub-builders write their own
+ * kblocks but append values to the vblocks of the output builder, hence
+ * each output remains a single kvset and the job commits in one cndb
+ * transaction.  The caller's thread only waits and reports progress.
+ *
+ * The caller's thread is blocked for the whole job, so a subcompaction
+ * occupies its compaction slot in csched as well as up to cw_subc threads
+ * of the subcompaction workqueue, which is sized independently.
+ */
+static merr_t
+kv_spill_subc(struct cn_compaction_work *w)
+{
+    struct workqueue_struct *wq = cn_get_subc_wq(w->cw_tree->cn);
+    struct cn_merge_stats    base = w->cw_stats;
+    struct cn_merge_stats *  vstatsv;
+    struct kvset_builder **  bldv;
+    struct spill_subc_ctl    ctl;
+    struct spill_subc *      subv;
+    merr_t                   err = 0;
+    uint                     i, j;
+
+    assert(w->cw_subc > 1);
+
+    subv = calloc(w->cw_subc, sizeof(*subv));
+    bldv = calloc(w->cw_subc, sizeof(*bldv));
+    vstatsv = calloc(w->cw_outc, sizeof(*vstatsv));
+    if (ev(!subv || !bldv || !vstatsv)) {
+        err = merr(ENOMEM);
+        goto out;
+    }
+
+    /* Values are written by the output builders on behalf of all key
+     * ranges, serialized by each output builder's lock.
      */
-    if (khashmap) {
-        merr_t err2;
-        bool   update;
+    for (i = 0; i < w->cw_outc; i++)
+        kvset_builder_set_merge_stats(w->cw_child[i], &vstatsv[i]);
 
-        spin_lock(&khashmap->khm_lock);
-        update = (khashmap->khm_gen > khashmap->khm_gen_committed);
-        spin_unlock(&khashmap->khm_lock);
+    for (j = 0; j < w->cw_subc; j++) {
+        struct cn_compaction_work *sw = &subv[j].ss_w;
 
-        if (update) {
-            struct cn_tstate *ts = w->cw_tree->ct_tstate;
+        /* kv_spill() uses only the merge parameters, inputs and builders
+         * of its work struct, so each key range merges on a shallow copy.
+         */
+        *sw = *w;
+        memset(&sw->cw_stats, 0, sizeof(sw->cw_stats));
+        memset(sw->cw_child, 0, sizeof(sw->cw_child));
+        sw->cw_progress = w->cw_progress ? kv_spill_subc_progress : NULL;
+        sw->cw_inputv = j ? w->cw_subinputv + (j - 1) * w->cw_kvset_cnt : w->cw_inputv;
+        sw->cw_sub_ekey = j + 1 < w->cw_subc ? &w->cw_subkeyv[j] : NULL;
+
+        for (i = 0; i < w->cw_kvset_cnt; i++)
+            kvset_iter_set_stats(sw->cw_inputv[i], &sw->cw_stats);
+
+        for (i = 0; i < w->cw_outc; i++) {
+            err = kvset_builder_create_sub(w->cw_child[i], &sw->cw_child[i]);
+            if (ev(err))
+                goto out;
 
-            err2 = ts->ts_update(ts, kv_spill_prepare, kv_spill_commit, kv_spill_abort, w->cw_tree);
-            err = err ?: err2;
+            kvset_builder_set_merge_stats(sw->cw_child[i], &sw->cw_stats);
         }
+
+        subv[j].ss_ctl = &ctl;
+        INIT_WORK(&subv[j].ss_wstruct, kv_spill_subc_cb);
     }
 
-    if (seqno_errcnt)
-        hse_log(HSE_WARNING "%s: seqno errcnt %u", __func__, seqno_errcnt);
+    mutex_init(&ctl.sc_lock);
+    cv_init(&ctl.sc_cv, "spill_subc");
+    ctl.sc_running = w->cw_subc;
 
-    if (tprog)
-        w->cw_progress(w);
+    for (j = 0; j < w->cw_subc; j++)
+        queue_work(wq, &subv[j].ss_wstruct);
+
+    mutex_lock(&ctl.sc_lock);
+    while (ctl.sc_running > 0) {
+        cv_timedwait(&ctl.sc_cv, &ctl.sc_lock, 1000);
+
+        if (w->cw_prog_interval && w->cw_progress) {
+            kv_spill_subc_stats(w, &base, subv, NULL);
+            mutex_unlock(&ctl.sc_lock);
+            w->cw_progress(w);
+            mutex_lock(&ctl.sc_lock);
+        }
+    }
+    mutex_unlock(&ctl.sc_lock);
+
+    cv_destroy(&ctl.sc_cv);
+    mutex_destroy(&ctl.sc_lock);
+
+    kv_spill_subc_stats(w, &base, subv, vstatsv);
+
+    for (j = 0; j < w->cw_subc && !err; j++)
+        err = subv[j].ss_err;
+
+    for (i = 0; i < w->cw_outc && !err; i++) {
+        for (j = 0; j < w->cw_subc; j++)
+            bldv[j] = subv[j].ss_w.cw_child[i];
+
+        err = kvset_builder_join(w->cw_child[i], bldv, w->cw_subc);
+        if (ev(err))
+            break;
+    }
+
+out:
+    if (vstatsv) {
+        for (i = 0; i < w->cw_outc; i++)
+            kvset_builder_set_merge_stats(w->cw_child[i], &w->cw_stats);
+    }
+
+    if (subv) {
+        for (j = 0; j < w->cw_subc; j++) {
+            for (i = 0; i < w->cw_outc; i++)
+                if (subv[j].ss_w.cw_child[i])
+                    kvset_builder_destroy(subv[j].ss_w.cw_child[i]);
+        }
+    }
+
+    free(vstatsv);
+    free(bldv);
+    free(subv);
 
     return err;
 }
@@ -606,23 +836,23 @@ is_spill_to_intnode(struct cn_tree_node *pnode, u32 child)
 merr_t
 cn_spill(struct cn_compaction_work *w)
 {
-    merr_t err;
-    uint   i;
+    merr_t err, err2;
+    uint   flags, i;
 
     assert(w->cw_kvset_cnt);
     assert(w->cw_inputv);
 
     memset(w->cw_outv, 0, w->cw_outc * sizeof(*w->cw_outv));
 
+    flags = KVSET_BUILDER_FLAGS_SPARE;
+    if (w->cw_node && cn_node_isroot(w->cw_node))
+        flags |= KVSET_BUILDER_FLAGS_ROOT;
+
     for (i = 0; i < w->cw_outc; i++) {
         struct cn_tree_node *pnode;
 
         err = kvset_builder_create(
-            &w->cw_child[i],
-            cn_tree_get_cn(w->cw_tree),
-            w->cw_pc,
-            w->cw_dgen_hi,
-            KVSET_BUILDER_FLAGS_SPARE);
+            &w->cw_child[i], cn_tree_get_cn(w->cw_tree), w->cw_pc, w->cw_dgen_hi, flags);
         if (ev(err))
             goto done;
 
@@ -646,7 +876,13 @@ cn_spill(struct cn_compaction_work *w)
         }
     }
 
-    err = kv_spill(w);
+    if (w->cw_subc > 1)
+        err = kv_spill_subc(w);
+    else
+        err = kv_spill(w);
+
+    err2 = cn_spill_khashmap_sync(w->cw_tree);
+    err = err ?: err2;
     if (ev(err))
         goto done;
 
@@ -10,6 +10,7 @@
 #include <hse_util/inttypes.h>
 
 struct cn_compaction_work;
+struct cn_tree;
 
 /* MTF_MOCK_DECL(spill) */
 
@@ -42,6 +43,17 @@ struct cn_compaction_work;
 merr_t
 cn_spill(struct cn_compaction_work *w);
 
+/**
+ * cn_spill_khashmap_sync() - persist the tree's key hash map if it changed
+ * @tree: cn tree
+ *
+ * Must be called after routing keys through the key hash map (by spill
+ * or by a partitioned ingest) and before committing the result, as it
+ * may have assigned children to previously unused hash map slots.
+ */
+merr_t
+cn_spill_khashmap_sync(struct cn_tree *tree);
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "spill_ut.h"
 #endif /* HSE_UNIT_TEST_MODE */
@@ -70,6 +70,7 @@ pre(struct mtf_test_info *info)
 {
     mock_mpool_set(); /* mdc mocks */
     mock_kvset_set(); /* neuter the tree */
+    mock_kvset_key_split = 0;
 
     rp.cn_diag_mode = 1;
 
@@ -197,13 +198,95 @@ verify_cursor(
     merr_t                err;
 
     /* make seqno so large there is never any filtering */
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
     verify(lcl_ti, cur, vtab, vc, 0);
 }
 
+static void
+verify_cursor_keys(
+    struct mtf_test_info *lcl_ti,
+    struct cn *           cn,
+    void *                pfx,
+    int                   pfx_len,
+    struct nkv_tab *      vtab)
+{
+    struct cursor_summary sum;
+    struct kvs_kvtuple    kvt;
+    void *                cur;
+    merr_t                err;
+    bool                  eof;
+    int                   key, nk;
+
+    err = cn_cursor_create(cn, seqno, false, true, NULL, pfx, pfx_len, &sum, &cur);
+    ASSERT_EQ(err, 0);
+    ASSERT_NE(cur, NULL);
+
+    key = vtab->key1;
+    for (nk = 0; nk < vtab->nkeys; ++nk, ++key) {
+        const int *ip;
+
+        err = cn_cursor_read(cur, &kvt, &eof);
+        ASSERT_EQ(err, 0);
+        ASSERT_FALSE(eof);
+
+        /* keys are returned with value lengths but no value data */
+        ip = kvt.kvt_key.kt_data;
+        ASSERT_EQ(ntohl(*ip), key);
+        ASSERT_EQ(kvt.kvt_value.vt_data, NULL);
+        ASSERT_EQ(kvs_vtuple_vlen(&kvt.kvt_value), sizeof(*ip));
+    }
+
+    err = cn_cursor_read(cur, &kvt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_TRUE(eof);
+
+    cn_cursor_destroy(cur);
+}
+
+static void
+verify_pred(
+    struct mtf_test_info *lcl_ti,
+    struct cn *           cn,
+    const struct kc_pred *pred,
+    const int *           keyv,
+    int                   keyc)
+{
+    struct cursor_summary sum;
+    struct kvs_kvtuple    kvt;
+    void *                cur;
+    merr_t                err;
+    bool                  eof;
+    int                   nk;
+
+    err = cn_cursor_create(cn, seqno, false, false, NULL, NULL, 0, &sum, &cur);
+    ASSERT_EQ(err, 0);
+    ASSERT_NE(cur, NULL);
+
+    cn_cursor_pred(cur, pred);
+
+    for (nk = 0; nk < keyc; ++nk) {
+        const int *ip;
+
+        err = cn_cursor_read(cur, &kvt, &eof);
+        ASSERT_EQ(err, 0);
+        ASSERT_FALSE(eof);
+
+        ip = kvt.kvt_key.kt_data;
+        ASSERT_EQ(ntohl(*ip), keyv[nk]);
+        ip = kvt.kvt_value.vt_data;
+        ASSERT_EQ(*ip, keyv[nk]);
+    }
+
+    err = cn_cursor_read(cur, &kvt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_TRUE(eof);
+
+    cn_cursor_destroy(cur);
+}
+
 static void
 verify_seek(
     struct mtf_test_info *lcl_ti,
@@ -219,7 +302,7 @@ verify_seek(
     void *                cur;
     merr_t                err;
 
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -245,7 +328,7 @@ verify_seek_eof(
     void *cur;
     merr_t err;
 
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -387,7 +470,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, repeat_update, pre, post)
     err = cn_tree_insert_kvset(tree, ITV_KVSET(itv[0]), 0, 0);
     ASSERT_EQ(err, 0);
 
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -477,6 +560,121 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, root_1kvset, pre, post)
     verify_cursor(lcl_ti, cn, pfx2, sizeof(pfx2), vtab, 1);
     verify_cursor(lcl_ti, cn, pfx1, sizeof(pfx2), vtab+1, 1);
     verify_cursor(lcl_ti, cn, pfx5, sizeof(pfx5), 0, 0);
+    verify_cursor_keys(lcl_ti, cn, pfx2, sizeof(pfx2), vtab);
+
+    err = cn_close(cn);
+    ASSERT_EQ(err, 0);
+
+    dummy_ikvdb_destroy(kk.kk_parent);
+    free(cndb.cndb_workv);
+    free(cndb.cndb_keepv);
+    free(cndb.cndb_tagv);
+    free(cndb.cndb_cbuf);
+
+    for (int i = 0; i < NELEM(make); ++i) {
+        struct mock_kv_iterator *iter = itv[i]->kvi_context;
+        struct kvdata *          d = iter->kvset->iter_data;
+
+        free(d);
+        kvset_iter_release(itv[i]);
+    }
+}
+
+MTF_DEFINE_UTEST_PREPOST(cn_cursor, root_1kvset_pred, pre, post)
+{
+    struct cn *         cn;
+    struct cn_tree *    tree;
+    struct mock_kvset * mk;
+    struct mpool *      ds = (void *)-1;
+    struct kv_iterator *itv[1];
+
+    merr_t             err;
+    struct cndb        cndb;
+    struct cndb_cn     cndbcn = cndb_cn_initializer(3, 0, 0);
+    struct kvdb_kvs    kk = { 0 };
+    struct kvs_cparams cp = {};
+    struct kc_pred     pred;
+
+    /* Keys 0..0x3ff, each with its own value. */
+    struct nkv_tab make[] = {
+        { 0x400, 0, 0, VMX_S32, KVDATA_BE_KEY, 1 },
+    };
+
+    const unsigned char sfx1[] = { 0x10 };
+    const unsigned char sfx2[] = { 0x02, 0x10 };
+    const unsigned char sfx4[] = { 0x00, 0x00, 0x02, 0x10 };
+    const unsigned char sfx2x[] = { 0x04, 0x10 };
+    const int           match1[] = { 0x010, 0x110, 0x210, 0x310 };
+    const int           match2[] = { 0x210 };
+    int                 vpat = 0x110;
+
+    ITV_INIT(itv, 0, make);
+
+    mk = ITV_KVSET_MOCK(itv[0]);
+    mapi_inject(mapi_idx_cn_tree_initial_dgen, mk->dgen);
+
+    err = cndb_init(&cndb, ds, true, 0, CNDB_ENTRIES, 0, 0, &health);
+    ASSERT_EQ(err, 0);
+
+    cndb.cndb_cnc = 1;
+    cndb.cndb_cnv[0] = &cndbcn;
+
+    kk.kk_parent = dummy_ikvdb_create();
+    kk.kk_cparams = &cp;
+    kk.kk_cparams->cp_fanout = 1 << 3;
+
+    err = cn_open(0, ds, &kk, &cndb, 0, &rp, "mp", "kvs", &health, 0, &cn);
+    ASSERT_EQ(err, 0);
+
+    tree = cn_get_tree(cn);
+    ASSERT_NE(tree, NULL);
+
+    err = cn_tree_insert_kvset(tree, ITV_KVSET(itv[0]), 0, 0);
+    ASSERT_EQ(err, 0);
+
+    /* The kvset returns the first three bytes of each key in the key
+     * object's prefix and the last byte in its suffix.
+     */
+    mock_kvset_key_split = 3;
+
+    memset(&pred, 0, sizeof(pred));
+    pred.kcp_ksfx = sfx1;
+    pred.kcp_ksfxlen = sizeof(sfx1);
+    verify_pred(lcl_ti, cn, &pred, match1, NELEM(match1));
+
+    /* Key suffixes that straddle the prefix/suffix split. */
+    pred.kcp_ksfx = sfx2;
+    pred.kcp_ksfxlen = sizeof(sfx2);
+    verify_pred(lcl_ti, cn, &pred, match2, NELEM(match2));
+
+    pred.kcp_ksfx = sfx4;
+    pred.kcp_ksfxlen = sizeof(sfx4);
+    verify_pred(lcl_ti, cn, &pred, match2, NELEM(match2));
+
+    pred.kcp_ksfx = sfx2x;
+    pred.kcp_ksfxlen = sizeof(sfx2x);
+    verify_pred(lcl_ti, cn, &pred, NULL, 0);
+
+    /* A suffix longer than the keys matches nothing. */
+    pred.kcp_ksfx = "abcde";
+    pred.kcp_ksfxlen = 5;
+    verify_pred(lcl_ti, cn, &pred, NULL, 0);
+
+    /* Value length and value pattern. */
+    memset(&pred, 0, sizeof(pred));
+    pred.kcp_vlenmax = sizeof(int) - 1;
+    verify_pred(lcl_ti, cn, &pred, NULL, 0);
+
+    pred.kcp_vlenmax = sizeof(int);
+    pred.kcp_ksfx = sfx1;
+    pred.kcp_ksfxlen = sizeof(sfx1);
+    verify_pred(lcl_ti, cn, &pred, match1, NELEM(match1));
+
+    pred.kcp_vpat = &vpat;
+    pred.kcp_vpatlen = sizeof(vpat);
+    verify_pred(lcl_ti, cn, &pred, match1 + 1, 1);
+
+    mock_kvset_key_split = 0;
 
     err = cn_close(cn);
     ASSERT_EQ(err, 0);
@@ -756,7 +954,8 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, prefix_tree, pre, post)
     free(cndb.cndb_cbuf);
 }
 
-MTF_DEFINE_UTEST_PREPOST(cn_cursor, cursor_seek, pre, post)
+static void
+cursor_seek_impl(struct mtf_test_info *lcl_ti)
 {
     struct cn *         cn;
     struct cn_tree *    tree;
@@ -922,6 +1121,28 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, cursor_seek, pre, post)
     free(cndb.cndb_cbuf);
 }
 
+MTF_DEFINE_UTEST_PREPOST(cn_cursor, cursor_seek, pre, post)
+{
+    cursor_seek_impl(lcl_ti);
+}
+
+MTF_DEFINE_UTEST_PREPOST(cn_cursor, cursor_seek_par, pre, post)
+{
+    unsigned long par = rp.cn_cursor_par;
+    unsigned long parmin = rp.cn_cursor_parmin;
+
+    /* Same as cursor_seek, but merge the kvsets in two groups
+     * on merge helper threads.
+     */
+    rp.cn_cursor_par = 2;
+    rp.cn_cursor_parmin = 2;
+
+    cursor_seek_impl(lcl_ti);
+
+    rp.cn_cursor_par = par;
+    rp.cn_cursor_parmin = parmin;
+}
+
 void
 _kvset_maxkey(struct kvset *ks, const void **maxkey, u16 *maxklen)
 {
@@ -1005,7 +1226,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, capped_update, pre, post)
     }
 
     /* Test 1: capped cursor update test */
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
 
     for (; i < NELEM(make); ++i) {
@@ -1158,7 +1379,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, capped_update_errors, pre, post)
         ASSERT_EQ(err, 0);
     }
 
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
 
     for (; i < NELEM(make); ++i) {
@@ -17,6 +17,7 @@
 #include <hse_ikvdb/cn_node_loc.h>
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/key_hash.h>
 
 #include "../cn_tree.h"
 #include "../cn_tree_iter.h"
@@ -49,6 +50,7 @@ struct fake_kvset {
     u64                     vused;
     u64                     workid;
     struct kvset_stats      stats;
+    struct kvset_heat       heat;
     struct fake_kvset *     next;
 };
 
@@ -169,6 +171,12 @@ _kvset_set_workid(struct kvset *handle, u64 id)
     ((struct fake_kvset *)handle)->workid = id;
 }
 
+static void
+_kvset_get_heat(struct kvset *handle, struct kvset_heat *heat)
+{
+    *heat = ((struct fake_kvset *)handle)->heat;
+}
+
 static u32
 _kvset_get_num_kblocks(struct kvset *handle)
 {
@@ -288,6 +296,7 @@ struct injections injections[] = {
 
     /* csched */
     { 0, mapi_idx_csched_notify_ingest },
+    { 0, mapi_idx_csched_notify_ingest_children },
 
     /* cndb: fake success */
     { 0, mapi_idx_cndb_txn_start },
@@ -362,6 +371,7 @@ test_setup(struct mtf_test_info *lcl_ti)
     MOCK_SET(kvset_view, _kvset_get_dgen);
     MOCK_SET(kvset_view, _kvset_get_num_kblocks);
     MOCK_SET(kvset_view, _kvset_get_num_vblocks);
+    MOCK_SET(kvset_view, _kvset_get_heat);
 
     memset(&mock_health, 0, sizeof(mock_health));
 
@@ -528,6 +538,42 @@ MTF_DEFINE_UTEST_PRE(test, t_cn_tree_create_node, test_setup)
     cn_tree_destroy(tree);
 }
 
+MTF_DEFINE_UTEST_PRE(test, t_cn_tree_ttl, test_setup)
+{
+    struct cn_tree *   tree = 0;
+    struct kvs_cparams cp = {
+        .cp_fanout = 4,
+    };
+    merr_t err;
+
+    rp->kvs_ttl = 1;
+    mapi_inject(mapi_idx_cn_is_capped, false);
+
+    err = cn_tree_create(&tree, NULL, 0, &cp, &mock_health, rp);
+    ASSERT_EQ(err, 0);
+
+    /* kvsets present at open are treated as ingested now */
+    cn_tree_set_initial_dgen(tree, 10);
+    ASSERT_FALSE(cn_tree_ttl_update(tree));
+    ASSERT_EQ(0, cn_tree_ttl_dgen(tree));
+    ASSERT_NE(0, cn_tree_ttl_window(tree, 5));
+    ASSERT_EQ(cn_tree_ttl_window(tree, 5), cn_tree_ttl_window(tree, 10));
+    ASSERT_EQ(U64_MAX, cn_tree_ttl_window(tree, 11));
+
+    usleep(1100 * 1000);
+
+    ASSERT_TRUE(cn_tree_ttl_update(tree));
+    ASSERT_EQ(10, cn_tree_ttl_dgen(tree));
+    ASSERT_EQ(0, cn_tree_ttl_window(tree, 10));
+    ASSERT_EQ(U64_MAX, cn_tree_ttl_window(tree, 11));
+    ASSERT_FALSE(cn_tree_ttl_update(tree));
+
+    cn_tree_destroy(tree);
+
+    mapi_inject_unset(mapi_idx_cn_is_capped);
+    rp->kvs_ttl = 0;
+}
+
 MTF_DEFINE_UTEST_PRE(test, t_cn_tree_ingest_update, test_setup)
 {
     struct cn_tree *         tree;
@@ -575,6 +621,85 @@ MTF_DEFINE_UTEST_PRE(test, t_cn_tree_ingest_update, test_setup)
         fake_kvset_destroy((struct fake_kvset *)kvsetv[i]);
 }
 
+MTF_DEFINE_UTEST_PRE(test, t_cn_tree_ingest_children, test_setup)
+{
+    struct cn_tree *         tree;
+    struct cn_tree_node *    root;
+    struct kvset *           kvsetv[4] = {};
+    struct kvset *           rkvset;
+    struct kvset_list_entry *le;
+    struct key_obj           ko;
+    char                     key[32];
+    merr_t                   err;
+    uint                     i;
+
+    struct kvs_cparams cp = {
+        .cp_fanout = NELEM(kvsetv),
+    };
+
+    rp->cn_ingest_partition = 1;
+    mapi_inject(mapi_idx_cn_is_capped, false);
+
+    err = cn_tree_create(&tree, NULL, 0, &cp, &mock_health, rp);
+    ASSERT_EQ(err, 0);
+
+    root = tree->ct_root;
+
+    /* The root must have all its children to partition an ingest */
+    ASSERT_EQ(1, cn_tree_ingest_fanout(tree));
+
+    for (i = 0; i < NELEM(kvsetv); i++) {
+        err = cn_tree_create_node(tree, 1, i, 0);
+        ASSERT_EQ(err, 0);
+    }
+
+    ASSERT_EQ(NELEM(kvsetv), cn_tree_ingest_fanout(tree));
+
+    /* Keys must be routed to the child that a lookup would search */
+    for (i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key%u", i);
+        key2kobj(&ko, key, strlen(key));
+
+        ASSERT_EQ(
+            key_hash64(key, strlen(key)) & tree->ct_fanout_mask,
+            cn_tree_ingest_route(tree, &ko));
+    }
+
+    /* Empty partitions have no kvset */
+    kvsetv[0] = (struct kvset *)fake_kvset_create(0, 100);
+    kvsetv[2] = (struct kvset *)fake_kvset_create(0, 100);
+
+    cn_tree_ingest_update_children(tree, kvsetv, NELEM(kvsetv));
+
+    ASSERT_TRUE(list_empty(&root->tn_kvset_list));
+    for (i = 0; i < NELEM(kvsetv); i++) {
+        le = list_first_entry_or_null(
+            &root->tn_childv[i]->tn_kvset_list, struct kvset_list_entry, le_link);
+        ASSERT_EQ(kvsetv[i], le ? le->le_kvset : NULL);
+    }
+
+    ASSERT_EQ(NELEM(kvsetv), cn_tree_ingest_fanout(tree));
+
+    /* Once the root has a kvset its children must not receive newer data */
+    rkvset = (struct kvset *)fake_kvset_create(0, 101);
+    cn_tree_ingest_update(tree, rkvset, 0, 0, 0);
+
+    ASSERT_EQ(1, cn_tree_ingest_fanout(tree));
+
+    rp->cn_ingest_partition = 0;
+    mapi_inject_unset(mapi_idx_cn_is_capped);
+
+    INIT_LIST_HEAD(&root->tn_kvset_list);
+    for (i = 0; i < NELEM(kvsetv); i++)
+        INIT_LIST_HEAD(&root->tn_childv[i]->tn_kvset_list);
+    cn_tree_destroy(tree);
+
+    fake_kvset_destroy((struct fake_kvset *)rkvset);
+    for (i = 0; i < NELEM(kvsetv); i++)
+        if (kvsetv[i])
+            fake_kvset_destroy((struct fake_kvset *)kvsetv[i]);
+}
+
 /*----------------------------------------------------------------
  * Support for the MY_TEST1 and MY_TEST2 macros below
  */
@@ -892,6 +1017,98 @@ MTF_DEFINE_UTEST_PRE(test, t_cn_comp, test_setup)
     }
 }
 
+/* Count a read that probes the newest @probes kvsets of @tn the way
+ * cn_tree_lookup() and kvset_lookup() do.
+ */
+static void
+heat_read(struct cn_tree_node *tn, enum kvset_heat_ctr ctr, uint probes)
+{
+    struct kvset_list_entry *le;
+
+    cn_heat_add(&tn->tn_heat, ctr, 1);
+
+    list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+        struct fake_kvset *fk = (void *)le->le_kvset;
+
+        if (probes-- == 0)
+            break;
+
+        fk->heat.kh_ctrv[ctr]++;
+        if (ctr == KVSET_HEAT_GETS) {
+            fk->heat.kh_ctrv[KVSET_HEAT_BLOOM_NEG] += 2;
+            fk->heat.kh_ctrv[KVSET_HEAT_BLOOM_FP] += 1;
+            fk->heat.kh_ctrv[KVSET_HEAT_WBT_PAGES] += 3;
+        }
+    }
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_cn_node_heat, test_setup)
+{
+    struct test_params        tp = {};
+    struct test               t = {};
+    struct cn_tree_node *     tn;
+    struct cn_compaction_work w;
+    struct kvset_heat         kh;
+    merr_t                    err;
+
+    tp.fanout_bits = 4;
+    tp.levels = 2;
+
+    test_init(&t, &tp, lcl_ti);
+
+    err = test_tree_create(&t);
+    ASSERT_EQ(0, err);
+
+    /* Third child in level 1 has 3 kvsets */
+    tn = t.tree->ct_root->tn_childv[2];
+    ASSERT_EQ(0, cn_node_rheat(tn));
+
+    /* A get that stops in the newest kvset probes nothing extra. */
+    heat_read(tn, KVSET_HEAT_GETS, 1);
+    cn_node_heat_get(tn, &kh);
+    ASSERT_EQ(1, kh.kh_ctrv[KVSET_HEAT_GETS]);
+    ASSERT_EQ(2, kh.kh_ctrv[KVSET_HEAT_BLOOM_NEG]);
+    ASSERT_EQ(1, kh.kh_ctrv[KVSET_HEAT_BLOOM_FP]);
+    ASSERT_EQ(3, kh.kh_ctrv[KVSET_HEAT_WBT_PAGES]);
+    ASSERT_EQ(0, cn_node_rheat(tn));
+
+    /* Gets count once per node but probe counters once per kvset. */
+    heat_read(tn, KVSET_HEAT_GETS, 3);
+    heat_read(tn, KVSET_HEAT_GETS, 2);
+    cn_node_heat_get(tn, &kh);
+    ASSERT_EQ(3, kh.kh_ctrv[KVSET_HEAT_GETS]);
+    ASSERT_EQ(12, kh.kh_ctrv[KVSET_HEAT_BLOOM_NEG]);
+    ASSERT_EQ(6, kh.kh_ctrv[KVSET_HEAT_BLOOM_FP]);
+    ASSERT_EQ(18, kh.kh_ctrv[KVSET_HEAT_WBT_PAGES]);
+    ASSERT_EQ(3, cn_node_rheat(tn));
+
+    heat_read(tn, KVSET_HEAT_CURSORS, 3);
+    cn_node_heat_get(tn, &kh);
+    ASSERT_EQ(1, kh.kh_ctrv[KVSET_HEAT_CURSORS]);
+    ASSERT_EQ(5, cn_node_rheat(tn));
+
+    /* A node's heat survives the compaction of its kvsets. */
+    cn_comp_work_init(&t, tn, &w, CN_ACTION_COMPACT_K, false);
+    ASSERT_EQ(3, w.cw_kvset_cnt);
+    cn_comp_slice_cb(&w.cw_job);
+    ASSERT_TRUE(list_empty(&tn->tn_kvset_list));
+
+    cn_node_heat_get(tn, &kh);
+    ASSERT_EQ(3, kh.kh_ctrv[KVSET_HEAT_GETS]);
+    ASSERT_EQ(1, kh.kh_ctrv[KVSET_HEAT_CURSORS]);
+    ASSERT_EQ(12, kh.kh_ctrv[KVSET_HEAT_BLOOM_NEG]);
+    ASSERT_EQ(6, kh.kh_ctrv[KVSET_HEAT_BLOOM_FP]);
+    ASSERT_EQ(18, kh.kh_ctrv[KVSET_HEAT_WBT_PAGES]);
+    ASSERT_EQ(5, cn_node_rheat(tn));
+
+    /* Root nodes count too, they are just not scheduled by heat. */
+    heat_read(t.tree->ct_root, KVSET_HEAT_GETS, 1);
+    cn_node_heat_get(t.tree->ct_root, &kh);
+    ASSERT_EQ(1, kh.kh_ctrv[KVSET_HEAT_GETS]);
+
+    test_tree_destroy(&t);
+}
+
 #define MY_TEST1(NAME, N1, V1, VERBOSE)                     \
     MTF_DEFINE_UTEST_PRE(test, NAME##_##N1##V1, test_setup) \
     {                                                       \
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_ut/framework.h>
+
+#include <hse_util/time.h>
+
+#include "../cn_wamp.h"
+#include "../cn_metrics.h"
+
+#define INTERVAL_NS ((u64)CN_WAMP_INTERVAL_SECS * NSEC_PER_SEC)
+
+static struct cn_wamp      wamp;
+static struct cn_wamp_view view;
+
+MTF_BEGIN_UTEST_COLLECTION(cn_wamp_test)
+
+MTF_DEFINE_UTEST(cn_wamp_test, totals)
+{
+    struct cn_samp_stats samp = { .i_alen = 300, .l_alen = 200, .l_good = 250 };
+    u64                  now = 1000 * INTERVAL_NS;
+
+    cn_wamp_init(&wamp, now);
+
+    cn_wamp_add(&wamp, now, CN_WAMP_INGEST, 0, 0, 0, 1000, NULL);
+    cn_wamp_add(&wamp, now, CN_WAMP_SPILL, 0, 1000, 1, 900, NULL);
+    cn_wamp_add(&wamp, now, CN_WAMP_KVCOMPACT, 1, 900, 1, 800, NULL);
+    cn_wamp_add(&wamp, now, CN_WAMP_KCOMPACT, 20, 100, 20, 100, &samp);
+
+    cn_wamp_read(&wamp, now + 1, &view);
+
+    ASSERT_EQ(now, view.wv_since);
+    ASSERT_EQ(1, view.wv_intc);
+    ASSERT_EQ(1000, view.wv_total.ws_opv[CN_WAMP_INGEST].wc_wbytes);
+    ASSERT_EQ(1, view.wv_total.ws_opv[CN_WAMP_SPILL].wc_jobs);
+    ASSERT_EQ(1000, view.wv_total.ws_opv[CN_WAMP_SPILL].wc_rbytes);
+
+    /* Reads are charged to the source level, writes to the target. */
+    ASSERT_EQ(1000, view.wv_total.ws_lvlv[0].wc_rbytes);
+    ASSERT_EQ(1000, view.wv_total.ws_lvlv[0].wc_wbytes);
+    ASSERT_EQ(900, view.wv_total.ws_lvlv[1].wc_rbytes);
+    ASSERT_EQ(1700, view.wv_total.ws_lvlv[1].wc_wbytes);
+    ASSERT_EQ(2, view.wv_total.ws_lvlv[1].wc_jobs);
+
+    /* Deep levels are counted in the last one. */
+    ASSERT_EQ(100, view.wv_total.ws_lvlv[CN_WAMP_LEVELS - 1].wc_wbytes);
+
+    ASSERT_EQ(280, cn_wamp_ratio(&view.wv_total));
+    ASSERT_EQ(500, view.wv_total.ws_alen);
+    ASSERT_EQ(250, view.wv_total.ws_good);
+    ASSERT_EQ(
+        0, memcmp(view.wv_total.ws_opv, view.wv_intv[0].ws_opv, sizeof(view.wv_total.ws_opv)));
+}
+
+MTF_DEFINE_UTEST(cn_wamp_test, intervals)
+{
+    struct cn_samp_stats samp = { .i_alen = 10, .l_alen = 0, .l_good = 5 };
+    u64                  start = 1000 * INTERVAL_NS;
+    u64                  now;
+    uint                 i;
+
+    cn_wamp_init(&wamp, start);
+
+    /* One ingest in each of twice as many intervals as are kept. */
+    for (i = 0; i < 2 * CN_WAMP_INTERVALS; i++) {
+        now = start + i * INTERVAL_NS;
+        cn_wamp_add(&wamp, now, CN_WAMP_INGEST, 0, 0, 0, i + 1, i == 0 ? &samp : NULL);
+    }
+
+    cn_wamp_read(&wamp, now, &view);
+
+    ASSERT_EQ(CN_WAMP_INTERVALS, view.wv_intc);
+    ASSERT_EQ(2 * CN_WAMP_INTERVALS, view.wv_total.ws_opv[CN_WAMP_INGEST].wc_jobs);
+
+    for (i = 0; i < view.wv_intc; i++) {
+        struct cn_wamp_sample *ws = view.wv_intv + i;
+
+        ASSERT_EQ(now / INTERVAL_NS - CN_WAMP_INTERVALS + 1 + i, ws->ws_idx);
+        ASSERT_EQ(CN_WAMP_INTERVALS + i + 1, ws->ws_opv[CN_WAMP_INGEST].wc_wbytes);
+
+        /* Space amp carries over into intervals that did not sample it. */
+        ASSERT_EQ(10, ws->ws_alen);
+    }
+
+    /* Intervals age out even when there is no new work. */
+    cn_wamp_read(&wamp, now + 10 * INTERVAL_NS, &view);
+    ASSERT_EQ(CN_WAMP_INTERVALS - 10, view.wv_intc);
+
+    cn_wamp_read(&wamp, now + CN_WAMP_INTERVALS * INTERVAL_NS, &view);
+    ASSERT_EQ(0, view.wv_intc);
+    ASSERT_EQ(2 * CN_WAMP_INTERVALS, view.wv_total.ws_opv[CN_WAMP_INGEST].wc_jobs);
+}
+
+MTF_DEFINE_UTEST(cn_wamp_test, names)
+{
+    int i;
+
+    for (i = 0; i < CN_WAMP_OP_MAX; i++)
+        ASSERT_STRNE("unknown", cn_wamp_op_name(i));
+
+    ASSERT_STREQ("unknown", cn_wamp_op_name(CN_WAMP_OP_MAX));
+}
+
+MTF_END_UTEST_COLLECTION(cn_wamp_test)
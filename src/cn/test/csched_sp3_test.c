@@ -499,6 +499,53 @@ MTF_DEFINE_UTEST_PRE(test, t_sp3_create_fail, pre_test)
     mapi_inject_unset(mapi_idx_sts_create);
 }
 
+MTF_DEFINE_UTEST_PRE(test, t_sp3_io_budget, pre_test)
+{
+    struct csched_ops *ops;
+    merr_t             err;
+    u64                t;
+
+    /* 64MB/s with 16MB of burst, leaf work gets 1% of that: 640KB/s
+     * with 160KB of burst.
+     */
+    kvdb_rp->csched_io_rate = 64;
+    kvdb_rp->csched_io_leaf_pct = 1;
+
+    err = sp3_create(NULL, kvdb_rp, mp, &health, &ops);
+    ASSERT_EQ(err, 0);
+
+    /* Let both buckets fill up. */
+    msleep(300);
+
+    t = get_time_ns();
+    ops->cs_io_charge(ops, CSCHED_IO_ROOT, 8 << 20);
+    ASSERT_LT(get_time_ns() - t, 100 * NSEC_PER_SEC / 1000);
+
+    /* Leaf work runs out of its share of the budget and waits for
+     * roughly half a second.
+     */
+    t = get_time_ns();
+    ops->cs_io_charge(ops, CSCHED_IO_LEAF, 480 << 10);
+    ASSERT_GT(get_time_ns() - t, 250 * NSEC_PER_SEC / 1000);
+
+    /* Root work still has budget. */
+    t = get_time_ns();
+    ops->cs_io_charge(ops, CSCHED_IO_ROOT, 4 << 20);
+    ASSERT_LT(get_time_ns() - t, 100 * NSEC_PER_SEC / 1000);
+
+    /* Ingest overdraws the budget without waiting... */
+    t = get_time_ns();
+    ops->cs_io_charge(ops, CSCHED_IO_INGEST, 64 << 20);
+    ASSERT_LT(get_time_ns() - t, 100 * NSEC_PER_SEC / 1000);
+
+    /* ...after which root work waits too. */
+    t = get_time_ns();
+    ops->cs_io_charge(ops, CSCHED_IO_ROOT, 1 << 20);
+    ASSERT_GT(get_time_ns() - t, 250 * NSEC_PER_SEC / 1000);
+
+    ops->cs_destroy(ops);
+}
+
 MTF_DEFINE_UTEST_PRE(test, t_sp3_one_empty_tree, pre_test)
 {
     merr_t             err;
@@ -652,4 +699,358 @@ MTF_DEFINE_UTEST_PRE(test, t_sp3_one_big_tree_with_work, pre_test)
     ops->cs_destroy(ops);
 }
 
+/* Add kvsets to leaf (1,0) of a tree, oldest last, each vusedv[i] MiB
+ * larger than the 32MiB of kblocks every mock kvset has.  The leaf's
+ * space amp stats are cleared.
+ */
+static struct cn_tree_node *
+tier_leaf(struct test_tree *tt, uint n, const uint *vusedv)
+{
+    struct cn_tree_node *tn;
+    struct kvset *       kvset;
+    merr_t               err;
+    uint                 i;
+
+    for (i = 0; i < n; i++) {
+        struct kvset_meta *km = init_kvset_meta(ttv->dgen--);
+
+        km->km_vused = MiB(vusedv[i]);
+
+        err = kvset_create(tt->tree, tt->tag, km, &kvset);
+        if (err)
+            return NULL;
+
+        err = cn_tree_insert_kvset(tt->tree, kvset, 1, 0);
+        if (err) {
+            kvset_put_ref(kvset);
+            return NULL;
+        }
+    }
+
+    tn = tt->tree->ct_root->tn_childv[0];
+    memset(&tn->tn_samp, 0, sizeof(tn->tn_samp));
+
+    return tn;
+}
+
+static void
+tier_thresh(struct sp3_thresholds *thresh)
+{
+    memset(thresh, 0, sizeof(*thresh));
+    thresh->tier_width_min = 4;
+    thresh->tier_width_max = 12;
+    thresh->tier_ratio_pct = 20;
+    thresh->tier_samp_pct = 200;
+}
+
+static struct kvset_list_entry *
+tier_nth(struct cn_tree_node *tn, uint nth)
+{
+    struct kvset_list_entry *le;
+
+    list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+        if (nth-- == 0)
+            return le;
+    }
+
+    return NULL;
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_tier_run, pre_test)
+{
+    const uint               vusedv[] = { 0, 0, 0, 0, 0 };
+    struct sp3_thresholds    thresh;
+    struct kvset_list_entry *mark = NULL;
+    struct cn_tree_node *    tn;
+    struct test_tree *       tt;
+    bool                     full;
+    uint                     n;
+
+    tier_thresh(&thresh);
+
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    /* Too few kvsets for a run. */
+    tn = tier_leaf(tt, 3, vusedv);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(0, n);
+    ASSERT_FALSE(full);
+
+    /* Five kvsets of the same size form one run, even when space amp
+     * is over the bound.
+     */
+    tn = tier_leaf(tt, 2, vusedv);
+    ASSERT_NE(tn, NULL);
+
+    tn->tn_samp.l_alen = 3000;
+    tn->tn_samp.l_good = 1000;
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(5, n);
+    ASSERT_FALSE(full);
+    ASSERT_EQ(tier_nth(tn, 4), mark);
+
+    destroy_trees();
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_tier_ratio, pre_test)
+{
+    const uint               joinv[] = { 0, 0, 0, 83 };
+    const uint               breakv[] = { 0, 0, 0, 84 };
+    struct sp3_thresholds    thresh;
+    struct kvset_list_entry *mark = NULL;
+    struct cn_tree_node *    tn;
+    struct test_tree *       tt;
+    bool                     full;
+    uint                     n;
+
+    tier_thresh(&thresh);
+
+    /* A kvset joins a run if it is at most tier_ratio_pct percent larger
+     * than the newer kvsets in the run: 115MiB <= 1.2 * 96MiB.
+     */
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    tn = tier_leaf(tt, NELEM(joinv), joinv);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(4, n);
+    ASSERT_FALSE(full);
+    ASSERT_EQ(tier_nth(tn, 3), mark);
+
+    /* 116MiB > 1.2 * 96MiB ends the run short of tier_width_min. */
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    tn = tier_leaf(tt, NELEM(breakv), breakv);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(0, n);
+    ASSERT_FALSE(full);
+
+    destroy_trees();
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_tier_samp, pre_test)
+{
+    const uint               vusedv[] = { 0, 0, 0, 1024, 0, 0 };
+    struct sp3_thresholds    thresh;
+    struct kvset_list_entry *mark = NULL;
+    struct cn_tree_node *    tn;
+    struct test_tree *       tt;
+    bool                     full;
+    uint                     n;
+
+    tier_thresh(&thresh);
+
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    tn = tier_leaf(tt, NELEM(vusedv), vusedv);
+    ASSERT_NE(tn, NULL);
+
+    /* No run and space amp at the bound: nothing to do. */
+    tn->tn_samp.l_alen = 2000;
+    tn->tn_samp.l_good = 1000;
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(0, n);
+    ASSERT_FALSE(full);
+
+    /* No run and space amp over the bound: kv-compact from the oldest. */
+    tn->tn_samp.l_alen = 2001;
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(NELEM(vusedv), n);
+    ASSERT_TRUE(full);
+    ASSERT_EQ(list_last_entry(&tn->tn_kvset_list, struct kvset_list_entry, le_link), mark);
+
+    /* Only tier_width_max of the oldest kvsets are compacted. */
+    thresh.tier_width_max = 4;
+
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(4, n);
+    ASSERT_TRUE(full);
+
+    destroy_trees();
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_tier_width_max, pre_test)
+{
+    uint                     vusedv[20] = {};
+    struct sp3_thresholds    thresh;
+    struct kvset_list_entry *mark = NULL;
+    struct cn_tree_node *    tn;
+    struct test_tree *       tt;
+    bool                     full;
+    uint                     n;
+
+    tier_thresh(&thresh);
+
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    tn = tier_leaf(tt, NELEM(vusedv), vusedv);
+    ASSERT_NE(tn, NULL);
+
+    /* The newest tier_width_max kvsets are merged. */
+    n = sp3_node_tier_len(tn2spn(tn), &thresh, &mark, &full);
+    ASSERT_EQ(thresh.tier_width_max, n);
+    ASSERT_FALSE(full);
+    ASSERT_EQ(tier_nth(tn, thresh.tier_width_max - 1), mark);
+
+    destroy_trees();
+}
+
+/* Add kvsets to leaf (1,off) of a tree and count them in its node
+ * stats, which is all that read heat scheduling looks at.
+ */
+static struct cn_tree_node *
+rheat_leaf(struct test_tree *tt, uint off, uint n)
+{
+    struct cn_tree_node *tn;
+
+    if (new_kvsets(tt, n, 1, off))
+        return NULL;
+
+    tn = tt->tree->ct_root->tn_childv[off];
+    tn->tn_ns.ns_kst.kst_kvsets = n;
+
+    return tn;
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_rheat_len, pre_test)
+{
+    struct sp3_thresholds    thresh = {};
+    struct kvset_list_entry *mark = NULL;
+    struct cn_tree_node *    tn;
+    struct test_tree *       tt;
+    uint                     n;
+
+    thresh.llen_runlen_max = 4;
+
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    /* A single kvset gains nothing from a compaction. */
+    tn = rheat_leaf(tt, 0, 1);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_rheat_len(tn2spn(tn), &thresh, &mark);
+    ASSERT_EQ(0, n);
+
+    /* The newest kvsets are merged, up to llen_runlen_max of them. */
+    tn = rheat_leaf(tt, 1, 3);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_rheat_len(tn2spn(tn), &thresh, &mark);
+    ASSERT_EQ(3, n);
+    ASSERT_EQ(list_last_entry(&tn->tn_kvset_list, struct kvset_list_entry, le_link), mark);
+
+    tn = rheat_leaf(tt, 2, 6);
+    ASSERT_NE(tn, NULL);
+
+    n = sp3_node_rheat_len(tn2spn(tn), &thresh, &mark);
+    ASSERT_EQ(4, n);
+    ASSERT_EQ(tier_nth(tn, 3), mark);
+
+    destroy_trees();
+}
+
+static u64      rheat_probes[4];
+static atomic_t rheat_calls[4];
+
+static u64
+cn_node_rheat_mock(struct cn_tree_node *tn)
+{
+    return tn->tn_parent ? rheat_probes[tn->tn_loc.node_offset % 4] : 0;
+}
+
+static merr_t
+sp3_work_rheat_mock(
+    struct sp3_node *           spn,
+    struct sp3_thresholds *     thresh,
+    enum sp3_work_type          wtype,
+    uint                        debug,
+    uint *                      qnum_out,
+    struct cn_compaction_work **w_out)
+{
+    if (wtype == wtype_read_heat)
+        atomic_inc(&rheat_calls[spn2tn(spn)->tn_loc.node_offset % 4]);
+
+    return sp3_work_mock(spn, thresh, wtype, debug, qnum_out, w_out);
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_sp3_rheat, pre_test)
+{
+    struct cn_tree_node *hot, *single;
+    struct csched_ops *  ops;
+    struct test_tree *   tt;
+    merr_t               err;
+    uint                 i, calls;
+
+    kvdb_rp->csched_rheat_min = 10;
+
+    memset(rheat_probes, 0, sizeof(rheat_probes));
+    for (i = 0; i < NELEM(rheat_calls); i++)
+        atomic_set(&rheat_calls[i], 0);
+
+    MOCK_SET_FN(cn_tree_internal, cn_node_rheat, cn_node_rheat_mock);
+    MOCK_SET_FN(csched_sp3_work, sp3_work, sp3_work_rheat_mock);
+
+    err = sp3_create(NULL, kvdb_rp, mp, &health, &ops);
+    ASSERT_EQ(err, 0);
+
+    tt = new_tree(4);
+    ASSERT_NE(tt, NULL);
+
+    hot = rheat_leaf(tt, 0, 3);
+    ASSERT_NE(hot, NULL);
+
+    single = rheat_leaf(tt, 1, 1);
+    ASSERT_NE(single, NULL);
+
+    /* 40 extra probes in the first second average out to a heat of 10,
+     * enough to be serviced.  A node with one kvset is never serviced,
+     * however hot.
+     */
+    rheat_probes[0] = 40;
+    rheat_probes[1] = 1000;
+
+    add_tree(tt->tree, ops);
+
+    for (i = 0; i < 50 && !atomic_read(&rheat_calls[0]); i++)
+        msleep(100);
+
+    ASSERT_NE(0, atomic_read(&rheat_calls[0]));
+    ASSERT_EQ(0, atomic_read(&rheat_calls[1]));
+    ASSERT_LE(10, tn2spn(single)->spn_rheat);
+
+    /* Without new probes the heat decays below csched_rheat_min and
+     * the node is left alone.
+     */
+    for (i = 0; i < 30 && tn2spn(hot)->spn_rheat >= 10; i++)
+        msleep(100);
+
+    ASSERT_LT(tn2spn(hot)->spn_rheat, 10);
+    ASSERT_GT(tn2spn(hot)->spn_rheat, 0);
+
+    calls = atomic_read(&rheat_calls[0]);
+    msleep(DELAY_MS);
+    ASSERT_EQ(calls, atomic_read(&rheat_calls[0]));
+    ASSERT_EQ(0, atomic_read(&rheat_calls[1]));
+
+    remove_tree(tt->tree, ops);
+    destroy_trees();
+    ops->cs_destroy(ops);
+
+    MOCK_UNSET_FN(cn_tree_internal, cn_node_rheat);
+}
+
 MTF_END_UTEST_COLLECTION(test);
@@ -28,7 +28,9 @@ merr_t mocked_sp_create_rc;
 
 struct throttle_sensor;
 
-enum csched_policy policy_list[] = { csched_policy_old, csched_policy_noop, csched_policy_sp3 };
+enum csched_policy policy_list[] = {
+    csched_policy_old, csched_policy_noop, csched_policy_sp3, csched_policy_tiered
+};
 
 static void
 mocked_sp_destroy(struct csched_ops *handle)
@@ -202,6 +202,7 @@ test_setup(struct mtf_test_info *lcl_ti)
     mapi_inject(mapi_idx_cn_get_dataset, 0);
     mapi_inject(mapi_idx_cn_get_flags, 0);
     mapi_inject(mapi_idx_cn_pc_mclass_get, 0);
+    mapi_inject(mapi_idx_cn_get_sched, 0);
 
     return 0;
 }
@@ -443,6 +444,70 @@ MTF_DEFINE_UTEST_PRE(test, t_kbb_finish, test_setup)
     kbb_destroy(kbb);
 }
 
+/* Test: kblock blooms built with key prefixes */
+MTF_DEFINE_UTEST_PRE(test, t_kbb_finish_pfx_bloom, test_setup)
+{
+    struct kblock_builder *kbb = 0;
+    struct blk_list        blks;
+    struct kblock_hdr_omf  kb_hdr;
+    struct bloom_hdr_omf   blm_hdr;
+    struct bloom_desc      desc = {};
+    struct kvs_ktuple      kt;
+    merr_t                 err;
+    u64                    blkid;
+    u8 *                   blm_pages;
+    uint                   pfx_len = 8;
+    int                    i;
+
+    mocked_cp.cp_pfx_len = pfx_len;
+
+    for (i = 0; i < 2; i++) {
+        mocked_rp.cn_bloom_pfx = i;
+
+        err = kbb_create(KBB_CREATE_ARGS);
+        ASSERT_EQ(err, 0);
+
+        err = add_entries(lcl_ti, kbb, 1000, 23, pfx_len, 9, 0);
+        ASSERT_EQ(err, 0);
+
+        err = kbb_finish(kbb, &blks, 0, 0);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(blks.n_blks, 1);
+
+        blkid = blks.blks[0].bk_blkid;
+
+        mpm_mblock_read(blkid, &kb_hdr, 0, sizeof(kb_hdr));
+        mpm_mblock_read(blkid, &blm_hdr, omf_kbh_blm_hoff(&kb_hdr), omf_kbh_blm_hlen(&kb_hdr));
+        ASSERT_EQ(omf_bh_pfx_len(&blm_hdr), i ? pfx_len : 0);
+
+        if (i) {
+            desc.bd_modulus = omf_bh_modulus(&blm_hdr);
+            desc.bd_bktshift = omf_bh_bktshift(&blm_hdr);
+            desc.bd_bktmask = (1u << desc.bd_bktshift) - 1;
+            desc.bd_rotl = omf_bh_rotl(&blm_hdr);
+            desc.bd_n_hashes = omf_bh_n_hashes(&blm_hdr);
+
+            blm_pages = mapi_safe_malloc(omf_bh_bitmapsz(&blm_hdr));
+            ASSERT_NE(blm_pages, NULL);
+
+            mpm_mblock_read(
+                blkid,
+                blm_pages,
+                omf_kbh_blm_doff_pg(&kb_hdr) * PAGE_SIZE,
+                omf_bh_bitmapsz(&blm_hdr));
+
+            /* All keys share the first pfx_len bytes of key_buf. */
+            kvs_ktuple_init(&kt, key_buf, pfx_len);
+            ASSERT_TRUE(bloom_reader_buffer_lookup(&desc, blm_pages, &kt));
+
+            free(blm_pages);
+        }
+
+        blk_list_free(&blks);
+        kbb_destroy(kbb);
+    }
+}
+
 /* [HSE_REVISIT] make a table fo this */
 static int
 get_max_keys(struct mtf_test_info *lcl_ti, uint klen, uint kmdlen)
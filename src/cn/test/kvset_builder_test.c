@@ -338,6 +338,101 @@ MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_get_mblocks, pre, post)
     kvset_builder_destroy(bld);
 }
 
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_join, pre, post)
+{
+    merr_t                err;
+    struct kvset_builder *bld = 0;
+    struct kvset_builder *subv[2] = {};
+    struct kvset_builder *sub;
+    struct kvset_mblocks  blks;
+    struct key_obj        ko;
+    char                  vbuf[1171] = {};
+    int                   i;
+
+    mapi_inject(mapi_idx_kbb_set_agegroup, 0);
+    mapi_inject(mapi_idx_kbb_hlog_union, 0);
+    mapi_inject(mapi_idx_kbb_is_empty, true);
+
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < 2; i++) {
+        err = kvset_builder_create_sub(bld, &subv[i]);
+        ASSERT_EQ(err, 0);
+        ASSERT_NE(subv[i], NULL);
+    }
+
+    /* sub-builders can neither nest nor hold ptombs */
+    err = kvset_builder_create_sub(subv[0], &sub);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+
+    err = kvset_builder_create_sub(bld, &sub);
+    ASSERT_EQ(err, 0);
+    err = kvset_builder_add_val(sub, 3, HSE_CORE_TOMB_PFX, 0, 0);
+    ASSERT_EQ(err, 0);
+    key2kobj(&ko, "ab", 2);
+    err = kvset_builder_add_key(sub, &ko);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+    kvset_builder_destroy(sub);
+
+    for (i = 0; i < 2; i++) {
+        err = kvset_builder_add_val(subv[i], 2, vbuf, sizeof(vbuf), 0);
+        ASSERT_EQ(err, 0);
+        key2kobj(&ko, i ? "b" : "a", 1);
+        err = kvset_builder_add_key(subv[i], &ko);
+        ASSERT_EQ(err, 0);
+    }
+
+    /* a failed join leaves the builder usable only for destroy */
+    mapi_inject(mapi_idx_kbb_finish, 1234);
+    err = kvset_builder_join(bld, subv, 2);
+    ASSERT_EQ(err, 1234);
+    mapi_inject(mapi_idx_kbb_finish, 0);
+
+    err = kvset_builder_join(bld, subv, 2);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+    err = kvset_builder_create_sub(bld, &sub);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+    err = kvset_builder_get_mblocks(bld, &blks);
+    ASSERT_EQ(err, 1234);
+
+    for (i = 0; i < 2; i++)
+        kvset_builder_destroy(subv[i]);
+    kvset_builder_destroy(bld);
+
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < 2; i++) {
+        err = kvset_builder_create_sub(bld, &subv[i]);
+        ASSERT_EQ(err, 0);
+        err = kvset_builder_add_val(subv[i], 2, vbuf, sizeof(vbuf), 0);
+        ASSERT_EQ(err, 0);
+        key2kobj(&ko, i ? "b" : "a", 1);
+        err = kvset_builder_add_key(subv[i], &ko);
+        ASSERT_EQ(err, 0);
+    }
+
+    err = kvset_builder_join(bld, subv, 2);
+    ASSERT_EQ(err, 0);
+
+    /* a builder can only be joined once */
+    err = kvset_builder_join(bld, subv, 2);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+
+    err = kvset_builder_get_mblocks(bld, &blks);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(blks.bl_vused, 2 * sizeof(vbuf));
+
+    for (i = 0; i < 2; i++)
+        kvset_builder_destroy(subv[i]);
+    kvset_builder_destroy(bld);
+
+    mapi_inject_unset(mapi_idx_kbb_set_agegroup);
+    mapi_inject_unset(mapi_idx_kbb_hlog_union);
+    mapi_inject_unset(mapi_idx_kbb_is_empty);
+}
+
 MTF_DEFINE_UTEST_PREPOST(test, t_kvset_build_destroy, pre, post)
 {
     kvset_builder_destroy(NULL);
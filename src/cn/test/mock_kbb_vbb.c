@@ -79,6 +79,7 @@ mock_vbb_set(void)
 
     mapi_inject(mapi_idx_vbb_destroy, 0);
     mapi_inject(mapi_idx_vbb_add_entry, 0);
+    mapi_inject(mapi_idx_vbb_add_entry_shared, 0);
     mapi_inject(mapi_idx_vbb_finish, 0);
 }
 
@@ -89,5 +90,6 @@ mock_vbb_unset(void)
 
     mapi_inject_unset(mapi_idx_vbb_destroy);
     mapi_inject_unset(mapi_idx_vbb_add_entry);
+    mapi_inject_unset(mapi_idx_vbb_add_entry_shared);
     mapi_inject_unset(mapi_idx_vbb_finish);
 }
@@ -40,6 +40,7 @@ struct kvdata {
 };
 
 int mock_kvset_verbose = 0;
+uint mock_kvset_key_split = 0;
 
 void
 mock_kvset_data_reset()
@@ -290,6 +291,12 @@ _kvset_get_dgen(struct kvset *kvset)
     return mk->dgen;
 }
 
+static void
+_kvset_get_heat(struct kvset *kvset, struct kvset_heat *heat)
+{
+    memset(heat, 0, sizeof(*heat));
+}
+
 static u64
 _kvset_get_nth_kblock_id(struct kvset *kvset, u32 index)
 {
@@ -472,10 +479,10 @@ _kvset_iter_next_key(struct kv_iterator *kvi, struct key_obj *kobj, struct kvset
 
     d += vc->off;
 
-    kobj->ko_pfx = 0;
-    kobj->ko_pfx_len = 0;
-    kobj->ko_sfx = &d->key;
-    kobj->ko_sfx_len = sizeof(d->key);
+    kobj->ko_pfx = &d->key;
+    kobj->ko_pfx_len = min_t(uint, mock_kvset_key_split, sizeof(d->key));
+    kobj->ko_sfx = (char *)&d->key + kobj->ko_pfx_len;
+    kobj->ko_sfx_len = sizeof(d->key) - kobj->ko_pfx_len;
 
     if (mock_kvset_verbose)
         printf(
@@ -673,6 +680,7 @@ mock_kvset_set(void)
     MOCK_SET(kvset_view, _kvset_get_nth_kblock_id);
     MOCK_SET(kvset_view, _kvset_get_num_vblocks);
     MOCK_SET(kvset_view, _kvset_get_nth_vblock_id);
+    MOCK_SET(kvset_view, _kvset_get_heat);
 }
 
 void
@@ -699,4 +707,5 @@ mock_kvset_unset(void)
     MOCK_UNSET(kvset_view, _kvset_get_num_vblocks);
     MOCK_UNSET(kvset_view, _kvset_get_nth_vblock_id);
     MOCK_UNSET(kvset_view, _kvset_get_dgen);
+    MOCK_UNSET(kvset_view, _kvset_get_heat);
 }
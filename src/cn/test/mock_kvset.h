@@ -67,6 +67,11 @@ struct mock_kv_iterator {
     size_t             sz;
 };
 
+/* Number of leading bytes of each key that kvset iterators return in
+ * the key object's prefix, as kblocks do for keys with a common prefix.
+ */
+extern uint mock_kvset_key_split;
+
 void
 mock_kvset_set(void);
 void
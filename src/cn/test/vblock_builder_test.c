@@ -20,12 +20,14 @@
 #include <hse/hse_limits.h>
 
 #include "../vblock_builder.h"
+#include "../vblock_builder_internal.h"
 #include "../blk_list.h"
 
 #include "mock_mpool.h"
 
 #include <assert.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 struct kvs_rparams kvsrp;
 int                salt;
@@ -76,6 +78,7 @@ test_setup(struct mtf_test_info *lcl_ti)
     mapi_inject(mapi_idx_cn_get_dataset, 0);
     mapi_inject(mapi_idx_cn_get_flags, 0);
     mapi_inject(mapi_idx_cn_pc_mclass_get, 0);
+    mapi_inject(mapi_idx_cn_get_sched, 0);
 
     return 0;
 }
@@ -635,4 +638,169 @@ MTF_DEFINE_UTEST_PRE(test, t_destroy_with_3_vblock, test_setup)
     run_test_case(lcl_ti, tc_destroy, 3);
 }
 
+/* Two key ranges of a subcompaction add values to one vblock builder at
+ * the same time.  Media writes are slowed down and captured so that we
+ * can check both that they do not hold up the other range and that every
+ * value lands where the builder said it would.
+ */
+#define SHARED_RANGES 2
+#define SHARED_VALUES 800
+#define SHARED_BLKS   8
+
+struct shared_val {
+    uint vbidx;
+    uint vboff;
+    uint vlen;
+    uint base;
+};
+
+struct shared_range {
+    struct vblock_builder *vbb;
+    struct shared_val      valv[SHARED_VALUES];
+    uint                   id;
+    uint                   during_write;
+    merr_t                 err;
+};
+
+static u64      shared_blkidv[SHARED_BLKS];
+static u8 *     shared_imagev[SHARED_BLKS];
+static size_t   shared_lenv[SHARED_BLKS];
+static atomic_t shared_writing;
+static atomic_t shared_overlap;
+
+static mpool_err_t
+shared_mblock_write(struct mpool *mp, uint64_t id, const struct iovec *iov, int niov)
+{
+    size_t off;
+    int    i, j;
+
+    if (atomic_inc_return(&shared_writing) > 1)
+        atomic_inc(&shared_overlap);
+
+    usleep(10 * 1000);
+
+    for (i = 0; i < SHARED_BLKS; i++) {
+        if (!shared_imagev[i]) {
+            shared_blkidv[i] = id;
+            shared_imagev[i] = malloc(kvsrp.vblock_size_mb << 20);
+        }
+        if (shared_blkidv[i] == id)
+            break;
+    }
+
+    if (i == SHARED_BLKS || !shared_imagev[i]) {
+        atomic_dec(&shared_writing);
+        return merr(ENOMEM);
+    }
+
+    off = shared_lenv[i];
+    for (j = 0; j < niov; j++) {
+        memcpy(shared_imagev[i] + off, iov[j].iov_base, iov[j].iov_len);
+        off += iov[j].iov_len;
+    }
+    shared_lenv[i] = off;
+
+    atomic_dec(&shared_writing);
+
+    return 0;
+}
+
+static void *
+shared_range_main(void *arg)
+{
+    struct shared_range *r = arg;
+    uint                 i;
+    u64                  vbid;
+
+    for (i = 0; i < SHARED_VALUES; i++) {
+        struct shared_val *v = r->valv + i;
+
+        v->vlen = 1000 + (i * 7919 + r->id * 1013) % (60 * 1000);
+        v->base = (i * 131 + r->id * 4099) % (WORKBUF_SIZE - v->vlen);
+
+        r->err = vbb_add_entry_shared(
+            r->vbb, workbuf + v->base, v->vlen, &vbid, &v->vbidx, &v->vboff);
+        if (r->err)
+            break;
+
+        if (atomic_read(&shared_writing))
+            r->during_write++;
+    }
+
+    return NULL;
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_vbb_add_entry_shared, test_setup)
+{
+    struct shared_range    rangev[SHARED_RANGES];
+    pthread_t              tidv[SHARED_RANGES];
+    struct vblock_builder *vbb;
+    struct blk_list        blks;
+    merr_t                 err;
+    uint                   during_write = 0;
+    int                    i, j, k, rc;
+
+    memset(shared_imagev, 0, sizeof(shared_imagev));
+    memset(shared_lenv, 0, sizeof(shared_lenv));
+    atomic_set(&shared_writing, 0);
+    atomic_set(&shared_overlap, 0);
+
+    MOCK_SET_FN(mpool, mpool_mblock_write, shared_mblock_write);
+
+    err = vbb_create(VBB_CREATE_ARGS, KVSET_BUILDER_FLAGS_NONE);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < SHARED_RANGES; i++) {
+        rangev[i].vbb = vbb;
+        rangev[i].id = i;
+        rangev[i].during_write = 0;
+        rangev[i].err = 0;
+
+        rc = pthread_create(tidv + i, NULL, shared_range_main, rangev + i);
+        ASSERT_EQ(rc, 0);
+    }
+
+    for (i = 0; i < SHARED_RANGES; i++) {
+        pthread_join(tidv[i], NULL);
+        ASSERT_EQ(rangev[i].err, 0);
+        during_write += rangev[i].during_write;
+    }
+
+    /* Values were added while buffers were being written, but the
+     * writes themselves were issued one at a time.
+     */
+    ASSERT_GT(during_write, 0);
+    ASSERT_EQ(atomic_read(&shared_overlap), 0);
+
+    err = vbb_finish(vbb, &blks);
+    ASSERT_EQ(err, 0);
+    ASSERT_GE(blks.n_blks, 2);
+    ASSERT_LE(blks.n_blks, SHARED_BLKS);
+
+    for (i = 0; i < SHARED_RANGES; i++) {
+        for (j = 0; j < SHARED_VALUES; j++) {
+            struct shared_val *v = rangev[i].valv + j;
+            size_t             off = VBLOCK_HDR_LEN + v->vboff;
+
+            ASSERT_LT(v->vbidx, blks.n_blks);
+
+            for (k = 0; k < SHARED_BLKS; k++)
+                if (shared_blkidv[k] == blks.blks[v->vbidx].bk_blkid)
+                    break;
+
+            ASSERT_LT(k, SHARED_BLKS);
+            ASSERT_LE(off + v->vlen, shared_lenv[k]);
+            ASSERT_EQ(0, memcmp(shared_imagev[k] + off, workbuf + v->base, v->vlen));
+        }
+    }
+
+    blk_list_free(&blks);
+    vbb_destroy(vbb);
+
+    for (i = 0; i < SHARED_BLKS; i++)
+        free(shared_imagev[i]);
+
+    mock_mpool_set();
+}
+
 MTF_END_UTEST_COLLECTION(test);
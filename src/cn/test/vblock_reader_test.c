@@ -506,4 +506,43 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_madvise_async, pre)
     mapi_safe_free(vblk);
 }
 
+MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_ra_adapt, pre)
+{
+    struct vbr_ra_adapt ra;
+    u32                 base = 8 * 1024;
+    u32                 max = 64 * 1024;
+    u32                 ra_len, voff;
+    int                 i;
+
+    vbr_ra_adapt_init(&ra, base, max);
+
+    /* Sequential reads never shrink the window, nor grow it past max.
+     */
+    for (i = 0, voff = 0; i < 64; ++i, voff += 1024) {
+        ra_len = vbr_ra_adapt(&ra, 0, voff, 1024, false, 32);
+        ASSERT_GE(ra_len, base);
+        ASSERT_LE(ra_len, max);
+    }
+
+    /* Random reads shrink the window until readahead is suspended.
+     */
+    for (i = 0; i < 64; ++i)
+        ra_len = vbr_ra_adapt(&ra, (i % 2) * 7, (i % 5) * 65536, 1024, false, 32);
+    ASSERT_EQ(0, ra_len);
+
+    /* A sequential scan of the next vblock restores readahead.
+     */
+    for (i = 0, voff = 0; i < 8; ++i, voff += 1024)
+        ra_len = vbr_ra_adapt(&ra, 1, voff, 1024, false, 32);
+    ASSERT_GE(ra_len, base);
+
+    /* Reverse scans are sequential in descending offset order.
+     */
+    vbr_ra_adapt_init(&ra, base, max);
+    for (i = 0, voff = 1024 * 1024; i < 16; ++i, voff -= 1024) {
+        ra_len = vbr_ra_adapt(&ra, 3, voff, 1024, true, 32);
+        ASSERT_GE(ra_len, base);
+    }
+}
+
 MTF_END_UTEST_COLLECTION(vblock_reader_test)
@@ -120,29 +120,46 @@ _vblock_start(struct vblock_builder *bld)
 }
 
 static merr_t
-_vblock_write(struct vblock_builder *bld)
+_vblock_write_buf(struct vblock_builder *bld, u64 blkid, void *buf, uint len)
 {
     merr_t                 err;
     struct iovec           iov;
     struct cn_merge_stats *stats = bld->mstats;
     u64                    tstart;
 
-    assert(bld->blkid);
+    assert(blkid);
 
-    iov.iov_base = bld->wbuf;
-    iov.iov_len = bld->wbuf_len;
+    iov.iov_base = buf;
+    iov.iov_len = len;
 
     /* Function mblk_blow_chunks(), which is used in the kblock builder,
      * is not needed here because our write buffer is already
      * smallish (1MiB) and a multiple of the mblock stripe length.
      */
+    csched_io_charge(cn_get_sched(bld->cn), kvset_builder_io_class(bld->flags), iov.iov_len);
+
     tstart = get_time_ns();
 
-    err = mpool_mblock_write(bld->ds, bld->blkid, &iov, 1);
+    err = mpool_mblock_write(bld->ds, blkid, &iov, 1);
 
     if (stats)
         count_ops(&stats->ms_vblk_write, 1, iov.iov_len, get_time_ns() - tstart);
 
+    if (ev(err))
+        return err;
+
+    perfc_inc(bld->pc, PERFC_RA_CNCOMP_WREQS);
+    perfc_add(bld->pc, PERFC_RA_CNCOMP_WBYTES, len);
+
+    return 0;
+}
+
+static merr_t
+_vblock_write(struct vblock_builder *bld)
+{
+    merr_t err;
+
+    err = _vblock_write_buf(bld, bld->blkid, bld->wbuf, bld->wbuf_len);
     if (ev(err)) {
         bld->destruct = true;
         return err;
@@ -150,9 +167,6 @@ _vblock_write(struct vblock_builder *bld)
 
     bld->wbuf_off = 0;
 
-    perfc_inc(bld->pc, PERFC_RA_CNCOMP_WREQS);
-    perfc_add(bld->pc, PERFC_RA_CNCOMP_WBYTES, bld->wbuf_len);
-
     return 0;
 }
 
@@ -221,6 +235,9 @@ vbb_create(
         return merr(ENOMEM);
     }
 
+    mutex_init(&bld->lock);
+    cv_init(&bld->wr_cv, "vbb_wr");
+
     *builder_out = bld;
 
     return 0;
@@ -236,6 +253,15 @@ vbb_destroy(struct vblock_builder *bld)
     abort_mblocks(bld->ds, &bld->vblk_list);
     blk_list_free(&bld->vblk_list);
 
+    while (bld->wbuf_free) {
+        void *buf = bld->wbuf_free;
+
+        bld->wbuf_free = *(void **)buf;
+        free_aligned(buf);
+    }
+
+    cv_destroy(&bld->wr_cv);
+    mutex_destroy(&bld->lock);
     free_aligned(bld->wbuf);
     free(bld);
 }
@@ -311,6 +337,163 @@ vbb_add_entry(
     return 0;
 }
 
+/* Swap the write buffer for a spare and queue it to be written by the
+ * caller once it drops the builder's lock.
+ */
+static merr_t
+_vblock_detach(struct vblock_builder *bld, uint len, struct vbb_wreq *req)
+{
+    void *buf = bld->wbuf_free;
+
+    if (buf) {
+        bld->wbuf_free = *(void **)buf;
+    } else {
+        buf = alloc_page_aligned(WBUF_LEN_MAX);
+        if (ev(!buf))
+            return merr(ENOMEM);
+    }
+
+    req->buf = bld->wbuf;
+    req->len = len;
+    req->blkid = bld->blkid;
+    req->ticket = bld->wr_next++;
+
+    bld->wbuf = buf;
+    bld->wbuf_off = 0;
+
+    return 0;
+}
+
+/* Write a detached buffer once all buffers detached before it have been
+ * written, then return it to the spares.
+ */
+static merr_t
+_vblock_write_shared(struct vblock_builder *bld, struct vbb_wreq *req)
+{
+    merr_t err;
+
+    mutex_lock(&bld->lock);
+    while (bld->wr_done != req->ticket)
+        cv_wait(&bld->wr_cv, &bld->lock);
+    err = bld->wr_err;
+    mutex_unlock(&bld->lock);
+
+    if (!err)
+        err = _vblock_write_buf(bld, req->blkid, req->buf, req->len);
+
+    mutex_lock(&bld->lock);
+    if (err && !bld->wr_err)
+        bld->wr_err = err;
+    *(void **)req->buf = bld->wbuf_free;
+    bld->wbuf_free = req->buf;
+    bld->wr_done++;
+    cv_broadcast(&bld->wr_cv);
+    mutex_unlock(&bld->lock);
+
+    return err;
+}
+
+merr_t
+vbb_add_entry_shared(
+    struct vblock_builder *bld,
+    const void *           vdata,
+    uint                   vlen,
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout)
+{
+    struct vbb_wreq reqv[VBB_WREQ_MAX];
+    merr_t          err, err2;
+    uint            voff, space, bytes, reqc, i;
+
+    assert(!bld->destruct);
+
+    assert(vdata);
+    assert(vlen);
+    assert(vlen <= HSE_KVS_VLEN_MAX);
+
+    reqc = 0;
+
+    mutex_lock(&bld->lock);
+    err = bld->wr_err;
+    if (ev(err))
+        goto unlock;
+
+    if (unlikely(!_vblock_has_room(bld, vlen))) {
+        if (bld->blkid && bld->wbuf_off) {
+            uint zfill_len = bld->wbuf_len - bld->wbuf_off;
+
+            if (zfill_len > _vblock_unused_media_space(bld))
+                zfill_len = _vblock_unused_media_space(bld);
+
+            memset(bld->wbuf + bld->wbuf_off, 0, zfill_len);
+
+            err = _vblock_detach(bld, bld->wbuf_off + zfill_len, reqv + reqc++);
+            if (ev(err)) {
+                reqc--;
+                goto unlock;
+            }
+        }
+
+        bld->blkid = 0;
+    }
+
+    if (unlikely(!bld->blkid)) {
+        err = _vblock_start(bld);
+        if (ev(err))
+            goto unlock;
+    }
+
+    assert(_vblock_has_room(bld, vlen));
+
+    voff = 0;
+
+    while (voff < vlen) {
+        space = bld->wbuf_len - bld->wbuf_off;
+        bytes = vlen - voff;
+        if (bytes > space)
+            bytes = space;
+
+        memcpy(bld->wbuf + bld->wbuf_off, vdata + voff, bytes);
+
+        bld->wbuf_off += bytes;
+        voff += bytes;
+
+        if (bld->wbuf_off == bld->wbuf_len) {
+            assert(reqc < VBB_WREQ_MAX);
+
+            err = _vblock_detach(bld, bld->wbuf_len, reqv + reqc++);
+            if (ev(err)) {
+                reqc--;
+                goto unlock;
+            }
+        }
+    }
+
+    *vboffout = bld->vblk_off - VBLOCK_HDR_LEN;
+    *vbidxout = bld->vblk_list.n_blks - 1;
+    *vbidout = bld->vblk_list.blks[*vbidxout].bk_blkid;
+
+    bld->vblk_off += vlen;
+    bld->vsize += vlen;
+
+unlock:
+    if (err && !bld->wr_err)
+        bld->wr_err = err;
+    mutex_unlock(&bld->lock);
+
+    /* Every detached buffer must be accounted for, even on error,
+     * or callers waiting for later tickets would never wake up.
+     */
+    for (i = 0; i < reqc; i++) {
+        err2 = _vblock_write_shared(bld, reqv + i);
+        if (!err)
+            err = err2;
+    }
+
+    return err;
+}
+
 /* Close out the current vblock, return IDs of all mblocks allocated so far,
  * and mark the builder as closed for business.
  */
@@ -323,6 +506,9 @@ vbb_finish(struct vblock_builder *bld, struct blk_list *vblks)
 
     bld->destruct = true;
 
+    if (ev(bld->wr_err))
+        return bld->wr_err;
+
     err = _vblock_finish(bld);
     if (ev(err))
         return err;
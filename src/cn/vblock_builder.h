@@ -66,6 +66,27 @@ vbb_add_entry(
     uint *                 vbidxout,
     uint *                 vboffout);
 
+/**
+ * vbb_add_entry_shared() - Store a value in a vblock shared by several threads
+ * @bld:  builder handle
+ * @vdata, @vlen: value to add to vblock
+ * @vbidout: The id of vblock that holds value
+ * @vbidxout: index of the vblock that holds the added value
+ * @vboffout: offset of value into vblock
+ *
+ * Same as vbb_add_entry(), but may be called concurrently.  Media writes
+ * are issued outside the builder's lock.
+ */
+/* MTF_MOCK */
+merr_t
+vbb_add_entry_shared(
+    struct vblock_builder *bld,
+    const void *           vdata,
+    uint                   vlen,
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout);
+
 /* MTF_MOCK */
 merr_t
 vbb_finish(struct vblock_builder *bld, struct blk_list *vblks);
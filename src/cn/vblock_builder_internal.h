@@ -6,8 +6,12 @@
 #ifndef HSE_KVS_CN_VBLOCK_BUILDER_INT_H
 #define HSE_KVS_CN_VBLOCK_BUILDER_INT_H
 
+#include <hse_util/mutex.h>
+#include <hse_util/condvar.h>
+
 #define WBUF_LEN_MAX (1024 * 1024)
 #define VBLOCK_HDR_LEN 4096
+#define VBB_WREQ_MAX 4
 
 struct cn_merge_stats;
 
@@ -25,6 +29,12 @@ struct cn_merge_stats;
  *             minus the size of the vblock byte header.
  * @destruct:  if true, vlbock builder is ready to be destroyed
  * @opt_wrsz:  optimal write size for incremental mblock writes
+ * @lock:      serializes vbb_add_entry_shared() callers
+ * @wr_cv:     signaled when a shared write completes
+ * @wr_next:   ticket of the next write buffer to be filled
+ * @wr_done:   ticket of the next write buffer to be written
+ * @wr_err:    error from a failed shared write
+ * @wbuf_free: spare write buffers, linked through their first word
  *
  * WBUF_LEN_MAX is the allocated size of the write buffer.  Each mblock write
  * will be at most WBUF_LEN_MAX bytes.  Member @wbuf_len is the actual write
@@ -62,6 +72,16 @@ struct cn_merge_stats;
  *       -- write @wbuf_len bytes to mblock
  *       -- set @wbuf_off to 0
  *       -- set @vblk_off += @wbuff_off
+ *
+ * Shared builders (vbb_add_entry_shared())
+ * ----------------------------------------
+ *
+ * Several threads may add values to one builder.  Each caller reserves
+ * space and copies its value into @wbuf under @lock.  A write buffer that
+ * fills up is swapped for a spare and given a ticket, and the caller that
+ * filled it writes it to media after dropping @lock.  Writes are issued in
+ * ticket order, so each mblock is still written sequentially, but other
+ * callers keep adding values while a write is in progress.
  */
 struct vblock_builder {
     struct mpool *             ds;
@@ -81,6 +101,27 @@ struct vblock_builder {
     u64                        vgroup;
     bool                       destruct;
     u32                        opt_wrsz;
+
+    struct mutex lock;
+    struct cv    wr_cv;
+    u64          wr_next;
+    u64          wr_done;
+    merr_t       wr_err;
+    void *       wbuf_free;
+};
+
+/**
+ * struct vbb_wreq - a full write buffer detached by a shared builder
+ * @buf:    write buffer
+ * @len:    number of bytes to write
+ * @blkid:  vblock to write to
+ * @ticket: position in the builder's write order
+ */
+struct vbb_wreq {
+    void *buf;
+    uint  len;
+    u64   blkid;
+    u64   ticket;
 };
 
 static inline bool
@@ -10,6 +10,8 @@
 #include <hse_util/slab.h>
 #include <hse_util/assert.h>
 #include <hse_util/arch.h>
+#include <hse_util/atomic.h>
+#include <hse_util/timing.h>
 
 #include <mpool/mpool.h>
 
@@ -18,6 +20,21 @@
 #include "omf.h"
 #include "vblock_reader.h"
 
+/* Adaptive readahead windows stop growing when fewer than this many GiB
+ * of memory are available.
+ */
+#define VBR_RA_MAVAIL_MIN   (2)
+
+/* Number of consecutive sequential (random) accesses required to grow
+ * (shrink) an adaptive readahead window.
+ */
+#define VBR_RA_SEQ_GROW     (4)
+#define VBR_RA_RAND_SHRINK  (2)
+
+static atomic_t   vbr_ra_inflight;
+static atomic64_t vbr_ra_mavail_ns;
+static atomic_t   vbr_ra_mavail_gb;
+
 merr_t
 vbr_desc_read(
     struct mpool *           ds,
@@ -188,6 +205,104 @@ willneed:
     vbr_madvise(vbd, voff, ra_len, MADV_WILLNEED);
 }
 
+/* Return available memory (GiB), sampled at most once per second by
+ * whichever reader finds the sample stale.
+ */
+static uint
+vbr_ra_mavail(void)
+{
+    u64 now = get_time_ns();
+    u64 last = atomic64_read(&vbr_ra_mavail_ns);
+
+    if (now - last > NSEC_PER_SEC && atomic64_cmpxchg(&vbr_ra_mavail_ns, last, now) == last) {
+        ulong mavail;
+
+        hse_meminfo(NULL, &mavail, 30);
+        atomic_set(&vbr_ra_mavail_gb, min_t(ulong, mavail, INT_MAX));
+    }
+
+    return atomic_read(&vbr_ra_mavail_gb);
+}
+
+void
+vbr_ra_adapt_init(struct vbr_ra_adapt *ra, u32 base, u32 max)
+{
+    memset(ra, 0, sizeof(*ra));
+
+    ra->ra_base = base;
+    ra->ra_max = max_t(u32, base, max);
+    ra->ra_cur = base;
+    ra->ra_vbidx = U32_MAX;
+}
+
+u32
+vbr_ra_adapt(struct vbr_ra_adapt *ra, u32 vbidx, u32 voff, u32 vlen, bool reverse, u32 qdepth)
+{
+    bool seq = false;
+
+    if (vbidx == ra->ra_vbidx) {
+        u32  gap;
+        bool mono;
+
+        if (reverse) {
+            mono = voff + vlen <= ra->ra_off;
+            gap = mono ? ra->ra_off - (voff + vlen) : 0;
+        } else {
+            mono = voff >= ra->ra_end;
+            gap = mono ? voff - ra->ra_end : 0;
+        }
+
+        /* Small gaps are sequential.  Larger gaps are strided if
+         * they repeat and the window spans several of them.
+         */
+        if (mono) {
+            if (gap <= PAGE_SIZE)
+                seq = true;
+            else if (gap * 4 <= ra->ra_cur && gap <= ra->ra_gap * 2 && gap * 2 >= ra->ra_gap)
+                seq = true;
+        }
+
+        ra->ra_gap = gap;
+    } else {
+        /* Moving to the adjacent vblock in the direction of
+         * iteration continues a sequential scan.
+         */
+        seq = (vbidx == ra->ra_vbidx + (reverse ? -1 : 1));
+        ra->ra_gap = 0;
+    }
+
+    ra->ra_vbidx = vbidx;
+    ra->ra_off = voff;
+    ra->ra_end = voff + vlen;
+
+    if (seq) {
+        ra->ra_rand = 0;
+
+        if (++ra->ra_seq >= VBR_RA_SEQ_GROW) {
+            ra->ra_seq = 0;
+
+            if (!ra->ra_cur) {
+                ra->ra_cur = ra->ra_base;
+            } else if (ra->ra_cur < ra->ra_max &&
+                       atomic_read(&vbr_ra_inflight) < qdepth &&
+                       vbr_ra_mavail() >= VBR_RA_MAVAIL_MIN) {
+                ra->ra_cur = min_t(u32, ra->ra_cur * 2, ra->ra_max);
+            }
+        }
+    } else {
+        ra->ra_seq = 0;
+
+        if (++ra->ra_rand >= VBR_RA_RAND_SHRINK) {
+            ra->ra_rand = 0;
+            ra->ra_cur /= 2;
+            if (ra->ra_cur < PAGE_SIZE * 2)
+                ra->ra_cur = 0;
+        }
+    }
+
+    return ra->ra_cur;
+}
+
 static void
 vbr_madvise_async_cb(struct work_struct *work)
 {
@@ -197,6 +312,7 @@ vbr_madvise_async_cb(struct work_struct *work)
 
     vbr_madvise(w->vmw_vbd, w->vmw_off, w->vmw_len, w->vmw_advice);
 
+    atomic_dec(&vbr_ra_inflight);
     atomic_dec(&w->vmw_vbd->vbd_refcnt);
     free(w);
 }
@@ -225,6 +341,7 @@ vbr_madvise_async(
     w->vmw_advice = advice;
 
     atomic_inc(&vbd->vbd_refcnt);
+    atomic_inc(&vbr_ra_inflight);
 
     return queue_work(wq, &w->vmw_work);
 }
@@ -34,6 +34,35 @@ struct ra_hist {
     u16 bkt;
 };
 
+/**
+ * struct vbr_ra_adapt - adaptive readahead window state
+ * @ra_base:   initial window size
+ * @ra_max:    max window size
+ * @ra_cur:    current window size (0 if readahead is suspended)
+ * @ra_vbidx:  vblock index of the last value read
+ * @ra_off:    offset of the last value read
+ * @ra_end:    end offset of the last value read
+ * @ra_gap:    gap between the last two values read from the same vblock
+ * @ra_seq:    consecutive sequential (or strided) accesses
+ * @ra_rand:   consecutive random accesses
+ *
+ * The window grows while a cursor reads values sequentially and shrinks
+ * (eventually to zero) while it reads them randomly.  Strided accesses
+ * whose stride fits within the window count as sequential, all others
+ * as random.
+ */
+struct vbr_ra_adapt {
+    u32 ra_base;
+    u32 ra_max;
+    u32 ra_cur;
+    u32 ra_vbidx;
+    u32 ra_off;
+    u32 ra_end;
+    u32 ra_gap;
+    u16 ra_seq;
+    u16 ra_rand;
+};
+
 /**
  * struct vbr_madvise_work - async vblock readahead params
  */
@@ -114,6 +143,30 @@ vbr_readahead(
     struct ra_hist *         ra_histv,
     struct workqueue_struct *wq);
 
+/**
+ * vbr_ra_adapt_init() - initialize adaptive readahead state
+ * @ra:   adaptive readahead state
+ * @base: initial window size (bytes)
+ * @max:  max window size (bytes)
+ */
+void
+vbr_ra_adapt_init(struct vbr_ra_adapt *ra, u32 base, u32 max);
+
+/**
+ * vbr_ra_adapt() - update the readahead window for an access
+ * @ra:      adaptive readahead state
+ * @vbidx:   vblock index of the value being read
+ * @voff:    offset of the value within its vblock
+ * @vlen:    length of the value
+ * @reverse: true if the caller is iterating in reverse
+ * @qdepth:  max async readaheads in flight before the window stops growing
+ *
+ * Return: the readahead length to pass to vbr_readahead(), or zero
+ * if readahead should be skipped for this access.
+ */
+u32
+vbr_ra_adapt(struct vbr_ra_adapt *ra, u32 vbidx, u32 voff, u32 vlen, bool reverse, u32 qdepth);
+
 /**
  * vbr_madvise() - tickle read-ahead logic for a more aggressive
  *                        sequential read ahead
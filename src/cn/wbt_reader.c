@@ -24,6 +24,8 @@
 #define MTF_MOCK_IMPL_wbt_reader
 #include "wbt_reader.h"
 
+__thread u64 wbtr_pages_tls;
+
 /*
  * This file should contain no wbt omf specific code.
  */
@@ -32,6 +32,11 @@ struct wbti {
 
 #define NODE_EOF ((u32)-1)
 
+/* Count of wbtree pages (nodes and key metadata) visited by point
+ * lookups on the calling thread.
+ */
+extern __thread u64 wbtr_pages_tls;
+
 /**
  * struct wbt_desc - a descriptor for accessing a KBLOCK's WBT
  * @wbd_first_page: offset, in pages, from start of MBLOCK to WBT data region
@@ -61,6 +61,7 @@ wbtr_seek_page(
     __builtin_prefetch(map_base + (first_page + wbd->wbd_root) * PAGE_SIZE);
 
     assert(0 <= node_num && node_num < wbd->wbd_n_pages);
+    ++wbtr_pages_tls;
     pg = first_page + node_num;
     node = map_base + pg * PAGE_SIZE;
 
@@ -123,6 +124,7 @@ wbtr_seek_page(
         node_num = omf_ine_left_child(ine);
 
         assert(0 <= node_num && node_num < wbd->wbd_n_pages);
+        ++wbtr_pages_tls;
         pg = first_page + node_num;
         node = map_base + pg * PAGE_SIZE;
         __builtin_prefetch(node);
@@ -746,6 +748,7 @@ wbtr5_read_vref(
             uint   nvals;
 
             kmd = kbd->map_base + PAGE_SIZE * (wbd->wbd_first_page + wbd->wbd_root + 1);
+            ++wbtr_pages_tls;
 
             off = wbt_lfe_kmd(node, lfe);
             assert(off < wbd->wbd_kmd_pgc * PAGE_SIZE);
@@ -26,6 +26,7 @@ struct mpool;
 struct kvs_cparams;
 struct kvs_rparams;
 struct kvset_mblocks;
+struct key_obj;
 struct kvdb_kvs;
 struct sts;
 struct mclass_policy;
@@ -137,7 +138,7 @@ cn_pfx_probe(
  * @cn:
  * @mbv:
  *      The first vcommitted[i] vblocks of kvset mbv[i] are already committed.
- * @mbc:
+ * @mbc: number of kvsets in mbv[i] (either 1 or cn_ingest_fanout())
  * @vcommitted: indicated in each kvset how many vblocks are already committed.
  *      Also these comitted vblocks ae not deleted by cndb replay [in the case
  *      this ingest is rolled back].
@@ -162,10 +163,39 @@ cn_ingestv(
     bool *                 ingested_out,
     u64 *                  seqno_max_out);
 
+/**
+ * cn_ingest_fanout() - number of kvsets into which to partition an ingest
+ * @cn:
+ *
+ * If the kvs enables cn_ingest_partition and the cn tree's root node is
+ * empty, c0 may partition its ingest by the root node's children to spare
+ * cn a root spill.  Each element of the mblocks vector passed to
+ * cn_ingestv() must then hold the keys for which cn_ingest_route()
+ * returned that element's index.
+ *
+ * Return: number of partitions (1 if the ingest must not be partitioned)
+ */
+/* MTF_MOCK */
+uint
+cn_ingest_fanout(struct cn *cn);
+
+/**
+ * cn_ingest_route() - partition to which a key belongs
+ * @cn:
+ * @kobj: key
+ */
+/* MTF_MOCK */
+uint
+cn_ingest_route(struct cn *cn, const struct key_obj *kobj);
+
 /* MTF_MOCK */
 struct perfc_set *
 cn_get_ingest_perfc(const struct cn *cn);
 
+/* MTF_MOCK */
+struct perfc_set *
+cn_get_lookup_perfc(const struct cn *cn);
+
 /* MTF_MOCK */
 void *
 cn_get_tree(const struct cn *cn);
@@ -194,6 +224,14 @@ cn_get_io_wq(struct cn *cn);
 struct workqueue_struct *
 cn_get_maint_wq(struct cn *cn);
 
+/* MTF_MOCK */
+struct workqueue_struct *
+cn_get_cursor_wq(struct cn *cn);
+
+/* MTF_MOCK */
+struct workqueue_struct *
+cn_get_subc_wq(struct cn *cn);
+
 /* MTF_MOCK */
 struct csched *
 cn_get_sched(struct cn *cn);
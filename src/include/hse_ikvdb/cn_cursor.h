@@ -17,13 +17,31 @@ struct cn;
 struct kvs_ktuple;
 struct kvs_kvtuple;
 struct cursor_summary;
+struct kc_pred;
 
+/**
+ * cn_cursor_create() - create a cn cursor
+ * @cn:        cn
+ * @seqno:     view seqno
+ * @reverse:   iterate in reverse key order
+ * @keys_only: the caller does not need values
+ * @pred:      read predicate (may be NULL)
+ * @prefix:    prefix to scan (may be NULL)
+ * @len:       length of @prefix
+ * @summary:   cursor summary
+ * @cursorp:   (output) cursor
+ *
+ * @keys_only and @pred are given at create time because a parallel
+ * merge starts fetching values as soon as the cursor is created.
+ */
 /* MTF_MOCK */
 merr_t
 cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
+    const struct kc_pred * pred,
     const void *           prefix,
     u32                    len,
     struct cursor_summary *summary,
@@ -46,6 +64,14 @@ cn_cursor_seek(
 merr_t
 cn_cursor_read(void *cursor, struct kvs_kvtuple *kvt, bool *eof);
 
+/* MTF_MOCK */
+void
+cn_cursor_pred(void *cursor, const struct kc_pred *pred);
+
+/* MTF_MOCK */
+void
+cn_cursor_keys_only(void *cursor, bool keys_only);
+
 /* MTF_MOCK */
 void
 cn_cursor_destroy(void *cursor);
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_IKVDB_CN_WAMP_H
+#define HSE_IKVDB_CN_WAMP_H
+
+#include <hse_util/inttypes.h>
+
+/*
+ * Each cn tree accounts for the bytes its ingests, spills and
+ * compactions read from and write to media, by operation and by tree
+ * level, both since the KVS was opened and in a series of fixed time
+ * intervals.  Write amplification is the ratio of all bytes written
+ * to the bytes written by ingest.
+ *
+ * A job's read bytes are the wlen of its input kvsets (kblocks only
+ * for k-compaction) and are charged to the level it reads from.  Its
+ * write bytes are what its kblock and vblock builders wrote and are
+ * charged to the level it writes to.  Ingests read nothing from media.
+ */
+
+#define CN_WAMP_LEVELS        (8) /* deeper levels are counted in the last */
+#define CN_WAMP_INTERVALS     (60)
+#define CN_WAMP_INTERVAL_SECS (60)
+
+struct cn;
+
+enum cn_wamp_op {
+    CN_WAMP_INGEST,
+    CN_WAMP_SPILL,
+    CN_WAMP_KCOMPACT,
+    CN_WAMP_KVCOMPACT,
+    CN_WAMP_OP_MAX,
+};
+
+/**
+ * struct cn_wamp_ctr - bytes moved by an operation or at a level
+ * @wc_jobs:   completed jobs (for a level, jobs that wrote to it)
+ * @wc_rbytes: bytes read
+ * @wc_wbytes: bytes written
+ */
+struct cn_wamp_ctr {
+    u64 wc_jobs;
+    u64 wc_rbytes;
+    u64 wc_wbytes;
+};
+
+/**
+ * struct cn_wamp_sample - bytes moved in one interval (or in total)
+ * @ws_idx:  interval number, i.e., get_time_ns() / interval length
+ * @ws_alen: allocated length of the tree after the last job
+ * @ws_good: estimated length of live data in the leaves after the last job
+ * @ws_opv:  counters by operation
+ * @ws_lvlv: counters by tree level
+ *
+ * @ws_alen / @ws_good is the space amplification csched works from.
+ */
+struct cn_wamp_sample {
+    u64                ws_idx;
+    s64                ws_alen;
+    s64                ws_good;
+    struct cn_wamp_ctr ws_opv[CN_WAMP_OP_MAX];
+    struct cn_wamp_ctr ws_lvlv[CN_WAMP_LEVELS];
+};
+
+/**
+ * struct cn_wamp_view - snapshot of a tree's accounting
+ * @wv_now:   get_time_ns() when the snapshot was taken
+ * @wv_since: get_time_ns() when accounting started
+ * @wv_total: totals since accounting started
+ * @wv_intc:  number of entries in @wv_intv
+ * @wv_intv:  intervals in which jobs completed, oldest first
+ */
+struct cn_wamp_view {
+    u64                   wv_now;
+    u64                   wv_since;
+    struct cn_wamp_sample wv_total;
+    uint                  wv_intc;
+    struct cn_wamp_sample wv_intv[CN_WAMP_INTERVALS];
+};
+
+/**
+ * cn_wamp_get() - take a snapshot of a cn tree's accounting
+ * @cn:   cn
+ * @view: (output) snapshot
+ */
+void
+cn_wamp_get(struct cn *cn, struct cn_wamp_view *view);
+
+const char *
+cn_wamp_op_name(enum cn_wamp_op op);
+
+/**
+ * cn_wamp_ratio() - write amplification of a sample, scaled by 100
+ */
+static inline u64
+cn_wamp_ratio(const struct cn_wamp_sample *ws)
+{
+    u64 ingest = ws->ws_opv[CN_WAMP_INGEST].wc_wbytes;
+    u64 total = 0;
+    int i;
+
+    for (i = 0; i < CN_WAMP_OP_MAX; i++)
+        total += ws->ws_opv[i].wc_wbytes;
+
+    return ingest ? (total * 100) / ingest : 0;
+}
+
+#endif
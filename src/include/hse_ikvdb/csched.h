@@ -25,9 +25,24 @@ struct kvdb_health;
 /**
  * enum csched_policy - compaction scheduler policy
  * csched_policy_old:  Do not use csched.  Use old tree walker scheduler.
+ * csched_policy_sp3:  Space amp driven scheduler.
+ * csched_policy_tiered: sp3 with size-tiered leaf compaction in all trees.
  * csched_policy_noop: Disable scheduler.
  */
-enum csched_policy { csched_policy_old = 0, csched_policy_sp3 = 3, csched_policy_noop = 0xff };
+enum csched_policy {
+    csched_policy_old = 0,
+    csched_policy_sp3 = 3,
+    csched_policy_tiered = 4,
+    csched_policy_noop = 0xff,
+};
+
+/**
+ * enum csched_io_class - priority class of cN media I/O
+ * CSCHED_IO_INGEST: ingest from c0 into the cN root node
+ * CSCHED_IO_ROOT:   compaction of a cN root node (e.g., root spill)
+ * CSCHED_IO_LEAF:   compaction of internal and leaf nodes
+ */
+enum csched_io_class { CSCHED_IO_INGEST, CSCHED_IO_ROOT, CSCHED_IO_LEAF };
 
 /**
  * csched_create() - create a scheduler for kvdb compaction work
@@ -56,6 +71,19 @@ csched_destroy(struct csched *csched);
 void
 csched_notify_ingest(struct csched *handle, struct cn_tree *tree, size_t alen, size_t wlen);
 
+/**
+ * csched_notify_ingest_children() - notify a partitioned ingest has completed
+ * @handle: scheduler handle
+ * @tree:   cn tree whose root node's children received the ingest
+ * @diff:   change in the tree's samp stats
+ */
+/* MTF_MOCK */
+void
+csched_notify_ingest_children(
+    struct csched *             handle,
+    struct cn_tree *            tree,
+    const struct cn_samp_stats *diff);
+
 /* MTF_MOCK */
 void
 csched_tree_add(struct csched *csched, struct cn_tree *tree);
@@ -76,6 +104,21 @@ csched_compact_request(struct csched *handle, int flags);
 void
 csched_compact_status_get(struct csched *handle, struct hse_kvdb_compact_status *status);
 
+/**
+ * csched_io_charge() - charge cN media I/O against the KVDB I/O budget
+ * @handle: scheduler handle (may be NULL)
+ * @ioc:    priority class of the I/O
+ * @len:    number of bytes read or written
+ *
+ * May sleep if the budget for @ioc is exhausted.  Ingest I/O is never
+ * delayed, it only reduces the budget available to compaction.  Call
+ * it from the thread that issues the I/O before the I/O is queued,
+ * never from a shared I/O workqueue.
+ */
+/* MTF_MOCK */
+void
+csched_io_charge(struct csched *handle, enum csched_io_class ioc, size_t len);
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "csched_ut.h"
 #endif /* HSE_UNIT_TEST_MODE */
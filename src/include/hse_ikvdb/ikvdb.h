@@ -13,6 +13,7 @@
 #include <hse_ikvdb/kvs_cparams.h>
 #include <hse_ikvdb/kvs_rparams.h>
 #include <hse_ikvdb/diag_kvdb.h>
+#include <hse_ikvdb/kvdb_optrace.h>
 
 #include <hse_util/inttypes.h>
 #include <hse_util/hse_err.h>
@@ -33,6 +34,7 @@ struct kvdb_rparams;
 struct hse_kvdb_opspec;
 struct kvdb_log;
 struct hse_kvs_cursor;
+struct kc_pred;
 struct mpool;
 struct c0sk;
 struct cndb;
@@ -406,6 +408,76 @@ ikvdb_txn_commit(struct ikvdb *kvdb, struct hse_kvdb_txn *txn);
 merr_t
 ikvdb_txn_abort(struct ikvdb *kvdb, struct hse_kvdb_txn *txn);
 
+/**
+ * ikvdb_optrace_start() - start time of an operation to be traced
+ * @kvdb: kvdb handle
+ *
+ * Return: get_time_ns() if operation tracing is enabled (see the kvdb
+ * rparam optrace_path), else 0
+ */
+u64
+ikvdb_optrace_start(struct ikvdb *kvdb);
+
+/**
+ * ikvdb_optrace() - trace a transaction operation
+ * @kvdb:   kvdb handle
+ * @op:     KVDB_OPTRACE_TXN_BEGIN, _COMMIT or _ABORT
+ * @txn:    transaction
+ * @tstart: time returned by ikvdb_optrace_start()
+ * @err:    operation status
+ */
+void
+ikvdb_optrace(
+    struct ikvdb *       kvdb,
+    enum kvdb_optrace_op op,
+    struct hse_kvdb_txn *txn,
+    u64                  tstart,
+    merr_t               err);
+
+/**
+ * ikvdb_kvs_optrace_start() - ikvdb_optrace_start() for KVS operations
+ * @kvs: kvs handle
+ */
+u64
+ikvdb_kvs_optrace_start(struct hse_kvs *kvs);
+
+/**
+ * ikvdb_kvs_optrace() - trace a KVS operation
+ * @kvs:    kvs handle
+ * @op:     operation
+ * @ctx:    transaction (from the opspec) or cursor, may be NULL
+ * @key:    key, prefix or seek key, may be NULL
+ * @klen:   length of @key
+ * @vlen:   length of the value put or found
+ * @tstart: time returned by ikvdb_kvs_optrace_start()
+ * @err:    operation status
+ */
+void
+ikvdb_kvs_optrace(
+    struct hse_kvs *     kvs,
+    enum kvdb_optrace_op op,
+    const void *         ctx,
+    const void *         key,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err);
+
+/**
+ * ikvdb_slowop_get() - copy out the most recent slow KVS operations
+ * @kvdb:  kvdb handle
+ * @recv:  (output) records, newest first
+ * @recc:  capacity of @recv
+ * @seenp: (output) slow operations seen since the kvdb was opened
+ *
+ * Return: number of records copied, zero if the slow operation log is
+ * disabled (see the kvdb rparam slowop_ns)
+ */
+struct kvdb_slowop_rec;
+
+uint
+ikvdb_slowop_get(struct ikvdb *kvdb, struct kvdb_slowop_rec *recv, uint recc, u64 *seenp);
+
 /**
  * ikvdb_txn_state() - retrieve the state of a transaction.
  *
@@ -460,6 +532,30 @@ ikvdb_kvs_cursor_read(
     size_t *                val_len,
     bool *                  eof);
 
+/**
+ * ikvdb_kvs_cursor_read_batch() - read many key/value pairs in one call
+ *
+ * See ikvs_cursor_read_batch().
+ */
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor * cursor,
+    struct hse_kvdb_opspec *opspec,
+    void *                  buf,
+    size_t                  bufsz,
+    struct kvs_kvtuple *    kvtv,
+    uint                    kvtmax,
+    uint *                  kvtc,
+    bool *                  eof);
+
+/**
+ * ikvdb_kvs_cursor_pred_set() - set or clear the cursor's scan predicate
+ *
+ * See ikvs_cursor_pred_set().
+ */
+void
+ikvdb_kvs_cursor_pred_set(struct hse_kvs_cursor *cursor, const struct kc_pred *pred);
+
 /**
  * ikvdb_kvs_cursor_destroy() - allow the caller to indicate that is is done
  * with the scan and release the associated cursor
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVDB_OPTRACE_H
+#define HSE_KVDB_OPTRACE_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/omf.h>
+
+/*
+ * An operation trace is a file holding a struct kvdb_optrace_hdr_omf
+ * followed by fixed-size records, each either a struct kvdb_optrace_omf
+ * describing one API operation or a struct kvdb_optrace_kvs_omf naming a
+ * KVS that later operation records refer to by id.
+ *
+ * Keys and values are not recorded.  Instead, each key is described by
+ * its length, a hash of the whole key and a hash of its KVS prefix so
+ * that a replay can synthesize keys that repeat, collide on prefixes and
+ * vary in size exactly as the original ones did.
+ *
+ * Records are written from per-cpu buffers and so are only roughly in
+ * time order in the file.  Readers should sort them by otr_ns.
+ */
+
+#define KVDB_OPTRACE_PATH_LEN_MAX 256
+
+#define KVDB_OPTRACE_MAGIC   ((u32)0x6f707472) /* "optr" */
+#define KVDB_OPTRACE_VERSION ((u32)1)
+
+enum kvdb_optrace_op {
+    KVDB_OPTRACE_KVS,
+    KVDB_OPTRACE_PUT,
+    KVDB_OPTRACE_GET,
+    KVDB_OPTRACE_DEL,
+    KVDB_OPTRACE_PDEL,
+    KVDB_OPTRACE_TXN_BEGIN,
+    KVDB_OPTRACE_TXN_COMMIT,
+    KVDB_OPTRACE_TXN_ABORT,
+    KVDB_OPTRACE_CUR_CREATE,
+    KVDB_OPTRACE_CUR_SEEK,
+    KVDB_OPTRACE_CUR_READ,
+    KVDB_OPTRACE_CUR_DESTROY,
+    KVDB_OPTRACE_CUR_UPDATE,
+    KVDB_OPTRACE_CUR_READ_BATCH,
+    KVDB_OPTRACE_CUR_PRED_SET,
+    KVDB_OPTRACE_PFX_PROBE,
+    KVDB_OPTRACE_OP_MAX,
+};
+
+/**
+ * struct kvdb_optrace_hdr_omf - trace file header
+ * @oth_magic:    KVDB_OPTRACE_MAGIC
+ * @oth_version:  KVDB_OPTRACE_VERSION
+ * @oth_recsz:    size of each record
+ * @oth_start_ns: wall clock time at which the trace started
+ */
+struct kvdb_optrace_hdr_omf {
+    __le32 oth_magic;
+    __le32 oth_version;
+    __le32 oth_recsz;
+    __le32 oth_rsvd;
+    __le64 oth_start_ns;
+} __packed;
+
+OMF_SETGET(struct kvdb_optrace_hdr_omf, oth_magic, 32)
+OMF_SETGET(struct kvdb_optrace_hdr_omf, oth_version, 32)
+OMF_SETGET(struct kvdb_optrace_hdr_omf, oth_recsz, 32)
+OMF_SETGET(struct kvdb_optrace_hdr_omf, oth_start_ns, 64)
+
+/**
+ * struct kvdb_optrace_omf - operation record
+ * @otr_ns:      start time relative to the start of the trace
+ * @otr_op:      enum kvdb_optrace_op
+ * @otr_pfx_len: KVS prefix length covered by @otr_phash
+ * @otr_klen:    key length (prefix length for prefix deletes, prefix
+ *               probes and cursors, key suffix length for cursor
+ *               predicates)
+ * @otr_kvs:     KVS id (see struct kvdb_optrace_kvs_omf)
+ * @otr_tid:     id of the calling thread
+ * @otr_lat_ns:  latency, saturated at U32_MAX
+ * @otr_vlen:    value length (put, and get, cursor read or prefix probe
+ *               if found), bytes returned by a cursor batch read, or
+ *               the value length limit of a cursor predicate
+ * @otr_err:     errno of the result
+ * @otr_ctx:     id of the transaction the op ran in (or, for cursor ops,
+ *               of the cursor), zero if none
+ * @otr_khash:   hash of the key
+ * @otr_phash:   hash of the first @otr_pfx_len bytes of the key
+ */
+struct kvdb_optrace_omf {
+    __le64 otr_ns;
+    u8     otr_op;
+    u8     otr_pfx_len;
+    __le16 otr_klen;
+    __le32 otr_kvs;
+    __le32 otr_tid;
+    __le32 otr_lat_ns;
+    __le32 otr_vlen;
+    __le32 otr_err;
+    __le64 otr_ctx;
+    __le64 otr_khash;
+    __le64 otr_phash;
+} __packed;
+
+OMF_SETGET(struct kvdb_optrace_omf, otr_ns, 64)
+OMF_SETGET(struct kvdb_optrace_omf, otr_op, 8)
+OMF_SETGET(struct kvdb_optrace_omf, otr_pfx_len, 8)
+OMF_SETGET(struct kvdb_optrace_omf, otr_klen, 16)
+OMF_SETGET(struct kvdb_optrace_omf, otr_kvs, 32)
+OMF_SETGET(struct kvdb_optrace_omf, otr_tid, 32)
+OMF_SETGET(struct kvdb_optrace_omf, otr_lat_ns, 32)
+OMF_SETGET(struct kvdb_optrace_omf, otr_vlen, 32)
+OMF_SETGET(struct kvdb_optrace_omf, otr_err, 32)
+OMF_SETGET(struct kvdb_optrace_omf, otr_ctx, 64)
+OMF_SETGET(struct kvdb_optrace_omf, otr_khash, 64)
+OMF_SETGET(struct kvdb_optrace_omf, otr_phash, 64)
+
+/**
+ * struct kvdb_optrace_kvs_omf - KVS record, written when a KVS is opened
+ * @otk_ns:   time relative to the start of the trace
+ * @otk_op:   KVDB_OPTRACE_KVS
+ * @otk_kvs:  id by which operation records refer to this KVS
+ * @otk_name: KVS name (NUL terminated)
+ */
+struct kvdb_optrace_kvs_omf {
+    __le64 otk_ns;
+    u8     otk_op;
+    u8     otk_pfx_len;
+    __le16 otk_rsvd;
+    __le32 otk_kvs;
+    char   otk_name[40];
+} __packed;
+
+OMF_SETGET(struct kvdb_optrace_kvs_omf, otk_ns, 64)
+OMF_SETGET(struct kvdb_optrace_kvs_omf, otk_op, 8)
+OMF_SETGET(struct kvdb_optrace_kvs_omf, otk_pfx_len, 8)
+OMF_SETGET(struct kvdb_optrace_kvs_omf, otk_kvs, 32)
+
+struct kvdb_optrace;
+
+/**
+ * kvdb_optrace_create() - start tracing operations to a file
+ * @path:  trace file, truncated if it exists
+ * @bufsz: total buffer space; records that arrive while all of it is
+ *         waiting to be written are dropped (and counted)
+ * @otp:   (output) trace handle
+ */
+merr_t
+kvdb_optrace_create(const char *path, size_t bufsz, struct kvdb_optrace **otp);
+
+/**
+ * kvdb_optrace_destroy() - flush all buffered records and close the trace
+ * @ot: trace handle (may be NULL)
+ */
+void
+kvdb_optrace_destroy(struct kvdb_optrace *ot);
+
+/**
+ * kvdb_optrace_kvs() - record the name of a KVS
+ * @ot:      trace handle
+ * @kvs:     KVS id
+ * @pfx_len: KVS prefix length
+ * @name:    KVS name
+ */
+void
+kvdb_optrace_kvs(struct kvdb_optrace *ot, u32 kvs, u32 pfx_len, const char *name);
+
+/**
+ * kvdb_optrace_op() - record an operation
+ * @ot:      trace handle
+ * @op:      operation
+ * @kvs:     KVS id (zero for transaction ops)
+ * @pfx_len: KVS prefix length
+ * @ctx:     transaction or cursor handle (may be NULL)
+ * @key:     key, prefix or seek key (may be NULL)
+ * @klen:    length of @key
+ * @vlen:    length of the value put or found
+ * @tstart:  get_time_ns() when the operation started
+ * @err:     operation status
+ */
+void
+kvdb_optrace_op(
+    struct kvdb_optrace *ot,
+    enum kvdb_optrace_op op,
+    u32                  kvs,
+    u32                  pfx_len,
+    const void *         ctx,
+    const void *         key,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err);
+
+#endif
@@ -7,6 +7,7 @@
 #define HSE_KVDB_RPARAMS_H
 
 #include <hse_ikvdb/throttle.h>
+#include <hse_ikvdb/kvdb_optrace.h>
 
 #include <stddef.h>
 #include <stdint.h>
@@ -25,6 +26,11 @@
  * @txn_wkth_delay:        delay (msecs) to invoke transaction worker thread
  * @cndb_entries:     max number of entries CNDB's in memory structures. Note
  *                    that this does not affect the MDC's size.
+ * @optrace_path:     if set, trace API operations to this file
+ * @optrace_bufsz:    operation trace buffer size (bytes)
+ * @slowop_ns:        keep KVS operations at least this slow (0: disable)
+ * @slowop_pct:       percentage of KVS operations checked for slowness
+ * @flightrec_sigdump: dump the flight recorder to stderr on fatal signals
  *
  * The following tunable parameters can have a major impact on the way KVDB
  * operates.  Test thoroughly after any modifications.
@@ -69,6 +75,12 @@ struct kvdb_rparams {
     unsigned long csched_leaf_comp_params;
     unsigned long csched_leaf_len_params;
     unsigned long csched_node_min_ttl;
+    unsigned long csched_io_rate;
+    unsigned long csched_io_leaf_pct;
+    unsigned long csched_io_lat_tgt;
+    unsigned long csched_rheat_min;
+    unsigned long csched_tier_params;
+    unsigned long csched_sts_steal;
 
     unsigned long dur_enable;
     unsigned long dur_intvl_ms;
@@ -86,6 +98,7 @@ struct kvdb_rparams {
     unsigned long throttle_sleep_min_ns;
     unsigned long throttle_burst;
     unsigned long throttle_rate;
+    unsigned int  throttle_fair_share;
     char          throttle_init_policy[THROTTLE_INIT_POLICY_NAME_LEN_MAX];
 
     /* The following fields are typically only accessed by kvdb open
@@ -104,6 +117,12 @@ struct kvdb_rparams {
     unsigned int  low_mem;
     unsigned int  excl;
 
+    unsigned long optrace_bufsz;
+    char          optrace_path[KVDB_OPTRACE_PATH_LEN_MAX];
+    unsigned long slowop_ns;
+    unsigned int  slowop_pct;
+    unsigned int  flightrec_sigdump;
+
     unsigned int rpmagic;
 };
 
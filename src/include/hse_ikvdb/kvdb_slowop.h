@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVDB_SLOWOP_H
+#define HSE_KVDB_SLOWOP_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/timing.h>
+
+#include <hse/hse_limits.h>
+
+#include <hse_ikvdb/kvdb_optrace.h>
+
+/*
+ * The slow operation log keeps the most recent KVS operations that took
+ * longer than a threshold (kvdb rparam slowop_ns), each with a breakdown
+ * of where its time went.
+ *
+ * While a sampled operation runs, the layers it passes through add their
+ * stage times and counts to a thread-local struct kvdb_slowop_stats.  No
+ * clock is read for operations that are not sampled.  When the operation
+ * completes, its record is kept only if it was slow.
+ */
+
+#define KVDB_SLOWOP_RECS_MAX 256
+
+/* Operations stop logging (but are still kept) if more than one arrives
+ * within this many nanoseconds of the last one logged.
+ */
+#define KVDB_SLOWOP_LOG_NS (1000ul * 1000 * 1000)
+
+/**
+ * enum kvdb_slowop_stage - where an operation's time went
+ * @KVDB_SLOWOP_C0:       c0 (or transaction) lookup or insert
+ * @KVDB_SLOWOP_CN:       cn tree lookup, including value reads
+ * @KVDB_SLOWOP_VREAD:    reading uncompressed values from vblocks
+ * @KVDB_SLOWOP_DECOMP:   reading and decompressing compressed values
+ * @KVDB_SLOWOP_COMP:     value compression (puts)
+ * @KVDB_SLOWOP_THROTTLE: throttle and quota delay (puts)
+ */
+enum kvdb_slowop_stage {
+    KVDB_SLOWOP_C0,
+    KVDB_SLOWOP_CN,
+    KVDB_SLOWOP_VREAD,
+    KVDB_SLOWOP_DECOMP,
+    KVDB_SLOWOP_COMP,
+    KVDB_SLOWOP_THROTTLE,
+    KVDB_SLOWOP_STAGE_MAX,
+};
+
+/**
+ * struct kvdb_slowop_stats - per-operation stage breakdown
+ * @ss_active:    true while a sampled operation is in progress
+ * @ss_ns:        time spent in each stage
+ * @ss_kvsets:    kvsets probed in cn
+ * @ss_depth:     cn tree levels descended
+ * @ss_bloom_neg: kblocks skipped by their bloom filters
+ * @ss_vreads:    values read from vblocks
+ * @ss_vbytes:    on-media bytes of the values read from vblocks
+ *
+ * A vblock read that takes far longer than its size suggests usually
+ * means its pages had to be faulted in.
+ */
+struct kvdb_slowop_stats {
+    bool ss_active;
+    u64  ss_ns[KVDB_SLOWOP_STAGE_MAX];
+    u32  ss_kvsets;
+    u32  ss_depth;
+    u32  ss_bloom_neg;
+    u32  ss_vreads;
+    u64  ss_vbytes;
+};
+
+extern __thread struct kvdb_slowop_stats kvdb_slowop_tls;
+
+/**
+ * kvdb_slowop_stage_start() - start timing a stage
+ *
+ * Return: get_time_ns() if a sampled operation is in progress, else 0
+ */
+static __always_inline u64
+kvdb_slowop_stage_start(void)
+{
+    return kvdb_slowop_tls.ss_active ? get_time_ns() : 0;
+}
+
+/**
+ * kvdb_slowop_stage_end() - charge the time since @tstart to @stage
+ * @stage:  stage
+ * @tstart: time returned by kvdb_slowop_stage_start()
+ */
+static __always_inline void
+kvdb_slowop_stage_end(enum kvdb_slowop_stage stage, u64 tstart)
+{
+    if (tstart)
+        kvdb_slowop_tls.ss_ns[stage] += get_time_ns() - tstart;
+}
+
+/**
+ * struct kvdb_slowop_rec - one slow operation
+ * @sr_time_ns: wall clock time at which the operation started
+ * @sr_lat_ns:  latency
+ * @sr_op:      enum kvdb_optrace_op
+ * @sr_err:     errno of the result
+ * @sr_klen:    key length
+ * @sr_vlen:    value length
+ * @sr_tid:     id of the calling thread
+ * @sr_kvs:     KVS name
+ * @sr_stats:   stage breakdown
+ */
+struct kvdb_slowop_rec {
+    u64                      sr_time_ns;
+    u64                      sr_lat_ns;
+    u32                      sr_op;
+    u32                      sr_err;
+    u32                      sr_klen;
+    u32                      sr_vlen;
+    u32                      sr_tid;
+    char                     sr_kvs[HSE_KVS_NAME_LEN_MAX];
+    struct kvdb_slowop_stats sr_stats;
+};
+
+struct kvdb_slowop;
+
+/**
+ * kvdb_slowop_create() - create a slow operation log
+ * @thresh_ns: operations at least this slow are recorded
+ * @pct:       percentage of operations to sample
+ * @name:      kvdb name, for log messages
+ * @sop:       (output) slow operation log
+ */
+merr_t
+kvdb_slowop_create(u64 thresh_ns, uint pct, const char *name, struct kvdb_slowop **sop);
+
+/**
+ * kvdb_slowop_destroy() - destroy a slow operation log
+ * @so: slow operation log (may be NULL)
+ */
+void
+kvdb_slowop_destroy(struct kvdb_slowop *so);
+
+/**
+ * kvdb_slowop_begin() - decide whether to sample an operation
+ * @so: slow operation log
+ *
+ * Return: true if the calling thread's next operation is sampled, in
+ * which case kvdb_slowop_end() must be called when it completes
+ */
+bool
+kvdb_slowop_begin(struct kvdb_slowop *so);
+
+/**
+ * kvdb_slowop_end() - finish a sampled operation, keeping it if slow
+ * @so:     slow operation log
+ * @op:     operation
+ * @kvs:    KVS name
+ * @klen:   key length
+ * @vlen:   value length
+ * @tstart: get_time_ns() when the operation started
+ * @err:    operation status
+ */
+void
+kvdb_slowop_end(
+    struct kvdb_slowop * so,
+    enum kvdb_optrace_op op,
+    const char *         kvs,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err);
+
+/**
+ * kvdb_slowop_get() - copy out the most recent slow operations
+ * @so:    slow operation log
+ * @recv:  (output) records, newest first
+ * @recc:  capacity of @recv
+ * @seenp: (output) slow operations seen since the log was created
+ *
+ * Return: number of records copied
+ */
+uint
+kvdb_slowop_get(struct kvdb_slowop *so, struct kvdb_slowop_rec *recv, uint recc, u64 *seenp);
+
+/**
+ * kvdb_slowop_op_name() - name of a KVS operation
+ * @op: operation
+ */
+const char *
+kvdb_slowop_op_name(enum kvdb_optrace_op op);
+
+/**
+ * kvdb_slowop_stage_name() - name of a stage
+ * @stage: stage
+ */
+const char *
+kvdb_slowop_stage_name(enum kvdb_slowop_stage stage);
+
+#endif
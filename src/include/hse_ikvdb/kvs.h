@@ -42,6 +42,64 @@ struct kc_filter {
     size_t      kcf_maxklen;
 };
 
+/**
+ * struct kc_pred - cursor scan predicate
+ * @kcp_ksfx:    required key suffix (NULL if none)
+ * @kcp_ksfxlen: length of @kcp_ksfx
+ * @kcp_vlenmax: max value length (0 if unlimited)
+ * @kcp_vpat:    required value bytes at offset @kcp_vpatoff (NULL if none)
+ * @kcp_vpatlen: length of @kcp_vpat
+ * @kcp_vpatoff: offset in the value at which @kcp_vpat must appear
+ *
+ * Records that fail the predicate are skipped by the cursor.  The key
+ * and value length checks are applied in cn before the value is fetched
+ * from its vblock.  Tombstones are never rejected, as they must still
+ * hide older values.
+ */
+struct kc_pred {
+    const void *kcp_ksfx;
+    uint        kcp_ksfxlen;
+    uint        kcp_vlenmax;
+    const void *kcp_vpat;
+    uint        kcp_vpatlen;
+    uint        kcp_vpatoff;
+};
+
+static inline bool
+kc_pred_active(const struct kc_pred *pred)
+{
+    return pred->kcp_ksfxlen || pred->kcp_vlenmax || pred->kcp_vpatlen;
+}
+
+static inline bool
+kc_pred_key(const struct kc_pred *pred, const void *key, uint klen)
+{
+    if (!pred->kcp_ksfxlen)
+        return true;
+
+    return klen >= pred->kcp_ksfxlen &&
+           !memcmp(key + klen - pred->kcp_ksfxlen, pred->kcp_ksfx, pred->kcp_ksfxlen);
+}
+
+static inline bool
+kc_pred_vlen(const struct kc_pred *pred, uint vlen)
+{
+    return !pred->kcp_vlenmax || vlen <= pred->kcp_vlenmax;
+}
+
+static inline bool
+kc_pred_val(const struct kc_pred *pred, const void *val, uint vlen)
+{
+    if (!kc_pred_vlen(pred, vlen))
+        return false;
+
+    if (!pred->kcp_vpatlen)
+        return true;
+
+    return vlen >= pred->kcp_vpatoff + pred->kcp_vpatlen &&
+           !memcmp(val + pred->kcp_vpatoff, pred->kcp_vpat, pred->kcp_vpatlen);
+}
+
 struct hse_kvs_cursor {
     struct perfc_set *     kc_pkvsl_pc;
     struct kvdb_kvs *      kc_kvs;
@@ -53,6 +111,7 @@ struct hse_kvs_cursor {
     merr_t                 kc_err;
     atomic_t *             kc_cursor_cnt;
     struct kc_filter       kc_filter;
+    struct kc_pred         kc_pred;
     void                  *kc_viewcookie;
 };
 
@@ -146,6 +205,41 @@ ikvs_cursor_update(struct hse_kvs_cursor *cursor, u64 seqno);
 merr_t
 ikvs_cursor_read(struct hse_kvs_cursor *cursor, struct kvs_kvtuple *kvt, bool *eof);
 
+/**
+ * ikvs_cursor_read_batch() - read up to @kvtmax key/value pairs
+ * @cursor: cursor handle
+ * @buf:    buffer into which keys and values are copied
+ * @bufsz:  size of @buf
+ * @kvtv:   vector of tuples describing the pairs copied into @buf
+ * @kvtmax: max elements in @kvtv
+ * @kvtc:   (output) number of pairs returned in @kvtv
+ * @eof:    (output) true if cursor reached eof
+ *
+ * Returns ENOSPC if the next pair does not fit in @buf, in which
+ * case the cursor is not advanced.
+ */
+merr_t
+ikvs_cursor_read_batch(
+    struct hse_kvs_cursor *cursor,
+    void *                 buf,
+    size_t                 bufsz,
+    struct kvs_kvtuple *   kvtv,
+    uint                   kvtmax,
+    uint *                 kvtc,
+    bool *                 eof);
+
+/**
+ * ikvs_cursor_pred_set() - set or clear the cursor's scan predicate
+ * @cursor: cursor handle
+ * @pred:   predicate (NULL to clear)
+ *
+ * The predicate's key suffix and value pattern are referenced, not
+ * copied, and must remain valid until the predicate is cleared or
+ * the cursor is destroyed.
+ */
+void
+ikvs_cursor_pred_set(struct hse_kvs_cursor *cursor, const struct kc_pred *pred);
+
 void
 ikvs_cursor_tombspan_check(struct hse_kvs_cursor *handle);
 
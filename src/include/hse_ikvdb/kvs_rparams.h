@@ -40,6 +40,10 @@ struct kvs_rparams {
     unsigned long cn_compact_kblk_ra;
     unsigned long cn_compact_vblk_ra;
     unsigned long cn_compact_vra;
+    unsigned long cn_compact_subc;
+    unsigned long cn_compact_subc_min;
+    unsigned long cn_compact_tiered;
+    unsigned long cn_ingest_partition;
 
     unsigned long cn_node_size_lo;
     unsigned long cn_node_size_hi;
@@ -48,8 +52,12 @@ struct kvs_rparams {
     unsigned long cn_capped_vra;
 
     unsigned long cn_cursor_vra;
+    unsigned long cn_cursor_vra_max;
+    unsigned long cn_cursor_ra_qdepth;
     unsigned long cn_cursor_kra;
     unsigned long cn_cursor_seq;
+    unsigned long cn_cursor_par;
+    unsigned long cn_cursor_parmin;
 
     unsigned long cn_mcache_wbt;
     unsigned long cn_mcache_vmin;
@@ -64,6 +72,7 @@ struct kvs_rparams {
     unsigned long cn_bloom_prob;
     unsigned long cn_bloom_capped;
     unsigned long cn_bloom_preload;
+    unsigned long cn_bloom_pfx;
 
     unsigned long cn_verify;
     unsigned long cn_kcachesz;
@@ -71,6 +80,10 @@ struct kvs_rparams {
     unsigned long vblock_size_mb;
 
     unsigned long capped_evict_ttl;
+    unsigned long kvs_ttl;
+
+    unsigned long throttle_put_rate;
+    unsigned long throttle_weight;
 
     unsigned long c1_vblock_cap;
     unsigned long c1_vblock_size_mb;
@@ -13,6 +13,7 @@
 #include <hse_ikvdb/blk_list.h>
 #include <hse_ikvdb/omf_kmd.h>
 #include <hse_ikvdb/mclass_policy.h>
+#include <hse_ikvdb/csched.h>
 
 #include <mpool/mpool.h>
 
@@ -25,6 +26,20 @@ struct cn_merge_stats;
 #define KVSET_BUILDER_FLAGS_NONE    (0)
 #define KVSET_BUILDER_FLAGS_SPARE   (1u << 0)
 #define KVSET_BUILDER_FLAGS_INGEST  (1u << 2) /* from c0 or c1, to cn root node */
+#define KVSET_BUILDER_FLAGS_ROOT    (1u << 3) /* compaction of cn root node */
+
+/**
+ * kvset_builder_io_class() - media I/O priority class of a builder
+ * @flags: KVSET_BUILDER_FLAGS_*
+ */
+static inline enum csched_io_class
+kvset_builder_io_class(uint flags)
+{
+    if (flags & KVSET_BUILDER_FLAGS_INGEST)
+        return CSCHED_IO_INGEST;
+
+    return (flags & KVSET_BUILDER_FLAGS_ROOT) ? CSCHED_IO_ROOT : CSCHED_IO_LEAF;
+}
 
 /* MTF_MOCK_DECL(kvset_builder) */
 /* MTF_MOCK */
@@ -111,6 +126,34 @@ kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_ag
 void
 kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats *stats);
 
+/**
+ * kvset_builder_create_sub() - create a builder for one key range of @self
+ * @self:    parent builder
+ * @sub_out: sub-builder (output)
+ *
+ * A sub-builder writes its own kblocks but appends values to the parent's
+ * vblocks, so several sub-builders may be filled concurrently with disjoint,
+ * ascending key ranges.  Prefix tombstones are not supported.  The caller
+ * must join the sub-builders with kvset_builder_join() before retrieving the
+ * parent's mblocks, and must destroy each sub-builder before the parent.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_create_sub(struct kvset_builder *self, struct kvset_builder **sub_out);
+
+/**
+ * kvset_builder_join() - adopt the kblocks of a set of sub-builders
+ * @self: parent builder (no keys may have been added to it)
+ * @subv: sub-builders of @self, in ascending key range order
+ * @subc: number of sub-builders in @subv
+ *
+ * If the join fails, @self may hold the kblocks of some of the sub-builders.
+ * It can then only be destroyed, kvset_builder_get_mblocks() fails.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_join(struct kvset_builder *self, struct kvset_builder **subv, uint subc);
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "kvset_builder_ut.h"
 #endif /* HSE_UNIT_TEST_MODE */
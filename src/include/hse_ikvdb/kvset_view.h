@@ -26,12 +26,50 @@ struct kvset_metrics {
     u32 vgroups;
 };
 
+/**
+ * enum kvset_heat_ctr - read activity counters of a kvset or cn tree node
+ * @KVSET_HEAT_GETS:      gets (and prefix probes) that searched it
+ * @KVSET_HEAT_BLOOM_NEG: kblock probes ruled out by a bloom filter
+ * @KVSET_HEAT_BLOOM_FP:  bloom filter hits on keys not in the kblock
+ * @KVSET_HEAT_WBT_PAGES: wbtree pages touched by gets
+ * @KVSET_HEAT_CURSORS:   cursors created over it
+ *
+ * For a node, gets and cursors count operations that searched at least
+ * one of its kvsets, while the bloom and wbtree counters are the sums
+ * over every kvset the node has held, including those since compacted.
+ */
+enum kvset_heat_ctr {
+    KVSET_HEAT_GETS,
+    KVSET_HEAT_BLOOM_NEG,
+    KVSET_HEAT_BLOOM_FP,
+    KVSET_HEAT_WBT_PAGES,
+    KVSET_HEAT_CURSORS,
+    KVSET_HEAT_MAX,
+};
+
+struct kvset_heat {
+    u64 kh_ctrv[KVSET_HEAT_MAX];
+};
+
 /* MTF_MOCK_DECL(kvset_view) */
 
 /* MTF_MOCK */
 void
 kvset_get_metrics(struct kvset *kvset, struct kvset_metrics *metrics);
 
+/**
+ * kvset_get_heat() - get the read activity counters of a kvset
+ */
+/* MTF_MOCK */
+void
+kvset_get_heat(struct kvset *kvset, struct kvset_heat *heat);
+
+/**
+ * kvset_heat_name() - name of a read activity counter
+ */
+const char *
+kvset_heat_name(enum kvset_heat_ctr ctr);
+
 /**
  * kvset_get_num_kblocks() - Get number of kblocks in kvset
  */
@@ -68,9 +106,13 @@ kvset_get_dgen(struct kvset *kvset);
 u64
 kvset_get_seqno_max(struct kvset *kvset);
 
+/* For node entries (kvset is NULL) cn_tree_view_create() also fills
+ * in node_heat, the read activity of the node.
+ */
 struct kvset_view {
     struct kvset *     kvset;
     struct cn_node_loc node_loc;
+    struct kvset_heat  node_heat;
 };
 
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
@@ -23,6 +23,11 @@ struct kvdb_rparams;
 
 #define STS_QUEUES_MAX 5
 
+/* Queue numbers double as priority classes: when a worker has no work
+ * in its own queue (see csched_sts_steal), it looks for jobs in the
+ * other queues in increasing queue number order.
+ */
+
 typedef void
 sts_job_fn(struct sts_job *job);
 typedef void
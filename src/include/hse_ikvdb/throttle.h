@@ -41,6 +41,20 @@ enum {
 #define THROTTLE_SENSOR_SCALE 1000
 #define THROTTLE_MAX_RUN 6
 
+/* Feedback controller settings for throttle_init_policy "pid".
+ * Setpoints are in sensor units, gains are per unit of
+ * THROTTLE_SENSOR_SCALE error, and the step limits bound the
+ * fractional change in delay per update.
+ */
+#define THROTTLE_PID_SETPOINT_C0SK   (THROTTLE_SENSOR_SCALE * 80 / 100)
+#define THROTTLE_PID_SETPOINT_CSCHED THROTTLE_SENSOR_SCALE
+#define THROTTLE_PID_HORIZON_MS      500
+#define THROTTLE_PID_SMOOTH_PCT      20
+#define THROTTLE_PID_KP              1.0
+#define THROTTLE_PID_KI              2.0
+#define THROTTLE_PID_STEP_UP_PCT     5
+#define THROTTLE_PID_STEP_DOWN_PCT   2
+
 /**
  * struct throttle_sensor - throttle sensor
  *
@@ -101,6 +115,32 @@ throttle_sensor_get(struct throttle_sensor *ts)
 
 enum throttle_state { THROTTLE_NO_CHANGE, THROTTLE_DECREASE, THROTTLE_INCREASE };
 
+/**
+ * struct throttle_pid - feedback controller state (throttle_init_policy "pid")
+ * @tp_enabled: true if the controller replaces the heuristic state machine
+ * @tp_primed:  true once the sensor averages have been seeded
+ * @tp_err:     control error from the previous update
+ * @tp_delay:   unquantized delay (raw delay units)
+ * @tp_avgv:    smoothed sensor values
+ * @tp_slopev:  smoothed sensor rates of change (sensor units per update)
+ *
+ * Rather than step through trial delays, the controller extrapolates each
+ * sensor THROTTLE_PID_HORIZON_MS into the future from its recent trend
+ * (e.g., c0 fills when ingest outpaces ingest into cn, and the csched
+ * sensor rises as compaction debt accumulates).  The delay is then
+ * adjusted by a proportional-integral step on the worst predicted error,
+ * limited to a few percent per update so that the put rate changes
+ * smoothly.
+ */
+struct throttle_pid {
+    bool   tp_enabled;
+    bool   tp_primed;
+    double tp_err;
+    double tp_delay;
+    double tp_avgv[THROTTLE_SENSOR_CNT];
+    double tp_slopev[THROTTLE_SENSOR_CNT];
+};
+
 /**
  * struct throttle_mavg - throttle mavg
  * @thr_samples   :     array of last THROTTLE_SAMPLE_CNT max sensor values
@@ -148,6 +188,7 @@ struct throttle_mavg {
  * @thr_max_tries:      max number of trials
  * @thr_rp:
  * @thr_perfc:
+ * @thr_pid:            feedback controller state
  * @thr_data:           raw nanosleep performance metrics
  * @thr_sensorv:        vector of throttle sensors
  */
@@ -184,6 +225,7 @@ struct throttle {
     struct kvdb_rparams *thr_rp;
     struct perfc_set     thr_sensor_perfc;
     struct perfc_set     thr_sleep_perfc;
+    struct throttle_pid  thr_pid;
 
     __aligned(SMP_CACHE_BYTES) atomic64_t thr_data;
 
@@ -220,6 +262,22 @@ throttle_debug(struct throttle *self);
 void
 throttle_reduce_debug(struct throttle *self, uint value, uint mavg);
 
+/**
+ * throttle_share() - divide a throttle rate among weighted sharers
+ * @rate:    rate to divide (bytes/sec, at most U64_MAX / 1024)
+ * @shrc:    number of sharers
+ * @demandv: recent rate of each sharer
+ * @weightv: weight of each sharer (at least 1)
+ * @allocv:  (output) rate allotted to each sharer
+ *
+ * Shares are max-min fair by weight: a sharer whose demand is under its
+ * weighted share gets its demand plus headroom to grow, the rest of the
+ * rate is split by weight among the sharers that want more.  The whole
+ * rate is always handed out, and every share is at least 1.
+ */
+void
+throttle_share(u64 rate, uint shrc, const u64 *demandv, const u64 *weightv, u64 *allocv);
+
 static inline
 u64
 throttle_raw_to_rate(unsigned raw_delay)
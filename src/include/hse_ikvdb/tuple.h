@@ -149,6 +149,16 @@ kvs_vtuple_vlen(const struct kvs_vtuple *vt)
     return clen ?: vlen;
 }
 
+/**
+ * kvs_vtuple_ulen() - return uncompressed value length
+ * @vt: ptr to a vtuple
+ */
+static __always_inline uint
+kvs_vtuple_ulen(const struct kvs_vtuple *vt)
+{
+    return vt->vt_xlen & 0xfffffffful;
+}
+
 static __always_inline uint
 kvs_vtuple_clen(const struct kvs_vtuple *vt)
 {
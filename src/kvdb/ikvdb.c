@@ -31,6 +31,8 @@
 #include <hse_ikvdb/rparam_debug_flags.h>
 #include <hse_ikvdb/hse_params_internal.h>
 #include <hse_ikvdb/mclass_policy.h>
+#include <hse_ikvdb/kvdb_optrace.h>
+#include <hse_ikvdb/kvdb_slowop.h>
 #include "kvdb_omf.h"
 
 #include "kvdb_log.h"
@@ -52,6 +54,7 @@
 #include <hse_util/compression_lz4.h>
 #include <hse_util/token_bucket.h>
 #include <hse_util/xrand.h>
+#include <hse_util/flightrec.h>
 
 #include <3rdparty/xxhash.h>
 #include <3rdparty/cJSON.h>
@@ -112,6 +115,8 @@ struct kvdb_ctxn_bkt {
  * @ikdb_log:           KVDB log handle
  * @ikdb_cndb:          CNDB handle
  * @ikdb_workqueue:
+ * @ikdb_optrace:       operation trace (NULL if tracing is disabled)
+ * @ikdb_slowop:        slow operation log (NULL if disabled)
  * @ikdb_curcnt:        number of active cursors
  * @ikdb_curcnt_max:    maximum number of active cursors
  * @ikdb_cur_ticket:    ticket lock ticket dispenser (serializes ikvdb_cur_list access)
@@ -158,6 +163,8 @@ struct ikvdb_impl {
     struct workqueue_struct *ikdb_workqueue;
     struct viewset          *ikdb_txn_viewset;
     struct viewset          *ikdb_cur_viewset;
+    struct kvdb_optrace     *ikdb_optrace;
+    struct kvdb_slowop      *ikdb_slowop;
 
     struct tbkt ikdb_tb __aligned(SMP_CACHE_BYTES * 2);
 
@@ -370,6 +377,60 @@ ikvdb_rate_limit_set(struct ikvdb_impl *self, u64 rate)
     }
 }
 
+/*
+ * ikvdb_rate_limit_share() - divide the throttle rate among open kvses
+ *
+ * With throttle_fair_share set, each kvs's puts are charged against its
+ * own share of the kvdb throttle rate rather than against the kvdb token
+ * bucket, so a kvs that saturates c0 is throttled without stalling every
+ * other kvs.  See throttle_share() for how the rate is divided.
+ */
+static void
+ikvdb_rate_limit_share(struct ikvdb_impl *self, u64 rate, u64 dt)
+{
+    struct kvdb_kvs *kvsv[HSE_KVS_COUNT_MAX];
+    u64              demandv[HSE_KVS_COUNT_MAX];
+    u64              weightv[HSE_KVS_COUNT_MAX];
+    u64              allocv[HSE_KVS_COUNT_MAX];
+    uint             kvsc, i;
+
+    if (!dt)
+        return;
+
+    rate = min_t(u64, rate, U64_MAX / 1024);
+
+    mutex_lock(&self->ikdb_lock);
+
+    kvsc = 0;
+    for (i = 0; i < self->ikdb_kvs_cnt; i++) {
+        struct kvdb_kvs *kk = self->ikdb_kvs_vec[i];
+        u64              bytes;
+
+        if (!kk || !kk->kk_ikvs)
+            continue;
+
+        /* Smooth the observed put rate with an EWMA that weighs each
+         * update by 1/8, i.e., over roughly the last eight throttle
+         * updates (throttle_update_ns apart, plus the task's 10ms tick).
+         */
+        bytes = atomic64_read(&kk->kk_tb_bytes);
+        atomic64_sub(bytes, &kk->kk_tb_bytes);
+        bytes = bytes * NSEC_PER_SEC / dt;
+        kk->kk_tb_demand = (kk->kk_tb_demand * 7 + bytes) / 8;
+
+        demandv[kvsc] = kk->kk_tb_demand;
+        weightv[kvsc] = kk->kk_tb_weight;
+        kvsv[kvsc++] = kk;
+    }
+
+    throttle_share(rate, kvsc, demandv, weightv, allocv);
+
+    for (i = 0; i < kvsc; i++)
+        tbkt_adjust(&kvsv[i]->kk_tb_share, allocv[i] / 2, allocv[i]);
+
+    mutex_unlock(&self->ikdb_lock);
+}
+
 static void
 ikvdb_throttle_task(struct work_struct *work)
 {
@@ -388,6 +449,10 @@ ikvdb_throttle_task(struct work_struct *work)
             u64  rate = throttle_raw_to_rate(raw);
 
             ikvdb_rate_limit_set(self, rate);
+
+            if (self->ikdb_rp.throttle_fair_share && throttle_update_prev)
+                ikvdb_rate_limit_share(self, self->ikdb_tb_rate, tstart - throttle_update_prev);
+
             throttle_update_prev = tstart;
         }
 
@@ -1043,6 +1108,26 @@ ikvdb_open(
 
     ikvdb_init_throttle_params(self);
 
+    if (self->ikdb_rp.optrace_path[0]) {
+        err = kvdb_optrace_create(
+            self->ikdb_rp.optrace_path, self->ikdb_rp.optrace_bufsz, &self->ikdb_optrace);
+        if (err)
+            hse_elog(HSE_WARNING "cannot trace %s operations: @@e", err, mp_name);
+    }
+
+    if (self->ikdb_rp.slowop_ns) {
+        err = kvdb_slowop_create(
+            self->ikdb_rp.slowop_ns, self->ikdb_rp.slowop_pct, mp_name, &self->ikdb_slowop);
+        if (err)
+            hse_elog(HSE_WARNING "cannot log slow %s operations: @@e", err, mp_name);
+    }
+
+    if (self->ikdb_rp.flightrec_sigdump) {
+        err = flightrec_sigdump_install();
+        if (err)
+            hse_elog(HSE_WARNING "%s: cannot dump flight recorder on signals: @@e", err, mp_name);
+    }
+
     return 0;
 
 err1:
@@ -1426,6 +1511,15 @@ ikvdb_kvs_open(
     kvs->kk_seqno = &self->ikdb_seqno;
     kvs->kk_viewset = self->ikdb_cur_viewset;
 
+    kvs->kk_tb_quota_on = rp.throttle_put_rate > 0;
+    if (kvs->kk_tb_quota_on)
+        tbkt_init(&kvs->kk_tb_quota, rp.throttle_put_rate / 2, rp.throttle_put_rate);
+
+    kvs->kk_tb_weight = rp.throttle_weight;
+    kvs->kk_tb_demand = 0;
+    atomic64_set(&kvs->kk_tb_bytes, 0);
+    tbkt_init(&kvs->kk_tb_share, self->ikdb_tb_burst, self->ikdb_tb_rate);
+
     kvs->kk_vcompmin = UINT_MAX;
     cops = vcomp_compress_ops(&rp);
     if (cops) {
@@ -1460,6 +1554,9 @@ ikvdb_kvs_open(
 
     atomic_inc(&kvs->kk_refcnt);
 
+    if (self->ikdb_optrace)
+        kvdb_optrace_kvs(self->ikdb_optrace, kvs->kk_cnid, kvs->kk_cparams->cp_pfx_len, kvs_name);
+
     *kvs_out = (struct hse_kvs *)kvs;
 
 err_out:
@@ -1531,11 +1628,18 @@ ikvdb_close(struct ikvdb *handle)
         destroy_workqueue(self->ikdb_workqueue);
     }
 
+    /* The application is done issuing operations, so the trace is
+     * complete.
+     */
+    kvdb_optrace_destroy(self->ikdb_optrace);
+
     /* Deregistering this url before trying to get ikdb_lock prevents
      * a deadlock between this call and an ongoing call to ikvdb_get_names()
      */
     kvdb_rest_deregister(self->ikdb_mpname);
 
+    kvdb_slowop_destroy(self->ikdb_slowop);
+
     mutex_lock(&self->ikdb_lock);
 
     for (i = 0; i < HSE_KVS_COUNT_MAX; i++) {
@@ -1620,11 +1724,26 @@ ikvdb_close(struct ikvdb *handle)
 
 static
 void
-ikvdb_throttle(struct ikvdb_impl *self, u64 bytes)
+ikvdb_throttle(struct ikvdb_impl *self, struct kvdb_kvs *kk, u64 bytes)
 {
-    u64 sleep_ns;
+    u64 sleep_ns = 0;
+
+    if (kk->kk_tb_quota_on)
+        sleep_ns = tbkt_request(&kk->kk_tb_quota, bytes);
+
+    if (!self->ikdb_rp.throttle_disable) {
+        u64 ns;
+
+        if (self->ikdb_rp.throttle_fair_share) {
+            atomic64_add(bytes, &kk->kk_tb_bytes);
+            ns = tbkt_request(&kk->kk_tb_share, bytes);
+        } else {
+            ns = tbkt_request(&self->ikdb_tb, bytes);
+        }
+
+        sleep_ns = max_t(u64, sleep_ns, ns);
+    }
 
-    sleep_ns = tbkt_request(&self->ikdb_tb, bytes);
     tbkt_delay(sleep_ns);
 
     if (self->ikdb_tb_dbg) {
@@ -1634,6 +1753,82 @@ ikvdb_throttle(struct ikvdb_impl *self, u64 bytes)
     }
 }
 
+u64
+ikvdb_optrace_start(struct ikvdb *handle)
+{
+    return ikvdb_h2r(handle)->ikdb_optrace ? get_time_ns() : 0;
+}
+
+void
+ikvdb_optrace(
+    struct ikvdb *       handle,
+    enum kvdb_optrace_op op,
+    struct hse_kvdb_txn *txn,
+    u64                  tstart,
+    merr_t               err)
+{
+    struct ikvdb_impl *self = ikvdb_h2r(handle);
+
+    if (self->ikdb_optrace)
+        kvdb_optrace_op(self->ikdb_optrace, op, 0, 0, txn, NULL, 0, 0, tstart, err);
+}
+
+u64
+ikvdb_kvs_optrace_start(struct hse_kvs *handle)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *self = kk->kk_parent;
+    bool               sampled;
+
+    sampled = self->ikdb_slowop && kvdb_slowop_begin(self->ikdb_slowop);
+
+    return (sampled || self->ikdb_optrace) ? get_time_ns() : 0;
+}
+
+void
+ikvdb_kvs_optrace(
+    struct hse_kvs *     handle,
+    enum kvdb_optrace_op op,
+    const void *         ctx,
+    const void *         key,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *self = kk->kk_parent;
+
+    if (kvdb_slowop_tls.ss_active)
+        kvdb_slowop_end(self->ikdb_slowop, op, kk->kk_name, klen, vlen, tstart, err);
+
+    if (self->ikdb_optrace)
+        kvdb_optrace_op(
+            self->ikdb_optrace,
+            op,
+            kk->kk_cnid,
+            kk->kk_cparams->cp_pfx_len,
+            ctx,
+            key,
+            klen,
+            vlen,
+            tstart,
+            err);
+}
+
+uint
+ikvdb_slowop_get(struct ikvdb *handle, struct kvdb_slowop_rec *recv, uint recc, u64 *seenp)
+{
+    struct ikvdb_impl *self = ikvdb_h2r(handle);
+
+    if (!self->ikdb_slowop) {
+        *seenp = 0;
+        return 0;
+    }
+
+    return kvdb_slowop_get(self->ikdb_slowop, recv, recc, seenp);
+}
+
 merr_t
 ikvdb_kvs_put(
     struct hse_kvs *         handle,
@@ -1678,7 +1873,10 @@ ikvdb_kvs_put(
         }
 
         if (vbuf) {
+            u64 tstart = kvdb_slowop_stage_start();
+
             err = kk->kk_vcompress(vt->vt_data, vlen, vbuf, vbufsz, &clen);
+            kvdb_slowop_stage_end(KVDB_SLOWOP_COMP, tstart);
 
             if (!err && clen < vlen) {
                 kvs_vtuple_cinit(&vtbuf, vbuf, vlen, clen);
@@ -1700,8 +1898,12 @@ ikvdb_kvs_put(
         return err;
     }
 
-    if (!(kvdb_kop_is_priority(os) || parent->ikdb_rp.throttle_disable))
-        ikvdb_throttle(parent, kt->kt_len + (clen ? clen : vlen));
+    if (!kvdb_kop_is_priority(os)) {
+        u64 tstart = kvdb_slowop_stage_start();
+
+        ikvdb_throttle(parent, kk, kt->kt_len + (clen ? clen : vlen));
+        kvdb_slowop_stage_end(KVDB_SLOWOP_THROTTLE, tstart);
+    }
 
     return 0;
 }
@@ -2279,7 +2481,7 @@ ikvdb_kvs_cursor_seek(
     /* errors on seek are not fatal */
     err = ikvs_cursor_seek(cur, key, (u32)len, limit, (u32)limit_len, kt);
 
-    perfc_lat_record(cur->kc_pkvsl_pc, PERFC_LT_PKVSL_KVS_CURSOR_SEEK, tstart);
+    perfc_lat_record(cur->kc_pkvsl_pc, PERFC_HG_PKVSL_KVS_CURSOR_SEEK, tstart);
 
     return ev(err);
 }
@@ -2332,13 +2534,67 @@ ikvdb_kvs_cursor_read(
 
     perfc_lat_record(
         cur->kc_pkvsl_pc,
-        cur->kc_flags & HSE_KVDB_KOP_FLAG_REVERSE ? PERFC_LT_PKVSL_KVS_CURSOR_READREV
-                                                  : PERFC_LT_PKVSL_KVS_CURSOR_READFWD,
+        cur->kc_flags & HSE_KVDB_KOP_FLAG_REVERSE ? PERFC_HG_PKVSL_KVS_CURSOR_READREV
+                                                  : PERFC_HG_PKVSL_KVS_CURSOR_READFWD,
         tstart);
 
     return 0;
 }
 
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor * cur,
+    struct hse_kvdb_opspec *os,
+    void *                  buf,
+    size_t                  bufsz,
+    struct kvs_kvtuple *    kvtv,
+    uint                    kvtmax,
+    uint *                  kvtc,
+    bool *                  eof)
+{
+    merr_t err;
+    u64    tstart;
+
+    tstart = perfc_lat_start(cur->kc_pkvsl_pc);
+
+    *kvtc = 0;
+
+    if (ev(kvdb_kop_is_txn(os)))
+        return merr(EINVAL);
+
+    if (ev(cur->kc_err)) {
+        if (ev(merr_errno(cur->kc_err) != EAGAIN))
+            return cur->kc_err;
+
+        cur->kc_err = ikvs_cursor_update(cur, cur->kc_seq);
+        if (ev(cur->kc_err))
+            return cur->kc_err;
+    }
+
+    if (cur->kc_bind) {
+        cur->kc_err = cursor_refresh(cur);
+        if (ev(cur->kc_err))
+            return cur->kc_err;
+    }
+
+    err = ikvs_cursor_read_batch(cur, buf, bufsz, kvtv, kvtmax, kvtc, eof);
+    if (err)
+        return err;
+
+    /* A batch is not comparable to a single read, keep it out of the
+     * per-read latency histograms.
+     */
+    perfc_lat_record(cur->kc_pkvsl_pc, PERFC_HG_PKVSL_KVS_CURSOR_READBATCH, tstart);
+
+    return 0;
+}
+
+void
+ikvdb_kvs_cursor_pred_set(struct hse_kvs_cursor *cur, const struct kc_pred *pred)
+{
+    ikvs_cursor_pred_set(cur, pred);
+}
+
 merr_t
 ikvdb_kvs_cursor_destroy(struct hse_kvs_cursor *cur)
 {
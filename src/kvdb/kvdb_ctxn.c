@@ -15,6 +15,8 @@
 #include <hse_util/delay.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/xrand.h>
+#include <hse_util/sdt.h>
+#include <hse_util/flightrec.h>
 
 #include <hse_ikvdb/kvs.h>
 #include <hse_ikvdb/kvdb_ctxn.h>
@@ -560,6 +562,8 @@ kvdb_ctxn_commit(struct kvdb_ctxn *handle)
     u64                     head;
     int                     num_retries;
 
+    HSE_SDT(kvdb_txn_commit_start, handle);
+
     if (ev(!kvdb_ctxn_trylock(ctxn)))
         return merr(EPROTO);
 
@@ -600,6 +604,8 @@ kvdb_ctxn_commit(struct kvdb_ctxn *handle)
         kvdb_ctxn_deactivate(ctxn);
         kvdb_ctxn_unlock(ctxn);
 
+        HSE_SDT(kvdb_txn_commit_done, handle, ctxn->ctxn_view_seqno, 0);
+
         return 0;
     }
 
@@ -638,6 +644,7 @@ retry:
          */
         head = atomic64_inc_acq(ctxn->ctxn_tseqno_head);
         err = c0sk_flush(ctxn->ctxn_c0sk, ctxn->ctxn_kvms);
+        flightrec_add(FLIGHTREC_TXN_FLUSH, c0kvms_gen_read(ctxn->ctxn_kvms), merr_errno(err));
         if (err) {
             atomic_dec(&flush_busy);
             mutex_unlock(&flush_lock);
@@ -848,6 +855,8 @@ retry:
 
     kvdb_ctxn_unlock(ctxn);
 
+    HSE_SDT(kvdb_txn_commit_done, handle, commit_sn, !dst);
+
     return 0;
 }
 
@@ -7,9 +7,11 @@
 #define HSE_IKVDB_KVS_H
 
 #include <hse_util/inttypes.h>
+#include <hse_util/atomic.h>
 #include <hse_util/list.h>
 #include <hse_util/mutex.h>
 #include <hse_util/compression.h>
+#include <hse_util/token_bucket.h>
 
 struct ikvs;
 struct ikvdb_impl;
@@ -28,6 +30,12 @@ struct kvdb_kvs;
  * @kk_flags:        flags for cn.
  * @kk_refcnt:       count of current users of the instance. Used mainly to
  *                   synchronize with rest requests.
+ * @kk_tb_quota_on:  true if puts are limited to throttle_put_rate
+ * @kk_tb_weight:    weight of this kvs's share of the kvdb throttle rate
+ * @kk_tb_demand:    smoothed put rate (bytes/sec), used to compute shares
+ * @kk_tb_bytes:     bytes put since the last share update
+ * @kk_tb_quota:     token bucket for throttle_put_rate
+ * @kk_tb_share:     token bucket for this kvs's share of the throttle rate
  * @kk_name:         kvs name.
  */
 struct kvdb_kvs {
@@ -43,6 +51,14 @@ struct kvdb_kvs {
     u32                     kk_flags;
     atomic_t                kk_refcnt;
 
+    bool       kk_tb_quota_on;
+    u32        kk_tb_weight;
+    u64        kk_tb_demand;
+    atomic64_t kk_tb_bytes;
+
+    struct tbkt kk_tb_quota;
+    struct tbkt kk_tb_share;
+
     char kk_name[HSE_KVS_NAME_LEN_MAX];
 };
 
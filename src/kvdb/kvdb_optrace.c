@@ -0,0 +1,371 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/alloc.h>
+#include <hse_util/atomic.h>
+#include <hse_util/slab.h>
+#include <hse_util/spinlock.h>
+#include <hse_util/workqueue.h>
+#include <hse_util/hash.h>
+#include <hse_util/string.h>
+#include <hse_util/logging.h>
+#include <hse_util/timing.h>
+#include <hse_util/time.h>
+
+#include <hse_ikvdb/kvdb_optrace.h>
+
+#include <fcntl.h>
+#include <syscall.h>
+
+_Static_assert(
+    sizeof(struct kvdb_optrace_omf) == sizeof(struct kvdb_optrace_kvs_omf),
+    "optrace records must be the same size");
+
+#define OPTRACE_RECSZ   sizeof(struct kvdb_optrace_omf)
+#define OPTRACE_BKT_MAX 16
+
+/* The flusher wakes this often to write out whatever has accumulated.
+ */
+#define OPTRACE_FLUSH_US (100 * 1000)
+
+/**
+ * struct optrace_bkt - double-buffered record staging area
+ * @ob_lock:    protects all fields
+ * @ob_active:  buffer receiving new records
+ * @ob_alen:    bytes in @ob_active
+ * @ob_standby: buffer owned by the flusher while @ob_slen is non-zero
+ * @ob_slen:    bytes in @ob_standby waiting to be written
+ * @ob_dropped: records dropped because both buffers were full
+ *
+ * Writers append to the active buffer of the bucket for the cpu they
+ * run on.  When it fills, they swap it with the standby buffer if the
+ * flusher has drained it, else they drop the record.
+ */
+struct optrace_bkt {
+    spinlock_t ob_lock;
+    char *     ob_active;
+    size_t     ob_alen;
+    char *     ob_standby;
+    size_t     ob_slen;
+    u64        ob_dropped;
+} __aligned(SMP_CACHE_BYTES);
+
+/**
+ * struct kvdb_optrace - operation trace
+ * @ot_fd:       trace file
+ * @ot_start_ns: get_time_ns() at the start of the trace
+ * @ot_bufsz:    size of each bucket buffer
+ * @ot_stop:     tells the flusher to exit
+ * @ot_failed:   set when a write fails, stops all tracing
+ * @ot_wq:       flusher workqueue
+ * @ot_work:     flusher
+ * @ot_written:  records written
+ * @ot_mem:      backing memory for all bucket buffers
+ * @ot_path:     trace file name
+ * @ot_bktv:     staging buckets
+ */
+struct kvdb_optrace {
+    int                      ot_fd;
+    u64                      ot_start_ns;
+    size_t                   ot_bufsz;
+    atomic_t                 ot_stop;
+    atomic_t                 ot_failed;
+    struct workqueue_struct *ot_wq;
+    struct work_struct       ot_work;
+    u64                      ot_written;
+    char *                   ot_mem;
+    char                     ot_path[KVDB_OPTRACE_PATH_LEN_MAX];
+
+    struct optrace_bkt ot_bktv[OPTRACE_BKT_MAX];
+};
+
+static __thread u32 optrace_tid;
+
+static void
+optrace_write(struct kvdb_optrace *ot, const void *buf, size_t len)
+{
+    ssize_t cc;
+    merr_t  err;
+
+    while (len > 0 && !atomic_read(&ot->ot_failed)) {
+        cc = write(ot->ot_fd, buf, len);
+        if (cc < 0) {
+            if (errno == EINTR)
+                continue;
+
+            err = merr(errno);
+            hse_elog(HSE_ERR "%s: cannot write %s, tracing stopped: @@e",
+                     err, __func__, ot->ot_path);
+            atomic_set(&ot->ot_failed, 1);
+            break;
+        }
+
+        buf += cc;
+        len -= cc;
+    }
+}
+
+/* Write out the standby buffer of each bucket, first swapping in the
+ * active buffer if the standby buffer is empty.  With @drain set, also
+ * write out the active buffer, which is only safe once writers are done.
+ */
+static void
+optrace_flush(struct kvdb_optrace *ot, bool drain)
+{
+    int i;
+
+    for (i = 0; i < OPTRACE_BKT_MAX; i++) {
+        struct optrace_bkt *bkt = ot->ot_bktv + i;
+        char *              buf;
+        size_t              len;
+
+        spin_lock(&bkt->ob_lock);
+        if (!bkt->ob_slen && bkt->ob_alen) {
+            buf = bkt->ob_standby;
+            bkt->ob_standby = bkt->ob_active;
+            bkt->ob_slen = bkt->ob_alen;
+            bkt->ob_active = buf;
+            bkt->ob_alen = 0;
+        }
+        buf = bkt->ob_standby;
+        len = bkt->ob_slen;
+        spin_unlock(&bkt->ob_lock);
+
+        if (len) {
+            optrace_write(ot, buf, len);
+            ot->ot_written += len / OPTRACE_RECSZ;
+
+            spin_lock(&bkt->ob_lock);
+            bkt->ob_slen = 0;
+            spin_unlock(&bkt->ob_lock);
+        }
+
+        /* On close, the active buffer may still hold records. */
+        if (drain && bkt->ob_alen) {
+            optrace_write(ot, bkt->ob_active, bkt->ob_alen);
+            ot->ot_written += bkt->ob_alen / OPTRACE_RECSZ;
+            bkt->ob_alen = 0;
+        }
+    }
+}
+
+static void
+optrace_flush_task(struct work_struct *work)
+{
+    struct kvdb_optrace *ot;
+
+    ot = container_of(work, struct kvdb_optrace, ot_work);
+
+    while (!atomic_read(&ot->ot_stop)) {
+        optrace_flush(ot, false);
+        usleep(OPTRACE_FLUSH_US);
+    }
+}
+
+merr_t
+kvdb_optrace_create(const char *path, size_t bufsz, struct kvdb_optrace **otp)
+{
+    struct kvdb_optrace_hdr_omf hdr;
+    struct kvdb_optrace *       ot;
+    struct timespec             ts;
+    merr_t                      err;
+    char *                      mem;
+    int                         i;
+
+    if (ev(!path || !otp))
+        return merr(EINVAL);
+
+    /* Two buffers per bucket, each holding a whole number of records. */
+    bufsz /= OPTRACE_BKT_MAX * 2;
+    bufsz -= bufsz % OPTRACE_RECSZ;
+    if (bufsz < OPTRACE_RECSZ * 64)
+        bufsz = OPTRACE_RECSZ * 64;
+
+    ot = alloc_aligned(sizeof(*ot), __alignof(*ot));
+    if (ev(!ot))
+        return merr(ENOMEM);
+
+    memset(ot, 0, sizeof(*ot));
+    strlcpy(ot->ot_path, path, sizeof(ot->ot_path));
+    ot->ot_bufsz = bufsz;
+    ot->ot_fd = -1;
+
+    mem = ot->ot_mem = malloc(bufsz * OPTRACE_BKT_MAX * 2);
+    if (ev(!mem)) {
+        err = merr(ENOMEM);
+        goto errout;
+    }
+
+    for (i = 0; i < OPTRACE_BKT_MAX; i++) {
+        struct optrace_bkt *bkt = ot->ot_bktv + i;
+
+        spin_lock_init(&bkt->ob_lock);
+        bkt->ob_active = mem + bufsz * (i * 2);
+        bkt->ob_standby = mem + bufsz * (i * 2 + 1);
+    }
+
+    ot->ot_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (ot->ot_fd == -1) {
+        err = merr(errno);
+        hse_elog(HSE_ERR "%s: cannot create %s: @@e", err, __func__, path);
+        goto errout;
+    }
+
+    ot->ot_start_ns = get_time_ns();
+
+    omf_set_oth_magic(&hdr, KVDB_OPTRACE_MAGIC);
+    omf_set_oth_version(&hdr, KVDB_OPTRACE_VERSION);
+    omf_set_oth_recsz(&hdr, OPTRACE_RECSZ);
+    hdr.oth_rsvd = 0;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    omf_set_oth_start_ns(&hdr, ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec);
+
+    optrace_write(ot, &hdr, sizeof(hdr));
+    if (atomic_read(&ot->ot_failed)) {
+        err = merr(EIO);
+        goto errout;
+    }
+
+    ot->ot_wq = alloc_workqueue("kvdb_optrace", 0, 1);
+    if (ev(!ot->ot_wq)) {
+        err = merr(ENOMEM);
+        goto errout;
+    }
+
+    INIT_WORK(&ot->ot_work, optrace_flush_task);
+    queue_work(ot->ot_wq, &ot->ot_work);
+
+    hse_log(HSE_NOTICE "%s: tracing operations to %s", __func__, path);
+
+    *otp = ot;
+
+    return 0;
+
+errout:
+    if (ot->ot_fd != -1)
+        close(ot->ot_fd);
+    free(ot->ot_mem);
+    free_aligned(ot);
+
+    return err;
+}
+
+void
+kvdb_optrace_destroy(struct kvdb_optrace *ot)
+{
+    u64 dropped = 0;
+    int i;
+
+    if (!ot)
+        return;
+
+    atomic_set(&ot->ot_stop, 1);
+    destroy_workqueue(ot->ot_wq);
+
+    optrace_flush(ot, true);
+
+    for (i = 0; i < OPTRACE_BKT_MAX; i++)
+        dropped += ot->ot_bktv[i].ob_dropped;
+
+    hse_log(
+        HSE_NOTICE "%s: %s: %lu records written, %lu dropped",
+        __func__,
+        ot->ot_path,
+        (ulong)ot->ot_written,
+        (ulong)dropped);
+
+    close(ot->ot_fd);
+    free(ot->ot_mem);
+    free_aligned(ot);
+}
+
+static void
+optrace_append(struct kvdb_optrace *ot, const void *rec)
+{
+    struct optrace_bkt *bkt;
+    char *              buf;
+
+    if (atomic_read(&ot->ot_failed))
+        return;
+
+    bkt = ot->ot_bktv + (raw_smp_processor_id() % OPTRACE_BKT_MAX);
+
+    spin_lock(&bkt->ob_lock);
+    if (bkt->ob_alen + OPTRACE_RECSZ > ot->ot_bufsz) {
+        if (bkt->ob_slen) {
+            bkt->ob_dropped++;
+            spin_unlock(&bkt->ob_lock);
+            return;
+        }
+
+        buf = bkt->ob_standby;
+        bkt->ob_standby = bkt->ob_active;
+        bkt->ob_slen = bkt->ob_alen;
+        bkt->ob_active = buf;
+        bkt->ob_alen = 0;
+    }
+
+    memcpy(bkt->ob_active + bkt->ob_alen, rec, OPTRACE_RECSZ);
+    bkt->ob_alen += OPTRACE_RECSZ;
+    spin_unlock(&bkt->ob_lock);
+}
+
+void
+kvdb_optrace_kvs(struct kvdb_optrace *ot, u32 kvs, u32 pfx_len, const char *name)
+{
+    struct kvdb_optrace_kvs_omf rec;
+
+    memset(&rec, 0, sizeof(rec));
+    omf_set_otk_ns(&rec, get_time_ns() - ot->ot_start_ns);
+    omf_set_otk_op(&rec, KVDB_OPTRACE_KVS);
+    omf_set_otk_pfx_len(&rec, pfx_len);
+    omf_set_otk_kvs(&rec, kvs);
+    strlcpy(rec.otk_name, name, sizeof(rec.otk_name));
+
+    optrace_append(ot, &rec);
+}
+
+void
+kvdb_optrace_op(
+    struct kvdb_optrace *ot,
+    enum kvdb_optrace_op op,
+    u32                  kvs,
+    u32                  pfx_len,
+    const void *         ctx,
+    const void *         key,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err)
+{
+    struct kvdb_optrace_omf rec;
+    u64                     lat;
+
+    if (unlikely(!optrace_tid))
+        optrace_tid = syscall(SYS_gettid);
+
+    lat = get_time_ns() - tstart;
+
+    if (!key)
+        klen = 0;
+    if (pfx_len > klen)
+        pfx_len = 0;
+
+    omf_set_otr_ns(&rec, tstart - ot->ot_start_ns);
+    omf_set_otr_op(&rec, op);
+    omf_set_otr_pfx_len(&rec, pfx_len);
+    omf_set_otr_klen(&rec, klen);
+    omf_set_otr_kvs(&rec, kvs);
+    omf_set_otr_tid(&rec, optrace_tid);
+    omf_set_otr_lat_ns(&rec, min_t(u64, lat, U32_MAX));
+    omf_set_otr_vlen(&rec, vlen);
+    omf_set_otr_err(&rec, merr_errno(err));
+    omf_set_otr_ctx(&rec, (uintptr_t)ctx);
+    omf_set_otr_khash(&rec, klen ? hse_hash64(key, klen) : 0);
+    omf_set_otr_phash(&rec, pfx_len ? hse_hash64(key, pfx_len) : 0);
+
+    optrace_append(ot, &rec);
+}
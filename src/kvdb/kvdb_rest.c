@@ -8,6 +8,8 @@
 #include <hse_util/hse_err.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/fmt.h>
+#include <hse_util/perfc.h>
+#include <hse_util/printbuf.h>
 
 #include <hse_util/data_tree.h>
 #include <hse_util/rest_api.h>
@@ -15,9 +17,11 @@
 #include <hse_util/string.h>
 
 #include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/kvdb_slowop.h>
 #include <hse_ikvdb/kvs.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/cn_tree_view.h>
+#include <hse_ikvdb/cn_wamp.h>
 
 #include "kvdb_rest.h"
 #include "kvdb_kvs.h"
@@ -180,6 +184,145 @@ rest_kvdb_compact_status_get(
 
     return 0;
 }
+
+#define KVDB_METRICS_FILT_MAX 8
+
+/* OpenMetrics scrape of this kvdb's perf counters plus the space amp
+ * gauges the compaction scheduler maintains.  Query arguments further
+ * filter the counters by label (e.g., mpool/mp1/metrics?kvs=kvs1).
+ */
+static merr_t
+rest_kvdb_metrics_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context)
+{
+    struct ikvdb *                 ikvdb = context;
+    struct hse_kvdb_compact_status status = { 0 };
+    struct perfc_label             filtv[KVDB_METRICS_FILT_MAX];
+    struct rest_kv *               kv;
+    const char *                   mp, *end;
+    char                           mp_name[DT_PATH_ELEMENT_LEN];
+    char *                         buf;
+    size_t                         len, off;
+    uint                           filtc = 0;
+    merr_t                         err;
+
+    /* url is "mpool/<mp_name>/metrics" */
+    mp = strchr(url, '/');
+    end = strrchr(url, '/');
+    if (ev(!mp || end <= mp + 1 || end - mp > sizeof(mp_name)))
+        return merr(EINVAL);
+
+    strlcpy(mp_name, mp + 1, end - mp);
+
+    filtv[filtc].pl_name = "name";
+    filtv[filtc++].pl_value = mp_name;
+
+    while ((kv = rest_kv_next(iter))) {
+        if (ev(filtc >= NELEM(filtv)))
+            return merr(E2BIG);
+
+        filtv[filtc].pl_name = kv->key;
+        filtv[filtc++].pl_value = kv->value ?: "";
+    }
+
+    err = perfc_metrics(PERFC_ROOT_PATH, filtc, filtv, &buf, &len);
+    if (ev(err))
+        return err;
+
+    rest_write_safe(info->resp_fd, buf, len);
+    free(buf);
+
+    ikvdb_compact_status_get(ikvdb, &status);
+
+    buf = info->buf;
+    off = 0;
+    snprintf_append(buf, info->buf_sz, &off,
+                    "# TYPE hse_csched_samp_pct gauge\n"
+                    "# HELP hse_csched_samp_pct space amplification (percent)\n");
+    snprintf_append(buf, info->buf_sz, &off,
+                    "hse_csched_samp_pct{name=\"%s\",bound=\"lwm\"} %u\n",
+                    mp_name, status.kvcs_samp_lwm);
+    snprintf_append(buf, info->buf_sz, &off,
+                    "hse_csched_samp_pct{name=\"%s\",bound=\"hwm\"} %u\n",
+                    mp_name, status.kvcs_samp_hwm);
+    snprintf_append(buf, info->buf_sz, &off,
+                    "hse_csched_samp_pct{name=\"%s\",bound=\"curr\"} %u\n",
+                    mp_name, status.kvcs_samp_curr);
+    snprintf_append(buf, info->buf_sz, &off, "# EOF\n");
+
+    if (rest_write_safe(info->resp_fd, buf, off) != off)
+        return merr(EIO);
+
+    return 0;
+}
+
+/* Report the most recent slow operations, newest first.
+ */
+static merr_t
+rest_kvdb_slowops_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context)
+{
+    struct ikvdb *          ikvdb = context;
+    struct kvdb_slowop_rec *recv;
+    char *                  buf = info->buf;
+    size_t                  bufsz = info->buf_sz;
+    size_t                  off;
+    uint                    recc, i, j;
+    u64                     seen;
+
+    recv = malloc(sizeof(*recv) * KVDB_SLOWOP_RECS_MAX);
+    if (ev(!recv))
+        return merr(ENOMEM);
+
+    recc = ikvdb_slowop_get(ikvdb, recv, KVDB_SLOWOP_RECS_MAX, &seen);
+
+    off = 0;
+    snprintf_append(buf, bufsz, &off, "slowops:\n  seen: %lu\n  ops:\n", (ulong)seen);
+    rest_write_safe(info->resp_fd, buf, off);
+
+    for (i = 0; i < recc; i++) {
+        struct kvdb_slowop_rec *  rec = recv + i;
+        struct kvdb_slowop_stats *ss = &rec->sr_stats;
+
+        off = 0;
+        snprintf_append(buf, bufsz, &off, "  - time_ns: %lu\n", (ulong)rec->sr_time_ns);
+        snprintf_append(buf, bufsz, &off, "    op: %s\n", kvdb_slowop_op_name(rec->sr_op));
+        snprintf_append(buf, bufsz, &off, "    kvs: %s\n", rec->sr_kvs);
+        snprintf_append(buf, bufsz, &off, "    tid: %u\n", rec->sr_tid);
+        snprintf_append(buf, bufsz, &off, "    lat_us: %lu\n", (ulong)rec->sr_lat_ns / 1000);
+        snprintf_append(buf, bufsz, &off, "    klen: %u\n", rec->sr_klen);
+        snprintf_append(buf, bufsz, &off, "    vlen: %u\n", rec->sr_vlen);
+        snprintf_append(buf, bufsz, &off, "    errno: %u\n", rec->sr_err);
+        snprintf_append(buf, bufsz, &off, "    stages_us:\n");
+
+        for (j = 0; j < KVDB_SLOWOP_STAGE_MAX; j++)
+            snprintf_append(
+                buf, bufsz, &off, "      %s: %lu\n",
+                kvdb_slowop_stage_name(j), (ulong)ss->ss_ns[j] / 1000);
+
+        snprintf_append(buf, bufsz, &off, "    kvsets: %u\n", ss->ss_kvsets);
+        snprintf_append(buf, bufsz, &off, "    depth: %u\n", ss->ss_depth);
+        snprintf_append(buf, bufsz, &off, "    bloom_neg: %u\n", ss->ss_bloom_neg);
+        snprintf_append(buf, bufsz, &off, "    vreads: %u\n", ss->ss_vreads);
+        snprintf_append(buf, bufsz, &off, "    vbytes: %lu\n", (ulong)ss->ss_vbytes);
+
+        if (rest_write_safe(info->resp_fd, buf, off) != off)
+            break;
+    }
+
+    free(recv);
+
+    return 0;
+}
+
 merr_t
 kvdb_rest_register(const char *mp_name, void *kvdb)
 {
@@ -200,6 +343,22 @@ kvdb_rest_register(const char *mp_name, void *kvdb)
         rest_kvdb_compact_request,
         "mpool/%s/compact",
         mp_name);
+
+    if (ev(status) && !err)
+        err = status;
+
+    status = rest_url_register(
+        kvdb, URL_FLAG_EXACT, rest_kvdb_metrics_get, 0, "mpool/%s/metrics", mp_name);
+
+    if (ev(status) && !err)
+        err = status;
+
+    status = rest_url_register(
+        kvdb, URL_FLAG_EXACT, rest_kvdb_slowops_get, 0, "mpool/%s/slowops", mp_name);
+
+    if (ev(status) && !err)
+        err = status;
+
     return err;
 }
 
@@ -233,6 +392,7 @@ struct ctx {
 
     /* per node */
     struct cn_node_loc node_loc; /* cached loc */
+    struct kvset_heat  node_heat;
     u32                node_kblks;
     u32                node_vblks;
     u64                node_dgen;
@@ -309,6 +469,18 @@ print_unit(
     yaml2fd(fd, yaml_field_fmt, yc, "nvblks", "%d", nvblks);
 }
 
+static void
+print_heat(struct kvset_heat *heat, int fd, struct yaml_context *yc)
+{
+    int i;
+
+    yaml2fd(fd, yaml_start_element_type, yc, "heat");
+    for (i = 0; i < KVSET_HEAT_MAX; i++)
+        yaml2fd(fd, yaml_field_fmt, yc, kvset_heat_name(i), "%lu", heat->kh_ctrv[i]);
+    yaml2fd(fd, yaml_end_element, yc);
+    yaml2fd(fd, yaml_end_element_type, yc);
+}
+
 static void
 print_elem(
     const char *          who,
@@ -318,6 +490,7 @@ print_elem(
     struct kvset *        kvset)
 {
     char                 idx[10];
+    struct kvset_heat    heat;
     struct yaml_context *yc = ctx->yc;
     int                  fd = ctx->fd;
 
@@ -364,6 +537,9 @@ print_elem(
                 yaml2fd(ctx->fd, yaml_end_element_type, yc);
             }
 
+            kvset_get_heat(kvset, &heat);
+            print_heat(&heat, ctx->fd, yc);
+
             yaml2fd(ctx->fd, yaml_end_element, yc); /* index */
 
             ctx->prev_elem = TYPE_KVSET;
@@ -388,6 +564,7 @@ print_elem(
                 ctx->node_vblks,
                 ctx->fd,
                 yc);
+            print_heat(&ctx->node_heat, ctx->fd, yc);
             yaml2fd(ctx->fd, yaml_end_element, yc);
             yaml2fd(ctx->fd, yaml_end_element_type, yc);
 
@@ -404,8 +581,10 @@ print_elem(
 }
 
 static int
-print_tree(struct ctx *ctx, struct cn_node_loc *loc, struct kvset *kvset)
+print_tree(struct ctx *ctx, struct kvset_view *v)
 {
+    struct cn_node_loc * loc = &v->node_loc;
+    struct kvset *       kvset = v->kvset;
     struct kvset_metrics km;
 
     /* A null kvset is the start of a new node */
@@ -414,6 +593,7 @@ print_tree(struct ctx *ctx, struct cn_node_loc *loc, struct kvset *kvset)
             print_elem("node", ctx, &ctx->node, &ctx->node_loc, 0);
         memset(&ctx->node, 0, sizeof(ctx->node));
         ctx->node_loc = *loc;
+        ctx->node_heat = v->node_heat;
         ctx->node_kblks = 0;
         ctx->node_vblks = 0;
         ctx->node_dgen = 0;
@@ -488,7 +668,7 @@ kvs_rest_query_tree(struct kvdb_kvs *kvs, struct yaml_context *yc, int fd, bool
         int                rc;
         struct kvset_view *v = table_at(tree_view, i);
 
-        rc = print_tree(&ctx, &v->node_loc, v->kvset);
+        rc = print_tree(&ctx, v);
         if (rc)
             break;
     }
@@ -613,6 +793,117 @@ rest_kvs_tree(
     return 0;
 }
 
+static void
+print_wamp_ctr(char *buf, size_t bufsz, size_t *off, const char *name, struct cn_wamp_ctr *wc)
+{
+    snprintf_append(
+        buf, bufsz, off, "%s: { jobs: %lu, rbytes: %lu, wbytes: %lu }\n",
+        name, (ulong)wc->wc_jobs, (ulong)wc->wc_rbytes, (ulong)wc->wc_wbytes);
+}
+
+static void
+print_wamp_sample(char *buf, size_t bufsz, size_t *off, int indent, struct cn_wamp_sample *ws)
+{
+    char name[16];
+    u64  wamp, samp;
+    int  i;
+
+    wamp = cn_wamp_ratio(ws);
+    samp = ws->ws_good > 0 ? (ws->ws_alen * 100) / ws->ws_good : 0;
+
+    snprintf_append(
+        buf, bufsz, off, "%*swamp: %lu.%02lu\n", indent, "", (ulong)wamp / 100, (ulong)wamp % 100);
+    snprintf_append(
+        buf, bufsz, off, "%*ssamp: %lu.%02lu\n", indent, "", (ulong)samp / 100, (ulong)samp % 100);
+
+    snprintf_append(buf, bufsz, off, "%*sops:\n", indent, "");
+    for (i = 0; i < CN_WAMP_OP_MAX; i++) {
+        snprintf_append(buf, bufsz, off, "%*s", indent + 2, "");
+        print_wamp_ctr(buf, bufsz, off, cn_wamp_op_name(i), &ws->ws_opv[i]);
+    }
+
+    snprintf_append(buf, bufsz, off, "%*slevels:\n", indent, "");
+    for (i = 0; i < CN_WAMP_LEVELS; i++) {
+        struct cn_wamp_ctr *wc = &ws->ws_lvlv[i];
+
+        if (!wc->wc_jobs && !wc->wc_rbytes && !wc->wc_wbytes)
+            continue;
+
+        snprintf(name, sizeof(name), "%d", i);
+        snprintf_append(buf, bufsz, off, "%*s", indent + 2, "");
+        print_wamp_ctr(buf, bufsz, off, name, wc);
+    }
+}
+
+static merr_t
+rest_kvs_wamp(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context)
+{
+    struct kvdb_kvs *    kvs = context;
+    struct cn_wamp_view *view;
+    struct cn *          cn;
+    char *               buf = info->buf;
+    size_t               bufsz = info->buf_sz;
+    size_t               off;
+    u64                  idx;
+    uint                 i;
+
+    if (strcmp(path, url) != 0)
+        return merr(ev(E2BIG));
+
+    view = malloc(sizeof(*view));
+    if (ev(!view))
+        return merr(ENOMEM);
+
+    /* HSE_REVISIT: See rest_kvs_tree() */
+    atomic_inc(&kvs->kk_refcnt);
+
+    cn = kvs->kk_ikvs ? kvs_cn(kvs->kk_ikvs) : NULL;
+    if (!cn) {
+        atomic_dec(&kvs->kk_refcnt);
+        free(view);
+        return merr(ev(EINVAL));
+    }
+
+    cn_wamp_get(cn, view);
+
+    atomic_dec(&kvs->kk_refcnt);
+
+    off = 0;
+    snprintf_append(buf, bufsz, &off, "wamp:\n");
+    snprintf_append(buf, bufsz, &off, "  interval_secs: %u\n", CN_WAMP_INTERVAL_SECS);
+    snprintf_append(
+        buf, bufsz, &off, "  since_secs: %lu\n",
+        (ulong)(view->wv_now - view->wv_since) / NSEC_PER_SEC);
+    snprintf_append(buf, bufsz, &off, "  total:\n");
+    print_wamp_sample(buf, bufsz, &off, 4, &view->wv_total);
+    snprintf_append(buf, bufsz, &off, "  intervals:\n");
+    rest_write_safe(info->resp_fd, buf, off);
+
+    idx = view->wv_now / ((u64)CN_WAMP_INTERVAL_SECS * NSEC_PER_SEC);
+
+    for (i = 0; i < view->wv_intc; i++) {
+        struct cn_wamp_sample *ws = view->wv_intv + i;
+
+        off = 0;
+        snprintf_append(
+            buf, bufsz, &off, "    - age_secs: %lu\n",
+            (ulong)(idx - ws->ws_idx) * CN_WAMP_INTERVAL_SECS);
+        print_wamp_sample(buf, bufsz, &off, 6, ws);
+
+        if (rest_write_safe(info->resp_fd, buf, off) != off)
+            break;
+    }
+
+    free(view);
+
+    return 0;
+}
+
 struct cursor_test_params {
     const void *ctp_pkey;
     ulong       ctp_pkey_len;
@@ -944,6 +1235,12 @@ kvs_rest_register(const char *mp_name, const char *kvs_name, void *kvs)
     if (ev(status) && !err)
         err = status;
 
+    status = rest_url_register(
+        kvs, URL_FLAG_EXACT, rest_kvs_wamp, 0, "mpool/%s/kvs/%s/cn/wamp", mp_name, kvs_name);
+
+    if (ev(status) && !err)
+        err = status;
+
     status = rest_url_register(
         kvs,
         URL_FLAG_BINVAL | URL_FLAG_EXACT,
@@ -970,6 +1267,11 @@ kvs_rest_deregister(const char *mp_name, const char *kvs_name)
 
     status = rest_url_deregister("mpool/%s/kvs/%s/cn/tree", mp_name, kvs_name);
 
+    if (ev(status) && !err)
+        err = status;
+
+    status = rest_url_deregister("mpool/%s/kvs/%s/cn/wamp", mp_name, kvs_name);
+
     if (ev(status) && !err)
         err = status;
 
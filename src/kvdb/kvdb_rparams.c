@@ -82,6 +82,12 @@ kvdb_rparams_defaults(void)
         .csched_leaf_comp_params = 0,
         .csched_leaf_len_params = 0,
         .csched_node_min_ttl = 17,
+        .csched_io_rate = 0,
+        .csched_io_leaf_pct = 50,
+        .csched_io_lat_tgt = 0,
+        .csched_rheat_min = 0,
+        .csched_tier_params = 0,
+        .csched_sts_steal = 1,
 
         .dur_enable = 0,
         .dur_intvl_ms = 500,
@@ -102,6 +108,7 @@ kvdb_rparams_defaults(void)
         .throttle_debug = 0,
         .throttle_debug_intvl_s = 300,
         .throttle_c0_hi_th = 1024 * 4,
+        .throttle_fair_share = 0,
         .throttle_init_policy = "default",
 
         .log_lvl = HSE_LOG_PRI_DEFAULT,
@@ -116,6 +123,12 @@ kvdb_rparams_defaults(void)
 
         .low_mem = 0,
 
+        .optrace_bufsz = 16ul << 20,
+        .optrace_path = "",
+        .slowop_ns = 0,
+        .slowop_pct = 100,
+        .flightrec_sigdump = 0,
+
         .rpmagic = RPARAMS_MAGIC,
     };
 
@@ -155,6 +168,12 @@ static struct param_inst   kvdb_rp_table[] = {
     KVDB_PARAM_EXP(csched_leaf_comp_params, "leaf compact params [poppct,min,max]"),
     KVDB_PARAM_EXP(csched_leaf_len_params, "leaf length params [idlem,idlec,kvcompc,min,max]"),
     KVDB_PARAM_EXP(csched_node_min_ttl, "Min. time-to-live for cN nodes (secs)"),
+    KVDB_PARAM_EXP(csched_io_rate, "compaction I/O budget (MiB/s, 0: unlimited)"),
+    KVDB_PARAM_EXP(csched_io_leaf_pct, "max percent of compaction I/O budget for leaf work"),
+    KVDB_PARAM_EXP(csched_io_lat_tgt, "cN get latency target for I/O budget tuning (us, 0: disable)"),
+    KVDB_PARAM_EXP(csched_rheat_min, "min read heat (extra kvsets probed/sec) to compact a node (0: disable)"),
+    KVDB_PARAM_EXP(csched_tier_params, "size-tiered leaf params [samppct,ratiopct,min,max]"),
+    KVDB_PARAM_EXP(csched_sts_steal, "let idle queue workers run jobs from other queues"),
 
     KVDB_PARAM_EXP(dur_enable, "0: disable durability, 1:enable durability"),
     KVDB_PARAM(dur_intvl_ms, "durability lag in ms"),
@@ -171,9 +190,10 @@ static struct param_inst   kvdb_rp_table[] = {
     KVDB_PARAM_U32_EXP(throttle_debug_intvl_s, "throttle debug interval (secs)"),
     KVDB_PARAM_EXP(throttle_sleep_min_ns, "nanosleep time overhead (nsecs)"),
     KVDB_PARAM_EXP(throttle_c0_hi_th, "throttle sensor: c0 high water mark (MiB)"),
-    KVDB_PARAM_STR(throttle_init_policy, "throttle initialization policy"),
+    KVDB_PARAM_STR(throttle_init_policy, "throttle policy (light, medium, default, pid)"),
     KVDB_PARAM_EXP(throttle_burst, "initial throttle burst size (bytes)"),
     KVDB_PARAM_EXP(throttle_rate, "initial throttle rate (bytes/sec)"),
+    KVDB_PARAM_U32_EXP(throttle_fair_share, "share the throttle rate among kvses by weight"),
 
     KVDB_PARAM_U32(log_lvl, "log message verbosity. Range: 0 to 7."),
     KVDB_PARAM_EXP(log_squelch_ns, "drop messages repeated within nsec window"),
@@ -191,6 +211,12 @@ static struct param_inst   kvdb_rp_table[] = {
     KVDB_PARAM_U32_EXP(low_mem, "configure for a constrained memory environment"),
     KVDB_PARAM_U32_EXP(excl, "open the kvdb in exclusive mode"),
 
+    KVDB_PARAM_STR(optrace_path, "trace API operations to this file (empty: disable)"),
+    KVDB_PARAM_EXP(optrace_bufsz, "operation trace buffer size (bytes)"),
+    KVDB_PARAM_EXP(slowop_ns, "keep KVS operations at least this slow (nsecs, 0: disable)"),
+    KVDB_PARAM_U32_EXP(slowop_pct, "percentage of KVS operations checked for slowness"),
+    KVDB_PARAM_U32_EXP(flightrec_sigdump, "dump the flight recorder to stderr on fatal signals"),
+
     PARAM_INST_END
 };
 
@@ -201,6 +227,7 @@ static char const *const kvdb_rp_writable[] = {
     "throttle_update_ns",
     "throttle_burst",
     "throttle_rate",
+    "throttle_fair_share",
     "csched_policy",
     "csched_qthreads",
     "csched_node_len_max",
@@ -214,6 +241,12 @@ static char const *const kvdb_rp_writable[] = {
     "csched_leaf_comp_params",
     "csched_leaf_len_params",
     "csched_debug_mask",
+    "csched_io_rate",
+    "csched_io_leaf_pct",
+    "csched_io_lat_tgt",
+    "csched_rheat_min",
+    "csched_tier_params",
+    "csched_sts_steal",
     "txn_commit_abort_pct",
 };
 
@@ -305,6 +338,11 @@ kvdb_rparams_validate(struct kvdb_rparams *params)
         return merr(EINVAL);
     }
 
+    if (params->csched_io_leaf_pct < 1 || params->csched_io_leaf_pct > 100) {
+        hse_log(HSE_ERR "csched_io_leaf_pct must be in the range [1, 100]");
+        return merr(EINVAL);
+    }
+
     return 0;
 }
 
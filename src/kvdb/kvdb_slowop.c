@@ -0,0 +1,234 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/alloc.h>
+#include <hse_util/spinlock.h>
+#include <hse_util/string.h>
+#include <hse_util/logging.h>
+#include <hse_util/timing.h>
+#include <hse_util/time.h>
+#include <hse_util/xrand.h>
+
+#include <hse_ikvdb/kvdb_slowop.h>
+
+#include <syscall.h>
+
+__thread struct kvdb_slowop_stats kvdb_slowop_tls;
+
+static __thread u32 slowop_tid;
+
+/**
+ * struct kvdb_slowop - slow operation log
+ * @so_thresh_ns: operations at least this slow are recorded
+ * @so_pct:       percentage of operations sampled
+ * @so_lock:      protects the fields below
+ * @so_seen:      slow operations seen
+ * @so_logged_ns: get_time_ns() of the last slow operation logged
+ * @so_unlogged:  slow operations not logged since then
+ * @so_name:      kvdb name
+ * @so_recv:      ring of the most recent slow operations
+ */
+struct kvdb_slowop {
+    u64  so_thresh_ns;
+    uint so_pct;
+
+    __aligned(SMP_CACHE_BYTES) spinlock_t so_lock;
+    u64                    so_seen;
+    u64                    so_logged_ns;
+    u64                    so_unlogged;
+    char                   so_name[64];
+    struct kvdb_slowop_rec so_recv[KVDB_SLOWOP_RECS_MAX];
+};
+
+static const char *const slowop_op_namev[] = {
+    [KVDB_OPTRACE_PUT] = "put",
+    [KVDB_OPTRACE_GET] = "get",
+    [KVDB_OPTRACE_DEL] = "del",
+    [KVDB_OPTRACE_PDEL] = "pdel",
+    [KVDB_OPTRACE_CUR_CREATE] = "cursor_create",
+    [KVDB_OPTRACE_CUR_SEEK] = "cursor_seek",
+    [KVDB_OPTRACE_CUR_READ] = "cursor_read",
+    [KVDB_OPTRACE_CUR_DESTROY] = "cursor_destroy",
+    [KVDB_OPTRACE_CUR_UPDATE] = "cursor_update",
+    [KVDB_OPTRACE_CUR_READ_BATCH] = "cursor_read_batch",
+    [KVDB_OPTRACE_CUR_PRED_SET] = "cursor_pred_set",
+    [KVDB_OPTRACE_PFX_PROBE] = "prefix_probe",
+};
+
+static const char *const slowop_stage_namev[] = {
+    [KVDB_SLOWOP_C0] = "c0",
+    [KVDB_SLOWOP_CN] = "cn",
+    [KVDB_SLOWOP_VREAD] = "vread",
+    [KVDB_SLOWOP_DECOMP] = "decompress",
+    [KVDB_SLOWOP_COMP] = "compress",
+    [KVDB_SLOWOP_THROTTLE] = "throttle",
+};
+
+const char *
+kvdb_slowop_op_name(enum kvdb_optrace_op op)
+{
+    if (op >= NELEM(slowop_op_namev) || !slowop_op_namev[op])
+        return "unknown";
+
+    return slowop_op_namev[op];
+}
+
+const char *
+kvdb_slowop_stage_name(enum kvdb_slowop_stage stage)
+{
+    if (stage >= NELEM(slowop_stage_namev))
+        return "unknown";
+
+    return slowop_stage_namev[stage];
+}
+
+merr_t
+kvdb_slowop_create(u64 thresh_ns, uint pct, const char *name, struct kvdb_slowop **sop)
+{
+    struct kvdb_slowop *so;
+
+    if (ev(!thresh_ns || !name || !sop))
+        return merr(EINVAL);
+
+    so = alloc_aligned(sizeof(*so), __alignof(*so));
+    if (ev(!so))
+        return merr(ENOMEM);
+
+    memset(so, 0, sizeof(*so));
+    so->so_thresh_ns = thresh_ns;
+    so->so_pct = clamp_t(uint, pct, 1, 100);
+    spin_lock_init(&so->so_lock);
+    strlcpy(so->so_name, name, sizeof(so->so_name));
+
+    hse_log(
+        HSE_NOTICE "%s: %s: keeping operations slower than %lu us (%u%% sampled)",
+        __func__,
+        name,
+        (ulong)thresh_ns / 1000,
+        so->so_pct);
+
+    *sop = so;
+
+    return 0;
+}
+
+void
+kvdb_slowop_destroy(struct kvdb_slowop *so)
+{
+    free_aligned(so);
+}
+
+bool
+kvdb_slowop_begin(struct kvdb_slowop *so)
+{
+    struct kvdb_slowop_stats *ss = &kvdb_slowop_tls;
+
+    if (so->so_pct < 100 && xrand64_tls() % 100 >= so->so_pct)
+        return false;
+
+    memset(ss, 0, sizeof(*ss));
+    ss->ss_active = true;
+
+    return true;
+}
+
+void
+kvdb_slowop_end(
+    struct kvdb_slowop * so,
+    enum kvdb_optrace_op op,
+    const char *         kvs,
+    size_t               klen,
+    size_t               vlen,
+    u64                  tstart,
+    merr_t               err)
+{
+    struct kvdb_slowop_stats *ss = &kvdb_slowop_tls;
+    struct kvdb_slowop_rec *  rec;
+    struct timespec           ts;
+    u64                       now, lat, unlogged;
+    bool                      log;
+
+    ss->ss_active = false;
+
+    now = get_time_ns();
+    lat = now - tstart;
+    if (lat < so->so_thresh_ns)
+        return;
+
+    if (unlikely(!slowop_tid))
+        slowop_tid = syscall(SYS_gettid);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    spin_lock(&so->so_lock);
+    rec = so->so_recv + (so->so_seen++ % KVDB_SLOWOP_RECS_MAX);
+
+    rec->sr_time_ns = ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec - lat;
+    rec->sr_lat_ns = lat;
+    rec->sr_op = op;
+    rec->sr_err = merr_errno(err);
+    rec->sr_klen = klen;
+    rec->sr_vlen = vlen;
+    rec->sr_tid = slowop_tid;
+    strlcpy(rec->sr_kvs, kvs, sizeof(rec->sr_kvs));
+    rec->sr_stats = *ss;
+
+    log = now > so->so_logged_ns + KVDB_SLOWOP_LOG_NS;
+    unlogged = so->so_unlogged;
+    if (log) {
+        so->so_logged_ns = now;
+        so->so_unlogged = 0;
+    } else {
+        so->so_unlogged++;
+    }
+    spin_unlock(&so->so_lock);
+
+    if (!log)
+        return;
+
+    hse_log(
+        HSE_WARNING "%s: %s/%s: %s klen %zu vlen %zu: %lu us (c0 %lu cn %lu "
+                    "vread %lu decomp %lu comp %lu throttle %lu) kvsets %u depth %u "
+                    "bloom_neg %u vreads %u, %lu more not logged",
+        __func__,
+        so->so_name,
+        kvs,
+        kvdb_slowop_op_name(op),
+        klen,
+        vlen,
+        (ulong)lat / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_C0] / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_CN] / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_VREAD] / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_DECOMP] / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_COMP] / 1000,
+        (ulong)ss->ss_ns[KVDB_SLOWOP_THROTTLE] / 1000,
+        ss->ss_kvsets,
+        ss->ss_depth,
+        ss->ss_bloom_neg,
+        ss->ss_vreads,
+        (ulong)unlogged);
+}
+
+uint
+kvdb_slowop_get(struct kvdb_slowop *so, struct kvdb_slowop_rec *recv, uint recc, u64 *seenp)
+{
+    uint i, n;
+    u64  seen;
+
+    spin_lock(&so->so_lock);
+    seen = so->so_seen;
+    n = min_t(u64, seen, min_t(uint, recc, KVDB_SLOWOP_RECS_MAX));
+
+    for (i = 0; i < n; i++)
+        recv[i] = so->so_recv[(seen - 1 - i) % KVDB_SLOWOP_RECS_MAX];
+    spin_unlock(&so->so_lock);
+
+    if (seenp)
+        *seenp = seen;
+
+    return n;
+}
@@ -14,6 +14,7 @@
 #include <hse_util/condvar.h>
 #include <hse_util/mutex.h>
 #include <hse_util/perfc.h>
+#include <hse_util/flightrec.h>
 
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/sched_sts.h>
@@ -152,6 +153,28 @@ found_job:
     return job;
 }
 
+/* Caller must have queue lock.
+ *
+ * Find a job for an idle worker dedicated to another queue.  One idle
+ * worker always stays with its own queue so that work submitted there
+ * does not wait behind a stolen job.
+ */
+static struct sts_queue *
+q_steal(struct sts *self, uint wqnum)
+{
+    uint i;
+
+    if (!self->rp->csched_sts_steal || atomic_read(&self->qv[wqnum].idle_workers) < 2)
+        return 0;
+
+    for (i = 0; i < self->qc; i++) {
+        if (i != wqnum && !list_empty(&self->qv[i].jobs))
+            return &self->qv[i];
+    }
+
+    return 0;
+}
+
 /* Caller must have queue lock */
 static struct sts_job *
 job_find_tag(struct sts *self, struct sts_queue *q, u64 tag)
@@ -560,10 +583,12 @@ sts_qsel(struct sts *self, struct sts_worker *w, int *status)
 
     if (w->wqnum < self->qc) {
 
-        /* Worker is bound to a queue */
+        /* Worker is bound to a queue, but may help out
+         * other queues when idle.
+         */
         q = &self->qv[w->wqnum];
         if (list_empty(&q->jobs))
-            return 0;
+            return q_steal(self, w->wqnum);
 
         return q;
     }
@@ -631,6 +656,16 @@ sts_worker_main(void *rock)
                 job = list_first_entry(&q->jobs, struct sts_job, sj_link);
                 list_del(&job->sj_link);
                 perfc_dec(&q->qpc, PERFC_BA_STS_QDEPTH);
+
+                /* Leave the idle state under the queue lock so that
+                 * q_steal() sees an accurate idle count.
+                 */
+                if (idle) {
+                    idle = false;
+                    assert(atomic_read(idle_count) > 0);
+                    atomic_dec(idle_count);
+                    perfc_dec(&self->qv[w->wqnum].qpc, PERFC_BA_STS_WORKERS_IDLE);
+                }
                 break;
             }
 
@@ -655,16 +690,8 @@ sts_worker_main(void *rock)
 
         q_unlock(self);
 
-        if (job) {
-            if (idle) {
-                idle = false;
-                assert(atomic_read(idle_count) > 0);
-                atomic_dec(idle_count);
-                perfc_dec(&self->qv[w->wqnum].qpc, PERFC_BA_STS_WORKERS_IDLE);
-            }
-
+        if (job)
             worker_run_slice(w, q, job);
-        }
 
         if (state == SS_PAUSE)
             msleep(WORKER_PAUSE_SLEEP_MS);
@@ -694,6 +721,8 @@ sts_job_submit(struct sts *self, struct sts_job *job)
 
     job->sj_sts = self;
 
+    flightrec_add(FLIGHTREC_STS_JOB_SUBMIT, job->sj_id, job->sj_qnum);
+
     q_lock(self);
     job_put(q, job);
     cv_signal(&self->qcondvar);
@@ -745,6 +774,16 @@ sts_wcnt_get_idle(struct sts *self, uint qnum)
     if (qnum <= self->qc)
         count = atomic_read(&self->qv[self->qc].idle_workers);
 
+    /* Idle dedicated workers beyond the first in each queue will
+     * pick up work from other queues.
+     */
+    if (self->rp->csched_sts_steal) {
+        uint i;
+
+        for (i = 0; i < self->qc; i++)
+            count += max_t(int, atomic_read(&self->qv[i].idle_workers) - 1, 0);
+    }
+
     assert(count >= 0);
     return count < 0 ? 0 : (uint)count;
 }
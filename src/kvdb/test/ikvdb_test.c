@@ -1013,6 +1013,130 @@ MTF_DEFINE_UTEST_PREPOST(ikvdb_test, cursor_1, test_pre_c0, test_post_c0)
     hse_params_destroy(params);
 }
 
+MTF_DEFINE_UTEST_PREPOST(ikvdb_test, cursor_batch, test_pre_c0, test_post_c0)
+{
+    struct ikvdb *         h = NULL;
+    struct hse_kvs *       kvs_h = NULL;
+    const char *           mpool = "mpool";
+    const char *           kvs = "kvs";
+    struct mpool *         ds = (struct mpool *)-1;
+    struct hse_params *    params;
+    struct hse_kvdb_opspec opspec;
+    struct hse_kvs_cursor *cur;
+    struct kvs_ktuple      kt = { 0 };
+    struct kvs_vtuple      vt = { 0 };
+    struct kvs_kvtuple     kvtv[8];
+    char                   buf[64];
+    char *                 dst;
+    merr_t                 err;
+    bool                   eof;
+    uint                   kvtc;
+    int                    i;
+
+    struct kvdata {
+        char *key;
+        char *val;
+    } sorted[] = {
+        { "AA", "AA_1" }, { "AAA", "AAA_1" },   { "AABB", "AABB_1" }, { "AABC", "AABC_1" },
+        { "AB", "AB_1" }, { "ABAA", "ABAA_1" }, { "ABC", "ABC_1" },   { "AC", "AC_1" },
+    };
+
+    HSE_KVDB_OPSPEC_INIT(&opspec);
+
+    hse_params_create(&params);
+
+    err = hse_params_set(params, "kvdb.c0_diag_mode", "1");
+    ASSERT_EQ(err, 0);
+
+    err = ikvdb_open(mpool, ds, params, &h);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(NULL, h);
+
+    err = ikvdb_kvs_make(h, kvs, NULL);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_kvs_open(h, kvs, 0, 0, &kvs_h);
+    ASSERT_EQ(0, err);
+
+    for (i = NELEM(sorted) - 1; i >= 0; --i) {
+        kvs_ktuple_init(&kt, sorted[i].key, strlen(sorted[i].key));
+        kvs_vtuple_init(&vt, sorted[i].val, strlen(sorted[i].val));
+
+        err = ikvdb_kvs_put(kvs_h, &opspec, &kt, &vt);
+        ASSERT_EQ(0, err);
+    }
+
+    err = ikvdb_kvs_cursor_create(kvs_h, &opspec, 0, 0, &cur);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(NULL, cur);
+
+    /* Keys and values are copied out back to back into the buffer. */
+    err = ikvdb_kvs_cursor_read_batch(cur, 0, buf, sizeof(buf), kvtv, 3, &kvtc, &eof);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(3, kvtc);
+    ASSERT_FALSE(eof);
+
+    dst = buf;
+    for (i = 0; i < kvtc; ++i) {
+        size_t klen = strlen(sorted[i].key);
+        size_t vlen = strlen(sorted[i].val);
+
+        ASSERT_EQ(dst, kvtv[i].kvt_key.kt_data);
+        ASSERT_EQ(klen, kvtv[i].kvt_key.kt_len);
+        ASSERT_EQ(0, memcmp(dst, sorted[i].key, klen));
+        dst += klen;
+
+        ASSERT_EQ(dst, kvtv[i].kvt_value.vt_data);
+        ASSERT_EQ(vlen, kvs_vtuple_vlen(&kvtv[i].kvt_value));
+        ASSERT_EQ(0, memcmp(dst, sorted[i].val, vlen));
+        dst += vlen;
+    }
+
+    /* The next pair (AABC, 10 bytes) does not fit: ENOSPC, and the
+     * cursor stays put.
+     */
+    err = ikvdb_kvs_cursor_read_batch(cur, 0, buf, 9, kvtv, 4, &kvtc, &eof);
+    ASSERT_EQ(ENOSPC, merr_errno(err));
+    ASSERT_EQ(0, kvtc);
+    ASSERT_FALSE(eof);
+
+    /* Room for AABC but not for AB: a short batch, without error. */
+    err = ikvdb_kvs_cursor_read_batch(cur, 0, buf, 15, kvtv, 4, &kvtc, &eof);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, kvtc);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(0, memcmp(kvtv[0].kvt_key.kt_data, sorted[3].key, kvtv[0].kvt_key.kt_len));
+
+    /* The rest of the keys make a partial batch that reaches eof. */
+    err = ikvdb_kvs_cursor_read_batch(cur, 0, buf, sizeof(buf), kvtv, 8, &kvtc, &eof);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(4, kvtc);
+    ASSERT_TRUE(eof);
+
+    for (i = 0; i < kvtc; ++i) {
+        ASSERT_EQ(strlen(sorted[i + 4].key), kvtv[i].kvt_key.kt_len);
+        ASSERT_EQ(0, memcmp(kvtv[i].kvt_key.kt_data, sorted[i + 4].key, kvtv[i].kvt_key.kt_len));
+        ASSERT_EQ(0, memcmp(kvtv[i].kvt_value.vt_data, sorted[i + 4].val,
+                            kvs_vtuple_vlen(&kvtv[i].kvt_value)));
+    }
+
+    err = ikvdb_kvs_cursor_read_batch(cur, 0, buf, sizeof(buf), kvtv, 8, &kvtc, &eof);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, kvtc);
+    ASSERT_TRUE(eof);
+
+    err = ikvdb_kvs_cursor_destroy(cur);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_kvs_close(kvs_h);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_close(h);
+    ASSERT_EQ(0, err);
+
+    hse_params_destroy(params);
+}
+
 MTF_DEFINE_UTEST_PREPOST(ikvdb_test, cursor_tx, test_pre_c0, test_post_c0)
 {
     struct ikvdb *         h = NULL;
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_ut/framework.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/hash.h>
+#include <hse_util/timing.h>
+
+#include <hse_ikvdb/kvdb_optrace.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static char path[64];
+
+static int
+pre_test(struct mtf_test_info *info)
+{
+    snprintf(path, sizeof(path), "/tmp/kvdb_optrace_test.%d", getpid());
+    return 0;
+}
+
+static int
+post_test(struct mtf_test_info *info)
+{
+    unlink(path);
+    return 0;
+}
+
+static void *
+read_trace(size_t *lenp)
+{
+    struct stat st;
+    void *      buf;
+    int         fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    if (fstat(fd, &st) || !(buf = malloc(st.st_size + 1))) {
+        close(fd);
+        return NULL;
+    }
+
+    *lenp = read(fd, buf, st.st_size);
+    close(fd);
+
+    return buf;
+}
+
+MTF_BEGIN_UTEST_COLLECTION(kvdb_optrace_test)
+
+MTF_DEFINE_UTEST_PREPOST(kvdb_optrace_test, basic, pre_test, post_test)
+{
+    struct kvdb_optrace_hdr_omf *hdr;
+    struct kvdb_optrace_kvs_omf *krec;
+    struct kvdb_optrace_omf *    rec;
+    struct kvdb_optrace *        ot;
+    const char *                 key = "abcdefgh";
+    void *                       buf;
+    size_t                       len;
+    merr_t                       err;
+    u64                          tstart;
+    int                          i, n = 1000;
+
+    err = kvdb_optrace_create(path, 4 << 20, &ot);
+    ASSERT_EQ(0, err);
+
+    kvdb_optrace_kvs(ot, 7, 4, "kvs1");
+
+    for (i = 0; i < n; i++) {
+        tstart = get_time_ns();
+        kvdb_optrace_op(ot, KVDB_OPTRACE_PUT, 7, 4, NULL, key, 8, i, tstart, 0);
+    }
+
+    kvdb_optrace_op(ot, KVDB_OPTRACE_GET, 7, 4, (void *)0x10, key, 8, 0, get_time_ns(), merr(ENOENT));
+
+    kvdb_optrace_destroy(ot);
+
+    buf = read_trace(&len);
+    ASSERT_NE(NULL, buf);
+
+    hdr = buf;
+    ASSERT_EQ(KVDB_OPTRACE_MAGIC, omf_oth_magic(hdr));
+    ASSERT_EQ(KVDB_OPTRACE_VERSION, omf_oth_version(hdr));
+    ASSERT_EQ(sizeof(*rec), omf_oth_recsz(hdr));
+    ASSERT_EQ(sizeof(*hdr) + (n + 2) * sizeof(*rec), len);
+
+    /* Everything ran on one thread, so records are in order despite
+     * per-cpu buffering unless the thread migrated.  Just check the
+     * contents irrespective of order.
+     */
+    rec = buf + sizeof(*hdr);
+    for (i = 0; i < n + 2; i++, rec++) {
+        switch (omf_otr_op(rec)) {
+        case KVDB_OPTRACE_KVS:
+            krec = (void *)rec;
+            ASSERT_EQ(7, omf_otk_kvs(krec));
+            ASSERT_EQ(4, omf_otk_pfx_len(krec));
+            ASSERT_STREQ("kvs1", krec->otk_name);
+            break;
+
+        case KVDB_OPTRACE_PUT:
+            ASSERT_EQ(7, omf_otr_kvs(rec));
+            ASSERT_EQ(8, omf_otr_klen(rec));
+            ASSERT_EQ(4, omf_otr_pfx_len(rec));
+            ASSERT_EQ(hse_hash64(key, 8), omf_otr_khash(rec));
+            ASSERT_EQ(hse_hash64(key, 4), omf_otr_phash(rec));
+            ASSERT_EQ(0, omf_otr_ctx(rec));
+            ASSERT_EQ(0, omf_otr_err(rec));
+            ASSERT_LT(omf_otr_vlen(rec), n);
+            break;
+
+        case KVDB_OPTRACE_GET:
+            ASSERT_EQ(0x10, omf_otr_ctx(rec));
+            ASSERT_EQ(ENOENT, omf_otr_err(rec));
+            break;
+
+        default:
+            ASSERT_TRUE(false);
+        }
+    }
+
+    free(buf);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvdb_optrace_test, badpath, pre_test, post_test)
+{
+    struct kvdb_optrace *ot = NULL;
+    merr_t               err;
+
+    err = kvdb_optrace_create("/nonexistent/dir/trace", 1 << 20, &ot);
+    ASSERT_EQ(ENOENT, merr_errno(err));
+    ASSERT_EQ(NULL, ot);
+
+    kvdb_optrace_destroy(NULL);
+}
+
+MTF_END_UTEST_COLLECTION(kvdb_optrace_test)
@@ -116,6 +116,12 @@ _kvset_get_metrics(struct kvset *kvset, struct kvset_metrics *metrics)
     metrics->vgroups = 1;
 }
 
+void
+_kvset_get_heat(struct kvset *kvset, struct kvset_heat *heat)
+{
+    memset(heat, 0, sizeof(*heat));
+}
+
 struct kvs_cparams cp;
 
 static int
@@ -163,6 +169,7 @@ test_pre(struct mtf_test_info *ti)
     ct_view_do_nothing = true;
 
     MOCK_SET(kvset_view, _kvset_get_metrics);
+    MOCK_SET(kvset_view, _kvset_get_heat);
 
     /* Rest */
     rest_init();
@@ -192,6 +199,7 @@ static int
 test_post(struct mtf_test_info *ti)
 {
     MOCK_UNSET(kvset_view, _kvset_get_metrics);
+    MOCK_UNSET(kvset_view, _kvset_get_heat);
 
     rest_server_stop();
 
@@ -353,6 +361,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, print_tree_test, test_pre, test_post)
                       "      - 0x70310d\n"
                       "    vblks:\n"
                       "      - 0x70310e\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "  info:\n"
                       "    dgen: 1\n"
                       "    nkeys: 1000000\n"
@@ -362,6 +376,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, print_tree_test, test_pre, test_post)
                       "    nkvsets: 1\n"
                       "    nkblks: 1\n"
                       "    nvblks: 1\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "info:\n"
                       "  name: kvdb_rest_kvs1\n"
                       "  cnid: 0\n"
@@ -414,6 +434,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, empty_root_test, test_pre, test_post)
                       "    nkvsets: 0\n"
                       "    nkblks: 0\n"
                       "    nvblks: 0\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "- loc: \n"
                       "    level: 1\n"
                       "    offset: 0\n"
@@ -432,6 +458,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, empty_root_test, test_pre, test_post)
                       "      - 0x70310d\n"
                       "    vblks:\n"
                       "      - 0x70310e\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "  info:\n"
                       "    dgen: 1\n"
                       "    nkeys: 1000000\n"
@@ -441,6 +473,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, empty_root_test, test_pre, test_post)
                       "    nkvsets: 1\n"
                       "    nkblks: 1\n"
                       "    nvblks: 1\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "info:\n"
                       "  name: kvdb_rest_kvs2\n"
                       "  cnid: 0\n"
@@ -504,6 +542,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, list_without_blkids, test_pre, test_post)
                       "    nkvsets: 0\n"
                       "    nkblks: 0\n"
                       "    nvblks: 0\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "- loc: \n"
                       "    level: 1\n"
                       "    offset: 0\n"
@@ -518,6 +562,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, list_without_blkids, test_pre, test_post)
                       "    vlen: 8000000\n"
                       "    nkblks: 1\n"
                       "    nvblks: 1\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "  - index: 1\n"
                       "    dgen: 8\n"
                       "    nkeys: 1000000\n"
@@ -528,6 +578,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, list_without_blkids, test_pre, test_post)
                       "    vlen: 8000000\n"
                       "    nkblks: 1\n"
                       "    nvblks: 1\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "  info:\n"
                       "    dgen: 8\n"
                       "    nkeys: 2000000\n"
@@ -537,6 +593,12 @@ MTF_DEFINE_UTEST_PREPOST(kvdb_rest, list_without_blkids, test_pre, test_post)
                       "    nkvsets: 2\n"
                       "    nkblks: 2\n"
                       "    nvblks: 2\n"
+                      "    heat:\n"
+                      "      gets: 0\n"
+                      "      bloom_neg: 0\n"
+                      "      bloom_fp: 0\n"
+                      "      wbt_pages: 0\n"
+                      "      cursors: 0\n"
                       "info:\n"
                       "  name: kvdb_rest_kvs2\n"
                       "  cnid: 0\n"
@@ -83,6 +83,18 @@ MTF_DEFINE_UTEST(kvdb_rparams, kvdb_rparams_validate_test)
     n = kvdb_get_num_rparams();
     ASSERT_GT(n, 0);
 
+    p.csched_io_leaf_pct = 0;
+    err = kvdb_rparams_validate(&p);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+
+    p.csched_io_leaf_pct = 101;
+    err = kvdb_rparams_validate(&p);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+
+    p.csched_io_leaf_pct = 100;
+    err = kvdb_rparams_validate(&p);
+    ASSERT_EQ(merr_errno(err), 0);
+
     p.rpmagic = 0xDEADBEEF;
     err = kvdb_rparams_validate(&p);
     ASSERT_EQ(merr_errno(err), EINVAL);
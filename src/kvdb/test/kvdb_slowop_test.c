@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_ut/framework.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/timing.h>
+
+#include <hse_ikvdb/kvdb_slowop.h>
+
+MTF_BEGIN_UTEST_COLLECTION(kvdb_slowop_test)
+
+MTF_DEFINE_UTEST(kvdb_slowop_test, basic)
+{
+    struct kvdb_slowop_rec recv[4];
+    struct kvdb_slowop *   so;
+    merr_t                 err;
+    u64                    tstart, seen;
+    uint                   n;
+    bool                   sampled;
+
+    err = kvdb_slowop_create(1000 * 1000, 100, "kvdb1", &so);
+    ASSERT_EQ(0, err);
+
+    n = kvdb_slowop_get(so, recv, NELEM(recv), &seen);
+    ASSERT_EQ(0, n);
+    ASSERT_EQ(0, seen);
+
+    /* A fast operation is not kept. */
+    sampled = kvdb_slowop_begin(so);
+    ASSERT_TRUE(sampled);
+    ASSERT_TRUE(kvdb_slowop_tls.ss_active);
+    tstart = get_time_ns();
+    kvdb_slowop_end(so, KVDB_OPTRACE_GET, "kvs1", 8, 0, tstart, 0);
+    ASSERT_FALSE(kvdb_slowop_tls.ss_active);
+
+    n = kvdb_slowop_get(so, recv, NELEM(recv), &seen);
+    ASSERT_EQ(0, n);
+
+    /* A slow one is kept along with its stage breakdown. */
+    kvdb_slowop_begin(so);
+    tstart = kvdb_slowop_stage_start();
+    ASSERT_NE(0, tstart);
+    kvdb_slowop_stage_end(KVDB_SLOWOP_CN, tstart - 5000);
+    kvdb_slowop_tls.ss_kvsets = 7;
+    kvdb_slowop_end(so, KVDB_OPTRACE_GET, "kvs1", 8, 100, get_time_ns() - 2000000, merr(ENOENT));
+
+    kvdb_slowop_begin(so);
+    kvdb_slowop_end(so, KVDB_OPTRACE_PUT, "kvs2", 9, 200, get_time_ns() - 3000000, 0);
+
+    n = kvdb_slowop_get(so, recv, NELEM(recv), &seen);
+    ASSERT_EQ(2, n);
+    ASSERT_EQ(2, seen);
+
+    ASSERT_EQ(KVDB_OPTRACE_PUT, recv[0].sr_op);
+    ASSERT_STREQ("kvs2", recv[0].sr_kvs);
+    ASSERT_GE(recv[0].sr_lat_ns, 3000000);
+
+    ASSERT_EQ(KVDB_OPTRACE_GET, recv[1].sr_op);
+    ASSERT_EQ(ENOENT, recv[1].sr_err);
+    ASSERT_EQ(8, recv[1].sr_klen);
+    ASSERT_EQ(100, recv[1].sr_vlen);
+    ASSERT_EQ(7, recv[1].sr_stats.ss_kvsets);
+    ASSERT_GE(recv[1].sr_stats.ss_ns[KVDB_SLOWOP_CN], 5000);
+    ASSERT_EQ(0, recv[1].sr_stats.ss_ns[KVDB_SLOWOP_C0]);
+
+    ASSERT_STREQ("get", kvdb_slowop_op_name(recv[1].sr_op));
+    ASSERT_STREQ("cn", kvdb_slowop_stage_name(KVDB_SLOWOP_CN));
+
+    kvdb_slowop_destroy(so);
+
+    /* Stages are not timed outside of a sampled operation. */
+    ASSERT_EQ(0, kvdb_slowop_stage_start());
+}
+
+MTF_DEFINE_UTEST(kvdb_slowop_test, wrap)
+{
+    struct kvdb_slowop_rec *recv;
+    struct kvdb_slowop *    so;
+    merr_t                  err;
+    u64                     seen;
+    uint                    n, i;
+
+    err = kvdb_slowop_create(1, 100, "kvdb1", &so);
+    ASSERT_EQ(0, err);
+
+    for (i = 0; i < KVDB_SLOWOP_RECS_MAX + 10; i++) {
+        kvdb_slowop_begin(so);
+        kvdb_slowop_end(so, KVDB_OPTRACE_PUT, "kvs1", i, 0, get_time_ns() - 10, 0);
+    }
+
+    recv = calloc(KVDB_SLOWOP_RECS_MAX + 10, sizeof(*recv));
+    ASSERT_NE(NULL, recv);
+
+    n = kvdb_slowop_get(so, recv, KVDB_SLOWOP_RECS_MAX + 10, &seen);
+    ASSERT_EQ(KVDB_SLOWOP_RECS_MAX, n);
+    ASSERT_EQ(KVDB_SLOWOP_RECS_MAX + 10, seen);
+
+    for (i = 0; i < n; i++)
+        ASSERT_EQ(KVDB_SLOWOP_RECS_MAX + 9 - i, recv[i].sr_klen);
+
+    free(recv);
+    kvdb_slowop_destroy(so);
+}
+
+MTF_DEFINE_UTEST(kvdb_slowop_test, badargs)
+{
+    struct kvdb_slowop *so = NULL;
+    merr_t              err;
+
+    err = kvdb_slowop_create(0, 100, "kvdb1", &so);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    ASSERT_EQ(NULL, so);
+
+    kvdb_slowop_destroy(NULL);
+}
+
+MTF_END_UTEST_COLLECTION(kvdb_slowop_test)
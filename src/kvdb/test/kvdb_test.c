@@ -9,6 +9,7 @@
 #include <hse_util/hse_err.h>
 
 #include <hse/hse.h>
+#include <hse/hse_experimental.h>
 
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/kvdb_rparams.h>
@@ -282,6 +283,119 @@ MTF_DEFINE_UTEST_PRE(kvdb_test, kvdb_cursor_test, general_pre)
     ASSERT_EQ(0, rc);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_test, kvdb_cursor_batch_test, general_pre)
+{
+    struct hse_kvdb *         h;
+    struct hse_kvs *          kvs;
+    struct hse_kvs_cursor *   cur;
+    struct hse_kvs_cursor_rec recv[4];
+    char                      buf[64];
+    size_t                    recc;
+    bool                      eof;
+    int                       rc;
+
+    /* API test only: c0, cn and cndb are mocked away. */
+
+    rc = hse_kvdb_open("mp1", 0, &h);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, h);
+
+    rc = hse_kvdb_kvs_make(h, "kv1", 0);
+    ASSERT_EQ(0, rc);
+
+    rc = hse_kvdb_kvs_open(h, "kv1", 0, &kvs);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, kvs);
+
+    rc = hse_kvs_cursor_create(kvs, 0, 0, 0, &cur);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, cur);
+
+    rc = hse_kvs_cursor_read_batch_exp(NULL, 0, buf, sizeof(buf), recv, 4, &recc, &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(rc));
+
+    rc = hse_kvs_cursor_read_batch_exp(cur, 0, NULL, sizeof(buf), recv, 4, &recc, &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(rc));
+
+    rc = hse_kvs_cursor_read_batch_exp(cur, 0, buf, sizeof(buf), NULL, 4, &recc, &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(rc));
+
+    recc = 1;
+    rc = hse_kvs_cursor_read_batch_exp(cur, 0, buf, sizeof(buf), recv, 0, &recc, &eof);
+    ASSERT_EQ(0, rc);
+    ASSERT_EQ(0, recc);
+
+    rc = hse_kvs_cursor_read_batch_exp(cur, 0, buf, sizeof(buf), recv, 4, &recc, &eof);
+    ASSERT_EQ(0, rc);
+    ASSERT_TRUE(recc <= 4);
+    ASSERT_TRUE(recc > 0 || eof);
+
+    rc = hse_kvs_cursor_destroy(cur);
+    ASSERT_EQ(0, rc);
+
+    rc = hse_kvdb_close(h);
+    ASSERT_EQ(0, rc);
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_test, kvdb_cursor_pred_test, general_pre)
+{
+    struct hse_kvdb *          h;
+    struct hse_kvs *           kvs;
+    struct hse_kvs_cursor *    cur;
+    struct hse_kvs_cursor_pred pred = {};
+    const void *               key, *val;
+    size_t                     klen, vlen;
+    bool                       eof;
+    int                        rc;
+
+    /* API test only: c0, cn and cndb are mocked away. */
+
+    rc = hse_kvdb_open("mp1", 0, &h);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, h);
+
+    rc = hse_kvdb_kvs_make(h, "kv1", 0);
+    ASSERT_EQ(0, rc);
+
+    rc = hse_kvdb_kvs_open(h, "kv1", 0, &kvs);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, kvs);
+
+    rc = hse_kvs_cursor_create(kvs, 0, 0, 0, &cur);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, cur);
+
+    rc = hse_kvs_cursor_pred_set_exp(NULL, &pred);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(rc));
+
+    pred.kcp_key_sfx_len = 1;
+    rc = hse_kvs_cursor_pred_set_exp(cur, &pred);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(rc));
+
+    pred.kcp_key_sfx = "x";
+    pred.kcp_val_max = 8;
+    rc = hse_kvs_cursor_pred_set_exp(cur, &pred);
+    ASSERT_EQ(0, rc);
+
+    do {
+        rc = hse_kvs_cursor_read(cur, 0, &key, &klen, &val, &vlen, &eof);
+        ASSERT_EQ(0, rc);
+        if (!eof) {
+            ASSERT_TRUE(klen > 0 && ((const char *)key)[klen - 1] == 'x');
+            ASSERT_TRUE(vlen <= 8);
+        }
+    } while (!eof);
+
+    rc = hse_kvs_cursor_pred_set_exp(cur, NULL);
+    ASSERT_EQ(0, rc);
+
+    rc = hse_kvs_cursor_destroy(cur);
+    ASSERT_EQ(0, rc);
+
+    rc = hse_kvdb_close(h);
+    ASSERT_EQ(0, rc);
+}
+
 mpool_err_t
 _mpool_open(const char *mp_name, uint32_t flags, struct mpool **dsp, struct mpool_devrpt *ei)
 {
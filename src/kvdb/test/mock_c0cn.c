@@ -417,6 +417,8 @@ _cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
+    const struct kc_pred * pred,
     const void *           prefix,
     u32                    pfx_len,
     struct cursor_summary *summary,
@@ -524,6 +526,16 @@ missed:
     return 0;
 }
 
+static void
+_cn_cursor_pred(void *cur, const struct kc_pred *pred)
+{
+}
+
+static void
+_cn_cursor_keys_only(void *cur, bool keys_only)
+{
+}
+
 static void
 _cn_cursor_destroy(void *cur)
 {
@@ -601,6 +613,8 @@ mock_cn_set()
     MOCK_SET(cn_cursor, _cn_cursor_update);
     MOCK_SET(cn_cursor, _cn_cursor_read);
     MOCK_SET(cn_cursor, _cn_cursor_seek);
+    MOCK_SET(cn_cursor, _cn_cursor_pred);
+    MOCK_SET(cn_cursor, _cn_cursor_keys_only);
     MOCK_SET(cn_cursor, _cn_cursor_destroy);
     MOCK_SET(cn_cursor, _cn_cursor_active_kvsets);
 }
@@ -628,6 +642,8 @@ mock_cn_unset()
     MOCK_UNSET(cn_cursor, _cn_cursor_update);
     MOCK_UNSET(cn_cursor, _cn_cursor_read);
     MOCK_UNSET(cn_cursor, _cn_cursor_seek);
+    MOCK_UNSET(cn_cursor, _cn_cursor_pred);
+    MOCK_UNSET(cn_cursor, _cn_cursor_keys_only);
     MOCK_UNSET(cn_cursor, _cn_cursor_destroy);
     MOCK_UNSET(cn_cursor, _cn_cursor_active_kvsets);
 }
@@ -456,6 +456,41 @@ MTF_DEFINE_UTEST_PRE(test, t_workers_concurrent, pre_test)
     sts_destroy(s);
 }
 
+/* Test: idle workers dedicated to one queue run jobs from another */
+MTF_DEFINE_UTEST_PRE(test, t_workers_steal, pre_test)
+{
+    merr_t      err;
+    atomic_t    var;
+    int         v;
+    struct sts *s;
+    struct job  job1, job2;
+
+    atomic_set(&var, 1);
+
+    /* two workers on queue 0, one on queue 1, no shared workers */
+    rp->csched_qthreads = 0x000102;
+    rp->csched_sts_steal = 0;
+
+    err = test_sts_create("steal", 2, &s);
+    ASSERT_EQ(err, 0);
+
+    /* job2 occupies the only queue 1 worker until var == 2 */
+    jsubmit(s, jinit(&job2, 1, 0, &var, 2, 1));
+
+    /* job1 cannot run on queue 1, nor on queue 0 without stealing */
+    jsubmit(s, jinit(&job1, 1, 0, &var, 1, 1));
+    sleep(1);
+    v = atomic_read(&var);
+    ASSERT_EQ(v, 1);
+
+    /* With stealing, an idle queue 0 worker runs job1 and unblocks job2 */
+    rp->csched_sts_steal = 1;
+    err = atomic_read_timeout(&var, 3, 10 * 1000 * 1000);
+    ASSERT_EQ(err, 0);
+
+    sts_destroy(s);
+}
+
 /* Test: pause / resume
  * Test: destroy with jobs in queue
  */
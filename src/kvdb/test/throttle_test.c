@@ -9,6 +9,7 @@
 #include <hse_test_support/mapi_alloc_tester.h>
 
 #include <hse_util/platform.h>
+#include <hse_util/string.h>
 
 #include <hse_ikvdb/throttle.h>
 #include <hse_ikvdb/throttle_perfc.h>
@@ -269,4 +270,118 @@ MTF_DEFINE_UTEST_PRE(test, t_range, pre_test)
     }
 }
 
+MTF_DEFINE_UTEST_PRE(test, t_pid, pre_test)
+{
+    uint delay, prev;
+    int  i;
+
+    kvdb_rp = kvdb_rparams_defaults();
+    strlcpy(kvdb_rp.throttle_init_policy, "pid", sizeof(kvdb_rp.throttle_init_policy));
+
+    throttle_init(t, &kvdb_rp);
+    for (i = 0; i < sc; i++)
+        sv[i] = throttle_sensor(t, i);
+    throttle_init_params(t, &kvdb_rp);
+
+    ASSERT_EQ(THROTTLE_DELAY_START_LIGHT, throttle_delay(t));
+
+    /* c0 over its high water mark: the delay rises smoothly. */
+    throttle_sensor_set(sv[THROTTLE_SENSOR_C0SK], 1500);
+    prev = throttle_delay(t);
+    for (i = 0; i < 100; i++) {
+        delay = throttle_update(t);
+        ASSERT_GE(delay, prev);
+        ASSERT_LE(delay, prev + prev * THROTTLE_PID_STEP_UP_PCT / 100 + 1);
+        prev = delay;
+    }
+    ASSERT_GT(delay, THROTTLE_DELAY_START_LIGHT);
+
+    /* A rising sensor below its setpoint is acted on before it
+     * crosses the setpoint.
+     */
+    throttle_fini(t);
+    throttle_init(t, &kvdb_rp);
+    throttle_init_params(t, &kvdb_rp);
+    for (i = 0; i < 20; i++) {
+        throttle_sensor_set(sv[THROTTLE_SENSOR_C0SK], 100 + i * 30);
+        delay = throttle_update(t);
+    }
+    ASSERT_GT(delay, THROTTLE_DELAY_START_LIGHT);
+
+    /* Idle sensors: the delay falls to the minimum and stays there. */
+    throttle_sensor_set(sv[THROTTLE_SENSOR_C0SK], 0);
+    throttle_sensor_set(sv[THROTTLE_SENSOR_CSCHED], 0);
+    prev = throttle_delay(t);
+    for (i = 0; i < 2000; i++) {
+        delay = throttle_update(t);
+        ASSERT_LE(delay, prev);
+        prev = delay;
+    }
+    ASSERT_EQ(THROTTLE_DELAY_MIN, delay);
+
+    /* Sensors at their setpoints hold the delay steady. */
+    throttle_sensor_set(sv[THROTTLE_SENSOR_C0SK], THROTTLE_PID_SETPOINT_C0SK);
+    throttle_sensor_set(sv[THROTTLE_SENSOR_CSCHED], THROTTLE_PID_SETPOINT_CSCHED);
+    for (i = 0; i < 2000; i++)
+        throttle_update(t);
+    prev = throttle_delay(t);
+    for (i = 0; i < 100; i++)
+        ASSERT_EQ(prev, throttle_update(t));
+
+    throttle_fini(t);
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_share, pre_test)
+{
+    const u64 rate = 1000 * 1000 * 1000;
+    u64       demandv[3], weightv[3], allocv[3];
+    u64       sum;
+
+    /* Nothing to share among. */
+    allocv[0] = 7;
+    throttle_share(rate, 0, demandv, weightv, allocv);
+    ASSERT_EQ(7, allocv[0]);
+
+    /* Idle sharers get the whole rate by weight. */
+    demandv[0] = demandv[1] = 0;
+    weightv[0] = 100;
+    weightv[1] = 300;
+    throttle_share(rate, 2, demandv, weightv, allocv);
+    sum = allocv[0] + allocv[1];
+    ASSERT_LE(sum, rate);
+    ASSERT_GE(sum, rate - 400);
+    ASSERT_GT(allocv[1], 2 * allocv[0]);
+
+    /* Busy sharers are split by weight. */
+    demandv[0] = demandv[1] = rate;
+    throttle_share(rate, 2, demandv, weightv, allocv);
+    ASSERT_GE(allocv[0], rate / 4 - 400);
+    ASSERT_LE(allocv[0], rate / 4);
+    ASSERT_GE(allocv[1], 3 * (rate / 4) - 400);
+    ASSERT_LE(allocv[1], 3 * (rate / 4));
+
+    /* A light sharer keeps its demand plus headroom, the busy ones split
+     * the rest by weight, and nothing is left over.
+     */
+    demandv[0] = rate / 10;
+    demandv[1] = rate;
+    demandv[2] = rate;
+    weightv[0] = 50;
+    weightv[1] = 100;
+    weightv[2] = 100;
+    throttle_share(rate, 3, demandv, weightv, allocv);
+    ASSERT_GE(allocv[0], demandv[0] + demandv[0] / 4);
+    ASSERT_LT(allocv[0], 2 * demandv[0]);
+    ASSERT_EQ(allocv[1], allocv[2]);
+    sum = allocv[0] + allocv[1] + allocv[2];
+    ASSERT_LE(sum, rate);
+    ASSERT_GE(sum, rate - 250);
+
+    /* Every share is non-zero even when there is nothing to share. */
+    throttle_share(0, 3, demandv, weightv, allocv);
+    ASSERT_EQ(1, allocv[0]);
+    ASSERT_EQ(1, allocv[1]);
+    ASSERT_EQ(1, allocv[2]);
+}
+
 MTF_END_UTEST_COLLECTION(test);
@@ -9,6 +9,8 @@
 #include <hse_util/logging.h>
 #include <hse_util/delay.h>
 #include <hse_util/perfc.h>
+#include <hse_util/sdt.h>
+#include <hse_util/flightrec.h>
 
 #include <hse_ikvdb/throttle.h>
 #include <hse_ikvdb/throttle_perfc.h>
@@ -149,7 +151,10 @@ throttle_init_params(struct throttle *self, struct kvdb_rparams *rp)
 {
     u32 time_ms;
 
-    if (strcmp(self->thr_rp->throttle_init_policy, "light") == 0) {
+    if (strcmp(self->thr_rp->throttle_init_policy, "pid") == 0) {
+        self->thr_delay_raw = THROTTLE_DELAY_START_LIGHT;
+        self->thr_pid.tp_enabled = true;
+    } else if (strcmp(self->thr_rp->throttle_init_policy, "light") == 0) {
         self->thr_delay_raw = THROTTLE_DELAY_START_LIGHT;
     } else if (strcmp(self->thr_rp->throttle_init_policy, "medium") == 0) {
         self->thr_delay_raw = THROTTLE_DELAY_START_MEDIUM;
@@ -172,6 +177,8 @@ throttle_init_params(struct throttle *self, struct kvdb_rparams *rp)
 
     self->thr_state = THROTTLE_NO_CHANGE;
     self->thr_update_ms = rp->throttle_update_ns / 1000000;
+    self->thr_update_ms = max_t(uint, self->thr_update_ms, 1);
+    self->thr_pid.tp_delay = self->thr_delay_raw;
 
     self->thr_inject_cycles = THROTTLE_INJECT_MS / self->thr_update_ms +
                               (THROTTLE_INJECT_MS % self->thr_update_ms ? 1 : 0);
@@ -385,6 +392,7 @@ throttle_switch_state(struct throttle *self, enum throttle_state state, uint max
     if (self->thr_state != state) {
         assert(self->thr_state == THROTTLE_NO_CHANGE);
         self->thr_state = state;
+        flightrec_add(FLIGHTREC_THROTTLE_STATE, state, max);
     }
 
     assert(self->thr_state == state);
@@ -397,12 +405,104 @@ throttle_switch_state(struct throttle *self, enum throttle_state state, uint max
     }
 }
 
+static void
+throttle_pid_debug(struct throttle *self, double pred)
+{
+    struct throttle_pid *pid = &self->thr_pid;
+
+    hse_log(
+        HSE_NOTICE "throttle: pid delay %d err %.3f pred %.0f c0sk %.0f/%.1f csched %.0f/%.1f",
+        self->thr_delay_raw,
+        pid->tp_err,
+        pred,
+        pid->tp_avgv[THROTTLE_SENSOR_C0SK],
+        pid->tp_slopev[THROTTLE_SENSOR_C0SK],
+        pid->tp_avgv[THROTTLE_SENSOR_CSCHED],
+        pid->tp_slopev[THROTTLE_SENSOR_CSCHED]);
+}
+
+/*
+ * throttle_pid_update() - one step of the feedback controller
+ * @sensorv: current sensor values
+ *
+ * The error is the largest amount by which a sensor is predicted to
+ * exceed its setpoint (or, if negative, the smallest margin below it),
+ * normalized to THROTTLE_SENSOR_SCALE.  The delay is scaled by a
+ * velocity-form PI step, so there is no integral term to wind up while
+ * the delay sits at THROTTLE_DELAY_MIN or THROTTLE_DELAY_MAX.
+ */
+static void
+throttle_pid_update(struct throttle *self, const uint *sensorv)
+{
+    struct throttle_pid *pid = &self->thr_pid;
+    const double         alpha = THROTTLE_PID_SMOOTH_PCT / 100.0;
+    const double         dt = self->thr_update_ms / 1000.0;
+    const double         horizon = (double)THROTTLE_PID_HORIZON_MS / self->thr_update_ms;
+    double               err, step, pred = 0;
+    int                  i;
+
+    err = -1.0 * (2 * THROTTLE_SENSOR_SCALE);
+
+    for (i = 0; i < THROTTLE_SENSOR_CNT; i++) {
+        double setpoint, avg, p;
+
+        setpoint = (i == THROTTLE_SENSOR_CSCHED) ? THROTTLE_PID_SETPOINT_CSCHED
+                                                 : THROTTLE_PID_SETPOINT_C0SK;
+
+        if (!pid->tp_primed) {
+            pid->tp_avgv[i] = sensorv[i];
+            pid->tp_slopev[i] = 0;
+        }
+
+        avg = pid->tp_avgv[i] + alpha * (sensorv[i] - pid->tp_avgv[i]);
+        pid->tp_slopev[i] += alpha * ((avg - pid->tp_avgv[i]) - pid->tp_slopev[i]);
+        pid->tp_avgv[i] = avg;
+
+        /* Extrapolate only rising sensors, a falling sensor will be
+         * seen soon enough.
+         */
+        p = avg + max_t(double, pid->tp_slopev[i], 0) * horizon;
+        p = min_t(double, p, 2 * THROTTLE_SENSOR_SCALE);
+
+        if (p - setpoint > err) {
+            err = p - setpoint;
+            pred = p;
+        }
+    }
+
+    err /= THROTTLE_SENSOR_SCALE;
+
+    if (!pid->tp_primed) {
+        pid->tp_err = err;
+        pid->tp_primed = true;
+    }
+
+    step = THROTTLE_PID_KP * (err - pid->tp_err) + THROTTLE_PID_KI * err * dt;
+    step = min_t(double, step, THROTTLE_PID_STEP_UP_PCT / 100.0);
+    step = max_t(double, step, -THROTTLE_PID_STEP_DOWN_PCT / 100.0);
+
+    pid->tp_err = err;
+    pid->tp_delay *= 1.0 + step;
+    pid->tp_delay = max_t(double, pid->tp_delay, THROTTLE_DELAY_MIN);
+    pid->tp_delay = min_t(double, pid->tp_delay, THROTTLE_DELAY_MAX);
+
+    self->thr_delay_raw = pid->tp_delay;
+
+    if (self->thr_rp->throttle_debug & THROTTLE_DEBUG_REDUCE) {
+        u32 debug_intvl_cycles = 40U * self->thr_rp->throttle_debug_intvl_s;
+
+        if (self->thr_cycles % debug_intvl_cycles == 0)
+            throttle_pid_debug(self, pred);
+    }
+}
+
 uint
 throttle_update(struct throttle *self)
 {
     struct throttle_mavg *mavg = &self->thr_mavg;
     u32                   max_val = 0;
     u64                   debug = self->thr_rp->throttle_debug;
+    uint                  sensorv[THROTTLE_SENSOR_CNT];
 
     for (int i = 0; i < THROTTLE_SENSOR_CNT; i++) {
         u32  tmp = atomic_read(&self->thr_sensorv[i].ts_sensor);
@@ -410,6 +510,7 @@ throttle_update(struct throttle *self)
         bool ignore = false;
 
         tmp = min_t(uint, tmp, 2 * THROTTLE_SENSOR_SCALE);
+        sensorv[i] = tmp;
 
         switch (i) {
             case THROTTLE_SENSOR_CSCHED:
@@ -471,7 +572,9 @@ throttle_update(struct throttle *self)
     if (unlikely(self->thr_rp->throttle_disable))
         return 0;
 
-    if (self->thr_state != THROTTLE_NO_CHANGE) {
+    if (self->thr_pid.tp_enabled) {
+        throttle_pid_update(self, sensorv);
+    } else if (self->thr_state != THROTTLE_NO_CHANGE) {
         throttle_switch_state(self, self->thr_state, max_val);
     } else if (mavg->tm_sample_cnt >= THROTTLE_SMAX_CNT) {
         assert(mavg->tm_sample_cnt == THROTTLE_SMAX_CNT);
@@ -563,6 +666,14 @@ throttle_update(struct throttle *self)
             throttle_debug(self);
     }
 
+    HSE_SDT(
+        throttle_update,
+        self->thr_delay_raw,
+        max_val,
+        mavg->tm_curr,
+        self->thr_csched,
+        self->thr_state);
+
     return self->thr_delay_raw;
 }
 
@@ -579,3 +690,66 @@ throttle_debug(struct throttle *self)
             atomic_read(&self->thr_sensorv[0].ts_sensor),
             atomic_read(&self->thr_sensorv[1].ts_sensor));
 }
+
+void
+throttle_share(u64 rate, uint shrc, const u64 *demandv, const u64 *weightv, u64 *allocv)
+{
+    u64  weight, wtotal, remain;
+    uint i;
+    bool changed;
+
+    if (!shrc)
+        return;
+
+    weight = 0;
+    for (i = 0; i < shrc; i++) {
+        allocv[i] = 0;
+        weight += weightv[i];
+    }
+
+    wtotal = weight;
+
+    /* Water-fill: grant sharers whose demand is under their weighted share
+     * of the remaining rate, then repeat with what they leave behind.
+     */
+    remain = rate;
+    do {
+        changed = false;
+
+        for (i = 0; i < shrc && weight > 0; i++) {
+            u64 want;
+
+            if (allocv[i])
+                continue;
+
+            want = demandv[i] + demandv[i] / 4;
+            want = max_t(u64, want, rate / (8 * shrc) + 1);
+
+            if (want <= remain / weight * weightv[i]) {
+                allocv[i] = want;
+                remain -= want;
+                weight -= weightv[i];
+                changed = true;
+            }
+        }
+    } while (changed);
+
+    /* Sharers that want more than their share split what is left by weight.
+     */
+    if (weight > 0) {
+        u64 unit = remain / weight;
+
+        for (i = 0; i < shrc; i++) {
+            if (!allocv[i]) {
+                allocv[i] = unit * weightv[i];
+                remain -= allocv[i];
+            }
+        }
+    }
+
+    /* Give whatever is still left (e.g., when every sharer was satisfied)
+     * to all sharers by weight so that the whole rate is handed out.
+     */
+    for (i = 0; i < shrc; i++)
+        allocv[i] = max_t(u64, allocv[i] + remain / wtotal * weightv[i], 1);
+}
@@ -29,6 +29,7 @@
 #include <hse_ikvdb/key_hash.h>
 #include <hse_ikvdb/cn_cursor.h>
 #include <hse_ikvdb/kvdb_ctxn.h>
+#include <hse_ikvdb/kvdb_slowop.h>
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/cursor.h>
@@ -121,7 +122,8 @@ struct perfc_name kvs_cc_perfc_op[] = {
     NE(PERFC_BA_CC_TOMB_SKIPLEN, 3, "Count of cursor c0 tombs skipped (len)", "c_c0_tombs_skipped"),
     NE(PERFC_BA_CC_TOMB_SPAN_ADD, 3, "Count of cursor c0 tombs added to span", "c_c0_tombs_add"),
     NE(PERFC_BA_CC_TOMB_SPAN_TIME, 3, "Tomb span build time since invalidate", "c_c0_tombspan_"
-                                                                               "time")
+                                                                               "time"),
+    NE(PERFC_BA_CC_PRED_SKIP, 3, "Count of cursor pairs rejected by predicate", "c_pred_skips"),
 };
 
 NE_CHECK(kvs_cc_perfc_op, PERFC_EN_CC, "cursor cache perfc ops table/enum mismatch");
@@ -148,8 +150,8 @@ NE_CHECK(kvs_cd_perfc_op, PERFC_EN_CD, "cursor dist perfc ops table/enum mismatc
 
 /* "pkvsl" stands for Public KVS interface Latencies" */
 struct perfc_name kvs_pkvsl_perfc_op[] = {
-    NE(PERFC_LT_PKVSL_KVS_PUT, 3, "kvs_put latency", "kvs_put_lat", 7),
-    NE(PERFC_LT_PKVSL_KVS_GET, 3, "kvs_get latency", "kvs_get_lat", 7),
+    NE(PERFC_HG_PKVSL_KVS_PUT, 3, "kvs_put latency", "kvs_put_lat", 7),
+    NE(PERFC_HG_PKVSL_KVS_GET, 3, "kvs_get latency", "kvs_get_lat", 7),
     NE(PERFC_LT_PKVSL_KVS_DEL, 3, "kvs_delete latency", "kvs_del_lat", 7),
 
     NE(PERFC_LT_PKVSL_KVS_PFX_PROBE, 3, "kvs_prefix_probe latency", "kvs_pfx_probe_lat"),
@@ -157,15 +159,19 @@ struct perfc_name kvs_pkvsl_perfc_op[] = {
 
     NE(PERFC_LT_PKVSL_KVS_CURSOR_CREATE, 3, "kvs_cursor_create latency", "kvs_cursor_create_lat"),
     NE(PERFC_LT_PKVSL_KVS_CURSOR_UPDATE, 3, "kvs_cursor_update latency", "kvs_cursor_update_lat"),
-    NE(PERFC_LT_PKVSL_KVS_CURSOR_SEEK, 3, "kvs_cursor_seek latency", "kvs_cursor_seek_lat"),
-    NE(PERFC_LT_PKVSL_KVS_CURSOR_READFWD,
+    NE(PERFC_HG_PKVSL_KVS_CURSOR_SEEK, 3, "kvs_cursor_seek latency", "kvs_cursor_seek_lat"),
+    NE(PERFC_HG_PKVSL_KVS_CURSOR_READFWD,
        3,
        "kvs_cursor_read forward latency",
        "kvs_cursor_readfwd_lat"),
-    NE(PERFC_LT_PKVSL_KVS_CURSOR_READREV,
+    NE(PERFC_HG_PKVSL_KVS_CURSOR_READREV,
        3,
        "kvs_cursor_read reverse latency",
        "kvs_cursor_readrev_lat"),
+    NE(PERFC_HG_PKVSL_KVS_CURSOR_READBATCH,
+       3,
+       "kvs_cursor_read_batch latency (per batch)",
+       "kvs_cursor_readbatch_lat"),
     NE(PERFC_LT_PKVSL_KVS_CURSOR_DESTROY,
        3,
        "kvs_cursor_destroy latency",
@@ -260,7 +266,8 @@ struct kvs_cursor_impl {
     u32 kci_toss : 1;
     u32 kci_force_toss : 1;
     u32 kci_reverse : 1;
-    u32 kci_unused : 15;
+    u32 kci_keys_only : 1;
+    u32 kci_unused : 14;
     u32 kci_pfx_len : 8;
 
     u64    kci_pfxhash;
@@ -533,7 +540,7 @@ ikvs_put(
     struct c0 *c0 = kvs->ikv_c0;
     size_t     sfx_len;
     size_t     hashlen;
-    u64        tstart;
+    u64        tstart, stage;
     merr_t     err;
 
     tstart = perfc_lat_start(pkvsl_pc);
@@ -556,12 +563,15 @@ ikvs_put(
         return merr(EINVAL);
     }
 
+    stage = kvdb_slowop_stage_start();
+
     if (unlikely(os && os->kop_txn))
         err = kvdb_ctxn_put(kvdb_ctxn_h2h(os->kop_txn), c0, kt, vt);
     else
         err = c0_put(c0, kt, vt, seqno);
 
-    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_PUT, tstart);
+    kvdb_slowop_stage_end(KVDB_SLOWOP_C0, stage);
+    perfc_lat_record(pkvsl_pc, PERFC_HG_PKVSL_KVS_PUT, tstart);
 
     return err;
 }
@@ -580,7 +590,7 @@ ikvs_get(
     struct cn *       cn = kvs->ikv_cn;
     struct kvdb_ctxn *ctxn;
     size_t            hashlen;
-    u64               tstart;
+    u64               tstart, stage;
     merr_t            err;
 
     tstart = perfc_lat_start(pkvsl_pc);
@@ -590,11 +600,15 @@ ikvs_get(
 
     ctxn = (os && os->kop_txn) ? kvdb_ctxn_h2h(os->kop_txn) : 0;
 
+    stage = kvdb_slowop_stage_start();
+
     if (!ctxn)
         err = c0_get(c0, kt, seqno, 0, res, vbuf);
     else
         err = kvdb_ctxn_get(ctxn, c0, cn, kt, res, vbuf);
 
+    kvdb_slowop_stage_end(KVDB_SLOWOP_C0, stage);
+
     if (!err && *res == NOT_FOUND) {
         if (ctxn) {
             err = kvdb_ctxn_get_view_seqno(ctxn, &seqno);
@@ -602,10 +616,12 @@ ikvs_get(
                 return err;
         }
 
+        stage = kvdb_slowop_stage_start();
         err = cn_get(cn, kt, seqno, res, vbuf);
+        kvdb_slowop_stage_end(KVDB_SLOWOP_CN, stage);
     }
 
-    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_GET, tstart);
+    perfc_lat_record(pkvsl_pc, PERFC_HG_PKVSL_KVS_GET, tstart);
 
     return err;
 }
@@ -1357,6 +1373,7 @@ ikvs_cursor_alloc(struct ikvs *kvs, const void *prefix, size_t pfx_len, bool rev
          * else if seek is done, already at correct location
          */
         ikvs_cursor_reset(cur, BIT_BOTH);
+        ikvs_cursor_pred_set(&cur->kci_handle, NULL);
 
         return &cur->kci_handle;
     }
@@ -1523,6 +1540,8 @@ ikvs_cursor_init(struct hse_kvs_cursor *cursor)
         goto error;
     }
 
+    cur->kci_keys_only = !!(cursor->kc_flags & HSE_KVDB_KOP_FLAG_KEYS_ONLY);
+
     if (!cur->kci_cncur) {
         perfc_inc(cur->kci_cc_pc, PERFC_BA_CC_INIT_CREATE_CN);
 
@@ -1531,12 +1550,19 @@ ikvs_cursor_init(struct hse_kvs_cursor *cursor)
             cn,
             seqno,
             cur->kci_reverse,
+            cur->kci_keys_only,
+            &cursor->kc_pred,
             cur->kci_prefix,
             cur->kci_pfx_len,
             &cur->kci_summary,
             &cur->kci_cncur);
         perfc_lat_record(cur->kci_cd_pc, PERFC_LT_CD_CREATE_CN, tstart);
     } else {
+        /* The cursor is re-seeked below, which restarts any parallel
+         * merge with the new keys-only setting.
+         */
+        cn_cursor_keys_only(cur->kci_cncur, cur->kci_keys_only);
+
         tstart = perfc_lat_start(cur->kci_cd_pc);
         err = cn_cursor_update(cur->kci_cncur, seqno, &updated);
         perfc_lat_record(cur->kci_cd_pc, PERFC_LT_CD_UPDATE_CN, tstart);
@@ -2174,12 +2200,62 @@ ikvs_cursor_replenish(struct kvs_cursor_impl *cursor, bool *eofp)
     return 0;
 }
 
-merr_t
-ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *eofp)
+/*
+ * ikvs_cursor_pred_match() - test a key/value pair against the cursor predicate
+ *
+ * cn applies the predicate before fetching values, so this mostly serves
+ * to filter c0.  The value pattern is not tested against compressed values
+ * or values that were not fetched.
+ */
+static bool
+ikvs_cursor_pred_match(const struct kc_pred *pred, const struct kvs_kvtuple *kvt)
 {
-    struct kvs_cursor_impl *cursor = (void *)handle;
-    int                     oready;
-    int                     rc;
+    const struct kvs_vtuple *vt = &kvt->kvt_value;
+
+    if (HSE_CORE_IS_TOMB(vt->vt_data))
+        return true;
+
+    if (!kc_pred_key(pred, kvt->kvt_key.kt_data, kvt->kvt_key.kt_len))
+        return false;
+
+    if (kvs_vtuple_clen(vt) || !vt->vt_data)
+        return kc_pred_vlen(pred, kvs_vtuple_ulen(vt));
+
+    return kc_pred_val(pred, vt->vt_data, kvs_vtuple_vlen(vt));
+}
+
+void
+ikvs_cursor_pred_set(struct hse_kvs_cursor *handle, const struct kc_pred *pred)
+{
+    struct kvs_cursor_impl *cursor = cursor_h2r(handle);
+
+    if (pred)
+        handle->kc_pred = *pred;
+    else
+        memset(&handle->kc_pred, 0, sizeof(handle->kc_pred));
+
+    if (cursor->kci_cncur)
+        cn_cursor_pred(cursor->kci_cncur, &handle->kc_pred);
+}
+
+/*
+ * ikvs_cursor_read_impl() - read the next key/value pair
+ *
+ * If the next pair is larger than @room then return ENOSPC without
+ * consuming it, leaving the cursor positioned at that pair.  The pair
+ * is still returned in @kvt so that the caller may learn its size.
+ */
+static merr_t
+ikvs_cursor_read_impl(
+    struct kvs_cursor_impl *cursor,
+    struct kvs_kvtuple *    kvt,
+    bool *                  eofp,
+    size_t                  room)
+{
+    struct kvs_kvtuple *next;
+    uint                vlen;
+    int                 oready;
+    int                 rc;
 
     if (ev(cursor->kci_err)) {
         if (ev(merr_errno(cursor->kci_err) != EAGAIN))
@@ -2188,6 +2264,7 @@ ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *e
         cursor->kci_err = 0;
     }
 
+again:
     if (cursor->kci_ready != BIT_BOTH)
         cursor->kci_err = ikvs_cursor_replenish(cursor, eofp);
     else
@@ -2212,6 +2289,28 @@ ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *e
         return 0;
     }
 
+    next = rc <= 0 ? &cursor->kci_c0kv : &cursor->kci_cnkv;
+    vlen = cursor->kci_keys_only ? 0 : kvs_vtuple_vlen(&next->kvt_value);
+
+    /* Consume pairs rejected by the predicate (along with any older
+     * version of the same key in cn) and try again.
+     */
+    if (unlikely(kc_pred_active(&cursor->kci_handle.kc_pred)) &&
+        !ikvs_cursor_pred_match(&cursor->kci_handle.kc_pred, next)) {
+        perfc_inc(cursor->kci_cc_pc, PERFC_BA_CC_PRED_SKIP);
+
+        if (rc <= 0)
+            cursor->kci_ready &= ~(rc == 0 ? BIT_BOTH : BIT_C0);
+        else
+            cursor->kci_ready &= ~BIT_CN;
+        goto again;
+    }
+
+    if (next->kvt_key.kt_len + vlen > room) {
+        *kvt = *next;
+        return merr(ENOSPC);
+    }
+
     cursor->kci_summary.util++;
     oready = cursor->kci_ready;
 
@@ -2261,6 +2360,10 @@ ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *e
 
     *kvt = *cursor->kci_last;
 
+    /* A keys-only cursor returns the value length without its data. */
+    if (cursor->kci_keys_only)
+        kvs_vtuple_init(&kvt->kvt_value, NULL, kvs_vtuple_ulen(&kvt->kvt_value));
+
     /* see comments in seek; do not change data state if peek */
     if (cursor->kci_peek) {
         cursor->kci_peek = 0;
@@ -2270,6 +2373,67 @@ ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *e
     return 0;
 }
 
+merr_t
+ikvs_cursor_read(struct hse_kvs_cursor *handle, struct kvs_kvtuple *kvt, bool *eofp)
+{
+    return ikvs_cursor_read_impl((void *)handle, kvt, eofp, SIZE_MAX);
+}
+
+merr_t
+ikvs_cursor_read_batch(
+    struct hse_kvs_cursor *handle,
+    void *                 buf,
+    size_t                 bufsz,
+    struct kvs_kvtuple *   kvtv,
+    uint                   kvtmax,
+    uint *                 kvtc,
+    bool *                 eofp)
+{
+    struct kvs_cursor_impl *cursor = (void *)handle;
+    char *                  dst = buf;
+    merr_t                  err = 0;
+    uint                    n;
+
+    *eofp = false;
+
+    for (n = 0; n < kvtmax; ++n) {
+        struct kvs_kvtuple kvt;
+        uint               klen, vlen;
+
+        err = ikvs_cursor_read_impl(cursor, &kvt, eofp, bufsz - (dst - (char *)buf));
+        if (err || *eofp)
+            break;
+
+        klen = kvt.kvt_key.kt_len;
+
+        memcpy(dst, kvt.kvt_key.kt_data, klen);
+        kvs_ktuple_init_nohash(&kvtv[n].kvt_key, dst, klen);
+        dst += klen;
+
+        if (cursor->kci_keys_only) {
+            kvtv[n].kvt_value = kvt.kvt_value;
+            continue;
+        }
+
+        vlen = kvs_vtuple_vlen(&kvt.kvt_value);
+
+        memcpy(dst, kvt.kvt_value.vt_data, vlen);
+        kvs_vtuple_init(&kvtv[n].kvt_value, dst, vlen);
+        dst += vlen;
+    }
+
+    *kvtc = n;
+
+    /* Pairs already copied out take precedence over an error (or a
+     * full buffer) encountered while reading the next pair.  Errors
+     * are sticky in the cursor, so the next call will report it.
+     */
+    if (n > 0)
+        return 0;
+
+    return merr_errno(err) == ENOSPC ? err : ev(err);
+}
+
 #undef bit_on
 
 static merr_t
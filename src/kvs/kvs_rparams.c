@@ -50,6 +50,7 @@ kvs_rparams_defaults(void)
         .cn_bloom_prob = 10000,
         .cn_bloom_capped = 0,
         .cn_bloom_preload = 0,
+        .cn_bloom_pfx = 0,
 
         .cn_node_size_lo = 20 * 1024,
         .cn_node_size_hi = 28 * 1024,
@@ -57,6 +58,10 @@ kvs_rparams_defaults(void)
         .cn_compact_vblk_ra = 256 * 1024,
         .cn_compact_kblk_ra = 512 * 1024,
         .cn_compact_vra = 128 * 1024,
+        .cn_compact_subc = 0,
+        .cn_compact_subc_min = 8 * 1024,
+        .cn_compact_tiered = 0,
+        .cn_ingest_partition = 0,
 
         .c0_cursor_ttl = 1000,
 
@@ -65,8 +70,12 @@ kvs_rparams_defaults(void)
 
         .cn_cursor_ttl = 1000,
         .cn_cursor_vra = 8 * 1024,
+        .cn_cursor_vra_max = 1024 * 1024,
+        .cn_cursor_ra_qdepth = 32,
         .cn_cursor_kra = 0,
         .cn_cursor_seq = 0,
+        .cn_cursor_par = 0,
+        .cn_cursor_parmin = 32,
 
         .cn_mcache_wbt = 0,
         .cn_mcache_vmin = 256,
@@ -93,6 +102,10 @@ kvs_rparams_defaults(void)
         .vblock_size_mb = 32,
 
         .capped_evict_ttl = 120,
+        .kvs_ttl = 0,
+
+        .throttle_put_rate = 0,
+        .throttle_weight = 100,
 
         .c1_vblock_cap = 96,
         .c1_vblock_size_mb = 32,
@@ -127,14 +140,22 @@ static struct param_inst  kvs_rp_table[] = {
     KVS_PARAM_EXP(cn_compact_vblk_ra, "compaction vblk read-ahead (bytes)"),
     KVS_PARAM_EXP(cn_compact_vra, "compaction vblk read-ahead via mcache"),
     KVS_PARAM_EXP(cn_compact_kblk_ra, "compaction kblk read-ahead (bytes)"),
+    KVS_PARAM_EXP(cn_compact_subc, "max key-range subcompactions per job (0: disable)"),
+    KVS_PARAM_EXP(cn_compact_subc_min, "min job read size to split into subcompactions (MiB)"),
+    KVS_PARAM_EXP(cn_compact_tiered, "use size-tiered leaf compaction (0: per csched_policy)"),
+    KVS_PARAM_EXP(cn_ingest_partition, "ingest directly into root's children when root is empty"),
 
     KVS_PARAM_EXP(cn_capped_ttl, "cn cursor cache TTL (ms) for capped kvs"),
     KVS_PARAM_EXP(cn_capped_vra, "capped cursor vblk madvise-ahead (bytes)"),
 
     KVS_PARAM_EXP(cn_cursor_ttl, "cached cN cursor time-to-live (ms)"),
     KVS_PARAM_EXP(cn_cursor_vra, "cursor vblk madvise-ahead (bytes)"),
+    KVS_PARAM_EXP(cn_cursor_vra_max, "max adaptive cursor vblk readahead (bytes, 0: static)"),
+    KVS_PARAM_EXP(cn_cursor_ra_qdepth, "max async cursor readaheads before growth stops"),
     KVS_PARAM_EXP(cn_cursor_kra, "cursor kblk madvise-ahead (boolean)"),
     KVS_PARAM_EXP(cn_cursor_seq, "optimize cn_tree for longer sequential cursor accesses"),
+    KVS_PARAM_EXP(cn_cursor_par, "max cursor merge helper threads (0: disable)"),
+    KVS_PARAM_EXP(cn_cursor_parmin, "min kvsets for a parallel cursor merge"),
 
     KVS_PARAM_EXP(
         cn_mcache_wbt,
@@ -167,6 +188,7 @@ static struct param_inst  kvs_rp_table[] = {
     KVS_PARAM_EXP(cn_bloom_prob, "bloom create probability"),
     KVS_PARAM_EXP(cn_bloom_capped, "bloom create probability (capped kvs)"),
     KVS_PARAM_EXP(cn_bloom_preload, "preload mcache bloom filters"),
+    KVS_PARAM_EXP(cn_bloom_pfx, "add pfx_len key prefixes to kblock blooms"),
 
     KVS_PARAM_EXP(cn_compaction_debug, "cn compaction debug flags"),
     KVS_PARAM_EXP(cn_maint_delay, "ms of delay between checks when idle"),
@@ -182,6 +204,10 @@ static struct param_inst  kvs_rp_table[] = {
     KVS_PARAM_EXP(vblock_size_mb, "preferred vblock size (in MiB)"),
 
     KVS_PARAM_EXP(capped_evict_ttl, "capped vblock TTL (seconds)"),
+    KVS_PARAM_EXP(kvs_ttl, "expire data this long after ingest into cn (seconds, 0: disable)"),
+
+    KVS_PARAM_EXP(throttle_put_rate, "max put rate (bytes/sec, 0: unlimited)"),
+    KVS_PARAM_EXP(throttle_weight, "share of the kvdb throttle rate (see throttle_fair_share)"),
 
     KVS_PARAM_EXP(c1_vblock_cap, "Max. no. vblocks loaned from c1 per cN"),
     KVS_PARAM_EXP(c1_vblock_size_mb, "preferred c1 vblock size (in MiB)"),
@@ -304,6 +330,32 @@ kvs_rparams_validate(struct kvs_rparams *params)
         return merr(EINVAL);
     }
 
+    if (params->cn_cursor_vra_max > 0 &&
+        (params->cn_cursor_vra_max < params->cn_cursor_vra ||
+         params->cn_cursor_vra_max > 16 * 1024 * 1024)) {
+        hse_log(HSE_ERR "cn_cursor_vra_max(%lu) must be 0 or in the range [cn_cursor_vra, 16MiB]",
+                (ulong)params->cn_cursor_vra_max);
+        return merr(EINVAL);
+    }
+
+    if (params->cn_compact_subc > 64) {
+        hse_log(HSE_ERR "cn_compact_subc(%lu) must be in the range [0, 64]",
+                (ulong)params->cn_compact_subc);
+        return merr(EINVAL);
+    }
+
+    if (params->cn_cursor_par > 64) {
+        hse_log(HSE_ERR "cn_cursor_par(%lu) must be in the range [0, 64]",
+                (ulong)params->cn_cursor_par);
+        return merr(EINVAL);
+    }
+
+    if (params->throttle_weight < 1 || params->throttle_weight > 10000) {
+        hse_log(HSE_ERR "throttle_weight(%lu) must be in the range [1, 10000]",
+                (ulong)params->throttle_weight);
+        return merr(EINVAL);
+    }
+
     sz = params->kblock_size_mb << 20;
     if (sz < KBLOCK_MIN_SIZE || sz > KBLOCK_MAX_SIZE) {
         hse_log(
@@ -163,6 +163,9 @@ MTF_DEFINE_UTEST(kvs_rparams, kvs_rparams_validate_test)
     EXP_SUCCESS(p.cn_close_wait = 1);
 
     TEST_MIN(p.cn_maint_delay, 20);
+
+    TEST_MIN(p.throttle_weight, 1);
+    TEST_MAX(p.throttle_weight, 10000);
 }
 
 static u64
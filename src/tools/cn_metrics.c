@@ -31,10 +31,14 @@ usage(void)
     printf("-b      show all kblock/vblock IDs\n"
            "-f FMT  set output format\n"
            "-h      show this help list\n"
+           "-H      show read heat of each kvset and node\n"
            "-l      use alternate node loc format\n"
            "-n      show node-level data only (skip kvsets)\n"
            "-y      output tree shape in yaml\n"
            "FMT  h=human(default), s=scalar, x=hex, e=exp\n"
+           "\n"
+           "Read heat counts only the reads made by this process, use the\n"
+           "REST tree endpoint of a running application to see its heat.\n"
            "\n");
 }
 
@@ -212,6 +216,7 @@ struct options {
     int  all_blocks;
     int  yaml_output;
     int  alternate_loc;
+    int  heat;
 
     /* derived */
     char *loc_hdr;
@@ -226,7 +231,7 @@ process_options(int argc, char *argv[])
 {
     int c;
 
-    while ((c = getopt(argc, argv, ":bf:hlny")) != -1) {
+    while ((c = getopt(argc, argv, ":bf:hHlny")) != -1) {
         switch (c) {
             case 'h':
                 usage();
@@ -234,6 +239,9 @@ process_options(int argc, char *argv[])
             case 'b':
                 opt.all_blocks = 1;
                 break;
+            case 'H':
+                opt.heat = 1;
+                break;
             case 'l':
                 opt.alternate_loc = 1;
                 break;
@@ -449,6 +457,17 @@ print_hdr(void)
         (opt.nodes_only ? "" : " KblockIDs  / VblockIDs"));
 }
 
+static void
+print_heat(const char *tag, struct kvset_heat *heat)
+{
+    int i;
+
+    printf("#%s heat", tag);
+    for (i = 0; i < KVSET_HEAT_MAX; i++)
+        printf(" %s %lu", kvset_heat_name(i), (ulong)heat->kh_ctrv[i]);
+    printf("\n");
+}
+
 static int
 tree_walk_callback(
     void *               rock,
@@ -494,6 +513,13 @@ tree_walk_callback(
             DIVZ(1e2 * ns.ns_vclen, n->ks.kst_valen),
             cn_ns_samp(&ns) / 1e2);
 
+        if (opt.heat) {
+            struct kvset_heat heat;
+
+            cn_node_heat_get(node, &heat);
+            print_heat("Node", &heat);
+        }
+
         memset(n, 0, sizeof(*n));
         c->node_kvsets = 0;
         return 0;
@@ -524,6 +550,13 @@ tree_walk_callback(
         printf(" /");
         print_ids(kvset, kvset_get_num_vblocks, kvset_get_nth_vblock_id, limit);
         printf("\n");
+
+        if (opt.heat) {
+            struct kvset_heat heat;
+
+            kvset_get_heat(kvset, &heat);
+            print_heat("Kvset", &heat);
+        }
     }
 
     return 0;
@@ -0,0 +1,1140 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+/*
+ * microbench - measure the core in-memory data structures
+ *
+ * Runs each selected benchmark once for every combination of key size,
+ * data size (number of keys loaded into the structure) and thread count,
+ * and reports throughput (ops/s, all threads) and latency (ns/op, per
+ * thread).  With -j the results are written as one JSON document so that
+ * successive runs can be archived and compared by CI.
+ *
+ * Setup (e.g., loading the keys a lookup benchmark searches for) is not
+ * timed.  Benchmarks of structures that are built by a single thread run
+ * only when the thread count is 1.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/alloc.h>
+#include <hse_util/atomic.h>
+#include <hse_util/bin_heap.h>
+#include <hse_util/bloom_filter.h>
+#include <hse_util/bonsai_tree.h>
+#include <hse_util/cursor_heap.h>
+#include <hse_util/element_source.h>
+#include <hse_util/hash.h>
+#include <hse_util/key_util.h>
+#include <hse_util/keylock.h>
+#include <hse_util/page.h>
+#include <hse_util/parse_num.h>
+#include <hse_util/rcu.h>
+#include <hse_util/rmlock.h>
+#include <hse_util/seqno.h>
+#include <hse_util/slab.h>
+#include <hse_util/string.h>
+#include <hse_util/timing.h>
+#include <hse_util/xrand.h>
+
+#include <hse/hse.h>
+#include <hse/hse_limits.h>
+
+#include <hse_ikvdb/omf_kmd.h>
+#include <hse_ikvdb/tuple.h>
+
+#include "../cn/omf.h"
+#include "../cn/kvs_mblk_desc.h"
+#include "../cn/wbt_builder.h"
+#include "../cn/wbt_internal.h"
+#include "../cn/wbt_reader.h"
+#include "../kvdb/viewset.h"
+
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sysexits.h>
+
+#define MB_LIST_MAX    16
+#define MB_HEAP_WIDTH  16
+#define MB_KMEM_BATCH  32
+#define MB_BLOOM_PROB  10000
+
+const char *progname;
+
+struct mbctx;
+
+/**
+ * struct mbench - one benchmark
+ * @mb_name:     name
+ * @mb_mt:       may be run from more than one thread
+ * @mb_setup:    prepare @ctx->priv (not timed)
+ * @mb_run:      timed body, returns the number of operations performed
+ * @mb_teardown: release @ctx->priv
+ */
+struct mbench {
+    const char *mb_name;
+    bool        mb_mt;
+    void (*mb_setup)(struct mbctx *ctx);
+    u64 (*mb_run)(struct mbctx *ctx, uint tidx);
+    void (*mb_teardown)(struct mbctx *ctx);
+};
+
+/**
+ * struct mbctx - one benchmark run
+ * @klen:    key length
+ * @nelem:   keys loaded into (or built into) the structure
+ * @ops:     operations per thread, for benchmarks not bounded by @nelem
+ * @threads: thread count
+ * @keys:    @nelem keys of @klen bytes each, in ascending order
+ * @priv:    benchmark private state
+ */
+struct mbctx {
+    uint              klen;
+    u64               nelem;
+    u64               ops;
+    uint              threads;
+    char *            keys;
+    void *            priv;
+    pthread_barrier_t barrier;
+};
+
+struct mbworker {
+    pthread_t     tid;
+    struct mbctx *ctx;
+    uint          tidx;
+    u64           ops;
+};
+
+static const struct mbench *mbench;
+static atomic64_t           mb_sink;
+static uint                 mb_heap_klen;
+
+static void
+fatal(const char *fmt, ...)
+{
+    char    msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "%s: %s\n", progname, msg);
+    exit(1);
+}
+
+static void
+syntax(const char *fmt, ...)
+{
+    char    msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "%s: %s, use -h for help\n", progname, msg);
+    exit(EX_USAGE);
+}
+
+static inline const void *
+key_at(const struct mbctx *ctx, u64 i)
+{
+    return ctx->keys + i * ctx->klen;
+}
+
+/* Keys share a constant prefix and end with their big-endian index, so
+ * they sort in index order and look like the structured keys typical of
+ * real workloads.
+ */
+static void
+keys_init(struct mbctx *ctx)
+{
+    u64 i;
+    uint b;
+
+    ctx->keys = malloc(ctx->nelem * ctx->klen);
+    if (!ctx->keys)
+        fatal("cannot allocate %lu keys", (ulong)ctx->nelem);
+
+    for (i = 0; i < ctx->nelem; i++) {
+        u8 *key = (u8 *)key_at(ctx, i);
+
+        for (b = 0; b < ctx->klen; b++)
+            key[ctx->klen - 1 - b] = (b < 8) ? (i >> (8 * b)) & 0xff : 'k';
+    }
+}
+
+static inline u64
+key_rand(const struct mbctx *ctx)
+{
+    return xrand64_tls() % ctx->nelem;
+}
+
+/*
+ * bonsai_tree: single-writer inserts and concurrent RCU lookups
+ */
+struct mbbonsai {
+    struct cheap *      cheap;
+    struct bonsai_root *root;
+    u64                 val;
+};
+
+static void
+mb_bonsai_ior_cb(
+    void *                rock,
+    enum bonsai_ior_code *code,
+    struct bonsai_kv *    kv,
+    struct bonsai_val *   val,
+    struct bonsai_val **  old_val)
+{
+    if (IS_IOR_INS(*code) || !val)
+        return;
+
+    SET_IOR_REP(*code);
+    val->bv_next = NULL;
+    *old_val = kv->bkv_values;
+    rcu_assign_pointer(kv->bkv_values, val);
+}
+
+static void
+mb_bonsai_create(struct mbctx *ctx)
+{
+    struct mbbonsai *b;
+    merr_t           err;
+
+    b = calloc(1, sizeof(*b));
+    if (!b)
+        fatal("cannot allocate bonsai benchmark");
+
+    /* Nodes replaced while rebalancing are not reclaimed from the cheap. */
+    b->cheap = cheap_create(16, ctx->nelem * (ctx->klen + 1024) + (64ul << 20));
+    if (!b->cheap)
+        fatal("cannot create cheap");
+
+    err = bn_create(b->cheap, 32 * 1024, mb_bonsai_ior_cb, NULL, &b->root);
+    if (err)
+        fatal("cannot create bonsai tree: %d", merr_errno(err));
+
+    ctx->priv = b;
+}
+
+static u64
+mb_bonsai_insert(struct mbctx *ctx, uint tidx)
+{
+    struct mbbonsai *b = ctx->priv;
+    u64              i;
+
+    for (i = 0; i < ctx->nelem; i++) {
+        struct bonsai_skey skey;
+        struct bonsai_sval sval;
+        merr_t             err;
+
+        bn_skey_init(key_at(ctx, i), ctx->klen, 0, &skey);
+        bn_sval_init(&b->val, sizeof(b->val), HSE_ORDNL_TO_SQNREF(i + 1), &sval);
+
+        err = bn_insert_or_replace(b->root, &skey, &sval, false);
+        if (err)
+            fatal("bonsai insert failed: %d", merr_errno(err));
+    }
+
+    return ctx->nelem;
+}
+
+static void
+mb_bonsai_load(struct mbctx *ctx)
+{
+    mb_bonsai_create(ctx);
+    mb_bonsai_insert(ctx, 0);
+}
+
+static u64
+mb_bonsai_find(struct mbctx *ctx, uint tidx)
+{
+    struct mbbonsai * b = ctx->priv;
+    struct bonsai_kv *kv;
+    u64               i, hits = 0;
+
+    for (i = 0; i < ctx->ops; i++) {
+        struct bonsai_skey skey;
+
+        bn_skey_init(key_at(ctx, key_rand(ctx)), ctx->klen, 0, &skey);
+
+        rcu_read_lock();
+        hits += bn_find(b->root, &skey, &kv);
+        rcu_read_unlock();
+    }
+
+    atomic64_add(hits, &mb_sink);
+
+    return ctx->ops;
+}
+
+static void
+mb_bonsai_destroy(struct mbctx *ctx)
+{
+    struct mbbonsai *b = ctx->priv;
+
+    bn_destroy(b->root);
+    cheap_destroy(b->cheap);
+    free(b);
+}
+
+/*
+ * bloom_filter: inserts and lookups, half of the latter negative
+ */
+struct mbbloom {
+    struct bloom_filter bf;
+    u8 *                bitmap;
+};
+
+static void
+mb_bloom_create(struct mbctx *ctx)
+{
+    struct bf_bithash_desc desc;
+    struct mbbloom *       b;
+    size_t                 sz;
+
+    b = calloc(1, sizeof(*b));
+    if (!b)
+        fatal("cannot allocate bloom benchmark");
+
+    desc = bf_compute_bithash_est(MB_BLOOM_PROB);
+    sz = bf_size_estimate(desc, ctx->nelem);
+
+    b->bitmap = alloc_page_aligned(sz);
+    if (!b->bitmap)
+        fatal("cannot allocate %zu byte bloom", sz);
+
+    memset(b->bitmap, 0, sz);
+    bf_filter_init(&b->bf, desc, ctx->nelem, b->bitmap, sz);
+
+    ctx->priv = b;
+}
+
+static u64
+mb_bloom_insert(struct mbctx *ctx, uint tidx)
+{
+    struct mbbloom *b = ctx->priv;
+    u64             i;
+
+    for (i = 0; i < ctx->nelem; i++)
+        bf_filter_insert_by_hash(&b->bf, hse_hash64(key_at(ctx, i), ctx->klen));
+
+    return ctx->nelem;
+}
+
+static void
+mb_bloom_load(struct mbctx *ctx)
+{
+    struct mbbloom *b;
+    u64             i;
+
+    mb_bloom_create(ctx);
+    b = ctx->priv;
+
+    for (i = 0; i < ctx->nelem; i += 2)
+        bf_filter_insert_by_hash(&b->bf, hse_hash64(key_at(ctx, i), ctx->klen));
+}
+
+static u64
+mb_bloom_lookup(struct mbctx *ctx, uint tidx)
+{
+    struct mbbloom *          b = ctx->priv;
+    const struct bloom_filter *bf = &b->bf;
+    u64                       i, hits = 0;
+
+    for (i = 0; i < ctx->ops; i++) {
+        u64       hash = hse_hash64(key_at(ctx, key_rand(ctx)), ctx->klen);
+        const u8 *bitmap = bf->bf_bitmap;
+
+        bitmap += bf_hash2bkt(hash, bf->bf_modulus, bf->bf_bktshift);
+        hits += bf_lookup(hash, bitmap, bf->bf_n_hashes, bf->bf_rotl, bf->bf_bktmask);
+    }
+
+    atomic64_add(hits, &mb_sink);
+
+    return ctx->ops;
+}
+
+static void
+mb_bloom_destroy(struct mbctx *ctx)
+{
+    struct mbbloom *b = ctx->priv;
+
+    free_aligned(b->bitmap);
+    free(b);
+}
+
+/*
+ * wbtree: building (the in-memory part of kblock building) and point
+ * lookups through the current (v5) reader on a tree held in memory
+ */
+struct mbwbt {
+    struct wbb *         wbb;
+    uint                 max_pgc;
+    uint                 wbt_pgc;
+    struct iovec *       iov;
+    uint                 iovc;
+    uint                 iov_max;
+    struct wbt_hdr_omf   hdr;
+    void *               tree;
+    struct wbt_desc      wbd;
+    struct kvs_mblk_desc kbd;
+};
+
+static void
+mb_wbt_create(struct mbctx *ctx)
+{
+    struct mbwbt *w;
+    merr_t        err;
+
+    w = calloc(1, sizeof(*w));
+    if (!w)
+        fatal("cannot allocate wbtree benchmark");
+
+    /* Room for every key in the leaves plus its kmd, with slack for
+     * internal nodes.
+     */
+    w->max_pgc = 2 * ((ctx->nelem * (ctx->klen + 16)) / PAGE_SIZE) + 64;
+    w->iov_max = w->max_pgc + 16;
+
+    w->iov = calloc(w->iov_max, sizeof(*w->iov));
+    if (!w->iov)
+        fatal("cannot allocate wbtree iovecs");
+
+    err = wbb_create(&w->wbb, w->max_pgc, &w->wbt_pgc);
+    if (err)
+        fatal("cannot create wbtree builder: %d", merr_errno(err));
+
+    ctx->priv = w;
+}
+
+static u64
+mb_wbt_build(struct mbctx *ctx, uint tidx)
+{
+    struct mbwbt *w = ctx->priv;
+    u8            kmd[16];
+    merr_t        err;
+    u64           i;
+
+    for (i = 0; i < ctx->nelem; i++) {
+        struct key_obj ko;
+        size_t         kmdlen = 0;
+        bool           added;
+
+        key2kobj(&ko, key_at(ctx, i), ctx->klen);
+        kmd_add_zval(kmd, &kmdlen, 1);
+
+        err = wbb_add_entry(w->wbb, &ko, 1, kmd, kmdlen, w->max_pgc, &w->wbt_pgc, &added);
+        if (err || !added)
+            fatal("wbtree full after %lu keys, use a smaller data size", (ulong)i);
+    }
+
+    wbb_hdr_init(w->wbb, &w->hdr);
+
+    err = wbb_freeze(w->wbb, &w->hdr, w->max_pgc, &w->wbt_pgc, w->iov, w->iov_max, &w->iovc);
+    if (err)
+        fatal("cannot freeze wbtree: %d", merr_errno(err));
+
+    return ctx->nelem;
+}
+
+static void
+mb_wbt_load(struct mbctx *ctx)
+{
+    struct mbwbt *w;
+    size_t        len = 0;
+    void *        p;
+    uint          i;
+
+    mb_wbt_create(ctx);
+    mb_wbt_build(ctx, 0);
+    w = ctx->priv;
+
+    for (i = 0; i < w->iovc; i++)
+        len += w->iov[i].iov_len;
+
+    w->tree = alloc_page_aligned(len);
+    if (!w->tree)
+        fatal("cannot allocate %zu byte wbtree", len);
+
+    for (i = 0, p = w->tree; i < w->iovc; i++) {
+        memcpy(p, w->iov[i].iov_base, w->iov[i].iov_len);
+        p += w->iov[i].iov_len;
+    }
+
+    w->kbd.map_base = w->tree;
+
+    w->wbd.wbd_first_page = 0;
+    w->wbd.wbd_n_pages = w->wbt_pgc;
+    w->wbd.wbd_version = WBT_TREE_VERSION;
+    w->wbd.wbd_root = omf_wbt_root(&w->hdr);
+    w->wbd.wbd_leaf = omf_wbt_leaf(&w->hdr);
+    w->wbd.wbd_leaf_cnt = omf_wbt_leaf_cnt(&w->hdr);
+    w->wbd.wbd_kmd_pgc = omf_wbt_kmd_pgc(&w->hdr);
+}
+
+static u64
+mb_wbt_lookup(struct mbctx *ctx, uint tidx)
+{
+    struct mbwbt *w = ctx->priv;
+    u64           i, hits = 0;
+
+    for (i = 0; i < ctx->ops; i++) {
+        enum key_lookup_res   res = NOT_FOUND;
+        struct kvs_vtuple_ref vref;
+        struct kvs_ktuple     kt;
+        merr_t                err;
+
+        kvs_ktuple_init_nohash(&kt, key_at(ctx, key_rand(ctx)), ctx->klen);
+
+        err = wbtr_read_vref(&w->kbd, &w->wbd, &kt, 0, 1, &res, &vref);
+        if (err)
+            fatal("wbtree lookup failed: %d", merr_errno(err));
+
+        hits += (res == FOUND_VAL);
+    }
+
+    atomic64_add(hits, &mb_sink);
+
+    return ctx->ops;
+}
+
+static void
+mb_wbt_destroy(struct mbctx *ctx)
+{
+    struct mbwbt *w = ctx->priv;
+
+    free_aligned(w->tree);
+    wbb_destroy(w->wbb);
+    free(w->iov);
+    free(w);
+}
+
+/*
+ * bin_heap2: merge MB_HEAP_WIDTH sorted sources, as compaction and
+ * cursors do
+ */
+struct mbsrc {
+    struct element_source es;
+    const char *          base;
+    size_t                stride;
+    u64                   cnt;
+    u64                   next;
+};
+
+struct mbheap {
+    struct bin_heap2 *     bh;
+    struct mbsrc           srcv[MB_HEAP_WIDTH];
+    struct element_source *esv[MB_HEAP_WIDTH];
+};
+
+static bool
+mb_src_next(struct element_source *es, void **item)
+{
+    struct mbsrc *s = container_of(es, struct mbsrc, es);
+
+    if (s->next >= s->cnt)
+        return false;
+
+    *item = (void *)(s->base + s->next++ * s->stride);
+
+    return true;
+}
+
+static int
+mb_heap_cmp(const void *a, const void *b)
+{
+    return memcmp(a, b, mb_heap_klen);
+}
+
+static void
+mb_heap_setup(struct mbctx *ctx)
+{
+    struct mbheap *h;
+    merr_t         err;
+    uint           i;
+
+    h = calloc(1, sizeof(*h));
+    if (!h)
+        fatal("cannot allocate bin_heap2 benchmark");
+
+    err = bin_heap2_create(MB_HEAP_WIDTH, mb_heap_cmp, &h->bh);
+    if (err)
+        fatal("cannot create bin_heap2: %d", merr_errno(err));
+
+    mb_heap_klen = ctx->klen;
+
+    /* Source i yields keys i, i + width, i + 2 * width, ... */
+    for (i = 0; i < MB_HEAP_WIDTH; i++) {
+        struct mbsrc *s = h->srcv + i;
+
+        s->es = es_make(mb_src_next, NULL, NULL);
+        s->base = key_at(ctx, i);
+        s->stride = (size_t)ctx->klen * MB_HEAP_WIDTH;
+        s->cnt = ctx->nelem / MB_HEAP_WIDTH + (i < ctx->nelem % MB_HEAP_WIDTH);
+        h->esv[i] = &s->es;
+    }
+
+    ctx->priv = h;
+}
+
+static u64
+mb_heap_merge(struct mbctx *ctx, uint tidx)
+{
+    struct mbheap *h = ctx->priv;
+    void *         item;
+    merr_t         err;
+    u64            n = 0;
+
+    err = bin_heap2_prepare(h->bh, MB_HEAP_WIDTH, h->esv);
+    if (err)
+        fatal("cannot prepare bin_heap2: %d", merr_errno(err));
+
+    while (bin_heap2_pop(h->bh, &item))
+        n++;
+
+    if (n != ctx->nelem)
+        fatal("bin_heap2 merged %lu of %lu keys", (ulong)n, (ulong)ctx->nelem);
+
+    return n;
+}
+
+static void
+mb_heap_teardown(struct mbctx *ctx)
+{
+    struct mbheap *h = ctx->priv;
+
+    bin_heap2_destroy(h->bh);
+    free(h);
+}
+
+/*
+ * cheap: key-sized allocations, resetting the cheap whenever it fills
+ */
+static void
+mb_cheap_setup(struct mbctx *ctx)
+{
+    ctx->priv = cheap_create(8, 64ul << 20);
+    if (!ctx->priv)
+        fatal("cannot create cheap");
+}
+
+static u64
+mb_cheap_malloc(struct mbctx *ctx, uint tidx)
+{
+    struct cheap *h = ctx->priv;
+    u64           i;
+
+    for (i = 0; i < ctx->ops; i++) {
+        char *p = cheap_malloc(h, ctx->klen);
+
+        if (!p) {
+            cheap_reset(h, 0);
+            p = cheap_malloc(h, ctx->klen);
+        }
+
+        *p = i;
+    }
+
+    return ctx->ops;
+}
+
+static void
+mb_cheap_teardown(struct mbctx *ctx)
+{
+    cheap_destroy(ctx->priv);
+}
+
+/*
+ * keylock: lock and unlock random keys, one table shared by all threads
+ */
+static void
+mb_keylock_setup(struct mbctx *ctx)
+{
+    struct keylock *kl;
+    merr_t          err;
+
+    err = keylock_create(ctx->nelem, NULL, &kl);
+    if (err)
+        fatal("cannot create keylock: %d", merr_errno(err));
+
+    ctx->priv = kl;
+}
+
+static u64
+mb_keylock_lock(struct mbctx *ctx, uint tidx)
+{
+    struct keylock_cb_rock *rock = (void *)(uintptr_t)(tidx + 1);
+    struct keylock *        kl = ctx->priv;
+    u64                     i, busy = 0;
+
+    for (i = 0; i < ctx->ops; i++) {
+        u64    hash = xrand64_tls();
+        bool   inherited;
+        merr_t err;
+
+        err = keylock_lock(kl, hash, 0, rock, &inherited);
+        if (err) {
+            busy++;
+            continue;
+        }
+
+        keylock_unlock(kl, hash, rock);
+    }
+
+    atomic64_add(busy, &mb_sink);
+
+    return ctx->ops;
+}
+
+static void
+mb_keylock_teardown(struct mbctx *ctx)
+{
+    keylock_destroy(ctx->priv);
+}
+
+/*
+ * viewset: insert and remove a view, as each transaction and cursor does
+ */
+struct mbviewset {
+    struct viewset *vs;
+    atomic64_t      seqno;
+};
+
+static void
+mb_viewset_setup(struct mbctx *ctx)
+{
+    struct mbviewset *v;
+    merr_t            err;
+
+    v = calloc(1, sizeof(*v));
+    if (!v)
+        fatal("cannot allocate viewset benchmark");
+
+    atomic64_set(&v->seqno, 1);
+
+    err = viewset_create(&v->vs, &v->seqno);
+    if (err)
+        fatal("cannot create viewset: %d", merr_errno(err));
+
+    ctx->priv = v;
+}
+
+static u64
+mb_viewset_insrem(struct mbctx *ctx, uint tidx)
+{
+    struct mbviewset *v = ctx->priv;
+    u64               i;
+
+    for (i = 0; i < ctx->ops; i++) {
+        void * cookie;
+        u64    view, minview;
+        u32    minchg;
+        merr_t err;
+
+        err = viewset_insert(v->vs, &view, &cookie);
+        if (err)
+            fatal("viewset insert failed: %d", merr_errno(err));
+
+        viewset_remove(v->vs, cookie, &minchg, &minview);
+    }
+
+    return ctx->ops;
+}
+
+static void
+mb_viewset_teardown(struct mbctx *ctx)
+{
+    struct mbviewset *v = ctx->priv;
+
+    viewset_destroy(v->vs);
+    free(v);
+}
+
+/*
+ * rmlock: read lock and unlock
+ */
+static void
+mb_rmlock_setup(struct mbctx *ctx)
+{
+    struct rmlock *lock;
+    merr_t         err;
+
+    lock = alloc_aligned(sizeof(*lock), SMP_CACHE_BYTES);
+    if (!lock)
+        fatal("cannot allocate rmlock");
+
+    err = rmlock_init(lock);
+    if (err)
+        fatal("cannot init rmlock: %d", merr_errno(err));
+
+    ctx->priv = lock;
+}
+
+static u64
+mb_rmlock_rlock(struct mbctx *ctx, uint tidx)
+{
+    struct rmlock *lock = ctx->priv;
+    u64            i;
+
+    for (i = 0; i < ctx->ops; i++) {
+        void *cookie;
+
+        rmlock_rlock(lock, &cookie);
+        rmlock_runlock(cookie);
+    }
+
+    return ctx->ops;
+}
+
+static void
+mb_rmlock_teardown(struct mbctx *ctx)
+{
+    rmlock_destroy(ctx->priv);
+    free_aligned(ctx->priv);
+}
+
+/*
+ * kmem_cache: allocate and free key-sized objects in small batches
+ */
+static void
+mb_kmem_setup(struct mbctx *ctx)
+{
+    ctx->priv = kmem_cache_create("microbench", ctx->klen, 0, 0, NULL);
+    if (!ctx->priv)
+        fatal("cannot create kmem cache");
+}
+
+static u64
+mb_kmem_alloc(struct mbctx *ctx, uint tidx)
+{
+    struct kmem_cache *zone = ctx->priv;
+    void *             memv[MB_KMEM_BATCH];
+    u64                i;
+    uint               j;
+
+    for (i = 0; i < ctx->ops; i += MB_KMEM_BATCH) {
+        for (j = 0; j < MB_KMEM_BATCH; j++) {
+            memv[j] = kmem_cache_alloc(zone);
+            if (!memv[j])
+                fatal("kmem_cache_alloc failed");
+        }
+
+        for (j = 0; j < MB_KMEM_BATCH; j++)
+            kmem_cache_free(zone, memv[j]);
+    }
+
+    return i;
+}
+
+static void
+mb_kmem_teardown(struct mbctx *ctx)
+{
+    kmem_cache_destroy(ctx->priv);
+}
+
+static const struct mbench mbenchv[] = {
+    { "bonsai_insert", false, mb_bonsai_create, mb_bonsai_insert, mb_bonsai_destroy },
+    { "bonsai_find", true, mb_bonsai_load, mb_bonsai_find, mb_bonsai_destroy },
+    { "bloom_insert", false, mb_bloom_create, mb_bloom_insert, mb_bloom_destroy },
+    { "bloom_lookup", true, mb_bloom_load, mb_bloom_lookup, mb_bloom_destroy },
+    { "wbt_build", false, mb_wbt_create, mb_wbt_build, mb_wbt_destroy },
+    { "wbt_lookup", true, mb_wbt_load, mb_wbt_lookup, mb_wbt_destroy },
+    { "bin_heap2_merge", false, mb_heap_setup, mb_heap_merge, mb_heap_teardown },
+    { "cheap_malloc", false, mb_cheap_setup, mb_cheap_malloc, mb_cheap_teardown },
+    { "keylock_lock", true, mb_keylock_setup, mb_keylock_lock, mb_keylock_teardown },
+    { "viewset_insrem", true, mb_viewset_setup, mb_viewset_insrem, mb_viewset_teardown },
+    { "rmlock_rlock", true, mb_rmlock_setup, mb_rmlock_rlock, mb_rmlock_teardown },
+    { "kmem_cache_alloc", true, mb_kmem_setup, mb_kmem_alloc, mb_kmem_teardown },
+};
+
+static void *
+mb_main(void *arg)
+{
+    struct mbworker *w = arg;
+
+    pthread_barrier_wait(&w->ctx->barrier);
+
+    w->ops = mbench->mb_run(w->ctx, w->tidx);
+
+    return NULL;
+}
+
+/**
+ * mb_run() - run one benchmark once
+ * @ctx:    run parameters
+ * @opsp:   (output) operations performed by all threads
+ *
+ * Return: elapsed time in nanoseconds
+ */
+static u64
+mb_run(struct mbctx *ctx, u64 *opsp)
+{
+    struct mbworker *workerv;
+    u64              start, ops = 0;
+    uint             i;
+
+    workerv = calloc(ctx->threads, sizeof(*workerv));
+    if (!workerv)
+        fatal("cannot allocate workers");
+
+    mbench->mb_setup(ctx);
+
+    if (pthread_barrier_init(&ctx->barrier, NULL, ctx->threads + 1))
+        fatal("cannot create barrier");
+
+    for (i = 0; i < ctx->threads; i++) {
+        workerv[i].ctx = ctx;
+        workerv[i].tidx = i;
+
+        if (pthread_create(&workerv[i].tid, NULL, mb_main, workerv + i))
+            fatal("cannot create thread: %s", strerror(errno));
+    }
+
+    pthread_barrier_wait(&ctx->barrier);
+    start = get_time_ns();
+
+    for (i = 0; i < ctx->threads; i++) {
+        pthread_join(workerv[i].tid, NULL);
+        ops += workerv[i].ops;
+    }
+
+    start = get_time_ns() - start;
+
+    pthread_barrier_destroy(&ctx->barrier);
+    mbench->mb_teardown(ctx);
+    free(workerv);
+
+    *opsp = ops;
+
+    return start;
+}
+
+static void
+parse_list(const char *opt, char *arg, u64 min, u64 max, u64 *listv, uint *listc)
+{
+    char *tok, *save = NULL;
+
+    *listc = 0;
+
+    for (tok = strtok_r(arg, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        if (*listc >= MB_LIST_MAX)
+            syntax("too many values for option '-%s'", opt);
+
+        if (parse_size_range(tok, min, max, listv + *listc))
+            syntax("invalid value '%s' for option '-%s'", tok, opt);
+
+        ++*listc;
+    }
+
+    if (!*listc)
+        syntax("missing value for option '-%s'", opt);
+}
+
+static bool
+mb_selected(const char *name, char *filter)
+{
+    char  buf[256];
+    char *tok, *save = NULL;
+
+    if (!filter)
+        return true;
+
+    strlcpy(buf, filter, sizeof(buf));
+
+    for (tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
+        if (!strncmp(name, tok, strlen(tok)))
+            return true;
+
+    return false;
+}
+
+static void
+usage(void)
+{
+    uint i;
+
+    printf("usage: %s [options]\n", progname);
+
+    printf("-b LIST  run benchmarks whose names start with an element of LIST\n"
+           "-h       show this help list\n"
+           "-j       write results as JSON\n"
+           "-k LIST  key sizes in bytes (default: 8,32,128)\n"
+           "-l       list benchmarks\n"
+           "-n LIST  data sizes in keys (default: 100000)\n"
+           "-o N     operations per thread for lookup and lock benchmarks "
+           "(default: 1000000)\n"
+           "-r N     run each combination N times, report the fastest (default: 1)\n"
+           "-t LIST  thread counts (default: 1,4)\n"
+           "\n"
+           "LIST is a comma-separated list, e.g. -k 16,64 -n 10k,1m.\n"
+           "ops/s is the aggregate rate of all threads, ns/op the mean\n"
+           "latency seen by one thread.\n"
+           "\n"
+           "Benchmarks:\n");
+
+    for (i = 0; i < NELEM(mbenchv); i++)
+        printf("  %-18s %s\n", mbenchv[i].mb_name, mbenchv[i].mb_mt ? "" : "(single thread)");
+}
+
+int
+main(int argc, char **argv)
+{
+    u64       klenv[MB_LIST_MAX] = { 8, 32, 128 };
+    u64       nelemv[MB_LIST_MAX] = { 100000 };
+    u64       threadv[MB_LIST_MAX] = { 1, 4 };
+    uint      klenc = 3, nelemc = 1, threadc = 2;
+    u64       ops = 1000000, reps = 1;
+    char *    filter = NULL;
+    bool      json = false, first = true;
+    uint      b, k, n, t, r;
+    hse_err_t herr;
+    int       c;
+
+    progname = (progname = strrchr(argv[0], '/')) ? progname + 1 : argv[0];
+
+    while ((c = getopt(argc, argv, ":b:hjk:ln:o:r:t:")) != -1) {
+        switch (c) {
+            case 'b':
+                filter = optarg;
+                break;
+            case 'h':
+                usage();
+                return 0;
+            case 'j':
+                json = true;
+                break;
+            case 'k':
+                parse_list("k", optarg, 1, HSE_KVS_KLEN_MAX, klenv, &klenc);
+                break;
+            case 'l':
+                for (b = 0; b < NELEM(mbenchv); b++)
+                    printf("%s\n", mbenchv[b].mb_name);
+                return 0;
+            case 'n':
+                parse_list("n", optarg, MB_HEAP_WIDTH, 1ul << 32, nelemv, &nelemc);
+                break;
+            case 'o':
+                if (parse_size_range(optarg, 1, U64_MAX, &ops))
+                    syntax("invalid operation count '%s'", optarg);
+                break;
+            case 'r':
+                if (parse_size_range(optarg, 1, 1000, &reps))
+                    syntax("invalid repeat count '%s'", optarg);
+                break;
+            case 't':
+                parse_list("t", optarg, 1, 1024, threadv, &threadc);
+                break;
+            case ':':
+                syntax("missing argument for option '-%c'", optopt);
+                break;
+            default:
+                syntax("invalid option '-%c'", optopt);
+                break;
+        }
+    }
+
+    if (argc - optind > 0)
+        syntax("extraneous argument '%s'", argv[optind]);
+
+    herr = hse_kvdb_init();
+    if (herr)
+        fatal("cannot initialize hse");
+
+    if (json)
+        printf("{\n  \"benchmarks\": [");
+    else
+        printf(
+            "%-18s %7s %5s %10s %12s %14s %10s\n",
+            "NAME",
+            "THREADS",
+            "KLEN",
+            "NELEM",
+            "OPS",
+            "OPS/S",
+            "NS/OP");
+
+    for (b = 0; b < NELEM(mbenchv); b++) {
+        mbench = mbenchv + b;
+
+        if (!mb_selected(mbench->mb_name, filter))
+            continue;
+
+        for (k = 0; k < klenc; k++) {
+            for (n = 0; n < nelemc; n++) {
+                struct mbctx ctx = {
+                    .klen = klenv[k],
+                    .nelem = nelemv[n],
+                    .ops = ops,
+                };
+
+                keys_init(&ctx);
+
+                for (t = 0; t < threadc; t++) {
+                    u64    best_ns = U64_MAX, best_ops = 0;
+                    double ops_sec, ns_op;
+
+                    ctx.threads = threadv[t];
+                    if (ctx.threads > 1 && !mbench->mb_mt)
+                        continue;
+
+                    for (r = 0; r < reps; r++) {
+                        u64 nops, ns;
+
+                        ns = mb_run(&ctx, &nops);
+                        if (ns < best_ns) {
+                            best_ns = ns ?: 1;
+                            best_ops = nops;
+                        }
+                    }
+
+                    ops_sec = best_ops * 1e9 / best_ns;
+                    ns_op = (double)best_ns * ctx.threads / best_ops;
+
+                    if (json) {
+                        printf(
+                            "%s\n    { \"name\": \"%s\", \"threads\": %u, \"klen\": %u, "
+                            "\"nelem\": %lu, \"ops\": %lu, \"elapsed_ns\": %lu, "
+                            "\"ops_per_sec\": %.1f, \"ns_per_op\": %.2f }",
+                            first ? "" : ",",
+                            mbench->mb_name,
+                            ctx.threads,
+                            ctx.klen,
+                            (ulong)ctx.nelem,
+                            (ulong)best_ops,
+                            (ulong)best_ns,
+                            ops_sec,
+                            ns_op);
+                        first = false;
+                    } else {
+                        printf(
+                            "%-18s %7u %5u %10lu %12lu %14.0f %10.2f\n",
+                            mbench->mb_name,
+                            ctx.threads,
+                            ctx.klen,
+                            (ulong)ctx.nelem,
+                            (ulong)best_ops,
+                            ops_sec,
+                            ns_op);
+                    }
+
+                    fflush(stdout);
+                }
+
+                free(ctx.keys);
+            }
+        }
+    }
+
+    if (json)
+        printf("\n  ]\n}\n");
+
+    hse_kvdb_fini();
+
+    return 0;
+}
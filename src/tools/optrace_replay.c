@@ -0,0 +1,744 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+/*
+ * optrace_replay - re-drive an operation trace against a KVDB
+ *
+ * Reads a trace written by a KVDB opened with the optrace_path rparam,
+ * sorts it by time and replays it from a pool of threads.  Operations of
+ * a given transaction or cursor always run on the same thread, as do the
+ * remaining operations of each traced thread, so per-thread and per-txn
+ * ordering is preserved while the replay keeps the original concurrency.
+ *
+ * Keys are synthesized from the traced key hashes: the KVS prefix part of
+ * each key is derived from its prefix hash and the rest from its key hash,
+ * so keys that were equal (or shared a prefix) in the original workload
+ * are equal (or share a prefix) in the replay.  Value contents are
+ * arbitrary but value sizes are preserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/hash.h>
+#include <hse_util/hdr_hist.h>
+#include <hse_util/parse_num.h>
+#include <hse_util/string.h>
+#include <hse_util/timing.h>
+#include <hse_util/xrand.h>
+
+#include <hse/hse.h>
+#include <hse/hse_experimental.h>
+
+#include <hse_ikvdb/kvdb_optrace.h>
+#include <hse_ikvdb/limits.h>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sysexits.h>
+
+const char *progname;
+
+static const char *const op_names[] = {
+    [KVDB_OPTRACE_KVS] = "kvs",
+    [KVDB_OPTRACE_PUT] = "put",
+    [KVDB_OPTRACE_GET] = "get",
+    [KVDB_OPTRACE_DEL] = "del",
+    [KVDB_OPTRACE_PDEL] = "pdel",
+    [KVDB_OPTRACE_TXN_BEGIN] = "txn_begin",
+    [KVDB_OPTRACE_TXN_COMMIT] = "txn_commit",
+    [KVDB_OPTRACE_TXN_ABORT] = "txn_abort",
+    [KVDB_OPTRACE_CUR_CREATE] = "cur_create",
+    [KVDB_OPTRACE_CUR_SEEK] = "cur_seek",
+    [KVDB_OPTRACE_CUR_READ] = "cur_read",
+    [KVDB_OPTRACE_CUR_DESTROY] = "cur_destroy",
+    [KVDB_OPTRACE_CUR_UPDATE] = "cur_update",
+    [KVDB_OPTRACE_CUR_READ_BATCH] = "cur_read_batch",
+    [KVDB_OPTRACE_CUR_PRED_SET] = "cur_pred_set",
+    [KVDB_OPTRACE_PFX_PROBE] = "pfx_probe",
+};
+
+struct rkvs {
+    u32             rk_id;
+    u32             rk_pfx_len;
+    char            rk_name[HSE_KVS_NAME_LEN_MAX];
+    struct hse_kvs *rk_kvs;
+};
+
+struct rctx {
+    u64                    rc_id;
+    struct hse_kvdb_txn *  rc_txn;
+    struct hse_kvs_cursor *rc_cur;
+};
+
+struct worker {
+    pthread_t                      w_tid;
+    const struct kvdb_optrace_omf **w_recv;
+    size_t                         w_recc;
+    size_t                         w_recmax;
+    struct rctx *                  w_ctxv;
+    uint                           w_ctxc;
+    uint                           w_ctxmax;
+    char *                         w_kbuf;
+    char *                         w_vbuf;
+    u64                            w_errv[KVDB_OPTRACE_OP_MAX];
+    u64                            w_newerrv[KVDB_OPTRACE_OP_MAX];
+    struct hdr_hist                w_origv[KVDB_OPTRACE_OP_MAX];
+    struct hdr_hist                w_histv[KVDB_OPTRACE_OP_MAX];
+};
+
+static struct hse_kvdb *kvdb;
+static struct rkvs      kvsv[HSE_KVS_COUNT_MAX];
+static uint             kvsc;
+static const char *     vdata;
+static double           speed = 1.0;
+static u64              replay_start;
+static bool             verbose;
+
+static void
+fatal(const char *fmt, ...)
+{
+    char    msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "%s: %s\n", progname, msg);
+    exit(1);
+}
+
+static void
+syntax(const char *fmt, ...)
+{
+    char    msg[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "%s: %s, use -h for help\n", progname, msg);
+    exit(EX_USAGE);
+}
+
+static void
+usage(void)
+{
+    printf("usage: %s [options] <trace> <kvdb> [param=value ...]\n", progname);
+
+    printf("-c       create KVSes named in the trace if they do not exist\n"
+           "-h       show this help list\n"
+           "-s MULT  replay at MULT times the original speed (0: unpaced)\n"
+           "-t N     replay from N threads (default: 8)\n"
+           "-v       be verbose\n"
+           "\n"
+           "Replays the API operations recorded in <trace> against <kvdb>.\n"
+           "Enable tracing by opening a kvdb with kvdb.optrace_path=<file>.\n"
+           "\n");
+}
+
+static const char *
+errstr(hse_err_t err)
+{
+    static __thread char buf[128];
+
+    return hse_err_to_string(err, buf, sizeof(buf), NULL);
+}
+
+static struct rkvs *
+kvs_lookup(u32 id)
+{
+    uint i;
+
+    for (i = 0; i < kvsc; i++)
+        if (kvsv[i].rk_id == id)
+            return kvsv + i;
+
+    return NULL;
+}
+
+static struct rctx *
+ctx_lookup(struct worker *w, u64 id, bool create)
+{
+    uint i;
+
+    for (i = 0; i < w->w_ctxc; i++)
+        if (w->w_ctxv[i].rc_id == id)
+            return w->w_ctxv + i;
+
+    if (!create)
+        return NULL;
+
+    if (w->w_ctxc == w->w_ctxmax) {
+        w->w_ctxmax = w->w_ctxmax ? w->w_ctxmax * 2 : 64;
+        w->w_ctxv = realloc(w->w_ctxv, w->w_ctxmax * sizeof(*w->w_ctxv));
+        if (!w->w_ctxv)
+            fatal("cannot allocate memory");
+    }
+
+    w->w_ctxv[w->w_ctxc].rc_id = id;
+    w->w_ctxv[w->w_ctxc].rc_txn = NULL;
+    w->w_ctxv[w->w_ctxc].rc_cur = NULL;
+
+    return w->w_ctxv + w->w_ctxc++;
+}
+
+static void
+ctx_remove(struct worker *w, struct rctx *ctx)
+{
+    *ctx = w->w_ctxv[--w->w_ctxc];
+}
+
+/* Fill buf with len bytes derived from hash.
+ */
+static void
+synth(char *buf, size_t len, u64 hash)
+{
+    while (len > 0) {
+        size_t n = min_t(size_t, len, sizeof(hash));
+        u64    v = cpu_to_le64(hash);
+
+        memcpy(buf, &v, n);
+        buf += n;
+        len -= n;
+        hash = hse_hash64(&hash, sizeof(hash));
+    }
+}
+
+static size_t
+synth_key(struct worker *w, const struct kvdb_optrace_omf *rec)
+{
+    size_t klen = omf_otr_klen(rec);
+    size_t plen = omf_otr_pfx_len(rec);
+
+    if (plen > klen)
+        plen = klen;
+
+    synth(w->w_kbuf, plen, omf_otr_phash(rec));
+    synth(w->w_kbuf + plen, klen - plen, omf_otr_khash(rec));
+
+    return klen;
+}
+
+static hse_err_t
+replay_one(struct worker *w, const struct kvdb_optrace_omf *rec, struct hse_kvs *kvs)
+{
+    struct hse_kvdb_opspec os, *osp = NULL;
+    enum kvdb_optrace_op   op = omf_otr_op(rec);
+    u64                    id = omf_otr_ctx(rec);
+    struct rctx *          ctx = NULL;
+    const void *           k, *v;
+    size_t                 klen, vlen;
+    hse_err_t              err = 0;
+    bool                   b;
+
+    klen = synth_key(w, rec);
+    vlen = omf_otr_vlen(rec);
+
+    if (id) {
+        ctx = ctx_lookup(w, id, op == KVDB_OPTRACE_TXN_BEGIN || op == KVDB_OPTRACE_CUR_CREATE);
+
+        /* Ops in a transaction that began before the trace did run
+         * outside of any transaction.
+         */
+        if (ctx && ctx->rc_txn && (op < KVDB_OPTRACE_TXN_BEGIN || op == KVDB_OPTRACE_PFX_PROBE)) {
+            HSE_KVDB_OPSPEC_INIT(&os);
+            os.kop_txn = ctx->rc_txn;
+            osp = &os;
+        }
+    }
+
+    switch (op) {
+    case KVDB_OPTRACE_PUT:
+        return hse_kvs_put(kvs, osp, w->w_kbuf, klen, vdata, vlen);
+
+    case KVDB_OPTRACE_GET:
+        return hse_kvs_get(kvs, osp, w->w_kbuf, klen, &b, w->w_vbuf, HSE_KVS_VLEN_MAX, &vlen);
+
+    case KVDB_OPTRACE_DEL:
+        return hse_kvs_delete(kvs, osp, w->w_kbuf, klen);
+
+    case KVDB_OPTRACE_PDEL:
+        return hse_kvs_prefix_delete(kvs, osp, w->w_kbuf, klen, NULL);
+
+    case KVDB_OPTRACE_TXN_BEGIN:
+        if (!ctx->rc_txn) {
+            ctx->rc_txn = hse_kvdb_txn_alloc(kvdb);
+            if (!ctx->rc_txn)
+                return ENOMEM;
+        }
+        return hse_kvdb_txn_begin(kvdb, ctx->rc_txn);
+
+    case KVDB_OPTRACE_TXN_COMMIT:
+    case KVDB_OPTRACE_TXN_ABORT:
+        if (!ctx || !ctx->rc_txn)
+            return 0;
+        if (op == KVDB_OPTRACE_TXN_COMMIT)
+            return hse_kvdb_txn_commit(kvdb, ctx->rc_txn);
+        return hse_kvdb_txn_abort(kvdb, ctx->rc_txn);
+
+    case KVDB_OPTRACE_CUR_CREATE:
+        if (ctx->rc_cur)
+            hse_kvs_cursor_destroy(ctx->rc_cur);
+        err = hse_kvs_cursor_create(kvs, NULL, klen ? w->w_kbuf : NULL, klen, &ctx->rc_cur);
+        if (err) {
+            ctx->rc_cur = NULL;
+            ctx_remove(w, ctx);
+        }
+        return err;
+
+    case KVDB_OPTRACE_CUR_SEEK:
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        return hse_kvs_cursor_seek(ctx->rc_cur, NULL, w->w_kbuf, klen, NULL, NULL);
+
+    case KVDB_OPTRACE_CUR_READ:
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        return hse_kvs_cursor_read(ctx->rc_cur, NULL, &k, &klen, &v, &vlen, &b);
+
+    case KVDB_OPTRACE_CUR_DESTROY:
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        err = hse_kvs_cursor_destroy(ctx->rc_cur);
+        ctx_remove(w, ctx);
+        return err;
+
+    case KVDB_OPTRACE_CUR_UPDATE:
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        return hse_kvs_cursor_update(ctx->rc_cur, NULL);
+
+    case KVDB_OPTRACE_CUR_READ_BATCH: {
+        struct hse_kvs_cursor_rec recv[64];
+        size_t                    recc;
+
+        /* Bound the batch by the bytes it originally returned. */
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        return hse_kvs_cursor_read_batch_exp(
+            ctx->rc_cur,
+            NULL,
+            w->w_vbuf,
+            clamp_t(size_t, vlen, 1, HSE_KVS_VLEN_MAX),
+            recv,
+            NELEM(recv),
+            &recc,
+            &b);
+    }
+
+    case KVDB_OPTRACE_CUR_PRED_SET: {
+        struct hse_kvs_cursor_pred pred = {};
+
+        if (!ctx || !ctx->rc_cur)
+            return 0;
+        pred.kcp_key_sfx = w->w_kbuf;
+        pred.kcp_key_sfx_len = klen;
+        pred.kcp_val_max = vlen;
+        return hse_kvs_cursor_pred_set_exp(ctx->rc_cur, &pred);
+    }
+
+    case KVDB_OPTRACE_PFX_PROBE: {
+        enum hse_kvs_pfx_probe_cnt cnt;
+
+        if (!klen)
+            return 0;
+        return hse_kvs_prefix_probe_exp(
+            kvs,
+            osp,
+            w->w_kbuf,
+            klen,
+            &cnt,
+            w->w_vbuf,
+            HSE_KVS_KLEN_MAX,
+            &klen,
+            w->w_vbuf + HSE_KVS_KLEN_MAX,
+            HSE_KVS_VLEN_MAX - HSE_KVS_KLEN_MAX,
+            &vlen);
+    }
+
+    default:
+        return 0;
+    }
+}
+
+static void *
+replay_main(void *arg)
+{
+    struct worker *w = arg;
+    size_t         i;
+
+    for (i = 0; i < w->w_recc; i++) {
+        const struct kvdb_optrace_omf *rec = w->w_recv[i];
+        enum kvdb_optrace_op           op = omf_otr_op(rec);
+        struct hse_kvs *               kvs = NULL;
+        hse_err_t                      err;
+        u64                            tstart;
+
+        if (op >= KVDB_OPTRACE_OP_MAX)
+            continue;
+
+        if (op < KVDB_OPTRACE_TXN_BEGIN || op >= KVDB_OPTRACE_CUR_CREATE) {
+            struct rkvs *rk = kvs_lookup(omf_otr_kvs(rec));
+
+            if (!rk || !rk->rk_kvs)
+                continue;
+            kvs = rk->rk_kvs;
+        }
+
+        /* Pace the replay, charging any lag to the operation that
+         * was held up so that replay latency is comparable to the
+         * original.
+         */
+        tstart = get_time_ns();
+        if (speed > 0) {
+            u64 when = replay_start + omf_otr_ns(rec) / speed;
+
+            if (when > tstart) {
+                struct timespec ts;
+
+                ts.tv_sec = (when - tstart) / NSEC_PER_SEC;
+                ts.tv_nsec = (when - tstart) % NSEC_PER_SEC;
+                nanosleep(&ts, NULL);
+            }
+            tstart = when;
+        }
+
+        err = replay_one(w, rec, kvs);
+
+        hdr_hist_record(&w->w_histv[op], get_time_ns() - tstart);
+        hdr_hist_record(&w->w_origv[op], omf_otr_lat_ns(rec));
+
+        if (err) {
+            w->w_errv[op]++;
+            if (!omf_otr_err(rec)) {
+                w->w_newerrv[op]++;
+                if (verbose)
+                    fprintf(stderr, "%s: %s failed: %s\n", progname, op_names[op], errstr(err));
+            }
+        }
+    }
+
+    /* Clean up anything the trace left open. */
+    for (i = 0; i < w->w_ctxc; i++) {
+        if (w->w_ctxv[i].rc_cur)
+            hse_kvs_cursor_destroy(w->w_ctxv[i].rc_cur);
+        if (w->w_ctxv[i].rc_txn)
+            hse_kvdb_txn_free(kvdb, w->w_ctxv[i].rc_txn);
+    }
+
+    return NULL;
+}
+
+static int
+rec_cmp(const void *lhs, const void *rhs)
+{
+    const struct kvdb_optrace_omf *l = *(const struct kvdb_optrace_omf *const *)lhs;
+    const struct kvdb_optrace_omf *r = *(const struct kvdb_optrace_omf *const *)rhs;
+    u64                            lns = omf_otr_ns(l), rns = omf_otr_ns(r);
+
+    if (lns != rns)
+        return lns < rns ? -1 : 1;
+
+    /* Records of equal time keep their file order. */
+    return l < r ? -1 : l > r;
+}
+
+static void
+report(struct worker *workerv, uint workerc, u64 elapsed)
+{
+    struct hdr_hist *orig, *hist;
+    uint             op, i;
+
+    orig = malloc(sizeof(*orig));
+    hist = malloc(sizeof(*hist));
+    if (!orig || !hist)
+        fatal("cannot allocate memory");
+
+    printf(
+        "%-12s %10s %9s %9s %9s %9s %10s %8s\n",
+        "op", "count", "orig_us", "mean_us", "orig_p99", "p99_us", "errors", "new_errs");
+
+    for (op = 0; op < KVDB_OPTRACE_OP_MAX; op++) {
+        u64 errs = 0, newerrs = 0;
+
+        hdr_hist_init(orig);
+        hdr_hist_init(hist);
+
+        for (i = 0; i < workerc; i++) {
+            hdr_hist_merge(orig, &workerv[i].w_origv[op]);
+            hdr_hist_merge(hist, &workerv[i].w_histv[op]);
+            errs += workerv[i].w_errv[op];
+            newerrs += workerv[i].w_newerrv[op];
+        }
+
+        if (!hist->hh_count)
+            continue;
+
+        printf(
+            "%-12s %10lu %9.1f %9.1f %9.1f %9.1f %10lu %8lu\n",
+            op_names[op],
+            (ulong)hist->hh_count,
+            orig->hh_sum / 1000.0 / orig->hh_count,
+            hist->hh_sum / 1000.0 / hist->hh_count,
+            hdr_hist_pctile(orig, 990000) / 1000.0,
+            hdr_hist_pctile(hist, 990000) / 1000.0,
+            (ulong)errs,
+            (ulong)newerrs);
+    }
+
+    printf("replayed in %.2f s from %u threads\n", elapsed / 1e9, workerc);
+
+    free(orig);
+    free(hist);
+}
+
+static void
+open_kvses(struct hse_params *hp, bool create)
+{
+    hse_err_t err;
+    uint      i;
+
+    for (i = 0; i < kvsc; i++) {
+        struct rkvs *rk = kvsv + i;
+
+        err = hse_kvdb_kvs_open(kvdb, rk->rk_name, hp, &rk->rk_kvs);
+        if (err && hse_err_to_errno(err) == ENOENT && create) {
+            char pfx_len[16];
+
+            snprintf(pfx_len, sizeof(pfx_len), "%u", rk->rk_pfx_len);
+
+            err = hse_params_set(hp, "kvs.pfx_len", pfx_len);
+            if (!err)
+                err = hse_kvdb_kvs_make(kvdb, rk->rk_name, hp);
+            if (!err)
+                err = hse_kvdb_kvs_open(kvdb, rk->rk_name, hp, &rk->rk_kvs);
+        }
+
+        if (err) {
+            fprintf(stderr, "%s: skipping kvs %s: %s\n", progname, rk->rk_name, errstr(err));
+            rk->rk_kvs = NULL;
+        }
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    struct kvdb_optrace_hdr_omf *hdr;
+    struct kvdb_optrace_omf *    recv, **sortv;
+    struct hse_params *          hp;
+    struct worker *              workerv;
+    struct stat                  st;
+    const char *                 tpath, *mpool;
+    hse_err_t                    err;
+    size_t                       recc, i;
+    uint                         workerc = 8;
+    bool                         create = false;
+    char *                       buf, *end;
+    int                          fd, c;
+    u64                          elapsed;
+
+    progname = (progname = strrchr(argv[0], '/')) ? progname + 1 : argv[0];
+
+    while ((c = getopt(argc, argv, ":chs:t:v")) != -1) {
+        switch (c) {
+            case 'c':
+                create = true;
+                break;
+            case 'h':
+                usage();
+                return 0;
+            case 's':
+                speed = strtod(optarg, &end);
+                if (*end || speed < 0)
+                    syntax("invalid speed '%s'", optarg);
+                break;
+            case 't':
+                if (parse_uint(optarg, &workerc) || !workerc)
+                    syntax("invalid thread count '%s'", optarg);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case ':':
+                syntax("missing argument for option '-%c'", optopt);
+                break;
+            default:
+                syntax("invalid option '-%c'", optopt);
+                break;
+        }
+    }
+
+    if (argc - optind < 2)
+        syntax("insufficient arguments for mandatory parameters");
+
+    tpath = argv[optind++];
+    mpool = argv[optind++];
+
+    /* Load and check the trace. */
+    fd = open(tpath, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st))
+        fatal("cannot open %s: %s", tpath, strerror(errno));
+
+    buf = malloc(st.st_size + 1);
+    if (!buf)
+        fatal("cannot allocate memory");
+
+    if (read(fd, buf, st.st_size) != st.st_size)
+        fatal("cannot read %s: %s", tpath, strerror(errno));
+    close(fd);
+
+    hdr = (void *)buf;
+    if (st.st_size < sizeof(*hdr) || omf_oth_magic(hdr) != KVDB_OPTRACE_MAGIC)
+        fatal("%s is not an operation trace", tpath);
+
+    if (omf_oth_version(hdr) != KVDB_OPTRACE_VERSION || omf_oth_recsz(hdr) != sizeof(*recv))
+        fatal("%s has unsupported trace version %u", tpath, omf_oth_version(hdr));
+
+    recv = (void *)(buf + sizeof(*hdr));
+    recc = (st.st_size - sizeof(*hdr)) / sizeof(*recv);
+
+    sortv = malloc(recc * sizeof(*sortv));
+    if (!sortv)
+        fatal("cannot allocate memory");
+
+    for (i = 0; i < recc; i++)
+        sortv[i] = recv + i;
+
+    qsort(sortv, recc, sizeof(*sortv), rec_cmp);
+
+    for (i = 0; i < recc; i++) {
+        struct kvdb_optrace_kvs_omf *krec = (void *)sortv[i];
+
+        if (omf_otk_op(krec) != KVDB_OPTRACE_KVS || kvs_lookup(omf_otk_kvs(krec)))
+            continue;
+
+        if (kvsc == NELEM(kvsv))
+            fatal("too many kvses in %s", tpath);
+
+        kvsv[kvsc].rk_id = omf_otk_kvs(krec);
+        kvsv[kvsc].rk_pfx_len = omf_otk_pfx_len(krec);
+        strlcpy(kvsv[kvsc].rk_name, krec->otk_name, sizeof(kvsv[kvsc].rk_name));
+        kvsc++;
+    }
+
+    /* Deal records out to the workers by transaction/cursor id,
+     * or by traced thread id for everything else.
+     */
+    workerv = calloc(workerc, sizeof(*workerv));
+    if (!workerv)
+        fatal("cannot allocate memory");
+
+    for (i = 0; i < recc; i++) {
+        const struct kvdb_optrace_omf *rec = sortv[i];
+        struct worker *                w;
+        u64                            id;
+
+        if (omf_otr_op(rec) == KVDB_OPTRACE_KVS)
+            continue;
+
+        id = omf_otr_ctx(rec) ?: omf_otr_tid(rec);
+        w = workerv + hse_hash64(&id, sizeof(id)) % workerc;
+
+        if (w->w_recc == w->w_recmax) {
+            w->w_recmax = w->w_recmax ? w->w_recmax * 2 : 4096;
+            w->w_recv = realloc(w->w_recv, w->w_recmax * sizeof(*w->w_recv));
+            if (!w->w_recv)
+                fatal("cannot allocate memory");
+        }
+
+        w->w_recv[w->w_recc++] = rec;
+    }
+
+    vdata = calloc(1, HSE_KVS_VLEN_MAX);
+    if (!vdata)
+        fatal("cannot allocate memory");
+
+    for (i = 0; i < workerc; i++) {
+        struct worker *w = workerv + i;
+        uint           op;
+
+        w->w_kbuf = malloc(HSE_KVS_KLEN_MAX);
+        w->w_vbuf = malloc(HSE_KVS_VLEN_MAX);
+        if (!w->w_kbuf || !w->w_vbuf)
+            fatal("cannot allocate memory");
+
+        for (op = 0; op < KVDB_OPTRACE_OP_MAX; op++) {
+            hdr_hist_init(&w->w_origv[op]);
+            hdr_hist_init(&w->w_histv[op]);
+        }
+    }
+
+    /* Open the target kvdb. */
+    err = hse_kvdb_init();
+    if (err)
+        fatal("failed to initialize kvdb: %s", errstr(err));
+
+    err = hse_params_create(&hp);
+    if (err)
+        fatal("cannot create params: %s", errstr(err));
+
+    for (; optind < argc; optind++) {
+        char *val = strchr(argv[optind], '=');
+
+        if (!val)
+            syntax("invalid parameter '%s'", argv[optind]);
+
+        *val++ = '\0';
+
+        err = hse_params_set(hp, argv[optind], val);
+        if (err)
+            syntax("invalid parameter '%s': %s", argv[optind], errstr(err));
+    }
+
+    err = hse_kvdb_open(mpool, hp, &kvdb);
+    if (err)
+        fatal("cannot open kvdb %s: %s", mpool, errstr(err));
+
+    open_kvses(hp, create);
+
+    if (verbose)
+        printf("replaying %zu records from %s\n", recc, tpath);
+
+    replay_start = get_time_ns();
+
+    for (i = 0; i < workerc; i++) {
+        if (pthread_create(&workerv[i].w_tid, NULL, replay_main, workerv + i))
+            fatal("cannot create thread: %s", strerror(errno));
+    }
+
+    for (i = 0; i < workerc; i++)
+        pthread_join(workerv[i].w_tid, NULL);
+
+    elapsed = get_time_ns() - replay_start;
+
+    report(workerv, workerc, elapsed);
+
+    for (i = 0; i < kvsc; i++)
+        if (kvsv[i].rk_kvs)
+            hse_kvdb_kvs_close(kvsv[i].rk_kvs);
+
+    hse_kvdb_close(kvdb);
+    hse_params_destroy(hp);
+    hse_kvdb_fini();
+
+    for (i = 0; i < workerc; i++) {
+        free(workerv[i].w_recv);
+        free(workerv[i].w_ctxv);
+        free(workerv[i].w_kbuf);
+        free(workerv[i].w_vbuf);
+    }
+
+    free(workerv);
+    free((void *)vdata);
+    free(sortv);
+    free(buf);
+
+    return 0;
+}
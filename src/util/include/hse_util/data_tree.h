@@ -116,6 +116,8 @@ typedef size_t(dt_count_handler_t)(struct dt_element *);
 
 typedef bool(dt_match_select_handler_t)(struct dt_element *, char *, char *);
 
+typedef size_t(dt_walk_t)(struct dt_element *, void *);
+
 struct dt_element_ops {
     dt_remove_handler_t *      remove;
     dt_emit_handler_t *        emit;
@@ -341,6 +343,23 @@ dt_iterate_cmd(
     char *                       selector_field,
     char *                       selector_value);
 
+/**
+ * dt_walk() - Call a function on each element below a path.
+ * @tree:   pointer to dt_tree to operate on
+ * @path:   path to operate on
+ * @func:   function to call on each element
+ * @arg:    opaque argument passed to @func
+ *
+ * The tree is locked for the duration of the walk.  After the last
+ * element, @func is called once more with a NULL element so that it
+ * can act on whatever it gathered while the elements are still known
+ * to exist.
+ *
+ * Return: sum of the values returned by @func
+ */
+size_t
+dt_walk(struct dt_tree *tree, const char *path, dt_walk_t *func, void *arg);
+
 /**
  * dt_iterate_next - Iteratively find elements of the data tree.
  * @tree:   pointer to dt_tree to operate on
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_PLATFORM_FLIGHTREC_H
+#define HSE_PLATFORM_FLIGHTREC_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+#include <hse_util/atomic.h>
+
+struct conn_info;
+struct kv_iter;
+
+/*
+ * The flight recorder keeps the most recent engine events (ingests,
+ * compactions, throttle changes, cndb transactions, ...) in fixed-size
+ * rings in memory, one ring per group of CPUs.  It is always on: an
+ * event costs a clock read and an atomic add, and events are recorded
+ * only at the rate of background work, not per KVS operation.
+ *
+ * The rings are served at the REST endpoint "flightrec" and, if the
+ * kvdb rparam flightrec_sigdump is set, written to stderr when the
+ * process takes a fatal signal.  Either way the output is one line per
+ * event, oldest first:
+ *
+ *   <monotonic ns> <cpu> <event> <arg0> <arg1>
+ *
+ * Event               arg0                 arg1
+ * ------------------  -------------------  ----------------------------
+ * c0_ingest_queue     kvms generation      bytes used in kvms
+ * c0_ingest_done      kvms generation      errno
+ * cn_comp_start       cnid                 action (enum cn_action)
+ * cn_comp_commit      cnid                 errno
+ * throttle_state      new state            max sensor value
+ * sts_job_submit      job id               queue
+ * cndb_txn_start      txid                 ingest id
+ * cndb_txn_ack_c      txid                 0
+ * cndb_txn_nak        txid                 0
+ * txn_flush           kvms generation      errno
+ */
+
+#define FLIGHTREC_RINGS     (16)
+#define FLIGHTREC_RING_RECS (1024) /* must be a power of two */
+
+enum flightrec_ev {
+    FLIGHTREC_NONE,
+    FLIGHTREC_C0_INGEST_QUEUE,
+    FLIGHTREC_C0_INGEST_DONE,
+    FLIGHTREC_CN_COMP_START,
+    FLIGHTREC_CN_COMP_COMMIT,
+    FLIGHTREC_THROTTLE_STATE,
+    FLIGHTREC_STS_JOB_SUBMIT,
+    FLIGHTREC_CNDB_TXN_START,
+    FLIGHTREC_CNDB_TXN_ACK_C,
+    FLIGHTREC_CNDB_TXN_NAK,
+    FLIGHTREC_TXN_FLUSH,
+    FLIGHTREC_EV_MAX,
+};
+
+/**
+ * struct flightrec_rec - one recorded event
+ * @fr_ns:   get_time_ns() when the event was recorded
+ * @fr_argv: event arguments (see table above)
+ * @fr_seq:  ring index + 1, zero while the record is being written
+ * @fr_ev:   enum flightrec_ev
+ * @fr_cpu:  CPU that recorded the event
+ */
+struct flightrec_rec {
+    u64      fr_ns;
+    u64      fr_argv[2];
+    atomic_t fr_seq;
+    u16      fr_ev;
+    u16      fr_cpu;
+};
+
+/**
+ * flightrec_add() - record an event
+ * @ev:   event
+ * @arg0: first argument
+ * @arg1: second argument
+ */
+void
+flightrec_add(enum flightrec_ev ev, u64 arg0, u64 arg1);
+
+/**
+ * flightrec_get() - copy out recorded events, oldest first
+ * @recv: (output) events
+ * @recc: capacity of @recv
+ *
+ * Return: number of events copied
+ */
+uint
+flightrec_get(struct flightrec_rec *recv, uint recc);
+
+/**
+ * flightrec_dump() - write all recorded events to a file descriptor
+ * @fd: file descriptor
+ *
+ * Safe to call from a signal handler.
+ */
+void
+flightrec_dump(int fd);
+
+/**
+ * flightrec_sigdump_install() - dump the flight recorder on fatal signals
+ *
+ * Installs handlers for SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT
+ * that write the flight recorder to stderr and then hand the signal
+ * to whatever handler was installed before.  Subsequent calls do
+ * nothing.
+ */
+merr_t
+flightrec_sigdump_install(void);
+
+/**
+ * flightrec_ev_name() - name of an event
+ * @ev: event
+ */
+const char *
+flightrec_ev_name(enum flightrec_ev ev);
+
+merr_t
+flightrec_rest_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context);
+
+#endif
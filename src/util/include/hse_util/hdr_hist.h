@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_PLATFORM_HDR_HIST_H
+#define HSE_PLATFORM_HDR_HIST_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/log2.h>
+
+/*
+ * struct hdr_hist - log-linear (HDR-style) histogram
+ *
+ * Values below HDR_HIST_SUB_CNT each get their own bucket.  Above that,
+ * each power-of-two range [2^k, 2^(k+1)) is split into HDR_HIST_SUB_CNT
+ * equal sub-buckets, so every recorded value is known to within
+ * 1/HDR_HIST_SUB_CNT of its magnitude (about 3%) regardless of scale.
+ * Values of 2^HDR_HIST_VAL_BITS and above (about 18 minutes when
+ * recording nanoseconds) land in the last bucket.
+ *
+ * A histogram is not thread safe.  Writers that need concurrency should
+ * record into private histograms and combine them with hdr_hist_merge().
+ */
+#define HDR_HIST_SUB_BITS 5
+#define HDR_HIST_SUB_CNT (1u << HDR_HIST_SUB_BITS)
+#define HDR_HIST_VAL_BITS 40
+#define HDR_HIST_BKT_CNT ((HDR_HIST_VAL_BITS - HDR_HIST_SUB_BITS + 1) * HDR_HIST_SUB_CNT)
+
+struct hdr_hist {
+    u64 hh_count;
+    u64 hh_sum;
+    u64 hh_min;
+    u64 hh_max;
+    u64 hh_bktv[HDR_HIST_BKT_CNT];
+};
+
+#pragma GCC visibility push(hidden)
+
+static inline uint
+hdr_hist_bkt(u64 value)
+{
+    uint shift;
+
+    if (value < HDR_HIST_SUB_CNT)
+        return value;
+
+    if (value >> HDR_HIST_VAL_BITS)
+        return HDR_HIST_BKT_CNT - 1;
+
+    shift = ilog2(value) - HDR_HIST_SUB_BITS;
+
+    return shift * HDR_HIST_SUB_CNT + (value >> shift);
+}
+
+static inline void
+hdr_hist_record(struct hdr_hist *hh, u64 value)
+{
+    hh->hh_bktv[hdr_hist_bkt(value)]++;
+    hh->hh_count++;
+    hh->hh_sum += value;
+
+    if (value < hh->hh_min)
+        hh->hh_min = value;
+    if (value > hh->hh_max)
+        hh->hh_max = value;
+}
+
+/**
+ * hdr_hist_bkt_hi() - largest value that maps to a bucket
+ * @bkt: bucket index
+ */
+u64
+hdr_hist_bkt_hi(uint bkt);
+
+void
+hdr_hist_init(struct hdr_hist *hh);
+
+/**
+ * hdr_hist_merge() - add the contents of one histogram to another
+ * @dst: histogram to add to
+ * @src: histogram to add
+ */
+void
+hdr_hist_merge(struct hdr_hist *dst, const struct hdr_hist *src);
+
+/**
+ * hdr_hist_pctile() - value at or below which a given share of values lie
+ * @hh:  histogram
+ * @ppm: share in parts per million (e.g., 999900 for p99.99)
+ *
+ * Return: upper bound of the bucket holding the requested value, capped
+ * at the largest recorded value (0 if the histogram is empty)
+ */
+u64
+hdr_hist_pctile(const struct hdr_hist *hh, uint ppm);
+
+#pragma GCC visibility pop
+
+#endif
@@ -13,6 +13,7 @@
 #include <hse_util/timer.h>
 #include <hse_util/hse_err.h>
 #include <hse_util/data_tree.h>
+#include <hse_util/hdr_hist.h>
 
 #pragma GCC visibility push(hidden)
 
@@ -22,6 +23,7 @@
  * PERFC_VALPERCPU          max per-cpu values per cacheline
  * PERFC_IVL_MAX            max bounds in a distribution counter
  * PERFC_GRP_MAX            max cpu groups in a distribution counter
+ * PERFC_HG_GRP_MAX         max cpu groups in a histogram counter
  * PERFC_PCT_SCALE          power-of-two scaling factor for pdi_pct
  */
 #define PERFC_VALPERCNT     (128)
@@ -31,6 +33,8 @@
 #define PERFC_GRP_MAX \
   ((PERFC_VALPERCNT * SMP_CACHE_BYTES * 2) / ((PERFC_IVL_MAX + 1) * sizeof(struct perfc_bkt)))
 
+#define PERFC_HG_GRP_MAX    (8)
+
 #define PERFC_PCT_SCALE     (128)
 
 struct perfc_ivl;
@@ -42,6 +46,7 @@ enum perfc_type {
     PERFC_TYPE_DI, /* Get the distribution of a variable */
     PERFC_TYPE_LT, /* Get the distribution of a latency */
     PERFC_TYPE_SL, /* Simple latency, cumulative average */
+    PERFC_TYPE_HG, /* Get the HDR histogram of a latency */
 };
 
 /**
@@ -281,6 +286,7 @@ perfc_ivl_destroy(const struct perfc_ivl *ivl);
  * DI_ distribution counter
  * LT_ distribution of a latency counter
  * SL_ simple latency counter
+ * HG_ latency histogram counter (accurate tail percentiles)
  *
  * Followed with <FAMILYNAME>_ that identifies the family of the counter.
  *
@@ -402,12 +408,27 @@ struct perfc_bkt {
     atomic64_t pcb_hits;
 };
 
+/**
+ * struct perfc_hg_grp - per-cpu-group data for histogram counters
+ * @phg_sum:    sum of samples recorded by this group
+ * @phg_bktv:   sample counts indexed by hdr_hist_bkt()
+ *
+ * Histogram counters trade memory for precision: each cpu group keeps
+ * a full log-linear histogram so that p99.9 and beyond can be reported
+ * to within a few percent rather than to the nearest perfc_ivl bound.
+ */
+struct perfc_hg_grp {
+    atomic64_t phg_sum;
+    atomic64_t phg_bktv[HDR_HIST_BKT_CNT];
+} __aligned(SMP_CACHE_BYTES);
+
 /**
  * struct perfc_ctr_hdr - per counter data
  * @pch_type:       counter type (basic, rate, distribution, ...)
  * @pch_flags:      counter flags
  * @pch_val:        per-cpu values for basic and rate counters
  * @pch_bkt:        distribution counter bucket data (per-cpu node)
+ * @pch_hgv:        histogram counter data (per-cpu group)
  *
  * For basic and rate counters there is one pch_val[] per cpu (modulo
  * PERFC_VALPERCNT).  For distribution counters each pch_val[] object
@@ -419,8 +440,9 @@ struct perfc_ctr_hdr {
     u32                 pch_prio;
 
     union {
-        struct perfc_val   *pch_val;
-        struct perfc_bkt   *pch_bktv;
+        struct perfc_val    *pch_val;
+        struct perfc_bkt    *pch_bktv;
+        struct perfc_hg_grp *pch_hgv;
     };
 };
 
@@ -449,11 +471,11 @@ struct perfc_rate {
 };
 
 /**
- * struct perfc_dis - distribution/latency counter
+ * struct perfc_dis - distribution/latency/histogram counter
  * @pdi_hdr:    base counter object
  * @pdi_min:    overall minimum value in distribution
  * @pdi_max:    overall maximum value in distribution
- * @pdi_ivl:    distribution bucket bounds
+ * @pdi_ivl:    distribution bucket bounds (unused by histogram counters)
  *
  * perfc_dis "is-a" perfc_ctr_hdr.
  */
@@ -528,6 +550,7 @@ struct perfc_seti {
 #define PERFC_CTR_TYPE_DI "DI"
 #define PERFC_CTR_TYPE_LT "LT"
 #define PERFC_CTR_TYPE_SL "SL"
+#define PERFC_CTR_TYPE_HG "HG"
 
 enum perfc_ctr_flags {
     PCC_FLAGS_ENABLED = 0x1,
@@ -570,7 +593,7 @@ extern u32 perfc_verbosity;
 /**
  * perfc_lat_record_impl() - Record a latency sample to get its distribution
  *
- * @dis:      distribution performance counter ptr
+ * @dis:      latency or histogram performance counter ptr
  * @sample:   sample to record
  *
  * %sample is the latency start time obtained by calling perfc_lat_start().
@@ -963,6 +986,56 @@ perfc_ctrseti_path(struct perfc_set *set);
 extern void
 perfc_ctrseti_invalidate_handle(struct perfc_set *set);
 
+/**
+ * perfc_dis_read() - read the totals of a distribution or histogram counter
+ * @pcs:  perfc counter set handle
+ * @cidx: counter index
+ * @sum:  (output) sum of all recorded samples
+ * @hits: (output) number of recorded samples
+ *
+ * The totals are cumulative since the counter set was created (or last
+ * cleared).  Both are zero if the counter is not enabled.
+ */
+void
+perfc_dis_read(struct perfc_set *pcs, u32 cidx, u64 *sum, u64 *hits);
+
+/**
+ * struct perfc_label - label filter for perfc_metrics()
+ * @pl_name:  label name
+ * @pl_value: value the label must have
+ */
+struct perfc_label {
+    const char *pl_name;
+    const char *pl_value;
+};
+
+/**
+ * perfc_metrics() - render enabled counters in OpenMetrics text format
+ * @path:  render only the counter sets at or below this data tree path
+ * @filtc: number of elements in @filtv
+ * @filtv: label filters, all of which a counter set must match
+ * @bufp:  (output) rendered text, to be freed by the caller
+ * @lenp:  (output) length of the rendered text
+ *
+ * Each counter in the set /data/perfc/<component>/<name>/<FAMILY>/<set>
+ * is rendered as metric "hse_<family>_<meaning>" labeled with component,
+ * name, set and, if <name> is of the form "<kvdb>:<kvs>", with name=<kvdb>
+ * and kvs=<kvs>.  Filters may also match on "family".  Basic counters
+ * become gauges, rate counters become counters, distribution and latency
+ * counters become histograms, and simple latency and histogram counters
+ * become summaries (with p50 through p99.99 quantiles for the latter).
+ *
+ * The text is not terminated with "# EOF" so that callers may append
+ * metrics of their own.
+ */
+merr_t
+perfc_metrics(
+    const char *              path,
+    uint                      filtc,
+    const struct perfc_label *filtv,
+    char **                   bufp,
+    size_t *                  lenp);
+
 #pragma GCC visibility pop
 
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
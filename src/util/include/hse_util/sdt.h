@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_PLATFORM_SDT_H
+#define HSE_PLATFORM_SDT_H
+
+/*
+ * Statically defined tracepoints (USDT) for perf, bpftrace and SystemTap.
+ *
+ * When sys/sdt.h (systemtap-sdt-devel) is present at build time, each
+ * HSE_SDT() site compiles to a single nop plus an ELF note telling a
+ * tracer where to find the probe's arguments.  A probe costs only that
+ * nop until a tracer attaches to it.  The arguments are still evaluated,
+ * so pass only values already at hand, never calls with cost or side
+ * effects.  Without sys/sdt.h, HSE_SDT() compiles to nothing.
+ *
+ * All probes belong to provider "hse".  To list them:
+ *
+ *   bpftrace -l 'usdt:/usr/lib64/libhse_kvdb.so*:hse:*'
+ *   perf buildid-cache --add /usr/lib64/libhse_kvdb.so && perf list 'sdt_hse:*'
+ *
+ * Durations are measured by pairing a *_start probe with its *_done
+ * probe on the same thread (or, for compactions, on the same @work).
+ *
+ * Probe                 Arguments
+ * --------------------  -----------------------------------------------
+ * c0sk_putdel_start     op (0 put, 1 del, 2 prefix del), klen, vlen
+ * c0sk_putdel_done      op, klen, vlen, errno
+ * c0sk_ingest_start     kvms, kvms generation, bytes used in kvms
+ * c0sk_ingest_done      kvms, kvms generation, errno
+ * cn_lookup_start       tree, klen
+ * cn_lookup_done        tree, klen, kvsets probed, nodes descended,
+ *                       result (enum key_lookup_res), errno
+ * kvset_bloom           kvset, kblock index, hit (1) or miss (0)
+ * kvset_lookup          kvset, klen, result (enum key_lookup_res)
+ * kvdb_txn_commit_start txn
+ * kvdb_txn_commit_done  txn, commit seqno, 1 if c0 had to be flushed
+ *                       (fired only if the commit succeeds)
+ * throttle_update       delay, max sensor, sensor moving average,
+ *                       csched sensor, state
+ * cn_comp_start         work, cnid, action (enum cn_action), node level,
+ *                       node offset, input kvsets
+ * cn_comp_done          work, cnid, action, errno, keys written,
+ *                       key bytes written, value bytes written
+ */
+
+#ifdef HSE_HAVE_SDT
+#include <sys/sdt.h>
+
+#define HSE_SDT(_name, ...) STAP_PROBEV(hse, _name, ##__VA_ARGS__)
+
+#else
+
+/* Reference the arguments so that values computed only for a probe
+ * don't trigger unused variable warnings, but never evaluate them.
+ */
+static inline void
+hse_sdt_nop(int unused, ...)
+{
+}
+
+#define HSE_SDT(_name, ...)                      \
+    do {                                         \
+        if (0)                                   \
+            hse_sdt_nop(0, ##__VA_ARGS__);       \
+    } while (0)
+
+#endif
+
+#endif
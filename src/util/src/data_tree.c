@@ -689,6 +689,37 @@ dt_iterate_cmd(
     return count;
 }
 
+size_t
+dt_walk(struct dt_tree *tree, const char *path, dt_walk_t *func, void *arg)
+{
+    struct dt_element *dte;
+    struct rb_node *   node;
+    size_t             count = 0;
+    int                pathlen;
+
+    pathlen = strnlen(path, DT_PATH_LEN);
+    if (pathlen >= DT_PATH_LEN)
+        return 0;
+
+    dt_lock(tree);
+    dt_add_pending(tree);
+
+    dte = dt_find_locked(tree, path, 0);
+    while (dte) {
+        count += func(dte, arg);
+
+        node = rb_next(&dte->dte_node);
+        dte = container_of(node, struct dt_element, dte_node);
+        if (dte && strncmp(path, dte->dte_path, pathlen))
+            break;
+    }
+
+    count += func(NULL, arg);
+    dt_unlock(tree);
+
+    return count;
+}
+
 struct dt_element *
 dt_iterate_next(struct dt_tree *tree, const char *path, struct dt_element *previous)
 {
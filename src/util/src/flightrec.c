@@ -0,0 +1,341 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/barrier.h>
+#include <hse_util/timing.h>
+#include <hse_util/rest_api.h>
+#include <hse_util/flightrec.h>
+
+#include <signal.h>
+
+struct flightrec_ring {
+    atomic64_t frr_head;
+
+    __aligned(SMP_CACHE_BYTES) struct flightrec_rec frr_recv[FLIGHTREC_RING_RECS];
+};
+
+static struct flightrec_ring flightrec_ringv[FLIGHTREC_RINGS] __aligned(SMP_CACHE_BYTES);
+
+static const char *const flightrec_ev_namev[] = {
+    [FLIGHTREC_NONE] = "none",
+    [FLIGHTREC_C0_INGEST_QUEUE] = "c0_ingest_queue",
+    [FLIGHTREC_C0_INGEST_DONE] = "c0_ingest_done",
+    [FLIGHTREC_CN_COMP_START] = "cn_comp_start",
+    [FLIGHTREC_CN_COMP_COMMIT] = "cn_comp_commit",
+    [FLIGHTREC_THROTTLE_STATE] = "throttle_state",
+    [FLIGHTREC_STS_JOB_SUBMIT] = "sts_job_submit",
+    [FLIGHTREC_CNDB_TXN_START] = "cndb_txn_start",
+    [FLIGHTREC_CNDB_TXN_ACK_C] = "cndb_txn_ack_c",
+    [FLIGHTREC_CNDB_TXN_NAK] = "cndb_txn_nak",
+    [FLIGHTREC_TXN_FLUSH] = "txn_flush",
+};
+
+const char *
+flightrec_ev_name(enum flightrec_ev ev)
+{
+    if (ev >= NELEM(flightrec_ev_namev) || !flightrec_ev_namev[ev])
+        return "unknown";
+
+    return flightrec_ev_namev[ev];
+}
+
+void
+flightrec_add(enum flightrec_ev ev, u64 arg0, u64 arg1)
+{
+    struct flightrec_ring *ring;
+    struct flightrec_rec * rec;
+    uint                   cpu;
+    u64                    idx;
+
+    cpu = raw_smp_processor_id();
+    ring = flightrec_ringv + (cpu % FLIGHTREC_RINGS);
+
+    idx = atomic64_fetch_add(1, &ring->frr_head);
+    rec = ring->frr_recv + (idx % FLIGHTREC_RING_RECS);
+
+    /* Readers skip a record whose sequence number is not the one they
+     * expect, so invalidate it while it is being rewritten.
+     */
+    atomic_set(&rec->fr_seq, 0);
+    smp_wmb();
+
+    rec->fr_ns = get_time_ns();
+    rec->fr_argv[0] = arg0;
+    rec->fr_argv[1] = arg1;
+    rec->fr_ev = ev;
+    rec->fr_cpu = cpu;
+
+    smp_wmb();
+    atomic_set(&rec->fr_seq, (u32)(idx + 1));
+}
+
+/**
+ * struct flightrec_iter - merges the rings in time order
+ * @fi_idx:   next ring index to read
+ * @fi_end:   ring head when the iterator was created
+ * @fi_recv:  oldest unconsumed record of each ring
+ * @fi_valid: whether fi_recv[i] holds a record
+ *
+ * Records overwritten while the iterator runs are skipped.  Neither
+ * the iterator nor flightrec_dump() allocates memory or takes locks.
+ */
+struct flightrec_iter {
+    u64                  fi_idx[FLIGHTREC_RINGS];
+    u64                  fi_end[FLIGHTREC_RINGS];
+    struct flightrec_rec fi_recv[FLIGHTREC_RINGS];
+    bool                 fi_valid[FLIGHTREC_RINGS];
+};
+
+static bool
+flightrec_ring_read(struct flightrec_ring *ring, u64 idx, struct flightrec_rec *rec)
+{
+    struct flightrec_rec *src = ring->frr_recv + (idx % FLIGHTREC_RING_RECS);
+    u32                   seq = (u32)(idx + 1);
+
+    if (atomic_read(&src->fr_seq) != seq)
+        return false;
+
+    smp_rmb();
+    *rec = *src;
+    smp_rmb();
+
+    return atomic_read(&src->fr_seq) == seq;
+}
+
+static void
+flightrec_iter_fill(struct flightrec_iter *it, uint i)
+{
+    struct flightrec_ring *ring = flightrec_ringv + i;
+
+    it->fi_valid[i] = false;
+
+    while (it->fi_idx[i] < it->fi_end[i]) {
+        u64 idx = it->fi_idx[i]++;
+
+        if (flightrec_ring_read(ring, idx, &it->fi_recv[i])) {
+            it->fi_valid[i] = true;
+            break;
+        }
+    }
+}
+
+static void
+flightrec_iter_init(struct flightrec_iter *it)
+{
+    uint i;
+
+    for (i = 0; i < FLIGHTREC_RINGS; i++) {
+        u64 end = atomic64_read(&flightrec_ringv[i].frr_head);
+
+        it->fi_end[i] = end;
+        it->fi_idx[i] = end > FLIGHTREC_RING_RECS ? end - FLIGHTREC_RING_RECS : 0;
+
+        flightrec_iter_fill(it, i);
+    }
+}
+
+static bool
+flightrec_iter_next(struct flightrec_iter *it, struct flightrec_rec *rec)
+{
+    int  best = -1;
+    uint i;
+
+    for (i = 0; i < FLIGHTREC_RINGS; i++) {
+        if (!it->fi_valid[i])
+            continue;
+
+        if (best < 0 || it->fi_recv[i].fr_ns < it->fi_recv[best].fr_ns)
+            best = i;
+    }
+
+    if (best < 0)
+        return false;
+
+    *rec = it->fi_recv[best];
+    flightrec_iter_fill(it, best);
+
+    return true;
+}
+
+uint
+flightrec_get(struct flightrec_rec *recv, uint recc)
+{
+    struct flightrec_iter it;
+    uint                  n = 0;
+
+    flightrec_iter_init(&it);
+
+    while (n < recc && flightrec_iter_next(&it, recv + n))
+        n++;
+
+    return n;
+}
+
+/* The dump is formatted with these helpers rather than snprintf() so
+ * that it can run in a signal handler.
+ */
+struct flightrec_buf {
+    int    fb_fd;
+    size_t fb_off;
+    char   fb_buf[4096];
+};
+
+static void
+flightrec_buf_flush(struct flightrec_buf *fb)
+{
+    size_t  off = 0;
+    ssize_t cc;
+
+    while (off < fb->fb_off) {
+        cc = write(fb->fb_fd, fb->fb_buf + off, fb->fb_off - off);
+        if (cc <= 0) {
+            if (cc < 0 && errno == EINTR)
+                continue;
+            break;
+        }
+
+        off += cc;
+    }
+
+    fb->fb_off = 0;
+}
+
+static void
+flightrec_buf_str(struct flightrec_buf *fb, const char *str)
+{
+    while (*str) {
+        if (fb->fb_off == sizeof(fb->fb_buf))
+            flightrec_buf_flush(fb);
+
+        fb->fb_buf[fb->fb_off++] = *str++;
+    }
+}
+
+static void
+flightrec_buf_u64(struct flightrec_buf *fb, u64 val)
+{
+    char  tmp[24];
+    char *p = tmp + sizeof(tmp) - 1;
+
+    *p = '\000';
+    do {
+        *--p = '0' + (val % 10);
+        val /= 10;
+    } while (val);
+
+    flightrec_buf_str(fb, p);
+}
+
+void
+flightrec_dump(int fd)
+{
+    struct flightrec_iter it;
+    struct flightrec_rec  rec;
+    struct flightrec_buf  fb;
+    struct timespec       ts;
+
+    fb.fb_fd = fd;
+    fb.fb_off = 0;
+
+    /* Print both clocks so that event times can be related to the
+     * wall clock.
+     */
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    flightrec_buf_str(&fb, "flightrec: now_ns ");
+    flightrec_buf_u64(&fb, get_time_ns());
+    flightrec_buf_str(&fb, " realtime_ns ");
+    flightrec_buf_u64(&fb, ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec);
+    flightrec_buf_str(&fb, "\n");
+
+    flightrec_iter_init(&it);
+
+    while (flightrec_iter_next(&it, &rec)) {
+        flightrec_buf_u64(&fb, rec.fr_ns);
+        flightrec_buf_str(&fb, " ");
+        flightrec_buf_u64(&fb, rec.fr_cpu);
+        flightrec_buf_str(&fb, " ");
+        flightrec_buf_str(&fb, flightrec_ev_name(rec.fr_ev));
+        flightrec_buf_str(&fb, " ");
+        flightrec_buf_u64(&fb, rec.fr_argv[0]);
+        flightrec_buf_str(&fb, " ");
+        flightrec_buf_u64(&fb, rec.fr_argv[1]);
+        flightrec_buf_str(&fb, "\n");
+    }
+
+    flightrec_buf_flush(&fb);
+}
+
+static const int flightrec_sigv[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
+static struct sigaction flightrec_osav[NELEM(flightrec_sigv)];
+static atomic_t         flightrec_sig_installed;
+static atomic_t         flightrec_sig_dumped;
+
+static void
+flightrec_sighandler(int sig, siginfo_t *si, void *uctx)
+{
+    int i;
+
+    if (atomic_inc_return(&flightrec_sig_dumped) == 1)
+        flightrec_dump(STDERR_FILENO);
+
+    /* Restore the previous handler and let it (or the default action)
+     * deal with the signal once this handler returns.
+     */
+    for (i = 0; i < NELEM(flightrec_sigv); i++) {
+        if (flightrec_sigv[i] == sig) {
+            sigaction(sig, &flightrec_osav[i], NULL);
+            break;
+        }
+    }
+
+    raise(sig);
+}
+
+merr_t
+flightrec_sigdump_install(void)
+{
+    struct sigaction sa;
+    merr_t           err;
+    int              i;
+
+    if (atomic_cmpxchg(&flightrec_sig_installed, 0, 1) != 0)
+        return 0;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = flightrec_sighandler;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+
+    for (i = 0; i < NELEM(flightrec_sigv); i++) {
+        if (sigaction(flightrec_sigv[i], &sa, &flightrec_osav[i])) {
+            err = merr(errno);
+
+            while (i-- > 0)
+                sigaction(flightrec_sigv[i], &flightrec_osav[i], NULL);
+
+            atomic_set(&flightrec_sig_installed, 0);
+
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+merr_t
+flightrec_rest_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context)
+{
+    flightrec_dump(info->resp_fd);
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/minmax.h>
+#include <hse_util/string.h>
+#include <hse_util/hdr_hist.h>
+
+u64
+hdr_hist_bkt_hi(uint bkt)
+{
+    uint shift;
+
+    if (bkt < HDR_HIST_SUB_CNT)
+        return bkt;
+
+    if (bkt >= HDR_HIST_BKT_CNT - 1)
+        return U64_MAX;
+
+    shift = bkt / HDR_HIST_SUB_CNT - 1;
+
+    return (((u64)(bkt % HDR_HIST_SUB_CNT + HDR_HIST_SUB_CNT + 1)) << shift) - 1;
+}
+
+void
+hdr_hist_init(struct hdr_hist *hh)
+{
+    memset(hh, 0, sizeof(*hh));
+    hh->hh_min = U64_MAX;
+}
+
+void
+hdr_hist_merge(struct hdr_hist *dst, const struct hdr_hist *src)
+{
+    uint i;
+
+    if (!src->hh_count)
+        return;
+
+    for (i = 0; i < HDR_HIST_BKT_CNT; i++)
+        dst->hh_bktv[i] += src->hh_bktv[i];
+
+    dst->hh_count += src->hh_count;
+    dst->hh_sum += src->hh_sum;
+
+    if (src->hh_min < dst->hh_min)
+        dst->hh_min = src->hh_min;
+    if (src->hh_max > dst->hh_max)
+        dst->hh_max = src->hh_max;
+}
+
+u64
+hdr_hist_pctile(const struct hdr_hist *hh, uint ppm)
+{
+    u64  want, seen;
+    uint i;
+
+    if (!hh->hh_count)
+        return 0;
+
+    if (ppm >= 1000000)
+        return hh->hh_max;
+
+    /* Rank of the requested value, rounded up so that p50 of two
+     * values is the first of them rather than nothing at all.
+     */
+    want = (hh->hh_count * ppm + 999999) / 1000000;
+    if (want == 0)
+        want = 1;
+
+    seen = 0;
+    for (i = 0; i < HDR_HIST_BKT_CNT; i++) {
+        seen += hh->hh_bktv[i];
+        if (seen >= want)
+            return min_t(u64, hdr_hist_bkt_hi(i), hh->hh_max);
+    }
+
+    return hh->hh_max;
+}
@@ -14,14 +14,17 @@
 #include <hse_util/config.h>
 #include <hse_util/log2.h>
 #include <hse_util/string.h>
+#include <hse_util/printbuf.h>
 
 #include <3rdparty/rbtree.h>
 
+#include <ctype.h>
+
 #define PERFC_PRIO_MIN 1
 #define PERFC_PRIO_MAX 4
 
 static char *pc_type_names[] = {
-    "Invalid", "Basic", "Rate", "Distribution", "Latency", "SimpleLatency",
+    "Invalid", "Basic", "Rate", "Distribution", "Latency", "SimpleLatency", "Histogram",
 };
 
 /*
@@ -106,6 +109,25 @@ perfc_ctrseti_clear(struct perfc_seti *seti)
             }
             break;
 
+        case PERFC_TYPE_HG:
+            dis = &seti->pcs_ctrv[cidx].dis;
+            dis->pdi_min = 0;
+            dis->pdi_max = 0;
+
+            for (j = 0; j < PERFC_HG_GRP_MAX; ++j) {
+                struct perfc_hg_grp *grp = dis->pdi_hdr.pch_hgv + j;
+
+                vtmp = atomic64_read(&grp->phg_sum);
+                atomic64_sub(vtmp, &grp->phg_sum);
+
+                for (i = 0; i < HDR_HIST_BKT_CNT; ++i) {
+                    vtmp = atomic64_read(&grp->phg_bktv[i]);
+                    if (vtmp)
+                        atomic64_sub(vtmp, &grp->phg_bktv[i]);
+                }
+            }
+            break;
+
         case PERFC_TYPE_SL:
         case PERFC_TYPE_BA:
         default:
@@ -307,6 +329,108 @@ perfc_di_emit(struct perfc_dis *dis, struct yaml_context *yc)
     yaml_element_field(yc, "bkts", bktstr);
 }
 
+/* Sum the per-cpu-group histograms of a histogram counter into @hh.
+ */
+static void
+perfc_hg_gather(struct perfc_dis *dis, struct hdr_hist *hh)
+{
+    struct perfc_hg_grp *grp;
+    u64                  hits;
+    int                  i, j;
+
+    hdr_hist_init(hh);
+
+    for (j = 0; j < PERFC_HG_GRP_MAX; ++j) {
+        grp = dis->pdi_hdr.pch_hgv + j;
+
+        for (i = 0; i < HDR_HIST_BKT_CNT; ++i) {
+            hits = atomic64_read(&grp->phg_bktv[i]);
+            hh->hh_bktv[i] += hits;
+            hh->hh_count += hits;
+        }
+
+        hh->hh_sum += atomic64_read(&grp->phg_sum);
+    }
+
+    if (hh->hh_count) {
+        hh->hh_min = dis->pdi_min;
+        hh->hh_max = dis->pdi_max;
+    }
+}
+
+static void
+perfc_hg_emit(struct perfc_dis *dis, struct yaml_context *yc)
+{
+    static const struct {
+        const char *name;
+        uint        ppm;
+    } pctv[] = {
+        { "p50", 500000 }, { "p90", 900000 },    { "p99", 990000 },
+        { "p999", 999000 }, { "p9999", 999900 },
+    };
+
+    struct hdr_hist *hh;
+    size_t           hitoff, bktoff, bufsz;
+    char             valstr[32];
+    char            *hitstr, *bktstr;
+    int              i;
+
+    /* Only non-empty buckets are emitted, each as a "hits" count and
+     * the largest value that maps to it in "bkts".
+     */
+    bufsz = HDR_HIST_BKT_CNT * 21 + 1;
+
+    hh = malloc(sizeof(*hh) + bufsz * 2);
+    if (ev(!hh))
+        return;
+
+    hitstr = (char *)(hh + 1);
+    bktstr = hitstr + bufsz;
+    hitstr[0] = bktstr[0] = '\000';
+    hitoff = bktoff = 0;
+
+    perfc_hg_gather(dis, hh);
+
+    for (i = 0; i < HDR_HIST_BKT_CNT; ++i) {
+        if (!hh->hh_bktv[i])
+            continue;
+
+        u64_append(hitstr, bufsz, hh->hh_bktv[i], -1, &hitoff);
+        u64_append(bktstr, bufsz, hdr_hist_bkt_hi(i), -1, &bktoff);
+    }
+
+    u64_to_string(valstr, sizeof(valstr), hh->hh_count ? hh->hh_min : 0);
+    yaml_element_field(yc, "min", valstr);
+
+    u64_to_string(valstr, sizeof(valstr), hh->hh_max);
+    yaml_element_field(yc, "max", valstr);
+
+    u64_to_string(valstr, sizeof(valstr), hh->hh_count ? hh->hh_sum / hh->hh_count : 0);
+    yaml_element_field(yc, "average", valstr);
+
+    /* 'sum' and 'hitcnt' field names must match those of the
+     * distribution and simple lat counters.
+     */
+    u64_to_string(valstr, sizeof(valstr), hh->hh_sum);
+    yaml_element_field(yc, "sum", valstr);
+
+    u64_to_string(valstr, sizeof(valstr), hh->hh_count ?: 1);
+    yaml_element_field(yc, "hitcnt", valstr);
+
+    u64_to_string(valstr, sizeof(valstr), dis->pdi_pct * 100 / PERFC_PCT_SCALE);
+    yaml_element_field(yc, "pct", valstr);
+
+    for (i = 0; i < NELEM(pctv); ++i) {
+        u64_to_string(valstr, sizeof(valstr), hdr_hist_pctile(hh, pctv[i].ppm));
+        yaml_element_field(yc, pctv[i].name, valstr);
+    }
+
+    yaml_element_field(yc, "hits", hitstr);
+    yaml_element_field(yc, "bkts", bktstr);
+
+    free(hh);
+}
+
 static __always_inline void
 _gather_values(struct perfc_ctr_hdr *hdr, u64 *vadd, u64 *vsub)
 {
@@ -395,6 +519,10 @@ emit_handler_ctrset(struct dt_element *dte, struct yaml_context *yc)
             perfc_di_emit(&seti->pcs_ctrv[cidx].dis, yc);
             break;
 
+        case PERFC_TYPE_HG:
+            perfc_hg_emit(&seti->pcs_ctrv[cidx].dis, yc);
+            break;
+
         default:
             break;
         }
@@ -709,6 +837,8 @@ perfc_ctr_name2type(const char *ctr_name)
         return PERFC_TYPE_LT;
     else if (!strncmp(type_name, PERFC_CTR_TYPE_SL, PERCF_CTR_TYPE_LEN))
         return PERFC_TYPE_SL;
+    else if (!strncmp(type_name, PERFC_CTR_TYPE_HG, PERCF_CTR_TYPE_LEN))
+        return PERFC_TYPE_HG;
 
     return ev(PERFC_TYPE_INVAL);
 }
@@ -728,12 +858,12 @@ perfc_ctrseti_alloc(
     char               family[DT_PATH_LEN] = "";
     u32                err = 0;
     const char *       famptr;
-    size_t             valdatasz, sz;
-    void              *valdata, *valcur;
+    size_t             valdatasz, hgdatasz, sz;
+    void              *valdata, *valcur, *hgdata;
     char *             meaning;
     u32                famlen;
     u32                type;
-    u32                n, i;
+    u32                n, nhg, i;
 
     assert(setp);
 
@@ -750,7 +880,7 @@ perfc_ctrseti_alloc(
      * The counter name syntax is:
      *
      * PERFC_<counter type>_<family name>_<meaning>
-     * <counter type> is one of "BA", "RA", "DI"
+     * <counter type> is one of "BA", "RA", "DI", "LT", "SL", "HG"
      * <family name> is all caps and doesn't contain '_'
      * <meaning> describes the meaning of the counter. It can contain
      * '_' character.
@@ -827,26 +957,31 @@ perfc_ctrseti_alloc(
     sz = sizeof(*seti) + sizeof(seti->pcs_ctrv[0]) * ctrc;
     sz = roundup(sz, SMP_CACHE_BYTES * 2);
 
-    for (n = i = 0; i < ctrc; ++i) {
+    for (n = nhg = i = 0; i < ctrc; ++i) {
         const struct perfc_name *entry = &ctrv[i];
 
         type = perfc_ctr_name2type(entry->pcn_name);
 
-        if (!(type == PERFC_TYPE_DI || type == PERFC_TYPE_LT))
+        if (type == PERFC_TYPE_HG)
+            ++nhg;
+        else if (!(type == PERFC_TYPE_DI || type == PERFC_TYPE_LT))
             ++n;
     }
 
-    n = ctrc - n + (roundup(n, 4) / 4) + 1;
+    n = ctrc - nhg - n + (roundup(n, 4) / 4) + 1;
 
     valdatasz = sizeof(struct perfc_val) * PERFC_VALPERCNT * PERFC_VALPERCPU * n + 1;
+    valdatasz = roundup(valdatasz, SMP_CACHE_BYTES * 2);
+
+    hgdatasz = sizeof(struct perfc_hg_grp) * PERFC_HG_GRP_MAX * nhg;
 
-    seti = alloc_aligned(sz + valdatasz, SMP_CACHE_BYTES * 2);
+    seti = alloc_aligned(sz + valdatasz + hgdatasz, SMP_CACHE_BYTES * 2);
     if (ev(!seti)) {
         free(dte);
         return merr(ENOMEM);
     }
 
-    memset(seti, 0, sz + valdatasz);
+    memset(seti, 0, sz + valdatasz + hgdatasz);
     strlcpy(seti->pcs_path, path, sizeof(seti->pcs_path));
     strlcpy(seti->pcs_famname, family, sizeof(seti->pcs_famname));
     strlcpy(seti->pcs_ctrseti_name, ctrseti_name, sizeof(seti->pcs_ctrseti_name));
@@ -855,6 +990,7 @@ perfc_ctrseti_alloc(
     seti->pcs_ctrc = ctrc;
 
     valdata = (char *)seti + sz;
+    hgdata = (char *)valdata + valdatasz;
     valcur = NULL;
     n = 0;
 
@@ -891,6 +1027,13 @@ perfc_ctrseti_alloc(
 
             pch->pch_bktv = valdata;
             valdata += sizeof(struct perfc_val) * PERFC_VALPERCNT * PERFC_VALPERCPU;
+        } else if (type == PERFC_TYPE_HG) {
+            struct perfc_dis *dis = &seti->pcs_ctrv[i].dis;
+
+            dis->pdi_pct = entry->pcn_samplepct * PERFC_PCT_SCALE / 100;
+
+            pch->pch_hgv = hgdata;
+            hgdata += sizeof(struct perfc_hg_grp) * PERFC_HG_GRP_MAX;
         } else {
             if (!valcur || (n % PERFC_VALPERCPU) == 0) {
                 valcur = valdata;
@@ -968,6 +1111,46 @@ perfc_ctrseti_invalidate_handle(struct perfc_set *set)
     dt_iterate_cmd(dt_data_tree, DT_OP_SET, dsp.path, &dip, 0, 0, 0);
 }
 
+void
+perfc_dis_read(struct perfc_set *pcs, u32 cidx, u64 *sum, u64 *hits)
+{
+    struct perfc_seti *pcsi;
+    struct perfc_dis * dis;
+    struct perfc_bkt * bkt;
+    int                i, j;
+
+    *sum = *hits = 0;
+
+    pcsi = perfc_ison(pcs, cidx);
+    if (!pcsi)
+        return;
+
+    dis = &pcsi->pcs_ctrv[cidx].dis;
+
+    if (dis->pdi_hdr.pch_type == PERFC_TYPE_HG) {
+        for (j = 0; j < PERFC_HG_GRP_MAX; ++j) {
+            struct perfc_hg_grp *grp = dis->pdi_hdr.pch_hgv + j;
+
+            *sum += atomic64_read(&grp->phg_sum);
+
+            for (i = 0; i < HDR_HIST_BKT_CNT; ++i)
+                *hits += atomic64_read(&grp->phg_bktv[i]);
+        }
+        return;
+    }
+
+    assert(dis->pdi_hdr.pch_type == PERFC_TYPE_DI || dis->pdi_hdr.pch_type == PERFC_TYPE_LT);
+
+    for (j = 0; j < PERFC_GRP_MAX; ++j) {
+        bkt = dis->pdi_hdr.pch_bktv + (PERFC_IVL_MAX + 1) * j;
+
+        for (i = 0; i < dis->pdi_ivl->ivl_cnt + 1; ++i, ++bkt) {
+            *sum += atomic64_read(&bkt->pcb_vadd);
+            *hits += atomic64_read(&bkt->pcb_hits);
+        }
+    }
+}
+
 _Static_assert(sizeof(struct perfc_val) >= sizeof(struct perfc_bkt), "sizeof perfc_bkt too large");
 
 static __always_inline void
@@ -1003,13 +1186,35 @@ perfc_latdis_record(struct perfc_dis *dis, u64 sample)
     atomic64_add(1, &bkt->pcb_hits);
 }
 
+static __always_inline void
+perfc_hg_record(struct perfc_dis *dis, u64 sample)
+{
+    struct perfc_hg_grp *grp;
+
+    if (sample > dis->pdi_max)
+        dis->pdi_max = sample;
+    else if ((sample < dis->pdi_min) || (dis->pdi_min == 0))
+        dis->pdi_min = sample;
+
+    grp = dis->pdi_hdr.pch_hgv + (raw_smp_processor_id() % PERFC_HG_GRP_MAX);
+
+    atomic64_add(sample, &grp->phg_sum);
+    atomic64_add(1, &grp->phg_bktv[hdr_hist_bkt(sample)]);
+}
+
 void
 perfc_lat_record_impl(struct perfc_dis *dis, u64 sample)
 {
-    assert(dis->pdi_hdr.pch_type == PERFC_TYPE_LT);
+    assert(dis->pdi_hdr.pch_type == PERFC_TYPE_LT || dis->pdi_hdr.pch_type == PERFC_TYPE_HG);
+
+    if (sample % PERFC_PCT_SCALE < dis->pdi_pct) {
+        sample = cycles_to_nsecs(get_cycles() - sample);
 
-    if (sample % PERFC_PCT_SCALE < dis->pdi_pct)
-        perfc_latdis_record(dis, cycles_to_nsecs(get_cycles() - sample));
+        if (dis->pdi_hdr.pch_type == PERFC_TYPE_HG)
+            perfc_hg_record(dis, sample);
+        else
+            perfc_latdis_record(dis, sample);
+    }
 }
 
 void
@@ -1021,6 +1226,426 @@ perfc_dis_record_impl(struct perfc_dis *dis, u64 sample)
         perfc_latdis_record(dis, sample);
 }
 
+/*
+ * OpenMetrics rendering
+ *
+ * Counters are rendered from a single locked walk of the data tree so
+ * that no counter set can be freed while it is read.  The counters
+ * themselves are read with the same lockless atomic loads used by the
+ * YAML emitters, so rendering never contends with the update paths.
+ *
+ * OpenMetrics requires all samples of a metric family to be contiguous,
+ * so the sets are first gathered and sorted by counter table, then each
+ * counter is rendered across every set that shares its table.
+ */
+
+struct perfc_metrics {
+    char                     *pm_buf;
+    size_t                    pm_bufsz;
+    size_t                    pm_len;
+    bool                      pm_nomem;
+    uint                      pm_filtc;
+    const struct perfc_label *pm_filtv;
+    struct perfc_seti       **pm_setv;
+    uint                      pm_setc;
+    uint                      pm_setmax;
+    struct hdr_hist          *pm_hist;
+};
+
+struct perfc_metrics_labels {
+    char pml_comp[DT_PATH_ELEMENT_LEN];
+    char pml_name[DT_PATH_COMP_ELEMENT_LEN];
+    char pml_kvs[DT_PATH_COMP_ELEMENT_LEN];
+    char pml_set[DT_PATH_ELEMENT_LEN];
+    char pml_text[DT_PATH_LEN * 2];
+};
+
+static merr_t
+perfc_metrics_grow(struct perfc_metrics *pm)
+{
+    size_t sz = pm->pm_bufsz * 2;
+    char  *buf;
+
+    buf = realloc(pm->pm_buf, sz);
+    if (ev(!buf)) {
+        pm->pm_nomem = true;
+        return merr(ENOMEM);
+    }
+
+    pm->pm_buf = buf;
+    pm->pm_bufsz = sz;
+
+    return 0;
+}
+
+static __printf(2, 3) void
+pm_printf(struct perfc_metrics *pm, const char *fmt, ...)
+{
+    va_list ap;
+    int     n;
+
+    while (!pm->pm_nomem) {
+        va_start(ap, fmt);
+        n = vsnprintf(pm->pm_buf + pm->pm_len, pm->pm_bufsz - pm->pm_len, fmt, ap);
+        va_end(ap);
+
+        if (pm->pm_len + n < pm->pm_bufsz) {
+            pm->pm_len += n;
+            break;
+        }
+
+        if (perfc_metrics_grow(pm))
+            break;
+    }
+}
+
+/* Split a counter set path into its labels and render them as text.
+ */
+static void
+perfc_metrics_labels(const struct perfc_seti *seti, struct perfc_metrics_labels *pml)
+{
+    const char *path = seti->pcs_path + strlen(PERFC_ROOT_PATH "/");
+    const char *sep;
+    size_t      off = 0;
+    char *      kvs;
+
+    memset(pml, 0, offsetof(struct perfc_metrics_labels, pml_text));
+
+    sep = strchr(path, '/');
+    if (sep) {
+        strlcpy(pml->pml_comp, path, min_t(size_t, sep - path + 1, sizeof(pml->pml_comp)));
+        path = sep + 1;
+
+        sep = strchr(path, '/');
+        if (sep)
+            strlcpy(pml->pml_name, path, min_t(size_t, sep - path + 1, sizeof(pml->pml_name)));
+    }
+
+    kvs = strstr(pml->pml_name, ":");
+    if (kvs) {
+        *kvs++ = '\000';
+        strlcpy(pml->pml_kvs, kvs, sizeof(pml->pml_kvs));
+    }
+
+    strlcpy(pml->pml_set, seti->pcs_ctrseti_name, sizeof(pml->pml_set));
+
+    snprintf_append(
+        pml->pml_text, sizeof(pml->pml_text), &off,
+        "component=\"%s\",name=\"%s\"", pml->pml_comp, pml->pml_name);
+    if (pml->pml_kvs[0])
+        snprintf_append(pml->pml_text, sizeof(pml->pml_text), &off, ",kvs=\"%s\"", pml->pml_kvs);
+    snprintf_append(pml->pml_text, sizeof(pml->pml_text), &off, ",set=\"%s\"", pml->pml_set);
+}
+
+static bool
+perfc_metrics_match(struct perfc_metrics *pm, const struct perfc_seti *seti)
+{
+    struct perfc_metrics_labels pml;
+    const char *                val;
+    uint                        i;
+
+    if (!pm->pm_filtc)
+        return true;
+
+    perfc_metrics_labels(seti, &pml);
+
+    for (i = 0; i < pm->pm_filtc; i++) {
+        const struct perfc_label *filt = pm->pm_filtv + i;
+
+        if (!strcmp(filt->pl_name, "component"))
+            val = pml.pml_comp;
+        else if (!strcmp(filt->pl_name, "name"))
+            val = pml.pml_name;
+        else if (!strcmp(filt->pl_name, "kvs"))
+            val = pml.pml_kvs;
+        else if (!strcmp(filt->pl_name, "set"))
+            val = pml.pml_set;
+        else if (!strcmp(filt->pl_name, "family"))
+            val = seti->pcs_famname;
+        else
+            return false;
+
+        if (strcmp(filt->pl_value, val))
+            return false;
+    }
+
+    return true;
+}
+
+static int
+perfc_metrics_cmp(const void *lhs, const void *rhs)
+{
+    const struct perfc_seti *l = *(const struct perfc_seti *const *)lhs;
+    const struct perfc_seti *r = *(const struct perfc_seti *const *)rhs;
+
+    if (l->pcs_ctrnamev != r->pcs_ctrnamev)
+        return l->pcs_ctrnamev < r->pcs_ctrnamev ? -1 : 1;
+
+    return strcmp(l->pcs_path, r->pcs_path);
+}
+
+/* Render one counter of one set.  @name is the metric family name.
+ */
+static void
+perfc_metrics_ctr(
+    struct perfc_metrics *pm,
+    struct perfc_seti    *seti,
+    u32                   cidx,
+    const char           *name,
+    const char           *labels)
+{
+    static const struct {
+        const char *q;
+        uint        ppm;
+    } qv[] = {
+        { "0.5", 500000 }, { "0.9", 900000 }, { "0.99", 990000 },
+        { "0.999", 999000 }, { "0.9999", 999900 },
+    };
+
+    union perfc_ctru *ctr = &seti->pcs_ctrv[cidx];
+    struct perfc_dis *dis = &ctr->dis;
+    u64               vadd, vsub, hits, sum, cum;
+    int               i, j;
+
+    switch (ctr->hdr.pch_type) {
+    case PERFC_TYPE_BA:
+        _gather_values(&ctr->hdr, &vadd, &vsub);
+        pm_printf(pm, "%s{%s} %lu\n", name, labels, (ulong)(vadd > vsub ? vadd - vsub : 0));
+        break;
+
+    case PERFC_TYPE_RA:
+        _gather_values(&ctr->hdr, &vadd, &vsub);
+        pm_printf(pm, "%s_total{%s} %lu\n", name, labels, (ulong)(vadd > vsub ? vadd - vsub : 0));
+        break;
+
+    case PERFC_TYPE_SL:
+        _gather_values(&ctr->hdr, &vadd, &vsub);
+        pm_printf(pm, "%s_sum{%s} %lu\n", name, labels, (ulong)vadd);
+        pm_printf(pm, "%s_count{%s} %lu\n", name, labels, (ulong)vsub);
+        break;
+
+    case PERFC_TYPE_DI:
+    case PERFC_TYPE_LT:
+        cum = sum = 0;
+
+        for (i = 0; i < dis->pdi_ivl->ivl_cnt + 1; ++i) {
+            struct perfc_bkt *bkt = dis->pdi_hdr.pch_bktv + i;
+
+            for (j = 0; j < PERFC_GRP_MAX; ++j) {
+                sum += atomic64_read(&bkt->pcb_vadd);
+                cum += atomic64_read(&bkt->pcb_hits);
+                bkt += PERFC_IVL_MAX + 1;
+            }
+
+            if (i < dis->pdi_ivl->ivl_cnt)
+                pm_printf(
+                    pm, "%s_bucket{%s,le=\"%lu\"} %lu\n",
+                    name, labels, (ulong)dis->pdi_ivl->ivl_bound[i], (ulong)cum);
+        }
+
+        pm_printf(pm, "%s_bucket{%s,le=\"+Inf\"} %lu\n", name, labels, (ulong)cum);
+        pm_printf(pm, "%s_sum{%s} %lu\n", name, labels, (ulong)sum);
+        pm_printf(pm, "%s_count{%s} %lu\n", name, labels, (ulong)cum);
+        break;
+
+    case PERFC_TYPE_HG:
+        perfc_hg_gather(dis, pm->pm_hist);
+
+        for (i = 0; i < NELEM(qv); ++i)
+            pm_printf(
+                pm, "%s{%s,quantile=\"%s\"} %lu\n",
+                name, labels, qv[i].q, (ulong)hdr_hist_pctile(pm->pm_hist, qv[i].ppm));
+
+        hits = pm->pm_hist->hh_count;
+        pm_printf(pm, "%s_sum{%s} %lu\n", name, labels, (ulong)pm->pm_hist->hh_sum);
+        pm_printf(pm, "%s_count{%s} %lu\n", name, labels, (ulong)hits);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Render every enabled counter of a group of sets sharing one table.
+ */
+static void
+perfc_metrics_group(struct perfc_metrics *pm, struct perfc_seti **setv, uint setc)
+{
+    const struct perfc_name *    ctrnamev = setv[0]->pcs_ctrnamev;
+    struct perfc_metrics_labels *pmlv;
+    char                         name[DT_PATH_ELEMENT_LEN * 2];
+    u32                          cidx;
+    uint                         i;
+
+    pmlv = malloc(sizeof(*pmlv) * setc);
+    if (ev(!pmlv)) {
+        pm->pm_nomem = true;
+        return;
+    }
+
+    for (i = 0; i < setc; i++)
+        perfc_metrics_labels(setv[i], pmlv + i);
+
+    for (cidx = 0; cidx < setv[0]->pcs_ctrc; cidx++) {
+        enum perfc_type type = setv[0]->pcs_ctrv[cidx].hdr.pch_type;
+        const char *    otype, *suffix;
+        bool            on = false;
+        size_t          n;
+
+        for (i = 0; i < setc && !on; i++) {
+            struct perfc_set *pcs = setv[i]->pcs_handle;
+
+            on = pcs && (pcs->ps_bitmap & (1ull << cidx));
+        }
+
+        if (!on)
+            continue;
+
+        switch (type) {
+        case PERFC_TYPE_BA:
+            otype = "gauge";
+            suffix = "";
+            break;
+        case PERFC_TYPE_RA:
+            otype = "counter";
+            suffix = "";
+            break;
+        case PERFC_TYPE_DI:
+            otype = "histogram";
+            suffix = "_dist";
+            break;
+        case PERFC_TYPE_LT:
+            otype = "histogram";
+            suffix = "_ns";
+            break;
+        case PERFC_TYPE_SL:
+        case PERFC_TYPE_HG:
+            otype = "summary";
+            suffix = "_ns";
+            break;
+        default:
+            continue;
+        }
+
+        /* PERFC_XX_FAMILY_MEANING => hse_family_meaning<suffix> */
+        n = snprintf(
+            name, sizeof(name), "hse_%s%s",
+            ctrnamev[cidx].pcn_name + strlen(PERFC_CTR_IDX_END), suffix);
+        if (n >= sizeof(name))
+            continue;
+
+        for (n = 0; name[n]; n++)
+            name[n] = tolower(name[n]);
+
+        pm_printf(pm, "# TYPE %s %s\n", name, otype);
+        pm_printf(pm, "# HELP %s %s\n", name, ctrnamev[cidx].pcn_desc);
+
+        for (i = 0; i < setc; i++) {
+            struct perfc_set *pcs = setv[i]->pcs_handle;
+
+            if (pcs && (pcs->ps_bitmap & (1ull << cidx)))
+                perfc_metrics_ctr(pm, setv[i], cidx, name, pmlv[i].pml_text);
+        }
+    }
+
+    free(pmlv);
+}
+
+static size_t
+perfc_metrics_walk(struct dt_element *dte, void *arg)
+{
+    struct perfc_metrics *pm = arg;
+    uint                  i, j;
+
+    if (dte) {
+        struct perfc_seti *seti = dte->dte_data;
+
+        if (dte->dte_ops != &perfc_ops || !seti || !perfc_metrics_match(pm, seti))
+            return 0;
+
+        if (pm->pm_setc == pm->pm_setmax) {
+            struct perfc_seti **setv;
+
+            setv = realloc(pm->pm_setv, sizeof(*setv) * (pm->pm_setmax + 128));
+            if (ev(!setv)) {
+                pm->pm_nomem = true;
+                return 0;
+            }
+
+            pm->pm_setv = setv;
+            pm->pm_setmax += 128;
+        }
+
+        pm->pm_setv[pm->pm_setc++] = seti;
+
+        return 1;
+    }
+
+    if (pm->pm_nomem || !pm->pm_setc)
+        return 0;
+
+    qsort(pm->pm_setv, pm->pm_setc, sizeof(*pm->pm_setv), perfc_metrics_cmp);
+
+    for (i = 0; i < pm->pm_setc; i = j) {
+        for (j = i + 1; j < pm->pm_setc; j++)
+            if (pm->pm_setv[j]->pcs_ctrnamev != pm->pm_setv[i]->pcs_ctrnamev)
+                break;
+
+        perfc_metrics_group(pm, pm->pm_setv + i, j - i);
+    }
+
+    return 0;
+}
+
+merr_t
+perfc_metrics(
+    const char *              path,
+    uint                      filtc,
+    const struct perfc_label *filtv,
+    char **                   bufp,
+    size_t *                  lenp)
+{
+    struct perfc_metrics pm = {};
+
+    if (ev(!path || !bufp || !lenp || (filtc && !filtv)))
+        return merr(EINVAL);
+
+    *bufp = NULL;
+    *lenp = 0;
+
+    if (!dt_data_tree)
+        return merr(ENOENT);
+
+    pm.pm_bufsz = 1024 * 1024;
+    pm.pm_buf = malloc(pm.pm_bufsz);
+    pm.pm_hist = malloc(sizeof(*pm.pm_hist));
+    pm.pm_filtc = filtc;
+    pm.pm_filtv = filtv;
+
+    if (ev(!pm.pm_buf || !pm.pm_hist)) {
+        free(pm.pm_buf);
+        free(pm.pm_hist);
+        return merr(ENOMEM);
+    }
+
+    pm.pm_buf[0] = '\000';
+
+    dt_walk(dt_data_tree, path, perfc_metrics_walk, &pm);
+
+    free(pm.pm_setv);
+    free(pm.pm_hist);
+
+    if (ev(pm.pm_nomem)) {
+        free(pm.pm_buf);
+        return merr(ENOMEM);
+    }
+
+    *bufp = pm.pm_buf;
+    *lenp = pm.pm_len;
+
+    return 0;
+}
+
 #if defined(HSE_UNIT_TEST_MODE) && HSE_UNIT_TEST_MODE == 1
 #include "perfc_ut_impl.i"
 #endif /* HSE_UNIT_TEST_MODE */
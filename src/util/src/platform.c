@@ -10,6 +10,7 @@
 #include <hse_util/timer.h>
 #include <hse_util/vlb.h>
 #include <hse_util/hse_log_fmt.h>
+#include <hse_util/flightrec.h>
 
 #include <hse_version.h>
 
@@ -132,6 +133,8 @@ hse_platform_init(void)
     rest_init();
     rest_url_register(0, 0, rest_dt_get, rest_dt_put, "data"); /* for dt */
     rest_url_register(0, 0, kmc_rest_get, NULL, "kmc");
+    rest_url_register(0, URL_FLAG_EXACT, rest_metrics_get, NULL, "metrics");
+    rest_url_register(0, URL_FLAG_EXACT, flightrec_rest_get, NULL, "flightrec");
 
     /* We only need the name pointer, the error is superfluous */
     hse_program_name(&name, &basename);
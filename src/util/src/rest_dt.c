@@ -10,6 +10,7 @@
 #include <hse_util/event_counter.h>
 
 #include <hse_util/data_tree.h>
+#include <hse_util/perfc.h>
 #include <hse_util/rest_api.h>
 #include <hse_util/spinlock.h>
 #include <hse_util/string.h>
@@ -154,3 +155,66 @@ rest_dt_get(
 
     return 0;
 }
+
+/* Turn query arguments into perfc label filters.  The caller must
+ * free *filtv.
+ */
+static merr_t
+rest_metrics_filters(struct kv_iter *iter, uint *filtc, struct perfc_label **filtv)
+{
+    struct rest_kv *kv;
+    size_t          cnt;
+
+    *filtc = 0;
+    *filtv = NULL;
+
+    cnt = rest_kv_count(iter);
+    if (!cnt)
+        return 0;
+
+    *filtv = calloc(cnt, sizeof(**filtv));
+    if (ev(!*filtv))
+        return merr(ENOMEM);
+
+    while ((kv = rest_kv_next(iter)) && *filtc < cnt) {
+        (*filtv)[*filtc].pl_name = kv->key;
+        (*filtv)[*filtc].pl_value = kv->value ?: "";
+        ++*filtc;
+    }
+
+    return 0;
+}
+
+/* rest hook for OpenMetrics scrapes of all perf counters, filtered
+ * by labels given as query arguments (e.g., /metrics?family=CNCOMP)
+ */
+merr_t
+rest_metrics_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context)
+{
+    struct perfc_label *filtv;
+    size_t              len;
+    char *              buf;
+    uint                filtc;
+    merr_t              err;
+
+    err = rest_metrics_filters(iter, &filtc, &filtv);
+    if (ev(err))
+        return err;
+
+    err = perfc_metrics(PERFC_ROOT_PATH, filtc, filtv, &buf, &len);
+    free(filtv);
+    if (ev(err))
+        return err;
+
+    rest_write_safe(info->resp_fd, buf, len);
+    rest_write_string(info->resp_fd, "# EOF\n");
+
+    free(buf);
+
+    return 0;
+}
@@ -24,4 +24,12 @@ rest_dt_put(
     struct kv_iter *  iter,
     void *            context);
 
+merr_t
+rest_metrics_get(
+    const char *      path,
+    struct conn_info *info,
+    const char *      url,
+    struct kv_iter *  iter,
+    void *            context);
+
 #endif /* HSE_PLATFORM_REST_DT_H */
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_ut/framework.h>
+
+#include <hse_util/flightrec.h>
+
+#include <stdio.h>
+
+#define RECS_MAX (FLIGHTREC_RINGS * FLIGHTREC_RING_RECS)
+
+static struct flightrec_rec recv[RECS_MAX];
+
+MTF_BEGIN_UTEST_COLLECTION(flightrec_test)
+
+MTF_DEFINE_UTEST(flightrec_test, add_get)
+{
+    uint n, i, found;
+    u64  tag = 0x5eed0000;
+
+    for (i = 0; i < 10; i++)
+        flightrec_add(FLIGHTREC_STS_JOB_SUBMIT, tag + i, i);
+
+    n = flightrec_get(recv, RECS_MAX);
+    ASSERT_GE(n, 10);
+
+    /* Events come back oldest first, and ours in the order added.
+     */
+    found = 0;
+    for (i = 0; i < n; i++) {
+        if (i > 0)
+            ASSERT_LE(recv[i - 1].fr_ns, recv[i].fr_ns);
+
+        if (recv[i].fr_ev == FLIGHTREC_STS_JOB_SUBMIT && recv[i].fr_argv[0] == tag + found) {
+            ASSERT_EQ(found, recv[i].fr_argv[1]);
+            found++;
+        }
+    }
+    ASSERT_EQ(10, found);
+
+    ASSERT_EQ(3, flightrec_get(recv, 3));
+}
+
+MTF_DEFINE_UTEST(flightrec_test, wrap)
+{
+    uint n, i;
+
+    /* Overfill every ring, only the most recent events are kept.
+     */
+    for (i = 0; i < 2 * RECS_MAX; i++)
+        flightrec_add(FLIGHTREC_CNDB_TXN_START, i, 0);
+
+    n = flightrec_get(recv, RECS_MAX);
+    ASSERT_GE(n, FLIGHTREC_RING_RECS);
+    ASSERT_LE(n, RECS_MAX);
+
+    ASSERT_EQ(FLIGHTREC_CNDB_TXN_START, recv[n - 1].fr_ev);
+    ASSERT_EQ(2 * RECS_MAX - 1, recv[n - 1].fr_argv[0]);
+}
+
+MTF_DEFINE_UTEST(flightrec_test, dump)
+{
+    char  line[256];
+    FILE *fp;
+    uint  lines = 0, found = 0;
+
+    flightrec_add(FLIGHTREC_THROTTLE_STATE, 1, 12345);
+
+    fp = tmpfile();
+    ASSERT_NE(NULL, fp);
+
+    flightrec_dump(fileno(fp));
+    rewind(fp);
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (lines++ == 0)
+            ASSERT_EQ(0, strncmp(line, "flightrec: now_ns ", 18));
+        else if (strstr(line, " throttle_state 1 12345\n"))
+            found++;
+    }
+
+    fclose(fp);
+
+    ASSERT_GT(lines, 1);
+    ASSERT_EQ(1, found);
+}
+
+MTF_DEFINE_UTEST(flightrec_test, names)
+{
+    int i;
+
+    for (i = 0; i < FLIGHTREC_EV_MAX; i++)
+        ASSERT_STRNE("unknown", flightrec_ev_name(i));
+
+    ASSERT_STREQ("unknown", flightrec_ev_name(FLIGHTREC_EV_MAX));
+}
+
+MTF_END_UTEST_COLLECTION(flightrec_test)
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2015-2020 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_ut/framework.h>
+
+#include <hse_util/hdr_hist.h>
+
+MTF_BEGIN_UTEST_COLLECTION(hdr_hist_test)
+
+MTF_DEFINE_UTEST(hdr_hist_test, buckets)
+{
+    u64  v, hi, prev;
+    uint bkt, prev_bkt;
+
+    /* Small values map one-to-one onto buckets. */
+    for (v = 0; v < HDR_HIST_SUB_CNT; v++) {
+        ASSERT_EQ(v, hdr_hist_bkt(v));
+        ASSERT_EQ(v, hdr_hist_bkt_hi(v));
+    }
+
+    /* Buckets are contiguous and each value lies within its bucket's
+     * bounds with no more than 1/HDR_HIST_SUB_CNT relative error.
+     */
+    prev = 0;
+    prev_bkt = 0;
+    for (v = 1; v < (1ul << HDR_HIST_VAL_BITS); v = v + 1 + v / 7) {
+        bkt = hdr_hist_bkt(v);
+        hi = hdr_hist_bkt_hi(bkt);
+
+        ASSERT_LT(bkt, HDR_HIST_BKT_CNT);
+        ASSERT_GE(bkt, prev_bkt);
+        ASSERT_GE(hi, v);
+        ASSERT_LE(hi - v, v / HDR_HIST_SUB_CNT);
+        ASSERT_EQ(bkt, hdr_hist_bkt(hi));
+
+        if (bkt > 0)
+            ASSERT_EQ(bkt - 1, hdr_hist_bkt(hdr_hist_bkt_hi(bkt - 1)));
+
+        prev = v;
+        prev_bkt = bkt;
+    }
+
+    ASSERT_GT(prev, 0);
+    ASSERT_EQ(HDR_HIST_BKT_CNT - 1, hdr_hist_bkt(U64_MAX));
+}
+
+MTF_DEFINE_UTEST(hdr_hist_test, percentiles)
+{
+    struct hdr_hist a, b;
+    u64             v;
+
+    hdr_hist_init(&a);
+    hdr_hist_init(&b);
+
+    ASSERT_EQ(0, hdr_hist_pctile(&a, 500000));
+
+    /* 9990 fast values and 10 slow ones. */
+    for (v = 0; v < 9990; v++)
+        hdr_hist_record(&a, 1000 + v % 100);
+    for (v = 0; v < 10; v++)
+        hdr_hist_record(&b, 9 * 1000 * 1000);
+
+    hdr_hist_merge(&a, &b);
+
+    ASSERT_EQ(10000, a.hh_count);
+    ASSERT_EQ(1000, a.hh_min);
+    ASSERT_EQ(9 * 1000 * 1000, a.hh_max);
+
+    v = hdr_hist_pctile(&a, 500000);
+    ASSERT_GE(v, 1000);
+    ASSERT_LT(v, 1100);
+
+    v = hdr_hist_pctile(&a, 999000);
+    ASSERT_LT(v, 1100 + 1100 / HDR_HIST_SUB_CNT);
+
+    v = hdr_hist_pctile(&a, 999900);
+    ASSERT_EQ(v, 9 * 1000 * 1000);
+
+    ASSERT_EQ(a.hh_max, hdr_hist_pctile(&a, 1000000));
+}
+
+MTF_END_UTEST_COLLECTION(hdr_hist_test)
@@ -343,6 +343,121 @@ perfc_value(struct perfc_set *pcs, u32 cidx)
     return vadd - vsub;
 }
 
+MTF_DEFINE_UTEST(perfc, histogram)
+{
+    struct yaml_context yc = {
+        .yaml_indent = 0, .yaml_offset = 0,
+    };
+    union dt_iterate_parameters dip = {.yc = &yc };
+    struct dt_set_parameters    dsp;
+    struct perfc_name           ctrnames = { 0 };
+    struct perfc_set            set = { 0 };
+    u64                         sum, hits;
+    merr_t                      err;
+    int                         i, n = 1000;
+
+    ctrnames.pcn_name = "PERFC_HG_FAM_TEST";
+    ctrnames.pcn_hdr = "mycounterhdr";
+    ctrnames.pcn_desc = "mycounter";
+    ctrnames.pcn_flags = 0;
+    ctrnames.pcn_prio = 1;
+    ctrnames.pcn_samplepct = 100;
+
+    err = perfc_ctrseti_alloc(COMPNAME, "hist", &ctrnames, 1, "set", &set);
+    ASSERT_EQ(0, err);
+
+    for (i = 0; i < n; i++)
+        perfc_lat_record(&set, 0, perfc_lat_start(&set));
+
+    perfc_dis_read(&set, 0, &sum, &hits);
+    ASSERT_EQ(n, hits);
+
+    yc.yaml_buf = yamlbuf;
+    yc.yaml_buf_sz = sizeof(yamlbuf);
+    yc.yaml_emit = NULL;
+
+    dt_iterate_cmd(dt_data_tree, DT_OP_EMIT, perfc_ctrseti_path(&set), &dip, NULL, NULL, NULL);
+    ASSERT_NE(NULL, strstr(yamlbuf, "type: Histogram"));
+    ASSERT_NE(NULL, strstr(yamlbuf, "hitcnt: 1000"));
+    ASSERT_NE(NULL, strstr(yamlbuf, "p9999: "));
+
+    dsp.path = perfc_ctrseti_path(&set);
+    dsp.value = "1";
+    dsp.value_len = strlen(dsp.value);
+    dsp.field = DT_FIELD_CLEAR;
+    dip.dsp = &dsp;
+
+    dt_iterate_cmd(dt_data_tree, DT_OP_SET, dsp.path, &dip, NULL, NULL, NULL);
+
+    perfc_dis_read(&set, 0, &sum, &hits);
+    ASSERT_EQ(0, hits);
+    ASSERT_EQ(0, sum);
+
+    perfc_ctrseti_free(&set);
+}
+
+MTF_DEFINE_UTEST(perfc, metrics)
+{
+    enum perfc_metrics_sidx {
+        PERFC_BA_FAM_TEST_GAUGE,
+        PERFC_RA_FAM_TEST_RATE,
+        PERFC_HG_FAM_TEST_HIST,
+        PERFC_EN_FAM_TEST
+    };
+    struct perfc_name ctrnames[] = {
+        NE(PERFC_BA_FAM_TEST_GAUGE, 1, "gauge", "gauge"),
+        NE(PERFC_RA_FAM_TEST_RATE, 1, "rate", "rate"),
+        NE(PERFC_HG_FAM_TEST_HIST, 1, "hist", "hist"),
+    };
+    struct perfc_label filt[2];
+    struct perfc_set   set = { 0 };
+    merr_t             err;
+    size_t             len;
+    char *             buf;
+
+    err = perfc_ctrseti_alloc("mycomp", "mp1:kvs1", ctrnames, PERFC_EN_FAM_TEST, "set", &set);
+    ASSERT_EQ(0, err);
+
+    perfc_add(&set, PERFC_BA_FAM_TEST_GAUGE, 42);
+    perfc_add(&set, PERFC_RA_FAM_TEST_RATE, 7);
+    perfc_lat_record(&set, PERFC_HG_FAM_TEST_HIST, perfc_lat_start(&set));
+
+    filt[0].pl_name = "name";
+    filt[0].pl_value = "mp1";
+    filt[1].pl_name = "kvs";
+    filt[1].pl_value = "kvs1";
+
+    err = perfc_metrics(PERFC_ROOT_PATH, 2, filt, &buf, &len);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(strlen(buf), len);
+
+    ASSERT_NE(NULL, strstr(buf, "# TYPE hse_fam_test_gauge gauge\n"));
+    ASSERT_NE(NULL, strstr(buf, "hse_fam_test_gauge{component=\"mycomp\",name=\"mp1\","
+                                "kvs=\"kvs1\",set=\"set\"} 42\n"));
+    ASSERT_NE(NULL, strstr(buf, "# TYPE hse_fam_test_rate counter\n"));
+    ASSERT_NE(NULL, strstr(buf, "hse_fam_test_rate_total{"));
+    ASSERT_NE(NULL, strstr(buf, "# TYPE hse_fam_test_hist_ns summary\n"));
+    ASSERT_NE(NULL, strstr(buf, "quantile=\"0.99\"} "));
+    ASSERT_NE(NULL, strstr(buf, "hse_fam_test_hist_ns_count{"));
+    free(buf);
+
+    filt[1].pl_value = "kvs2";
+
+    err = perfc_metrics(PERFC_ROOT_PATH, 2, filt, &buf, &len);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, len);
+    free(buf);
+
+    filt[0].pl_name = "nosuchlabel";
+
+    err = perfc_metrics(PERFC_ROOT_PATH, 1, filt, &buf, &len);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, len);
+    free(buf);
+
+    perfc_ctrseti_free(&set);
+}
+
 MTF_DEFINE_UTEST(perfc, perfc_rollup)
 {
     enum perfc_rollup_sidx {